@@ -4,7 +4,9 @@
 
 #include <glm/glm.hpp>
 
+#include <map>
 #include <vector>
+#include <span>
 
 
 typedef struct {
@@ -20,11 +22,23 @@ typedef struct {
 	glm::vec2 texCoords;
 } VertexDataUnlit;
 
+// compact alternative to VertexData (24 bytes instead of 56), see `ModelImportOptions::compact_vertices`
+typedef struct {
+	uint16_t position[4];	// unorm16 inside the mesh bounds (`MeshData::position_offset/scale`), w unused
+	int16_t  normal[2];		// octahedral, snorm16
+	int16_t  tangent[2];	// octahedral, snorm16
+	uint16_t texCoords[2];	// half float
+	uint8_t  color[4];		// unorm8
+} VertexDataCompact;
+static_assert(sizeof(VertexDataCompact) == 24, "VertexDataCompact must stay tightly packed");
+
 namespace vkc::Assets {
 
-	// TODO fix ids for serialization
-	//      ATM, ids are simple incrementail counters. We already have maps to store assets,
-	//      what we need is a fast and safe way to get a new free id
+	// ids are generational handles into dense per type storages:
+	//   bit  31      built-in, built-ins have their own reserved range counting down from -1
+	//   bits 30..24  generation of the slot, ids of released assets don't resolve once the slot is reused
+	//   bits 23..0   slot index
+	// ids are serialized as is. The first assets of a session get 0, 1, 2...
 	typedef uint32_t IdAssetMesh;
 	typedef uint32_t IdAssetTexture;
 	typedef uint32_t IdAssetMaterial;
@@ -62,10 +76,17 @@ namespace vkc::Assets {
 	} TexChannelTypes;
 
 	typedef enum : uint8_t {
-		TEX_VIEW_TYPE_2D   = 1,	// VK_IMAGE_VIEW_TYPE_2D
-		TEX_VIEW_TYPE_CUBE = 3	// VK_IMAGE_VIEW_TYPE_CUBE
+		TEX_VIEW_TYPE_2D       = 1,	// VK_IMAGE_VIEW_TYPE_2D
+		TEX_VIEW_TYPE_CUBE     = 3,	// VK_IMAGE_VIEW_TYPE_CUBE
+		TEX_VIEW_TYPE_2D_ARRAY = 5	// VK_IMAGE_VIEW_TYPE_2D_ARRAY, see `pack_texture_arrays`
 	} TexViewTypes;
 
+	typedef enum : uint8_t {
+		TEX_COMPRESSION_NONE = 0,
+		TEX_COMPRESSION_FAST = 1,	// color: BC1, BC3 with alpha
+		TEX_COMPRESSION_HIGH = 2	// color: BC7
+	} TexCompression;
+
 	const IdAssetTexture IDX_MISSING_TEXTURE = -1;
 
 	inline uint8_t tex_get_num_channels(TexChannelTypes t) {
@@ -92,19 +113,79 @@ namespace vkc::Assets {
 		const IdAssetTexture IDX_TEX_BLUE_NORM = -3;
 	}
 
+	// cluster of up to 64 vertices / 124 triangles, contiguous in the index buffer.
+	// Bounds are in mesh space
+	struct MeshletData {
+		uint32_t  first_index;
+		uint32_t  index_count;
+		uint32_t  vertex_count;	// unique vertices referenced
+		float     radius;
+		glm::vec3 center;
+		// all triangles face away from a viewer at `p` if
+		//   dot(center - p, cone_axis) >= cone_cutoff * length(center - p) + radius
+		// cone_cutoff is 1 when the triangles face too many directions to ever be culled
+		glm::vec3 cone_axis;
+		float     cone_cutoff;
+		uint32_t  padding;
+	};
+	static_assert(sizeof(MeshletData) == 48, "MeshletData is stored as is in the asset db");
+
+	// index range of a simplified version of the mesh
+	struct MeshLodData {
+		uint32_t first_index;
+		uint32_t index_count;
+		float    error;		// mesh space distance from the full resolution surface, 0 for LOD 0
+		uint32_t padding;
+	};
+	static_assert(sizeof(MeshLodData) == 16, "MeshLodData is stored as is in the asset db");
+
 	struct MeshData {
 		static const uint8_t	FLAG_DYNAMIC = 0x00000001;
+		static const uint8_t	FLAG_MAPPED  = 0x00000002; // vertex and index data point into a loaded asset db
+		static const uint8_t	FLAG_COMPACT = 0x00000004; // vertex data is VertexDataCompact
+		static const uint8_t	FLAG_INDICES_16 = 0x00000008; // index data is uint16_t, uint32_t otherwise
 
 		void*			vertex_data;
 		uint32_t		vertex_count;
 		uint32_t		vertex_data_size; // size of a single element
-		uint32_t*		index_data;
+		void*			index_data;       // uint32_t, or uint16_t with FLAG_INDICES_16
 		uint32_t		index_count;
 		// [optional]	enum for contiguous ot interlieaved vertex data storage
 		uint8_t			flags;
+
+		// FLAG_COMPACT only: position = position_offset + normalized position ([0, 1]) * position_scale
+		glm::vec3		position_offset;
+		glm::vec3		position_scale;
+
+		// [optional] triangle lists only, covers LOD 0 in order
+		MeshletData*	meshlets;
+		uint32_t		meshlet_count;
+
+		// [optional] LOD 0 first, then decreasing detail. The index lists of all levels
+		// are stored back to back in `index_data`
+		MeshLodData*	lods;
+		uint32_t		lod_count;
+
+		// bounds of all vertices, mesh space. The sphere is centered on the box
+		glm::vec3		bounds_min;
+		glm::vec3		bounds_max;
+		glm::vec3		bounds_center;
+		float			bounds_radius;
 	};
 
+	inline uint32_t mesh_get_index_size(const MeshData& data) {
+		return (data.flags & MeshData::FLAG_INDICES_16) ? sizeof(uint16_t) : sizeof(uint32_t);
+	}
+
+	// indices of the full resolution mesh, at the start of `index_data`
+	inline uint32_t mesh_get_base_index_count(const MeshData& data) {
+		return data.lod_count > 0 ? data.lods[0].index_count : data.index_count;
+	}
+
 	struct TextureData {
+		static const uint8_t FLAG_MAPPED = 0x00000001; // pixels point into a loaded asset db
+		static const uint8_t FLAG_FILE   = 0x00000002; // pixels stay in their source file (DDS), see `texture_read_pixels`
+
 		uint16_t width;
 		uint16_t height;
 		uint8_t  mipmaps;
@@ -116,27 +197,82 @@ namespace vkc::Assets {
 		// TEX_FORMAT_COMPRESSED_BC2_SRGB  = 136,	// VK_FORMAT_BC2_UNORM_BLOCK
 		// TEX_FORMAT_COMPRESSED_BC3_SRGB  = 138,	// VK_FORMAT_BC3_UNORM_BLOCK
 		VkFormat        format;
-		std::vector<unsigned char> data;
+		uint8_t         flags;
+		// levels from the largest, tightly packed. Cubemaps (width and height are the face size) store the
+		// 6 faces of each level one after the other, in layer order +X -X +Y -Y +Z -Z, arrays their
+		// `layers` images the same way.
+		// Owned (malloc) unless FLAG_MAPPED is set. FLAG_FILE textures only have the size, `data.data()` is null
+		std::span<unsigned char> data;
+		uint16_t        layers;		// TEX_VIEW_TYPE_2D_ARRAY only, see `tex_get_layer_count`
+		uint32_t        file;		// FLAG_FILE only, source file of the pixels
 	};
 
+	inline uint32_t tex_get_layer_count(const TextureData& data) {
+		switch (data.viewType) {
+			case TEX_VIEW_TYPE_CUBE     : return 6;
+			case TEX_VIEW_TYPE_2D_ARRAY : return data.layers;
+			default                     : return 1;
+		}
+	}
+
 	struct MaterialData {
+		// the first MATERIAL_TEXTURE_ARRAY_SLOTS slots are sampled from 2D arrays, by layer: set for the
+		// materials of pipeline configs with the TEXTURE_ARRAYS flag (PBR), see `pack_texture_arrays`
+		static const uint8_t FLAG_TEXTURE_ARRAYS = 0x00000001;
+
 		uint32_t id_pipeline_config;
 		// TODO replace with IdRenderPass and IdPipeline
 		uint32_t id_render_pass;
 		uint32_t id_pipeline;
 		void* uniform_data_material;
 		std::vector<IdAssetTexture> image_views;
+		// layer of each image view, for the slots sampled from texture arrays. Empty until
+		// `pack_texture_arrays`, all 0 means the first layer
+		std::vector<uint32_t> image_layers;
+		uint8_t flags;
 	};
 
+	// the first slots of PBR materials (diffuse, arm, normal)
+	const uint32_t MATERIAL_TEXTURE_ARRAY_SLOTS = 3;
+	inline bool material_uses_texture_arrays(const MaterialData& data) {
+		return data.flags & MaterialData::FLAG_TEXTURE_ARRAYS;
+	}
+
+	const uint32_t NODE_NO_PARENT = 0xFFFFFFFF;
+
 	struct ModelData {
-		glm::mat4 transform;
+		glm::mat4 transform;			// placement of the whole model, identity on import
+		// one entry per mesh instance: a mesh referenced by several nodes is listed once per node
 		uint32_t meshes_count;
 		IdAssetMesh* meshes;
 		IdAssetMaterial* meshes_material;
+		uint32_t* meshes_node;			// node the mesh is drawn with
+		// node hierarchy of the imported scene, flattened depth first: parents come before their
+		// children and every subtree is contiguous. Node 0 is the root, models without a
+		// hierarchy have a single identity node
+		uint32_t nodes_count;
+		uint32_t* nodes_parent;			// NODE_NO_PARENT for the root
+		glm::mat4* nodes_transform;		// relative to the parent
+
+		// bounds of every mesh instance placed by its node, model space (`transform` not applied).
+		// The sphere is centered on the box
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		glm::vec3 bounds_center;
+		float bounds_radius;
+	};
+
+	// every loaded asset of a type, built-ins excluded, packed: `data[i]` is the asset `ids[i]`.
+	// Invalidated by the next create, load or unload
+	template <typename Id, typename T>
+	struct AssetRange {
+		std::span<const Id> ids;
+		std::span<T>        data;
 	};
 
 	void asset_manager_init();
 
+	// built-ins excluded
 	uint32_t get_num_mesh_assets();
 	uint32_t get_num_texture_assets();
 	uint32_t get_num_material_assets();
@@ -146,6 +282,22 @@ namespace vkc::Assets {
 	MaterialData& get_material_data(IdAssetMaterial id);
 	ModelData& get_model_data(IdAssetModel id);
 
+	// false for ids never created, released or of a reused slot
+	bool is_mesh_valid(IdAssetMesh id);
+	bool is_texture_valid(IdAssetTexture id);
+	bool is_material_valid(IdAssetMaterial id);
+	bool is_model_valid(IdAssetModel id);
+
+	AssetRange<IdAssetMesh, MeshData>         get_mesh_assets();
+	AssetRange<IdAssetTexture, TextureData>   get_texture_assets();
+	AssetRange<IdAssetMaterial, MaterialData> get_material_assets();
+	AssetRange<IdAssetModel, ModelData>       get_model_assets();
+
+	// copies `size` bytes of the pixels of `data` from `offset` into `dst`. FLAG_FILE textures are read
+	// from their file, mapped for the copy only, so `dst` can be mapped staging memory. Callable from any
+	// thread. False and `dst` zeroed if the file changed since the texture was loaded
+	bool texture_read_pixels(const TextureData& data, uint64_t offset, uint64_t size, void* dst);
+
 	// ===================================================================================
 	// load
 	// ===================================================================================
@@ -154,14 +306,92 @@ namespace vkc::Assets {
 	std::vector<IdAssetMesh> load_meshes(const char** paths);
 	std::vector<IdAssetMesh> load_meshes_from_folder(const char* folder_path);
 
+	struct ModelImportOptions {
+		// weld, vertex cache and vertex fetch optimization of triangle meshes
+		bool     optimize_meshes = true;
+		// simplified LODs of triangle meshes (LOD 0 included), 1 disables them
+		uint32_t lod_count = 4;
+		// block compression of 8 bit textures (not DDS, already compressed). Normal maps
+		// use BC5 and single channel textures BC4 in both modes
+		TexCompression texture_compression = TEX_COMPRESSION_HIGH;
+		// store VertexDataCompact instead of VertexData. Materials need a pipeline config with the
+		// compact vertex layout (PIPELINE_CONFIG_ID_PBR_COMPACT)
+		bool     compact_vertices = false;
+		// pipeline config of the materials, PIPELINE_CONFIG_ID_PBR by default
+		uint32_t id_pipeline_config = 1;
+		// the pipeline config samples the PBR textures from 2D arrays (TEXTURE_ARRAYS pipeline flag)
+		bool     texture_arrays = true;
+	};
+
+	// image based lighting of the PBR materials, see `load_environment`
+	struct EnvironmentTextures {
+		IdAssetTexture specular;	// GGX prefiltered radiance, roughness 0 to 1 over the mips
+		IdAssetTexture irradiance;	// 9x1, SH irradiance coefficients (RGB)
+		IdAssetTexture brdf_lut;	// split sum scale and bias of f0, NdotV x roughness
+	};
+	// no indirect lighting
+	const EnvironmentTextures ENVIRONMENT_NONE = {
+		.specular   = BuiltinPrimitives::IDX_TEX_BLACK,
+		.irradiance = BuiltinPrimitives::IDX_TEX_BLACK,
+		.brdf_lut   = BuiltinPrimitives::IDX_TEX_BLACK
+	};
+
 	uint32_t load_model(
 		const char* path,
 		const char* base_path_textures,
-		IdAssetTexture TMP_tex_environment_id
+		const EnvironmentTextures& environment,
+		const ModelImportOptions& options = { }
 	);
 
+	struct ModelLoadRequest {
+		const char*         path;
+		const char*         base_path_textures;
+		EnvironmentTextures environment;
+		ModelImportOptions  options;
+	};
+
+	// imports the models in parallel on the job pool, then stores them in request order: the ids are
+	// the same as loading them one by one. Writes one id per request to `out_ids`
+	void load_models(std::span<const ModelLoadRequest> requests, IdAssetModel* out_ids);
+
+	// loading the same file (normalized path) with the same options twice returns the id of the first load
 	IdAssetTexture load_texture(const char* path, TexViewTypes viewType = TEX_VIEW_TYPE_2D, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB, bool flip_vertical=false, bool generate_mipmaps=false);
 
+	// bakes the image based lighting of an equirectangular HDR file (see EnvironmentBaker.hpp), the BRDF LUT
+	// is shared by every environment. Loading the same file twice returns the textures of the first load.
+	// Environments are not hot reloaded
+	EnvironmentTextures load_environment(const char* path, bool flip_vertical = false);
+
+	// decodes and bytes saved by the texture cache so far
+	void texture_cache_print_stats();
+
+	struct BakeFormatStats {
+		uint32_t count;
+		uint64_t bytes;
+	};
+
+	// accumulated by the loads since the last `bake_stats_reset`. Stage times are summed over the
+	// models: models loaded in parallel overlap, and so do the meshes and textures of a model
+	struct BakeStats {
+		uint32_t models_count;
+		uint32_t meshes_count;
+		uint32_t textures_count;		// decoded, reuses of the texture cache excluded
+		double   time_import_ms;		// assimp, or the bake cache
+		double   time_meshes_ms;		// conversion and optimization
+		double   time_textures_ms;		// decode and block compression
+		double   time_store_ms;
+		uint64_t source_bytes;			// model and texture files
+		uint64_t vertex_bytes_imported;	// one VertexData per face corner
+		uint64_t vertex_bytes;
+		uint64_t index_bytes;
+		uint64_t texture_bytes;
+		std::map<VkFormat, BakeFormatStats> texture_formats;
+	};
+
+	const BakeStats& get_bake_stats();
+	void bake_stats_reset();
+	void bake_stats_print();
+
 	// ===================================================================================
 	// create
 	// ===================================================================================
@@ -172,11 +402,51 @@ namespace vkc::Assets {
 	// resources inside MaterialData will be acquired by the Asset Manager system
 	IdAssetMaterial create_material(MaterialData& data);
 
+	// largest texture packed with others by `pack_texture_arrays`
+	const uint32_t TEXTURE_ARRAY_MAX_SIZE = 256;
+
+	// moves the textures of the array slots of every material (see `material_uses_texture_arrays`) into
+	// 2D arrays and points the materials to their layers. Textures up to `max_size` texels wide and high
+	// with the same format, size and mip count share an array, one allocation and one descriptor
+	// for all of them: materials that end up with the same textures can share a descriptor set.
+	// Larger textures become arrays of a single layer, in place when nothing else samples them.
+	// Packed textures are released once no other slot refers to them, hot reload of their file
+	// updates their layer as long as the format and size don't change.
+	// Textures already in an array are left as they are, packing again only handles the new ones.
+	// Returns the number of arrays created
+	uint32_t pack_texture_arrays(uint32_t max_size = TEXTURE_ARRAY_MAX_SIZE);
+
+	// ===================================================================================
+	// hot reload
+	// ===================================================================================
+	struct ReloadedAssets {
+		std::vector<IdAssetMesh>    meshes;
+		std::vector<IdAssetTexture> textures;
+	};
+
+	// imports again the assets that came from `path` (textures, meshes of models) and replaces their
+	// data in place, ids don't change. Materials of reloaded models are kept as they are.
+	// The load functions record where assets come from, the asset db stores it.
+	// Appends to `out_reloaded`, returns false if no asset came from `path`
+	bool asset_reload_file(const char* path, ReloadedAssets* out_reloaded);
+
 	// ===================================================================================
 	// serialization
 	// ===================================================================================
-	void asset_db_dump(const char *path);
+	// the asset db is memory mapped on load: vertex, index and pixel data of the loaded
+	// assets point straight into the mapping, which stays alive until `asset_db_unload()`.
+	// With `compress`, large blobs are stored LZ compressed in chunks: on load they are
+	// decompressed on the job pool into memory owned by the db, with the same lifetime.
+	// Off by default, so that mesh and pixel data are used straight from the mapping
+	void asset_db_dump(const char *path, bool compress = false);
 	void asset_db_load(const char *path);
 
+	// releases all non built-in assets, the mappings and decompressed data of the loaded asset dbs
+	void asset_db_unload();
+
+	// previous format (one fread per field, raw structs), only kept as a baseline for benchmarks
+	void asset_db_dump_legacy(const char *path);
+	void asset_db_load_legacy(const char *path);
+
 
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+
+// minimal worker pool for baking and asset loading: jobs are pushed in a single FIFO queue and
+// picked up by `num_threads` workers
+//
+// - a JobCounter tracks a group of jobs, `job_pool_wait` returns once all of them are done
+// - the waiting thread runs queued jobs itself instead of sleeping, so jobs can
+//   submit and wait on other jobs without deadlocking the pool
+// - when the pool is not initialized, jobs run inline on submission (the baker and
+//   `VKRenderer` start it, standalone tools may not)
+namespace vkc::Jobs {
+	struct JobCounter {
+		std::atomic<uint32_t> pending = 0;
+	};
+
+	// `num_threads == 0` uses one worker per hardware thread, minus the calling thread
+	void     job_pool_init(uint32_t num_threads = 0);
+	void     job_pool_shutdown();
+	uint32_t job_pool_get_num_threads();
+
+	void job_pool_submit(JobCounter* counter, std::function<void()> job);
+	void job_pool_wait(JobCounter* counter);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+// offline mip chain generation, for every TexChannelTypes, 8 bit or 32 bit float texels
+//
+// - levels are filtered in linear float RGBA, sRGB color channels are decoded first and
+//   encoded back on output (alpha is always linear)
+// - every level is filtered from the full precision previous one, not from the quantized output
+// - texels are processed as one SSE register each when available, rows are split in jobs on the job pool
+// - negative lobes of the Kaiser filter can ring, results are clamped to [0, 1] (8 bit) or >= 0 (float)
+namespace vkc::Assets {
+	typedef enum : uint8_t {
+		MIP_FILTER_BOX    = 0,	// 2x2 average, fastest
+		MIP_FILTER_KAISER = 1	// Kaiser windowed sinc (width 3, alpha 4), keeps more detail
+	} MipFilter;
+
+	// levels down to 1x1, level 0 included
+	uint32_t texture_get_mip_count(uint32_t width, uint32_t height);
+
+	bool texture_format_is_srgb(VkFormat format);
+
+	// `pixels` is level 0, `channels` interleaved 8 bit (or float when `is_float`) texels.
+	// Returns a malloc'd buffer with all `out_mips` levels tightly packed in the same texel layout,
+	// `out_size` bytes. Level i is max(1, width >> i) x max(1, height >> i)
+	void* texture_generate_mips(
+		const void* pixels,
+		uint32_t width,
+		uint32_t height,
+		TexChannelTypes channels,
+		bool is_float,
+		bool is_srgb,
+		MipFilter filter,
+		uint32_t* out_mips,
+		uint32_t* out_size
+	);
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+// on-disk layout of the asset database
+//
+//   [Header][blob 0][blob 1]...[blob n][Entry 0]...[Entry n][Chunk 0]...[Chunk m]
+//
+// - every blob starts at a multiple of `ALIGNMENT` (from the beginning of the file), so that
+//   vertex, index and pixel data can be used straight from the mapped file
+// - blobs of at least `COMPRESS_MIN_SIZE` bytes can be stored compressed (see LzCodec.hpp), split in
+//   independent chunks of `CHUNK_SIZE` uncompressed bytes so that they decompress in parallel.
+//   Blobs that don't shrink by at least 1/8 stay uncompressed, and mappable in place
+// - the entry and chunk tables are written last, `Header::entries_offset` and `Header::chunks_offset` point to them
+// - entries of an asset always come after the entry of its record (e.g. ENTRY_MESH_VERTICES after ENTRY_MESH)
+// - records are plain data, no pointers
+namespace vkc::Assets::Db {
+	const uint32_t MAGIC     = 0x42444B56; // "VKDB"
+	const uint32_t VERSION   = 11;
+	const uint64_t ALIGNMENT = 64;
+
+	const uint32_t CHUNK_SIZE        = 256 * 1024;
+	const uint64_t COMPRESS_MIN_SIZE = 4 * 1024;
+
+	enum EntryType : uint32_t {
+		ENTRY_MESH            = 0,	// MeshRecord
+		ENTRY_MESH_VERTICES   = 1,	// vertex_count * vertex_data_size bytes
+		ENTRY_MESH_INDICES    = 2,	// index_count * uint32_t (uint16_t with MeshData::FLAG_INDICES_16)
+		ENTRY_TEXTURE         = 3,	// TextureRecord
+		ENTRY_TEXTURE_PIXELS  = 4,	// all mips, tightly packed
+		ENTRY_MATERIAL        = 5,	// MaterialRecord
+		ENTRY_MATERIAL_VIEWS  = 6,	// image_views_count * IdAssetTexture
+		ENTRY_MODEL           = 7,	// ModelRecord
+		ENTRY_MODEL_MESHES    = 8,	// meshes_count * IdAssetMesh
+		ENTRY_MODEL_MATERIALS = 9,	// meshes_count * IdAssetMaterial
+		ENTRY_MESH_MESHLETS   = 10,	// meshlet_count * MeshletData
+		ENTRY_MESH_LODS       = 11,	// lod_count * MeshLodData
+		// where an asset was imported from, for hot reload. Loaders that don't know them skip them
+		ENTRY_TEXTURE_SOURCE  = 12,	// TextureSourceRecord, then the path
+		ENTRY_MODEL_SOURCE    = 13,	// ModelSourceRecord, then the texture base path and the path
+		// node hierarchy, models written without it load as a single identity node
+		ENTRY_MODEL_MESH_NODES      = 14,	// meshes_count * uint32_t
+		ENTRY_MODEL_NODE_PARENTS    = 15,	// nodes_count * uint32_t
+		ENTRY_MODEL_NODE_TRANSFORMS = 16,	// nodes_count * glm::mat4
+		// texture array layers, written for materials packed by `pack_texture_arrays`
+		ENTRY_MATERIAL_LAYERS       = 17,	// image_views_count * uint32_t
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entries_count;
+		uint32_t alignment;
+		uint64_t entries_offset;
+		uint64_t file_size;
+
+		// counters of the asset manager at dump time (mesh, texture, material, model)
+		uint32_t num_assets[4];
+
+		uint64_t chunks_offset;
+		uint32_t chunks_count;
+		uint32_t chunk_size;
+	};
+
+	struct Entry {
+		uint32_t type;
+		uint32_t id;
+		uint64_t offset;	// of the blob, or of its first chunk when compressed
+		uint64_t size;		// uncompressed
+		uint32_t chunks_first;
+		uint32_t chunks_count;	// 0: stored uncompressed at `offset`
+	};
+
+	// `size` bytes at `offset`, `size == raw_size` means stored uncompressed
+	struct Chunk {
+		uint64_t offset;
+		uint32_t size;
+		uint32_t raw_size;
+	};
+
+	struct MeshRecord {
+		uint32_t vertex_count;
+		uint32_t vertex_data_size;
+		uint32_t index_count;
+		uint32_t flags;
+
+		// VertexDataCompact dequantization
+		glm::vec3 position_offset;
+		glm::vec3 position_scale;
+
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		glm::vec3 bounds_center;
+		float     bounds_radius;
+	};
+
+	struct TextureRecord {
+		uint16_t width;
+		uint16_t height;
+		uint8_t  mipmaps;
+		uint8_t  view_type;
+		uint16_t layers;	// 6 for cubemaps, 1 for 2D textures
+		uint32_t format;
+	};
+
+	struct MaterialRecord {
+		uint32_t id_pipeline_config;
+		uint32_t id_render_pass;
+		uint32_t id_pipeline;
+		uint32_t image_views_count;
+		uint32_t flags;		// MaterialData::flags
+	};
+
+	struct ModelRecord {
+		glm::mat4 transform;
+		uint32_t  meshes_count;
+		uint32_t  nodes_count;		// 0 in databases written before the node hierarchy
+		glm::vec3 bounds_min;
+		glm::vec3 bounds_max;
+		glm::vec3 bounds_center;
+		float     bounds_radius;
+	};
+
+	// import options of a texture. The source file path follows, up to the end of the blob (no terminator)
+	struct TextureSourceRecord {
+		uint32_t format;
+		uint8_t  view_type;
+		uint8_t  flip_vertical;
+		uint8_t  create_mipmaps;
+		uint8_t  compression;
+		uint32_t layer;		// in the texture of the entry when it's an array
+	};
+
+	// import options of a model. `base_path_textures_length` bytes of texture base path follow,
+	// then the source file path up to the end of the blob (no terminators)
+	struct ModelSourceRecord {
+		uint32_t environment_specular;
+		uint32_t environment_irradiance;
+		uint32_t environment_brdf_lut;
+		uint32_t id_pipeline_config;
+		uint32_t lod_count;
+		uint8_t  optimize_meshes;
+		uint8_t  compact_vertices;
+		uint8_t  texture_compression;
+		uint8_t  texture_arrays;
+		uint32_t base_path_textures_length;
+	};
+
+	static_assert(sizeof(Header)         == 64, "asset db header layout changed, bump VERSION");
+	static_assert(sizeof(Entry)          == 32, "asset db entry layout changed, bump VERSION");
+	static_assert(sizeof(Chunk)          == 16, "asset db chunk layout changed, bump VERSION");
+	static_assert(sizeof(MeshRecord)     == 80, "asset db mesh record layout changed, bump VERSION");
+	static_assert(sizeof(TextureRecord)  == 12, "asset db texture record layout changed, bump VERSION");
+	static_assert(sizeof(MaterialRecord) == 20, "asset db material record layout changed, bump VERSION");
+	static_assert(sizeof(ModelRecord)    == 112, "asset db model record layout changed, bump VERSION");
+	static_assert(sizeof(TextureSourceRecord) == 12, "asset db texture source record layout changed, bump VERSION");
+	static_assert(sizeof(ModelSourceRecord)   == 28, "asset db model source record layout changed, bump VERSION");
+}
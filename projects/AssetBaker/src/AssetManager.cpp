@@ -1,6 +1,21 @@
 #include "AssetManager.hpp"
+#include "AssetDatabase.hpp"
+#include "AssetStorage.hpp"
+#include "BakeCache.hpp"
+#include "EnvironmentBaker.hpp"
+#include "FileMapping.hpp"
+#include "JobPool.hpp"
+#include "LzCodec.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MipGenerator.hpp"
+#include "TextureCompressor.hpp"
 #include "dds.hpp"
 
+extern "C" {
+    #include <cc_hash.h>
+}
+
 // assimp
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -9,20 +24,25 @@
 // stb_image
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
-#define STB_IMAGE_RESIZE_IMPLEMENTATION
-#include <stb_image_resize2.h>
 
 #include <glm/glm.hpp>
 
 #include <map>
+#include <mutex>
+#include <set>
+#include <chrono>
 #include <filesystem> // for getting file extensions
 
 namespace vkc::Assets {
     // private creation/loading API, to allow creating assets with specific IDs
-    // used for built-in and debug aasets, until we have multime asset storages
+    // used for built-in and debug assets (reserved id range) and the asset db
     void create_mesh(const IdAssetMesh id, const MeshData& data);
     void create_material(const IdAssetMaterial id, const MaterialData& data);
     IdAssetTexture load_texture(const IdAssetTexture id, const char* path, TexViewTypes viewType = TEX_VIEW_TYPE_2D, VkFormat format = VK_FORMAT_R8G8B8A8_SRGB, bool flip_vertical=false, bool create_mipmaps=false);
+    // only decodes into `data`, does not touch the asset storage. Safe to call from the job pool
+    bool decode_texture(TextureData* data, const char* path, TexViewTypes viewType, VkFormat format, bool flip_vertical, bool create_mipmaps, TexCompression compression = TEX_COMPRESSION_NONE);
+    // prefiltered specular and SH irradiance textures of an equirectangular HDR file, same rules as `decode_texture`
+    bool decode_environment(TextureData* out_specular, TextureData* out_irradiance, const char* path, bool flip_vertical);
 
     namespace BuiltinPrimitives {
         //// filled cube with triangle topology
@@ -111,15 +131,52 @@ namespace vkc::Assets {
         };
     }
 
-    uint32_t num_mesh_assets = 0;
-    uint32_t num_texture_assets = 0;
-    uint32_t num_material_assets = 0;
-    uint32_t num_model_assets = 0;
-
-    std::map<IdAssetMesh, MeshData> mesh_data;
-    std::map<IdAssetTexture, TextureData> texture_data;
-    std::map<IdAssetMaterial, MaterialData> material_data;
-    std::map<IdAssetModel, ModelData> model_data;
+    AssetStorage<IdAssetMesh, MeshData> mesh_data;
+    AssetStorage<IdAssetTexture, TextureData> texture_data;
+    AssetStorage<IdAssetMaterial, MaterialData> material_data;
+    AssetStorage<IdAssetModel, ModelData> model_data;
+
+    // texture cache, see `texture_cache_find`
+    struct TextureCacheEntry {
+        std::string    key; // full key, to tell hash collisions apart
+        IdAssetTexture id;
+    };
+
+    struct TextureCacheStats {
+        uint32_t num_hits;
+        uint32_t num_misses;
+        uint32_t num_collisions;
+        uint64_t bytes_saved;
+    };
+
+    std::map<uint64_t, TextureCacheEntry> texture_cache;
+    TextureCacheStats texture_cache_stats;
+    // models imported in parallel look textures up from the job pool
+    std::mutex texture_cache_mutex;
+
+    BakeStats bake_stats;
+
+    // where assets were imported from and how, see `asset_reload_file`
+    struct TextureSource {
+        IdAssetTexture id;
+        TexViewTypes   view_type;
+        VkFormat       format;
+        bool           flip_vertical;
+        bool           create_mipmaps;
+        TexCompression compression;
+        uint32_t       layer;    // of `id` once packed in an array by `pack_texture_arrays`
+    };
+
+    struct ModelSource {
+        IdAssetModel       id;
+        std::string         base_path_textures;
+        EnvironmentTextures environment;
+        ModelImportOptions  options;
+    };
+
+    // keyed by normalized path, a file can be imported more than once with different options
+    std::map<std::string, std::vector<TextureSource>> texture_sources;
+    std::map<std::string, std::vector<ModelSource>>   model_sources;
 
     void asset_manager_init() {
         // create assets on CPU
@@ -134,31 +191,63 @@ namespace vkc::Assets {
     }
 
     uint32_t get_num_mesh_assets() {
-        return num_mesh_assets;
+        return storage_size(mesh_data);
     }
 
     uint32_t get_num_texture_assets() {
-        return num_texture_assets;
+        return storage_size(texture_data);
     }
 
     uint32_t get_num_material_assets() {
-        return num_material_assets;
+        return storage_size(material_data);
     }
 
     MeshData& get_mesh_data(IdAssetMesh id) {
-        return mesh_data[id];
+        return storage_get(mesh_data, id);
     }
 
     TextureData& get_texture_data(IdAssetTexture id) {
-        return texture_data[id];
+        return storage_get(texture_data, id);
     }
 
     MaterialData& get_material_data(IdAssetMaterial id) {
-        return material_data[id];
+        return storage_get(material_data, id);
     }
 
     ModelData& get_model_data(IdAssetModel id) {
-        return model_data[id];
+        return storage_get(model_data, id);
+    }
+
+    bool is_mesh_valid(IdAssetMesh id) {
+        return storage_contains(mesh_data, id);
+    }
+
+    bool is_texture_valid(IdAssetTexture id) {
+        return storage_contains(texture_data, id);
+    }
+
+    bool is_material_valid(IdAssetMaterial id) {
+        return storage_contains(material_data, id);
+    }
+
+    bool is_model_valid(IdAssetModel id) {
+        return storage_contains(model_data, id);
+    }
+
+    AssetRange<IdAssetMesh, MeshData> get_mesh_assets() {
+        return storage_range(mesh_data);
+    }
+
+    AssetRange<IdAssetTexture, TextureData> get_texture_assets() {
+        return storage_range(texture_data);
+    }
+
+    AssetRange<IdAssetMaterial, MaterialData> get_material_assets() {
+        return storage_range(material_data);
+    }
+
+    AssetRange<IdAssetModel, ModelData> get_model_assets() {
+        return storage_range(model_data);
     }
 
     void debug_print_material_info(const aiMaterial& ai_material_data) {
@@ -210,10 +299,157 @@ namespace vkc::Assets {
         }
     }
 
-    IdAssetTexture load_tex(const aiTextureType type, const aiMaterial& mat, const VkFormat format, IdAssetTexture tex_fallback, const std::string base_path) {
+    // ===================================================================================
+    // texture cache
+    // ===================================================================================
+    // same string for every spelling of a path ("res/./a.png", "res\\a.png", ...)
+    std::string normalize_path(const char* path) {
+        std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+        std::replace(normalized.begin(), normalized.end(), '\\', '/');
+#ifdef _WIN32
+        // case insensitive file system
+        std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return (char)tolower(c); });
+#endif
+        return normalized;
+    }
+
+    // keyed by the normalized path plus every option that changes the decoded result
+    std::string texture_cache_make_key(const char* path, TexViewTypes viewType, VkFormat format, bool flip_vertical, bool create_mipmaps, TexCompression compression = TEX_COMPRESSION_NONE) {
+        std::string key = normalize_path(path);
+
+        char options[64];
+        snprintf(options, sizeof(options), "|%d|%d|%d|%d|%d", viewType, format, flip_vertical, create_mipmaps, compression);
+        return key + options;
+    }
+
+    // returns true and the id of the cached texture on hit
+    bool texture_cache_find(const std::string& key, IdAssetTexture* out_id) {
+        uint64_t hash = Lookup3(key.c_str(), key.size());
+        std::lock_guard<std::mutex> lock(texture_cache_mutex);
+
+        auto it = texture_cache.find(hash);
+        if (it == texture_cache.end()) {
+            ++texture_cache_stats.num_misses;
+            return false;
+        }
+
+        if (it->second.key != key) {
+            CC_LOG(CC_WARNING, "[texture cache] hash collision between %s and %s", key.c_str(), it->second.key.c_str());
+            ++texture_cache_stats.num_collisions;
+            ++texture_cache_stats.num_misses;
+            return false;
+        }
+
+        ++texture_cache_stats.num_hits;
+        texture_cache_stats.bytes_saved += storage_get(texture_data, it->second.id).data.size();
+        *out_id = it->second.id;
+        return true;
+    }
+
+    void texture_cache_add(const std::string& key, IdAssetTexture id) {
+        uint64_t hash = Lookup3(key.c_str(), key.size());
+
+        // on collision the first texture keeps the slot, the other one is simply never cached
+        std::lock_guard<std::mutex> lock(texture_cache_mutex);
+        if (!texture_cache.contains(hash))
+            texture_cache[hash] = { key, id };
+    }
+
+    void texture_cache_clear() {
+        texture_cache.clear();
+    }
+
+    // forgets a released texture, the next load of its file decodes it again
+    void texture_cache_remove(IdAssetTexture id) {
+        std::lock_guard<std::mutex> lock(texture_cache_mutex);
+        std::erase_if(texture_cache, [id](const auto& item) { return item.second.id == id; });
+    }
+
+    // ===================================================================================
+    // sources
+    // ===================================================================================
+    void texture_source_add(const char* path, const TextureSource& source) {
+        texture_sources[normalize_path(path)].push_back(source);
+    }
+
+    void model_source_add(const char* path, const ModelSource& source) {
+        model_sources[normalize_path(path)].push_back(source);
+    }
+
+    void texture_cache_print_stats() {
+        CC_LOG(
+            CC_INFO,
+            "[texture cache] %d hits, %d misses, %d collisions, %.2fMB of decodes saved",
+            texture_cache_stats.num_hits,
+            texture_cache_stats.num_misses,
+            texture_cache_stats.num_collisions,
+            texture_cache_stats.bytes_saved / (1024.0 * 1024.0)
+        );
+    }
+
+    // ===================================================================================
+    // bake stats
+    // ===================================================================================
+    static uint64_t get_file_size(const char* path) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(path, error);
+        return error ? 0 : size;
+    }
+
+    // a texture decoded and stored, reuses of the texture cache are not counted
+    static void bake_stats_add_texture(const char* path, const TextureData& data) {
+        BakeFormatStats& format_stats = bake_stats.texture_formats[data.format];
+        format_stats.count += 1;
+        format_stats.bytes += data.data.size();
+
+        bake_stats.textures_count += 1;
+        bake_stats.texture_bytes  += data.data.size();
+        bake_stats.source_bytes   += get_file_size(path);
+    }
+
+    const BakeStats& get_bake_stats() {
+        return bake_stats;
+    }
+
+    void bake_stats_reset() {
+        bake_stats = { };
+    }
+
+    void bake_stats_print() {
+        CC_LOG(
+            CC_IMPORTANT,
+            "[bake] %d models, %d meshes, %d textures, %.2fMB of source files",
+            bake_stats.models_count, bake_stats.meshes_count, bake_stats.textures_count,
+            bake_stats.source_bytes / (1024.0 * 1024.0)
+        );
+        CC_LOG(
+            CC_INFO,
+            "[bake] time per stage (summed over models): import %.2fms, meshes %.2fms, textures %.2fms, store %.2fms",
+            bake_stats.time_import_ms, bake_stats.time_meshes_ms, bake_stats.time_textures_ms, bake_stats.time_store_ms
+        );
+        CC_LOG(
+            CC_INFO,
+            "[bake] vertex data %.2fMB -> %.2fMB, index data %.2fMB, texture data %.2fMB",
+            bake_stats.vertex_bytes_imported / (1024.0 * 1024.0),
+            bake_stats.vertex_bytes / (1024.0 * 1024.0),
+            bake_stats.index_bytes / (1024.0 * 1024.0),
+            bake_stats.texture_bytes / (1024.0 * 1024.0)
+        );
+        for (const auto& kp : bake_stats.texture_formats) {
+            CC_LOG(
+                CC_INFO,
+                "[bake] %-36s %4d textures %10.2fMB",
+                string_VkFormat(kp.first), kp.second.count, kp.second.bytes / (1024.0 * 1024.0)
+            );
+        }
+        texture_cache_print_stats();
+    }
+
+    // returns false if the material has no texture of the given type
+    bool get_tex_path(const aiTextureType type, const aiMaterial& mat, const std::string& base_path, std::string* out_path) {
         aiString path;
         if (mat.GetTextureCount(type) == 0)
-            return tex_fallback;
+            return false;
         mat.GetTexture(type, 0, &path);
 
 
@@ -221,41 +457,248 @@ namespace vkc::Assets {
         std::string TMP(path.C_Str());
         std::replace(TMP.begin(), TMP.end(), '\\', '/');
 
-        path = base_path + TMP;
-        return vkc::Assets::load_texture(path.C_Str(), vkc::Assets::TEX_VIEW_TYPE_2D, format, true);
+        *out_path = base_path + TMP;
+        return true;
+    }
+
+    static void free_mesh_data(MeshData& data) {
+        if (data.flags & MeshData::FLAG_MAPPED)
+            return;
+        free(data.vertex_data);
+        free(data.index_data);
+        free(data.meshlets);
+        free(data.lods);
+    }
+
+    // pixels of textures loaded from an asset db point into `db_mappings`, released with the db.
+    // FLAG_FILE textures have none in memory
+    static void free_texture_data(TextureData& data) {
+        if (data.flags & (TextureData::FLAG_MAPPED | TextureData::FLAG_FILE))
+            return;
+        free(data.data.data());
+    }
+
+    // frees a texture and forgets its id in the texture cache and the sources
+    static void release_texture(IdAssetTexture id) {
+        free_texture_data(storage_get(texture_data, id));
+        storage_remove(texture_data, id);
+        texture_cache_remove(id);
+        for (auto it = texture_sources.begin(); it != texture_sources.end();) {
+            std::erase_if(it->second, [id](const TextureSource& source) { return source.id == id; });
+            it = it->second.empty() ? texture_sources.erase(it) : std::next(it);
+        }
+    }
+
+    // arrays of a model, a single identity node with every mesh on it until filled
+    static ModelData alloc_model_data(uint32_t meshes_count, uint32_t nodes_count) {
+        ModelData data;
+        data.transform       = glm::mat4(1.0f);
+        data.meshes_count    = meshes_count;
+        data.meshes          = new IdAssetMesh[meshes_count];
+        data.meshes_material = new IdAssetMaterial[meshes_count];
+        data.meshes_node     = new uint32_t[meshes_count]();
+        data.nodes_count     = glm::max(nodes_count, 1u);
+        data.nodes_parent    = new uint32_t[data.nodes_count];
+        data.nodes_transform = new glm::mat4[data.nodes_count];
+        data.nodes_parent[0]    = NODE_NO_PARENT;
+        data.nodes_transform[0] = glm::mat4(1.0f);
+        data.bounds_min    = glm::vec3(0.0f);
+        data.bounds_max    = glm::vec3(0.0f);
+        data.bounds_center = glm::vec3(0.0f);
+        data.bounds_radius = 0.0f;
+        return data;
     }
 
+    static void free_model_data(ModelData& data) {
+        delete[] data.meshes;
+        delete[] data.meshes_material;
+        delete[] data.meshes_node;
+        delete[] data.nodes_parent;
+        delete[] data.nodes_transform;
+    }
+
+    // assimp space to ours, vertices are imported as (x, -z, y)
+    static glm::mat4 convert_node_transform(const aiMatrix4x4& ai_transform) {
+        const glm::mat4 AXES = glm::mat4(
+            1.0f,  0.0f, 0.0f, 0.0f,
+            0.0f,  0.0f, 1.0f, 0.0f,
+            0.0f, -1.0f, 0.0f, 0.0f,
+            0.0f,  0.0f, 0.0f, 1.0f
+        );
+
+        // assimp is row major
+        glm::mat4 transform;
+        for (int row = 0; row < 4; ++row)
+            for (int col = 0; col < 4; ++col)
+                transform[col][row] = ai_transform[row][col];
+
+        return AXES * transform * glm::transpose(AXES);
+    }
+
+    // depth first, parents before children and every subtree contiguous
+    static void flatten_nodes(const aiNode* node, uint32_t parent, BakedModel* baked) {
+        uint32_t index = (uint32_t)baked->nodes_parent.size();
+        baked->nodes_parent.push_back(parent);
+        baked->nodes_transform.push_back(convert_node_transform(node->mTransformation));
+
+        for (uint32_t i = 0; i < node->mNumMeshes; ++i) {
+            baked->instances_mesh.push_back(node->mMeshes[i]);
+            baked->instances_node.push_back(index);
+        }
+
+        for (uint32_t i = 0; i < node->mNumChildren; ++i)
+            flatten_nodes(node->mChildren[i], index, baked);
+    }
+
+    // mesh bounds placed by the world transform of their node, the meshes must be stored already
+    static void model_compute_bounds(ModelData* model) {
+        // parents come first, a single forward pass
+        std::vector<glm::mat4> world(model->nodes_count);
+        for (uint32_t i = 0; i < model->nodes_count; ++i) {
+            uint32_t parent = model->nodes_parent[i];
+            world[i] = parent == NODE_NO_PARENT ? model->nodes_transform[i] : world[parent] * model->nodes_transform[i];
+        }
+
+        bool is_empty = true;
+        for (uint32_t i = 0; i < model->meshes_count; ++i) {
+            const MeshData& mesh = storage_get(mesh_data, model->meshes[i]);
+            if (mesh.vertex_count == 0)
+                continue;
+
+            const glm::mat4& transform = world[model->meshes_node[i]];
+            for (uint32_t corner = 0; corner < 8; ++corner) {
+                glm::vec3 p = glm::vec3(
+                    (corner & 1) ? mesh.bounds_max.x : mesh.bounds_min.x,
+                    (corner & 2) ? mesh.bounds_max.y : mesh.bounds_min.y,
+                    (corner & 4) ? mesh.bounds_max.z : mesh.bounds_min.z
+                );
+                p = glm::vec3(transform * glm::vec4(p, 1.0f));
+                model->bounds_min = is_empty ? p : glm::min(model->bounds_min, p);
+                model->bounds_max = is_empty ? p : glm::max(model->bounds_max, p);
+                is_empty = false;
+            }
+        }
+        model->bounds_center = (model->bounds_min + model->bounds_max) * 0.5f;
+
+        // mesh spheres scaled by the largest axis of their node
+        model->bounds_radius = 0.0f;
+        for (uint32_t i = 0; i < model->meshes_count; ++i) {
+            const MeshData& mesh = storage_get(mesh_data, model->meshes[i]);
+            if (mesh.vertex_count == 0)
+                continue;
+
+            const glm::mat4& transform = world[model->meshes_node[i]];
+            float scale_max = glm::sqrt(glm::max(
+                glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])), glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+                glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))
+            ));
+            glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.bounds_center, 1.0f));
+            model->bounds_radius = glm::max(model->bounds_radius, glm::length(center - model->bounds_center) + mesh.bounds_radius * scale_max);
+        }
+    }
+
+    // texture slot of a material, decoded on the job pool
+    struct TextureRequest {
+        std::string    path;
+        std::string    cache_key;
+        VkFormat       format;
+        IdAssetTexture tex_fallback;
+        bool           has_path;
+        bool           is_cached;    // already loaded before this model, `id_cached` is valid
+        IdAssetTexture id_cached;
+        int32_t        idx_source;   // earlier request of this model with the same key, or -1
+        bool           is_decoded;
+        TextureData    data;
+    };
+
+    const uint32_t MODEL_TEXTURES_PER_MATERIAL = 3;
+
+    // a model between `import_model_process`, which only touches data of its own and runs for several
+    // models in parallel, and `import_model_store`, which adds its assets to the storages in order
+    struct ModelImport {
+        std::string         path;
+        std::string         base_path_textures;
+        EnvironmentTextures environment;
+        ModelImportOptions  options;
+
+        // processed meshes and texture paths, from the bake cache when the file and the options didn't change
+        BakedModel                     baked;
+        ModelData                      model;
+        std::vector<TextureRequest>    texture_requests;
+        std::vector<MeshOptimizeStats> meshes_stats;
+        double                         time_import_ms;
+        double                         time_meshes_ms;
+        double                         time_textures_ms;
+
+        // created by `import_model_store`, textures found in the texture cache excluded
+        std::vector<IdAssetTexture>  new_textures;
+        std::vector<IdAssetMaterial> new_materials;
+    };
+
     // load all mehses and materials from OBJ or FBX file
     // at the moment, each mesh will have its own material
-    uint32_t load_model(
-        const char* path,
-        const char* base_path_textures,
-        IdAssetTexture TMP_tex_environment_id
-    ) {
+    static void import_model_process(ModelImport* import) {
+        const char* path = import->path.c_str();
+        const char* base_path_textures = import->base_path_textures.c_str();
+        const ModelImportOptions& options = import->options;
         CC_LOG(CC_IMPORTANT, "Loading model %s...", path);
-        uint32_t model_idx = num_model_assets++;
-        ModelData new_model_data;
+
+        const uint32_t TEXTURES_PER_MATERIAL = MODEL_TEXTURES_PER_MATERIAL;
+
+        BakedModel& baked = import->baked;
+        uint64_t bake_key = 0;
+        if (bake_cache_is_enabled()) {
+            char key_options[512];
+            snprintf(
+                key_options, sizeof(key_options), "model|%s|%d|%d|%d",
+                base_path_textures, options.optimize_meshes, options.lod_count, options.compact_vertices
+            );
+            uint64_t content_hash = bake_cache_hash_file(path);
+            if (content_hash != 0)
+                bake_key = bake_cache_make_key(content_hash, key_options);
+        }
+        bool is_baked = bake_key != 0 && bake_cache_load_model(bake_key, &baked);
+
+        auto time_start = std::chrono::high_resolution_clock::now();
 
         // Read the file using Assimp importer
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(
-            path,
-            aiProcess_CalcTangentSpace
-            | aiProcess_Triangulate
-            | aiProcess_SortByPType
-            | aiProcess_MakeLeftHanded
-            | aiProcess_FlipWindingOrder
-            | aiProcess_FlipUVs
-        );
+        const aiScene* scene = nullptr;
+        if (is_baked)
+            CC_LOG(CC_INFO, "bake cache hit, meshes: %d, materials: %d", (int)baked.meshes.size(), baked.materials_count);
+        else {
+            scene = importer.ReadFile(
+                path,
+                aiProcess_CalcTangentSpace
+                | aiProcess_Triangulate
+                | aiProcess_SortByPType
+                | aiProcess_MakeLeftHanded
+                | aiProcess_FlipWindingOrder
+                | aiProcess_FlipUVs
+            );
 
-        CC_ASSERT(scene, "[assimp] could not load %s", path);
-        CC_LOG(CC_INFO, "assimp scene loaded");
-        CC_LOG(CC_INFO, "materials: %d", scene->mNumMaterials);
-        CC_LOG(CC_INFO, "meshes: %d", scene->mNumMeshes);
+            CC_ASSERT(scene, "[assimp] could not load %s", path);
+            CC_LOG(CC_INFO, "assimp scene loaded");
+            CC_LOG(CC_INFO, "materials: %d", scene->mNumMaterials);
+            CC_LOG(CC_INFO, "meshes: %d", scene->mNumMeshes);
 
-        // create material
-        std::map<unsigned int, IdAssetMaterial> material_map;
-        for(int i = 0; i < scene->mNumMaterials; ++i) {
+            baked.materials_count = scene->mNumMaterials;
+            baked.texture_paths.resize(scene->mNumMaterials * TEXTURES_PER_MATERIAL);
+        }
+        auto time_imported = std::chrono::high_resolution_clock::now();
+
+        // had-hoc semantics for bistrot model (diffuse, arm, normal)
+        const struct {
+            aiTextureType  type;
+            VkFormat       format;
+            IdAssetTexture tex_fallback;
+        } texture_slots[TEXTURES_PER_MATERIAL] = {
+            { aiTextureType_DIFFUSE,  VK_FORMAT_R8G8B8A8_SRGB, BuiltinPrimitives::IDX_TEX_WHITE     },
+            { aiTextureType_SPECULAR, VK_FORMAT_R8G8B8A8_SRGB, BuiltinPrimitives::IDX_TEX_BLACK     },
+            { aiTextureType_NORMALS,  VK_FORMAT_R8G8B8_UNORM,  BuiltinPrimitives::IDX_TEX_BLUE_NORM },
+        };
+
+        for(int i = 0; !is_baked && i < scene->mNumMaterials; ++i) {
             // load textures
             const aiMaterial& ai_material_data = *scene->mMaterials[i];
 
@@ -285,57 +728,118 @@ namespace vkc::Assets {
             // TODO hardcoded textures
             std::string base_path(base_path_textures);
 
-            
-            IdAssetTexture tex_idx_arm;
-            IdAssetTexture tex_idx_diffuse;
-            IdAssetTexture tex_idx_normal;
-
             //// had-hoc semantics for models taken from ituGL
             //{
-            //    tex_idx_arm     = load_tex(aiTextureType_SHININESS, ai_material_data, vkc::Assets::TEX_CHANNELS_RGB_A, TEX_FORMAT_RGB_A, BuiltinPrimitives::IDX_TEX_BLACK, base_path);
-            //    tex_idx_diffuse = load_tex(aiTextureType_DIFFUSE, ai_material_data, vkc::Assets::TEX_CHANNELS_RGB_A, TEX_FORMAT_RGB_A, BuiltinPrimitives::IDX_TEX_WHITE, base_path);
-            //    tex_idx_normal  = load_tex(aiTextureType_NORMALS, ai_material_data, vkc::Assets::TEX_CHANNELS_RGB, TEX_FORMAT_NORM, BuiltinPrimitives::IDX_TEX_BLUE_NORM, base_path);
+            //    { aiTextureType_SHININESS, TEX_FORMAT_RGB_A, BuiltinPrimitives::IDX_TEX_BLACK     },
+            //    { aiTextureType_DIFFUSE,   TEX_FORMAT_RGB_A, BuiltinPrimitives::IDX_TEX_WHITE     },
+            //    { aiTextureType_NORMALS,   TEX_FORMAT_NORM,  BuiltinPrimitives::IDX_TEX_BLUE_NORM },
             //}
 
-            // had-hoc semantics for bistrot model
-            {
-                tex_idx_diffuse = load_tex(aiTextureType_DIFFUSE,  ai_material_data, VK_FORMAT_R8G8B8A8_SRGB, BuiltinPrimitives::IDX_TEX_WHITE,     base_path);
-                tex_idx_arm     = load_tex(aiTextureType_SPECULAR, ai_material_data, VK_FORMAT_R8G8B8A8_SRGB, BuiltinPrimitives::IDX_TEX_BLACK,     base_path);
-                tex_idx_normal  = load_tex(aiTextureType_NORMALS,  ai_material_data, VK_FORMAT_R8G8B8_UNORM,  BuiltinPrimitives::IDX_TEX_BLUE_NORM, base_path);
+            for (uint32_t j = 0; j < TEXTURES_PER_MATERIAL; ++j) {
+                std::string* texture_path = &baked.texture_paths[i * TEXTURES_PER_MATERIAL + j];
+                if (!get_tex_path(texture_slots[j].type, ai_material_data, base_path, texture_path))
+                    texture_path->clear();
             }
+        }
 
-            auto mat = (MaterialData) {
-                .id_pipeline_config = 1,
-                .id_render_pass = 0,
-                .id_pipeline = 0,
-                .uniform_data_material = nullptr,
-                .image_views = std::vector<IdAssetTexture> {
-                    tex_idx_diffuse,
-                    tex_idx_arm,
-                    tex_idx_normal,
-                    TMP_tex_environment_id,
+        // textures are decoded on the job pool while the meshes are converted on this thread.
+        // Texture ids are only assigned once all decodes are done, in material order, so that
+        // they are the same we would get by loading serially
+        std::vector<TextureRequest>& texture_requests = import->texture_requests;
+        texture_requests.resize(baked.materials_count * TEXTURES_PER_MATERIAL);
+        std::map<std::string, int32_t> texture_requests_pending;    // cache key -> first request
+        Jobs::JobCounter texture_jobs;
+
+        for (uint32_t i = 0; i < baked.materials_count; ++i) {
+            for (uint32_t j = 0; j < TEXTURES_PER_MATERIAL; ++j) {
+                // `texture_requests` is never resized from here on, pointers stay valid for the jobs
+                TextureRequest* request = &texture_requests[i * TEXTURES_PER_MATERIAL + j];
+                request->path         = baked.texture_paths[i * TEXTURES_PER_MATERIAL + j];
+                request->format       = texture_slots[j].format;
+                request->tex_fallback = texture_slots[j].tex_fallback;
+                request->has_path     = !request->path.empty();
+                request->is_cached    = false;
+                request->idx_source   = -1;
+                request->is_decoded   = false;
+
+                if (!request->has_path)
+                    continue;
+
+                // same file and options as a texture loaded before, or as an earlier slot of this model
+                request->cache_key = texture_cache_make_key(request->path.c_str(), TEX_VIEW_TYPE_2D, request->format, true, false, options.texture_compression);
+                if (texture_cache_find(request->cache_key, &request->id_cached)) {
+                    request->is_cached = true;
+                    continue;
                 }
-            };
-            // TODO hardcoded PBR material
-            auto tmp = create_material(mat);
-            CC_LOG(CC_VERBOSE, "loading materials %d/%d", i+1, scene->mNumMaterials);
-            material_map[i] = tmp;
+
+                auto it_pending = texture_requests_pending.find(request->cache_key);
+                if (it_pending != texture_requests_pending.end()) {
+                    request->idx_source = it_pending->second;
+                    continue;
+                }
+                texture_requests_pending[request->cache_key] = i * TEXTURES_PER_MATERIAL + j;
+
+                Jobs::job_pool_submit(&texture_jobs, [request, compression = options.texture_compression]() {
+                    request->is_decoded = decode_texture(
+                        &request->data,
+                        request->path.c_str(),
+                        TEX_VIEW_TYPE_2D,
+                        request->format,
+                        true,
+                        false,
+                        compression
+                    );
+                });
+            }
         }
 
-        print_fourcc_count();
+        if (!is_baked) {
+            baked.meshes.resize(scene->mNumMeshes);
+            baked.meshes_material.resize(scene->mNumMeshes);
+            baked.imported_vertex_counts.resize(scene->mNumMeshes);
+            for(int i = 0; i < scene->mNumMeshes; ++i) {
+                baked.meshes_material[i]        = scene->mMeshes[i]->mMaterialIndex;
+                baked.imported_vertex_counts[i] = scene->mMeshes[i]->mNumVertices;
+            }
+
+            flatten_nodes(scene->mRootNode, NODE_NO_PARENT, &baked);
 
-        new_model_data.meshes_count = scene->mNumMeshes;
-        new_model_data.meshes = new IdAssetMesh[scene->mNumMeshes];
-        new_model_data.meshes_material = new IdAssetMesh[scene->mNumMeshes];
-        for(int i = 0; i < scene->mNumMeshes; ++i) {
-            IdAssetMesh mesh_idx = num_mesh_assets++;
-            MeshData new_submesh_data { };
+            // meshes no node references are still drawn, at the root
+            std::vector<bool> is_instanced(scene->mNumMeshes, false);
+            for (uint32_t mesh : baked.instances_mesh)
+                is_instanced[mesh] = true;
+            for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
+                if (!is_instanced[i]) {
+                    baked.instances_mesh.push_back(i);
+                    baked.instances_node.push_back(0);
+                }
+            }
+            CC_LOG(CC_INFO, "nodes: %d, mesh instances: %d", (int)baked.nodes_parent.size(), (int)baked.instances_mesh.size());
+        }
+        uint32_t meshes_count = (uint32_t)baked.meshes.size();
+        uint32_t instances_count = (uint32_t)baked.instances_mesh.size();
+
+        ModelData& new_model_data = import->model;
+        new_model_data = alloc_model_data(instances_count, (uint32_t)baked.nodes_parent.size());
+        std::copy(baked.nodes_parent.begin(),    baked.nodes_parent.end(),    new_model_data.nodes_parent);
+        std::copy(baked.nodes_transform.begin(), baked.nodes_transform.end(), new_model_data.nodes_transform);
+        std::copy(baked.instances_node.begin(),  baked.instances_node.end(),  new_model_data.meshes_node);
+
+        // meshes are optimized on the job pool as soon as they are converted,
+        // and stored once all jobs are done
+        std::vector<MeshData>& submeshes = baked.meshes;
+        std::vector<MeshOptimizeStats>& submeshes_stats = import->meshes_stats;
+        submeshes_stats.resize(meshes_count);
+        Jobs::JobCounter mesh_jobs;
+
+        for(int i = 0; !is_baked && i < scene->mNumMeshes; ++i) {
+            MeshData& new_submesh_data = submeshes[i];
             const aiMesh& ai_mesh_data = *scene->mMeshes[i];
 
             uint64_t stride_uv = sizeof(*ai_mesh_data.mTextureCoords[0]);
 
             new_submesh_data.vertex_data_size = sizeof(VertexData);
-            new_submesh_data.vertex_data = new VertexData[ai_mesh_data.mNumVertices];
+            new_submesh_data.vertex_data = malloc(sizeof(VertexData) * ai_mesh_data.mNumVertices);
             new_submesh_data.vertex_count = ai_mesh_data.mNumVertices;
             VertexData* p = (VertexData*)new_submesh_data.vertex_data;
             for(int j = 0; j < ai_mesh_data.mNumVertices; ++j) {
@@ -372,112 +876,1591 @@ namespace vkc::Assets {
             uint32_t num_indices = ai_mesh_data.mNumFaces * 3;
 
             // allocate worst case scenario
-            new_submesh_data.index_data = (uint32_t*)malloc(sizeof(uint32_t) * num_indices);
+            uint32_t* index_data = (uint32_t*)malloc(sizeof(uint32_t) * num_indices);
+            new_submesh_data.index_data = index_data;
             new_submesh_data.index_count = num_indices;
             uint32_t idx = 0;
             for(int j = 0; j < ai_mesh_data.mNumFaces; ++j) {
-                new_submesh_data.index_data[idx + 0] = ai_mesh_data.mFaces[j].mIndices[0];
-                new_submesh_data.index_data[idx + 1] = ai_mesh_data.mFaces[j].mIndices[1];
-                new_submesh_data.index_data[idx + 2] = ai_mesh_data.mFaces[j].mIndices[2];
+                index_data[idx + 0] = ai_mesh_data.mFaces[j].mIndices[0];
+                index_data[idx + 1] = ai_mesh_data.mFaces[j].mIndices[1];
+                index_data[idx + 2] = ai_mesh_data.mFaces[j].mIndices[2];
 
                 idx += 3;
             }
 
-           mesh_data[mesh_idx] = new_submesh_data;
-           new_model_data.meshes[i] = mesh_idx;
-           new_model_data.meshes_material[i] = material_map[ai_mesh_data.mMaterialIndex];
+            // SortByPType leaves points and lines in their own meshes, only triangle lists are optimized
+            bool is_optimized = options.optimize_meshes && ai_mesh_data.mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+            {
+                MeshData* submesh = &new_submesh_data;
+                MeshOptimizeStats* submesh_stats = &submeshes_stats[i];
+                bool is_compacted = options.compact_vertices;
+                bool is_triangles = ai_mesh_data.mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+                uint32_t lod_count = options.lod_count;
+                Jobs::job_pool_submit(&mesh_jobs, [submesh, submesh_stats, is_optimized, is_compacted, is_triangles, lod_count]() {
+                    if (is_optimized)
+                        *submesh_stats = mesh_optimize(submesh);
+                    // on the final triangle order, before positions are quantized
+                    mesh_compute_bounds(submesh);
+                    if (is_triangles) {
+                        mesh_build_meshlets(submesh);
+                        mesh_build_lods(submesh, lod_count);
+                    }
+                    if (is_compacted)
+                        mesh_compact_vertices(submesh);
+                    // last, after welding, so that more meshes fit
+                    mesh_shrink_indices(submesh);
+                });
+            }
            CC_LOG(CC_VERBOSE, "loaded mesh %d/%d", i+1, scene->mNumMeshes);
         }
 
-        model_data[model_idx] = new_model_data;
-        return model_idx;
+        auto time_meshes_converted = std::chrono::high_resolution_clock::now();
+        Jobs::job_pool_wait(&mesh_jobs);
+        auto time_meshes = std::chrono::high_resolution_clock::now();
+        // written while the textures are still decoding
+        if (!is_baked && bake_key != 0)
+            bake_cache_store_model(bake_key, baked);
+        Jobs::job_pool_wait(&texture_jobs);
+        auto time_textures = std::chrono::high_resolution_clock::now();
+
+        import->time_import_ms   = std::chrono::duration<double, std::milli>(time_imported - time_start).count();
+        import->time_meshes_ms   = std::chrono::duration<double, std::milli>(time_meshes   - time_imported).count();
+        import->time_textures_ms = std::chrono::duration<double, std::milli>(time_textures - time_imported).count();
+        CC_LOG(
+            CC_INFO,
+            "%s: imported in %.2fms, meshes converted in %.2fms, optimized in %.2fms, textures decoded in %.2fms (%d workers)",
+            path,
+            import->time_import_ms,
+            std::chrono::duration<double, std::milli>(time_meshes_converted - time_start).count(),
+            std::chrono::duration<double, std::milli>(time_meshes - time_start).count(),
+            std::chrono::duration<double, std::milli>(time_textures - time_start).count(),
+            Jobs::job_pool_get_num_threads()
+        );
+    }
+
+    static IdAssetModel import_model_store(ModelImport* import) {
+        auto time_start = std::chrono::high_resolution_clock::now();
+
+        const char* path = import->path.c_str();
+        const ModelImportOptions& options = import->options;
+        const EnvironmentTextures& environment = import->environment;
+        const uint32_t TEXTURES_PER_MATERIAL = MODEL_TEXTURES_PER_MATERIAL;
+
+        BakedModel& baked = import->baked;
+        ModelData& new_model_data = import->model;
+        std::vector<MeshData>& submeshes = baked.meshes;
+        const std::vector<MeshOptimizeStats>& submeshes_stats = import->meshes_stats;
+        std::vector<TextureRequest>& texture_requests = import->texture_requests;
+        uint32_t meshes_count = (uint32_t)baked.meshes.size();
+        uint32_t instances_count = (uint32_t)baked.instances_mesh.size();
+        std::vector<IdAssetMesh> mesh_ids(meshes_count);
+
+        // store optimized meshes
+        uint64_t total_vertices_before = 0;
+        uint64_t total_vertices_after = 0;
+        uint64_t total_transformed_before = 0;
+        uint64_t total_transformed_after = 0;
+        uint64_t total_triangles = 0;
+        uint64_t total_vertex_bytes_imported = 0;
+        uint64_t total_vertex_bytes = 0;
+        uint64_t total_index_bytes = 0;
+        uint64_t total_meshlets = 0;
+        for(uint32_t i = 0; i < meshes_count; ++i) {
+            const MeshOptimizeStats& stats = submeshes_stats[i];
+            const MeshData& submesh = submeshes[i];
+
+            // memory footprint, against the vertices as imported (one VertexData per face corner)
+            uint64_t vertex_bytes_imported = (uint64_t)baked.imported_vertex_counts[i] * sizeof(VertexData);
+            uint64_t vertex_bytes = (uint64_t)submesh.vertex_count * submesh.vertex_data_size;
+            uint64_t index_bytes  = (uint64_t)submesh.index_count * mesh_get_index_size(submesh);
+            CC_LOG(
+                CC_VERBOSE,
+                "mesh %3d: vertex data %8.1fKB -> %8.1fKB (%2d bytes/vertex), index data %8.1fKB (%d bit)",
+                i,
+                vertex_bytes_imported / 1024.0, vertex_bytes / 1024.0, submesh.vertex_data_size,
+                index_bytes / 1024.0, mesh_get_index_size(submesh) * 8
+            );
+            total_vertex_bytes_imported += vertex_bytes_imported;
+            total_vertex_bytes          += vertex_bytes;
+            total_index_bytes           += index_bytes;
+            total_meshlets              += submesh.meshlet_count;
+
+            if (stats.vertex_count_before > 0) {
+                uint32_t triangles = mesh_get_base_index_count(submeshes[i]) / 3;
+                CC_LOG(
+                    CC_VERBOSE,
+                    "mesh %3d: vertices %6d -> %6d   ACMR %.3f -> %.3f   ATVR %.3f -> %.3f",
+                    i,
+                    stats.vertex_count_before, stats.vertex_count_after,
+                    stats.acmr_before, stats.acmr_after,
+                    stats.atvr_before, stats.atvr_after
+                );
+                total_vertices_before    += stats.vertex_count_before;
+                total_vertices_after     += stats.vertex_count_after;
+                total_transformed_before += (uint64_t)(stats.acmr_before * triangles + 0.5f);
+                total_transformed_after  += (uint64_t)(stats.acmr_after  * triangles + 0.5f);
+                total_triangles          += triangles;
+            }
+
+            mesh_ids[i] = storage_add(mesh_data, submeshes[i]);
+        }
+        bake_stats.meshes_count          += meshes_count;
+        bake_stats.vertex_bytes_imported += total_vertex_bytes_imported;
+        bake_stats.vertex_bytes          += total_vertex_bytes;
+        bake_stats.index_bytes           += total_index_bytes;
+
+        CC_LOG(
+            CC_INFO,
+            "mesh memory: vertex data %.2fMB -> %.2fMB, index data %.2fMB, %llu meshlets (%.2fMB)",
+            total_vertex_bytes_imported / (1024.0 * 1024.0),
+            total_vertex_bytes / (1024.0 * 1024.0),
+            total_index_bytes / (1024.0 * 1024.0),
+            (unsigned long long)total_meshlets,
+            total_meshlets * sizeof(MeshletData) / (1024.0 * 1024.0)
+        );
+
+        if (total_triangles > 0) {
+            CC_LOG(
+                CC_INFO,
+                "mesh optimization: vertices %llu -> %llu   ACMR %.3f -> %.3f   ATVR %.3f -> %.3f",
+                (unsigned long long)total_vertices_before, (unsigned long long)total_vertices_after,
+                (double)total_transformed_before / total_triangles, (double)total_transformed_after / total_triangles,
+                (double)total_transformed_before / total_vertices_before, (double)total_transformed_after / total_vertices_after
+            );
+        }
+
+        // store decoded textures
+        std::vector<IdAssetTexture> texture_ids(texture_requests.size());
+        uint32_t num_decoded = 0;
+        for(size_t j = 0; j < texture_requests.size(); ++j) {
+            TextureRequest& request = texture_requests[j];
+            if (request.is_cached)
+                texture_ids[j] = request.id_cached;
+            else if (request.is_decoded && texture_cache_find(request.cache_key, &texture_ids[j])) {
+                // stored meanwhile by a model imported in parallel with this one
+                free_texture_data(request.data);
+            }
+            else if (request.idx_source >= 0) {
+                // sources come first, their id is already assigned
+                texture_ids[j] = texture_ids[request.idx_source];
+                if (texture_requests[request.idx_source].is_decoded) {
+                    ++texture_cache_stats.num_hits;
+                    texture_cache_stats.bytes_saved += storage_get(texture_data, texture_ids[j]).data.size();
+                }
+            }
+            else if (request.is_decoded) {
+                texture_ids[j] = storage_add(texture_data, request.data);
+                texture_cache_add(request.cache_key, texture_ids[j]);
+                texture_source_add(request.path.c_str(), {
+                    .id             = texture_ids[j],
+                    .view_type      = TEX_VIEW_TYPE_2D,
+                    .format         = request.format,
+                    .flip_vertical  = true,
+                    .create_mipmaps = false,
+                    .compression    = options.texture_compression,
+                    .layer          = 0
+                });
+                bake_stats_add_texture(request.path.c_str(), request.data);
+                import->new_textures.push_back(texture_ids[j]);
+                ++num_decoded;
+            }
+            else if (request.has_path)
+                texture_ids[j] = IDX_MISSING_TEXTURE;
+            else
+                texture_ids[j] = request.tex_fallback;
+        }
+
+        CC_LOG(CC_INFO, "%s: %d textures decoded", path, num_decoded);
+
+        // create material
+        std::map<unsigned int, IdAssetMaterial> material_map;
+        for(uint32_t i = 0; i < baked.materials_count; ++i) {
+            const IdAssetTexture* material_textures = &texture_ids[i * TEXTURES_PER_MATERIAL];
+
+            auto mat = (MaterialData) {
+                .id_pipeline_config = options.id_pipeline_config,
+                .id_render_pass = 0,
+                .id_pipeline = 0,
+                .uniform_data_material = nullptr,
+                .image_views = std::vector<IdAssetTexture> {
+                    material_textures[0],   // diffuse
+                    material_textures[1],   // arm
+                    material_textures[2],   // normal
+                    environment.specular,
+                    environment.irradiance,
+                    environment.brdf_lut
+                },
+                .flags = options.texture_arrays ? MaterialData::FLAG_TEXTURE_ARRAYS : (uint8_t)0
+            };
+            // TODO hardcoded PBR material
+            auto tmp = create_material(mat);
+            CC_LOG(CC_VERBOSE, "loading materials %d/%d", i+1, baked.materials_count);
+            material_map[i] = tmp;
+            import->new_materials.push_back(tmp);
+        }
+
+        for(uint32_t i = 0; i < instances_count; ++i) {
+            uint32_t mesh = baked.instances_mesh[i];
+            new_model_data.meshes[i]          = mesh_ids[mesh];
+            new_model_data.meshes_material[i] = material_map[baked.meshes_material[mesh]];
+        }
+        model_compute_bounds(&new_model_data);
+
+        auto time_stored = std::chrono::high_resolution_clock::now();
+        bake_stats.models_count     += 1;
+        bake_stats.source_bytes     += get_file_size(path);
+        bake_stats.time_import_ms   += import->time_import_ms;
+        bake_stats.time_meshes_ms   += import->time_meshes_ms;
+        bake_stats.time_textures_ms += import->time_textures_ms;
+        bake_stats.time_store_ms    += std::chrono::duration<double, std::milli>(time_stored - time_start).count();
+
+        return storage_add(model_data, new_model_data);
+    }
+
+    static IdAssetModel import_model(
+        const char* path,
+        const char* base_path_textures,
+        const EnvironmentTextures& environment,
+        const ModelImportOptions& options
+    ) {
+        ModelImport import = {
+            .path               = path,
+            .base_path_textures = base_path_textures,
+            .environment        = environment,
+            .options            = options
+        };
+        import_model_process(&import);
+        return import_model_store(&import);
+    }
+
+    uint32_t load_model(
+        const char* path,
+        const char* base_path_textures,
+        const EnvironmentTextures& environment,
+        const ModelImportOptions& options
+    ) {
+        IdAssetModel id = import_model(path, base_path_textures, environment, options);
+        model_source_add(path, {
+            .id                 = id,
+            .base_path_textures = base_path_textures,
+            .environment        = environment,
+            .options            = options
+        });
+        return id;
+    }
+
+    void load_models(std::span<const ModelLoadRequest> requests, IdAssetModel* out_ids) {
+        std::vector<ModelImport> imports(requests.size());
+        Jobs::JobCounter model_jobs;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            imports[i] = {
+                .path               = requests[i].path,
+                .base_path_textures = requests[i].base_path_textures,
+                .environment        = requests[i].environment,
+                .options            = requests[i].options
+            };
+            Jobs::job_pool_submit(&model_jobs, [import = &imports[i]]() {
+                import_model_process(import);
+            });
+        }
+        Jobs::job_pool_wait(&model_jobs);
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            out_ids[i] = import_model_store(&imports[i]);
+            model_source_add(requests[i].path, {
+                .id                 = out_ids[i],
+                .base_path_textures = requests[i].base_path_textures,
+                .environment        = requests[i].environment,
+                .options            = requests[i].options
+            });
+        }
     }
 
     IdAssetTexture load_texture(const char* path, TexViewTypes viewType, VkFormat format, bool flip_vertical, bool generate_mipmaps) {
-        IdAssetTexture tex_idx = num_texture_assets;
-        
-        if(load_texture(tex_idx, path, viewType, format, flip_vertical, generate_mipmaps) == IDX_MISSING_TEXTURE)
+        std::string cache_key = texture_cache_make_key(path, viewType, format, flip_vertical, generate_mipmaps);
+
+        IdAssetTexture tex_idx;
+        if (texture_cache_find(cache_key, &tex_idx))
+            return tex_idx;
+
+        TextureData data;
+        if (!decode_texture(&data, path, viewType, format, flip_vertical, generate_mipmaps))
             return IDX_MISSING_TEXTURE;
 
-        ++num_texture_assets;
+        tex_idx = storage_add(texture_data, data);
+        texture_cache_add(cache_key, tex_idx);
+        texture_source_add(path, {
+            .id             = tex_idx,
+            .view_type      = viewType,
+            .format         = format,
+            .flip_vertical  = flip_vertical,
+            .create_mipmaps = generate_mipmaps,
+            .compression    = TEX_COMPRESSION_NONE,
+            .layer          = 0
+        });
+        bake_stats_add_texture(path, data);
         return tex_idx;
     }
 
-    inline IdAssetMesh create_mesh(MeshData data) {
+    EnvironmentTextures load_environment(const char* path, bool flip_vertical) {
+        EnvironmentTextures environment;
+
+        // not an actual file, the texture cache only keeps it alive for the other environments
+        const std::string KEY_BRDF_LUT = "|environment|brdf_lut";
+        if (!texture_cache_find(KEY_BRDF_LUT, &environment.brdf_lut)) {
+            uint32_t size;
+            TextureData lut;
+            lut.viewType = TEX_VIEW_TYPE_2D;
+            lut.width    = ENVIRONMENT_BRDF_LUT_SIZE;
+            lut.height   = ENVIRONMENT_BRDF_LUT_SIZE;
+            lut.mipmaps  = 1;
+            lut.format   = VK_FORMAT_R16G16_SFLOAT;
+            lut.flags    = 0;
+            lut.data     = std::span<unsigned char>((unsigned char*)environment_compute_brdf_lut(&size), size);
+
+            environment.brdf_lut = storage_add(texture_data, lut);
+            texture_cache_add(KEY_BRDF_LUT, environment.brdf_lut);
+        }
+
+        std::string key = normalize_path(path) + (flip_vertical ? "|environment|1" : "|environment|0");
+        if (texture_cache_find(key + "|specular", &environment.specular) && texture_cache_find(key + "|irradiance", &environment.irradiance))
+            return environment;
+
+        TextureData specular;
+        TextureData irradiance;
+        if (!decode_environment(&specular, &irradiance, path, flip_vertical)) {
+            CC_LOG(CC_WARNING, "missing environment at path %s", path);
+            return ENVIRONMENT_NONE;
+        }
+
+        environment.specular   = storage_add(texture_data, specular);
+        environment.irradiance = storage_add(texture_data, irradiance);
+        texture_cache_add(key + "|specular",   environment.specular);
+        texture_cache_add(key + "|irradiance", environment.irradiance);
+        bake_stats_add_texture(path, specular);
+        bake_stats_add_texture(path, irradiance);
+        return environment;
+    }
+
+    IdAssetMesh create_mesh(MeshData& data) {
+        return storage_add(mesh_data, data);
+    }
+
+    IdAssetMaterial create_material(MaterialData& data) {
+        return storage_add(material_data, data);
+    }
+
+    // ===================================================================================
+    // texture arrays
+    // ===================================================================================
+    // textures sharing an array
+    struct TextureArrayKey {
+        VkFormat format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipmaps;
+        uint64_t size;
+
+        auto operator<=>(const TextureArrayKey&) const = default;
+    };
+
+    // bytes of each level of a single layer, from the size of the data: all levels have the same bytes
+    // per texel (per 4x4 block for BC formats). False if the data doesn't split evenly
+    static bool texture_get_level_sizes(const TextureData& data, std::vector<uint64_t>* out_sizes) {
+        bool is_block = data.format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && data.format <= VK_FORMAT_BC7_SRGB_BLOCK;
+
+        uint64_t units = 0;
+        out_sizes->resize(data.mipmaps);
+        for (uint32_t mip = 0; mip < data.mipmaps; ++mip) {
+            uint32_t width  = glm::max((uint32_t)data.width  >> mip, 1u);
+            uint32_t height = glm::max((uint32_t)data.height >> mip, 1u);
+            (*out_sizes)[mip] = is_block ? (uint64_t)((width + 3) / 4) * ((height + 3) / 4) : (uint64_t)width * height;
+            units += (*out_sizes)[mip];
+        }
+
+        units *= tex_get_layer_count(data);
+        if (units == 0 || data.data.size() % units != 0)
+            return false;
+
+        uint64_t unit_size = data.data.size() / units;
+        for (uint64_t& size : *out_sizes)
+            size *= unit_size;
+        return true;
+    }
+
+    // copies `textures` (same format, size and mips) into the layers of a new array, level by level
+    static TextureData texture_array_build(std::span<const IdAssetTexture> textures, const std::vector<uint64_t>& level_sizes) {
+        const TextureData& first = storage_get(texture_data, textures[0]);
+
+        TextureData array = first;
+        array.viewType = TEX_VIEW_TYPE_2D_ARRAY;
+        array.layers   = (uint16_t)textures.size();
+        array.flags    = 0;
+
+        uint64_t size = first.data.size() * textures.size();
+        unsigned char* dst = (unsigned char*)malloc(size);
+        array.data = std::span<unsigned char>(dst, size);
+
+        uint64_t src_offset = 0;
+        for (uint64_t level_size : level_sizes) {
+            for (IdAssetTexture id : textures) {
+                texture_read_pixels(storage_get(texture_data, id), src_offset, level_size, dst);
+                dst += level_size;
+            }
+            src_offset += level_size;
+        }
+        return array;
+    }
+
+    uint32_t pack_texture_arrays(uint32_t max_size) {
+        // 2D textures of the array slots in order of first use, and the 2D textures other slots sample
+        std::vector<IdAssetTexture> candidates;
+        std::set<IdAssetTexture>    candidates_set;
+        std::set<IdAssetTexture>    shared_set;
+        for (const MaterialData& material : material_data.dense) {
+            bool uses_arrays = material_uses_texture_arrays(material);
+            for (uint32_t slot = 0; slot < material.image_views.size(); ++slot) {
+                IdAssetTexture id = material.image_views[slot];
+                const TextureData* texture = storage_find(texture_data, id);
+                if (!texture || texture->viewType != TEX_VIEW_TYPE_2D)
+                    continue;
+
+                if (!uses_arrays || slot >= MATERIAL_TEXTURE_ARRAY_SLOTS)
+                    shared_set.insert(id);
+                else if (candidates_set.insert(id).second)
+                    candidates.push_back(id);
+            }
+        }
+        if (candidates.empty())
+            return 0;
+
+        // the hardware guarantees at least 256 layers
+        const uint32_t MAX_LAYERS = 256;
+
+        std::map<TextureArrayKey, std::vector<IdAssetTexture>> groups;
+        std::vector<IdAssetTexture> singles;
+        std::vector<uint64_t> level_sizes;
+        for (IdAssetTexture id : candidates) {
+            const TextureData& texture = storage_get(texture_data, id);
+            if (texture.width > max_size || texture.height > max_size || !texture_get_level_sizes(texture, &level_sizes)) {
+                singles.push_back(id);
+                continue;
+            }
+
+            TextureArrayKey key = {
+                .format  = texture.format,
+                .width   = texture.width,
+                .height  = texture.height,
+                .mipmaps = texture.mipmaps,
+                .size    = texture.data.size()
+            };
+            groups[key].push_back(id);
+        }
+
+        // texture -> array and layer
+        std::map<IdAssetTexture, std::pair<IdAssetTexture, uint32_t>> layers;
+        std::vector<IdAssetTexture> released;
+        uint32_t num_arrays = 0;
+        uint32_t num_packed = 0;
+        for (auto& [key, ids] : groups) {
+            if (ids.size() == 1) {
+                singles.push_back(ids[0]);
+                continue;
+            }
+
+            texture_get_level_sizes(storage_get(texture_data, ids[0]), &level_sizes);
+            for (size_t first = 0; first < ids.size(); first += MAX_LAYERS) {
+                std::span<const IdAssetTexture> members(ids.data() + first, glm::min(ids.size() - first, (size_t)MAX_LAYERS));
+                TextureData array = texture_array_build(members, level_sizes);
+                IdAssetTexture id_array = storage_add(texture_data, array);
+                ++num_arrays;
+
+                for (uint32_t layer = 0; layer < members.size(); ++layer) {
+                    layers[members[layer]] = { id_array, layer };
+                    if (!id_is_builtin(members[layer]) && !shared_set.contains(members[layer]))
+                        released.push_back(members[layer]);
+                }
+                num_packed += (uint32_t)members.size();
+            }
+        }
+
+        // textures alone in their array: in place, copied when something else samples them as 2D
+        for (IdAssetTexture id : singles) {
+            if (id_is_builtin(id) || shared_set.contains(id)) {
+                const TextureData& texture = storage_get(texture_data, id);
+                TextureData array = texture;
+                array.viewType = TEX_VIEW_TYPE_2D_ARRAY;
+                array.layers   = 1;
+                array.flags    = 0;
+                array.data     = std::span<unsigned char>((unsigned char*)malloc(texture.data.size()), texture.data.size());
+                texture_read_pixels(texture, 0, texture.data.size(), array.data.data());
+                layers[id] = { storage_add(texture_data, array), 0 };
+            }
+            else {
+                // later loads of its file must get a 2D texture again
+                TextureData& texture = storage_get(texture_data, id);
+                texture.viewType = TEX_VIEW_TYPE_2D_ARRAY;
+                texture.layers   = 1;
+                texture_cache_remove(id);
+                layers[id] = { id, 0 };
+            }
+            ++num_arrays;
+        }
+
+        for (MaterialData& material : material_data.dense) {
+            if (!material_uses_texture_arrays(material))
+                continue;
+
+            material.image_layers.resize(material.image_views.size(), 0);
+            for (uint32_t slot = 0; slot < glm::min((uint32_t)material.image_views.size(), MATERIAL_TEXTURE_ARRAY_SLOTS); ++slot) {
+                auto it = layers.find(material.image_views[slot]);
+                if (it == layers.end())
+                    continue;
+                material.image_views[slot]  = it->second.first;
+                material.image_layers[slot] = it->second.second;
+            }
+        }
+
+        // sources follow their texture into its layer, so that hot reload updates the array.
+        // Textures still sampled as 2D are reloaded in both
+        for (auto& [path, sources] : texture_sources) {
+            size_t sources_count = sources.size();
+            for (size_t i = 0; i < sources_count; ++i) {
+                auto it = layers.find(sources[i].id);
+                if (it == layers.end() || it->second.first == sources[i].id)
+                    continue;
+
+                TextureSource source = sources[i];
+                source.id    = it->second.first;
+                source.layer = it->second.second;
+                if (!id_is_builtin(sources[i].id) && !shared_set.contains(sources[i].id))
+                    sources[i] = source;
+                else
+                    sources.push_back(source);
+            }
+        }
+
+        for (IdAssetTexture id : released)
+            release_texture(id);
+
+        CC_LOG(
+            CC_INFO,
+            "[texture arrays] %d textures in %d arrays (%d single layer), %d textures released",
+            (int)candidates.size(),
+            (int)num_arrays,
+            (int)singles.size(),
+            (int)released.size()
+        );
+        return num_arrays;
+    }
+
+    // ===================================================================================
+    // hot reload
+    // ===================================================================================
+    // copies a decoded texture into its layer of an array, level by level. The array keeps its
+    // format and size, a file that doesn't match them anymore is not reloaded until the next bake
+    static bool reload_texture_layer(const char* path, const TextureSource& source, TextureData* data) {
+        TextureData& array = storage_get(texture_data, source.id);
+
+        std::vector<uint64_t> level_sizes;
+        bool is_matching =
+            source.layer < array.layers
+            && data->format  == array.format
+            && data->width   == array.width
+            && data->height  == array.height
+            && data->mipmaps == array.mipmaps
+            && data->data.size() * array.layers == array.data.size()
+            && texture_get_level_sizes(*data, &level_sizes);
+        if (!is_matching) {
+            CC_LOG(CC_WARNING, "[hot reload] %s doesn't match the format or size of array %u anymore, keeping layer %u", path, source.id, source.layer);
+            free_texture_data(*data);
+            return false;
+        }
+
+        // arrays of a loaded db are read only in the mapping, single layer DDS arrays are in their file
+        if (array.flags & (TextureData::FLAG_MAPPED | TextureData::FLAG_FILE)) {
+            unsigned char* pixels = (unsigned char*)malloc(array.data.size());
+            texture_read_pixels(array, 0, array.data.size(), pixels);
+            free_texture_data(array);
+            array.data   = std::span<unsigned char>(pixels, array.data.size());
+            array.flags &= ~(TextureData::FLAG_MAPPED | TextureData::FLAG_FILE);
+        }
+
+        uint64_t src_offset = 0;
+        uint64_t dst_offset = 0;
+        for (uint64_t level_size : level_sizes) {
+            texture_read_pixels(*data, src_offset, level_size, array.data.data() + dst_offset + source.layer * level_size);
+            src_offset += level_size;
+            dst_offset += level_size * array.layers;
+        }
+        free_texture_data(*data);
+        return true;
+    }
+
+    static bool reload_texture(const char* path, const TextureSource& source) {
+        TextureData data;
+        if (!decode_texture(&data, path, source.view_type, source.format, source.flip_vertical, source.create_mipmaps, source.compression)) {
+            CC_LOG(CC_WARNING, "[hot reload] %s could not be decoded, keeping texture %u", path, source.id);
+            return false;
+        }
+
+        TextureData& texture = storage_get(texture_data, source.id);
+        if (texture.viewType == TEX_VIEW_TYPE_2D_ARRAY && texture.layers > 1)
+            return reload_texture_layer(path, source, &data);
+
+        // turned into an array of a single layer in place by `pack_texture_arrays`
+        if (texture.viewType == TEX_VIEW_TYPE_2D_ARRAY) {
+            data.viewType = TEX_VIEW_TYPE_2D_ARRAY;
+            data.layers   = 1;
+        }
+        free_texture_data(texture);
+        texture = data;
+        return true;
+    }
+
+    // imports the model again and moves the new meshes into the ids of the old ones.
+    // Materials and textures of the new import are released, the ones of the old model stay
+    static bool reload_model(const char* path, const ModelSource& source, std::vector<IdAssetMesh>* out_meshes) {
+        ModelImport import = { };
+        import.path               = path;
+        import.base_path_textures = source.base_path_textures;
+        import.environment        = source.environment;
+        import.options            = source.options;
+        import_model_process(&import);
+        IdAssetModel id_fresh = import_model_store(&import);
+
+        ModelData fresh = storage_get(model_data, id_fresh);
+        ModelData old   = storage_get(model_data, source.id);
+        bool is_matching = fresh.meshes_count == old.meshes_count;
+        if (!is_matching)
+            CC_LOG(CC_WARNING, "[hot reload] %s has %u meshes instead of %u, keeping model %d", path, fresh.meshes_count, old.meshes_count, source.id);
+        else {
+            ModelData& model = storage_get(model_data, source.id);
+            model.bounds_min    = fresh.bounds_min;
+            model.bounds_max    = fresh.bounds_max;
+            model.bounds_center = fresh.bounds_center;
+            model.bounds_radius = fresh.bounds_radius;
+        }
+
+        // instanced meshes are listed once per node, the first instance swaps them
+        for (uint32_t i = 0; i < fresh.meshes_count; ++i) {
+            if (!storage_contains(mesh_data, fresh.meshes[i]))
+                continue;
+            if (is_matching) {
+                std::swap(storage_get(mesh_data, old.meshes[i]), storage_get(mesh_data, fresh.meshes[i]));
+                out_meshes->push_back(old.meshes[i]);
+            }
+            free_mesh_data(storage_get(mesh_data, fresh.meshes[i]));
+            storage_remove(mesh_data, fresh.meshes[i]);
+        }
+
+        for (IdAssetMaterial id : import.new_materials)
+            storage_remove(material_data, id);
+        // the old materials don't sample them, and texture files are reloaded on their own
+        for (IdAssetTexture id : import.new_textures)
+            release_texture(id);
 
-        IdAssetMesh mesh_idx = num_mesh_assets++;
-        create_mesh(mesh_idx, data);
-        return mesh_idx;
+        free_model_data(fresh);
+        storage_remove(model_data, id_fresh);
+        return is_matching;
     }
 
-    inline IdAssetMaterial create_material(MaterialData& data) {
-        IdAssetMaterial material_idx = num_material_assets++;
-        create_material(material_idx, data);
-        return material_idx;
+    bool asset_reload_file(const char* path, ReloadedAssets* out_reloaded) {
+        std::string key = normalize_path(path);
+
+        auto it_textures = texture_sources.find(key);
+        auto it_models   = model_sources.find(key);
+        if (it_textures == texture_sources.end() && it_models == model_sources.end())
+            return false;
+
+        auto time_start = std::chrono::high_resolution_clock::now();
+        uint32_t num_textures = (uint32_t)out_reloaded->textures.size();
+        uint32_t num_meshes   = (uint32_t)out_reloaded->meshes.size();
+
+        if (it_textures != texture_sources.end())
+            for (const TextureSource& source : it_textures->second)
+                if (storage_contains(texture_data, source.id) && reload_texture(path, source))
+                    out_reloaded->textures.push_back(source.id);
+
+        // `import_model` can add sources, copy the ones to reload first
+        if (it_models != model_sources.end()) {
+            std::vector<ModelSource> sources = it_models->second;
+            for (const ModelSource& source : sources)
+                if (storage_contains(model_data, source.id))
+                    reload_model(path, source, &out_reloaded->meshes);
+        }
+
+        CC_LOG(
+            CC_INFO,
+            "[hot reload] %s: %d textures, %d meshes in %.2fms",
+            path,
+            (int)(out_reloaded->textures.size() - num_textures),
+            (int)(out_reloaded->meshes.size() - num_meshes),
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - time_start).count()
+        );
+        return true;
     }
 
     // ===================================================================================
     // serialization
     // ===================================================================================
-    void asset_db_dump(const char *path) {
+
+    // mappings of the loaded asset dbs, mapped assets point into them until `asset_db_unload()`
+    std::vector<FileMapping> db_mappings;
+    // decompressed blobs of the loaded asset dbs, same lifetime as the mappings
+    std::vector<void*> db_arenas;
+
+    struct DbWriter {
+        FILE* fp;
+        uint64_t offset;
+        bool compress;
+        std::vector<Db::Entry> entries;
+        std::vector<Db::Chunk> chunks;
+        // totals of the compressed blobs
+        uint64_t compressed_raw_size;
+        uint64_t compressed_size;
+    };
+
+    // compresses `data` in chunks on the job pool, and writes them if the blob shrinks enough
+    static bool db_write_chunks(DbWriter& writer, Db::Entry* entry, const void* data, uint64_t size) {
+        uint32_t chunks_count = (uint32_t)((size + Db::CHUNK_SIZE - 1) / Db::CHUNK_SIZE);
+        uint32_t bound = Lz::lz_compress_bound(Db::CHUNK_SIZE);
+
+        std::vector<unsigned char> buffer((size_t)chunks_count * bound);
+        std::vector<uint32_t> chunk_sizes(chunks_count);
+        Jobs::JobCounter jobs;
+        for (uint32_t i = 0; i < chunks_count; ++i) {
+            Jobs::job_pool_submit(&jobs, [&, i]() {
+                uint64_t raw_offset = (uint64_t)i * Db::CHUNK_SIZE;
+                uint32_t raw_size   = (uint32_t)glm::min<uint64_t>(Db::CHUNK_SIZE, size - raw_offset);
+                chunk_sizes[i] = Lz::lz_compress((const unsigned char*)data + raw_offset, raw_size, buffer.data() + (size_t)i * bound);
+            });
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        // chunks that don't shrink are stored as they are
+        uint64_t stored_size = 0;
+        for (uint32_t i = 0; i < chunks_count; ++i) {
+            uint32_t raw_size = (uint32_t)glm::min<uint64_t>(Db::CHUNK_SIZE, size - (uint64_t)i * Db::CHUNK_SIZE);
+            chunk_sizes[i] = glm::min(chunk_sizes[i], raw_size);
+            stored_size += chunk_sizes[i];
+        }
+        if (stored_size > size - size / 8)
+            return false;
+
+        entry->chunks_first = (uint32_t)writer.chunks.size();
+        entry->chunks_count = chunks_count;
+        for (uint32_t i = 0; i < chunks_count; ++i) {
+            uint64_t raw_offset = (uint64_t)i * Db::CHUNK_SIZE;
+            uint32_t raw_size   = (uint32_t)glm::min<uint64_t>(Db::CHUNK_SIZE, size - raw_offset);
+            const void* chunk_data = chunk_sizes[i] == raw_size
+                ? (const unsigned char*)data + raw_offset
+                : buffer.data() + (size_t)i * bound;
+
+            writer.chunks.push_back(Db::Chunk {
+                .offset   = writer.offset,
+                .size     = chunk_sizes[i],
+                .raw_size = raw_size
+            });
+            fwrite(chunk_data, 1, chunk_sizes[i], writer.fp);
+            writer.offset += chunk_sizes[i];
+        }
+
+        writer.compressed_raw_size += size;
+        writer.compressed_size     += stored_size;
+        return true;
+    }
+
+    // appends an aligned blob to the file and registers it in the entry table
+    static void db_write_blob(DbWriter& writer, Db::EntryType type, uint32_t id, const void* data, uint64_t size) {
+        static const unsigned char PADDING[Db::ALIGNMENT] = { 0 };
+
+        uint64_t padding = (Db::ALIGNMENT - writer.offset % Db::ALIGNMENT) % Db::ALIGNMENT;
+        fwrite(PADDING, 1, padding, writer.fp);
+        writer.offset += padding;
+
+        Db::Entry entry = {
+            .type   = type,
+            .id     = id,
+            .offset = writer.offset,
+            .size   = size
+        };
+
+        bool is_compressed = writer.compress && size >= Db::COMPRESS_MIN_SIZE && db_write_chunks(writer, &entry, data, size);
+        if (!is_compressed && size > 0) {
+            fwrite(data, 1, size, writer.fp);
+            writer.offset += size;
+        }
+        writer.entries.push_back(entry);
+    }
+
+    void asset_db_dump(const char *path, bool compress) {
+        FILE* fp = fopen(path, "wb");
+
+        CC_ASSERT(fp, "error opening file");
+
+        DbWriter writer = { .fp = fp, .offset = sizeof(Db::Header), .compress = compress };
+
+        // placeholder, rewritten once the entry table is known
+        Db::Header header = { };
+        fwrite(&header, sizeof(Db::Header), 1, fp);
+
+        storage_for_each(mesh_data, [&writer](IdAssetMesh id, const MeshData& data) {
+            Db::MeshRecord record = {
+                .vertex_count     = data.vertex_count,
+                .vertex_data_size = data.vertex_data_size,
+                .index_count      = data.index_count,
+                .flags            = (uint32_t)(data.flags & ~MeshData::FLAG_MAPPED),
+                .position_offset  = data.position_offset,
+                .position_scale   = data.position_scale,
+                .bounds_min       = data.bounds_min,
+                .bounds_max       = data.bounds_max,
+                .bounds_center    = data.bounds_center,
+                .bounds_radius    = data.bounds_radius
+            };
+            db_write_blob(writer, Db::ENTRY_MESH,          id, &record,          sizeof(record));
+            db_write_blob(writer, Db::ENTRY_MESH_VERTICES, id, data.vertex_data, (uint64_t)data.vertex_count * data.vertex_data_size);
+            db_write_blob(writer, Db::ENTRY_MESH_INDICES,  id, data.index_data,  (uint64_t)data.index_count * mesh_get_index_size(data));
+            if (data.meshlet_count > 0)
+                db_write_blob(writer, Db::ENTRY_MESH_MESHLETS, id, data.meshlets, (uint64_t)data.meshlet_count * sizeof(MeshletData));
+            if (data.lod_count > 0)
+                db_write_blob(writer, Db::ENTRY_MESH_LODS,     id, data.lods,     (uint64_t)data.lod_count * sizeof(MeshLodData));
+        });
+
+        storage_for_each(texture_data, [&writer](IdAssetTexture id, const TextureData& data) {
+            Db::TextureRecord record = {
+                .width     = data.width,
+                .height    = data.height,
+                .mipmaps   = data.mipmaps,
+                .view_type = data.viewType,
+                .layers    = (uint16_t)tex_get_layer_count(data),
+                .format    = (uint32_t)data.format
+            };
+            db_write_blob(writer, Db::ENTRY_TEXTURE, id, &record, sizeof(record));
+
+            // DDS pixels are still in their file
+            std::vector<unsigned char> pixels;
+            const unsigned char* src = data.data.data();
+            if (data.flags & TextureData::FLAG_FILE) {
+                pixels.resize(data.data.size());
+                texture_read_pixels(data, 0, data.data.size(), pixels.data());
+                src = pixels.data();
+            }
+            db_write_blob(writer, Db::ENTRY_TEXTURE_PIXELS, id, src, data.data.size());
+        });
+
+        storage_for_each(material_data, [&writer](IdAssetMaterial id, const MaterialData& data) {
+            Db::MaterialRecord record = {
+                .id_pipeline_config = data.id_pipeline_config,
+                .id_render_pass     = data.id_render_pass,
+                .id_pipeline        = data.id_pipeline,
+                .image_views_count  = (uint32_t)data.image_views.size(),
+                .flags              = data.flags
+            };
+            db_write_blob(writer, Db::ENTRY_MATERIAL,       id, &record,                 sizeof(record));
+            db_write_blob(writer, Db::ENTRY_MATERIAL_VIEWS, id, data.image_views.data(), data.image_views.size() * sizeof(IdAssetTexture));
+            if (!data.image_layers.empty())
+                db_write_blob(writer, Db::ENTRY_MATERIAL_LAYERS, id, data.image_layers.data(), data.image_layers.size() * sizeof(uint32_t));
+        });
+
+        storage_for_each(model_data, [&writer](IdAssetModel id, const ModelData& data) {
+            Db::ModelRecord record = {
+                .transform    = data.transform,
+                .meshes_count  = data.meshes_count,
+                .nodes_count   = data.nodes_count,
+                .bounds_min    = data.bounds_min,
+                .bounds_max    = data.bounds_max,
+                .bounds_center = data.bounds_center,
+                .bounds_radius = data.bounds_radius
+            };
+            db_write_blob(writer, Db::ENTRY_MODEL,                 (uint32_t)id, &record,              sizeof(record));
+            db_write_blob(writer, Db::ENTRY_MODEL_MESHES,          (uint32_t)id, data.meshes,          data.meshes_count * sizeof(IdAssetMesh));
+            db_write_blob(writer, Db::ENTRY_MODEL_MATERIALS,       (uint32_t)id, data.meshes_material, data.meshes_count * sizeof(IdAssetMaterial));
+            db_write_blob(writer, Db::ENTRY_MODEL_MESH_NODES,      (uint32_t)id, data.meshes_node,     data.meshes_count * sizeof(uint32_t));
+            db_write_blob(writer, Db::ENTRY_MODEL_NODE_PARENTS,    (uint32_t)id, data.nodes_parent,    data.nodes_count * sizeof(uint32_t));
+            db_write_blob(writer, Db::ENTRY_MODEL_NODE_TRANSFORMS, (uint32_t)id, data.nodes_transform, data.nodes_count * sizeof(glm::mat4));
+        });
+
+        // sources, record then strings
+        std::vector<unsigned char> source_blob;
+        for (auto& kp : texture_sources) {
+            for (const TextureSource& source : kp.second) {
+                if (!storage_contains(texture_data, source.id))
+                    continue;
+
+                Db::TextureSourceRecord record = {
+                    .format         = (uint32_t)source.format,
+                    .view_type      = (uint8_t)source.view_type,
+                    .flip_vertical  = source.flip_vertical,
+                    .create_mipmaps = source.create_mipmaps,
+                    .compression    = (uint8_t)source.compression,
+                    .layer          = source.layer
+                };
+                source_blob.assign((const unsigned char*)&record, (const unsigned char*)(&record + 1));
+                source_blob.insert(source_blob.end(), kp.first.begin(), kp.first.end());
+                db_write_blob(writer, Db::ENTRY_TEXTURE_SOURCE, source.id, source_blob.data(), source_blob.size());
+            }
+        }
+
+        for (auto& kp : model_sources) {
+            for (const ModelSource& source : kp.second) {
+                if (!storage_contains(model_data, source.id))
+                    continue;
+
+                Db::ModelSourceRecord record = {
+                    .environment_specular      = source.environment.specular,
+                    .environment_irradiance    = source.environment.irradiance,
+                    .environment_brdf_lut      = source.environment.brdf_lut,
+                    .id_pipeline_config        = source.options.id_pipeline_config,
+                    .lod_count                 = source.options.lod_count,
+                    .optimize_meshes           = source.options.optimize_meshes,
+                    .compact_vertices          = source.options.compact_vertices,
+                    .texture_compression       = (uint8_t)source.options.texture_compression,
+                    .texture_arrays            = source.options.texture_arrays,
+                    .base_path_textures_length = (uint32_t)source.base_path_textures.size()
+                };
+                source_blob.assign((const unsigned char*)&record, (const unsigned char*)(&record + 1));
+                source_blob.insert(source_blob.end(), source.base_path_textures.begin(), source.base_path_textures.end());
+                source_blob.insert(source_blob.end(), kp.first.begin(), kp.first.end());
+                db_write_blob(writer, Db::ENTRY_MODEL_SOURCE, (uint32_t)source.id, source_blob.data(), source_blob.size());
+            }
+        }
+
+        // entry and chunk tables
+        uint64_t entries_offset = writer.offset;
+        fwrite(writer.entries.data(), sizeof(Db::Entry), writer.entries.size(), fp);
+        uint64_t chunks_offset = entries_offset + writer.entries.size() * sizeof(Db::Entry);
+        fwrite(writer.chunks.data(), sizeof(Db::Chunk), writer.chunks.size(), fp);
+
+        header = {
+            .magic          = Db::MAGIC,
+            .version        = Db::VERSION,
+            .entries_count  = (uint32_t)writer.entries.size(),
+            .alignment      = (uint32_t)Db::ALIGNMENT,
+            .entries_offset = entries_offset,
+            .file_size      = chunks_offset + writer.chunks.size() * sizeof(Db::Chunk),
+            .num_assets     = {
+                storage_count_all(mesh_data),
+                storage_count_all(texture_data),
+                storage_count_all(material_data),
+                storage_count_all(model_data)
+            },
+            .chunks_offset  = chunks_offset,
+            .chunks_count   = (uint32_t)writer.chunks.size(),
+            .chunk_size     = Db::CHUNK_SIZE
+        };
+        fseek(fp, 0, SEEK_SET);
+        fwrite(&header, sizeof(Db::Header), 1, fp);
+
+        fclose(fp);
+        CC_LOG_SYS_ERROR();
+
+        if (writer.compressed_raw_size > 0)
+            CC_LOG(CC_INFO, "[asset db] %s: %.1fMB compressed to %.1fMB in %d chunks",
+                path,
+                writer.compressed_raw_size / (1024.0 * 1024.0),
+                writer.compressed_size / (1024.0 * 1024.0),
+                (int)writer.chunks.size()
+            );
+    }
+
+    static uint64_t db_record_key(uint32_t type, uint32_t id) {
+        return ((uint64_t)type << 32) | id;
+    }
+
+    // bytes of a level, per 4x4 block for BC formats. 0 for formats the baker doesn't write
+    static uint64_t db_texture_get_level_size(VkFormat format, uint32_t width, uint32_t height) {
+        uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+        uint64_t texels = (uint64_t)width * height;
+        switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return blocks * 8;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return blocks * 16;
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return texels;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+            return texels * 2;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_B8G8R8_SRGB:
+            return texels * 3;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+        case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+            return texels * 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return texels * 8;
+        case VK_FORMAT_R32G32B32_SFLOAT:
+            return texels * 12;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return texels * 16;
+        default:
+            return 0;
+        }
+    }
+
+    // bytes of the pixels of `texture`: its mip chain, once per layer. 0 if the record can't be uploaded as is
+    static uint64_t db_texture_get_size(const Db::TextureRecord& texture) {
+        uint32_t mips_full = 1;
+        for (uint32_t size = glm::max(texture.width, texture.height); size > 1; size >>= 1)
+            ++mips_full;
+
+        bool is_valid =
+            ((texture.view_type == TEX_VIEW_TYPE_2D       && texture.layers == 1) ||
+             (texture.view_type == TEX_VIEW_TYPE_CUBE     && texture.layers == 6) ||
+             (texture.view_type == TEX_VIEW_TYPE_2D_ARRAY && texture.layers >= 1)) &&
+            texture.width > 0 && texture.height > 0 && texture.mipmaps > 0 && texture.mipmaps <= mips_full;
+        if (!is_valid)
+            return 0;
+
+        uint64_t size = 0;
+        for (uint32_t mip = 0; mip < texture.mipmaps; ++mip) {
+            uint64_t level_size = db_texture_get_level_size((VkFormat)texture.format, glm::max((uint32_t)texture.width >> mip, 1u), glm::max((uint32_t)texture.height >> mip, 1u));
+            if (level_size == 0)
+                return 0;
+            size += level_size;
+        }
+        return size * texture.layers;
+    }
+
+    // size of `entry` against its type and the record of its asset. Records are smaller than
+    // COMPRESS_MIN_SIZE, never compressed: `records` points to them in the mapping
+    static bool db_entry_is_valid(const Db::Entry& entry, const std::map<uint64_t, const unsigned char*>& records) {
+        auto find_record = [&records, &entry](uint32_t type) -> const unsigned char* {
+            auto it = records.find(db_record_key(type, entry.id));
+            return it != records.end() ? it->second : nullptr;
+        };
+        auto is_record = [&entry](uint64_t size) {
+            return entry.chunks_count == 0 && entry.size >= size;
+        };
+
+        switch (entry.type) {
+        case Db::ENTRY_MESH:            return is_record(sizeof(Db::MeshRecord));
+        case Db::ENTRY_TEXTURE:         return is_record(sizeof(Db::TextureRecord));
+        case Db::ENTRY_MATERIAL:        return is_record(sizeof(Db::MaterialRecord));
+        case Db::ENTRY_MODEL:           return is_record(sizeof(Db::ModelRecord));
+        case Db::ENTRY_TEXTURE_SOURCE:  return entry.size >= sizeof(Db::TextureSourceRecord);
+        case Db::ENTRY_MODEL_SOURCE:    return entry.size >= sizeof(Db::ModelSourceRecord);
+
+        case Db::ENTRY_MESH_VERTICES:
+        case Db::ENTRY_MESH_INDICES:
+        case Db::ENTRY_MESH_MESHLETS:
+        case Db::ENTRY_MESH_LODS: {
+            const Db::MeshRecord* mesh = (const Db::MeshRecord*)find_record(Db::ENTRY_MESH);
+            if (!mesh)
+                return false;
+            uint64_t index_size = (mesh->flags & MeshData::FLAG_INDICES_16) ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (entry.type == Db::ENTRY_MESH_VERTICES) return entry.size == (uint64_t)mesh->vertex_count * mesh->vertex_data_size;
+            if (entry.type == Db::ENTRY_MESH_INDICES)  return entry.size == (uint64_t)mesh->index_count * index_size;
+            if (entry.type == Db::ENTRY_MESH_MESHLETS) return entry.size % sizeof(MeshletData) == 0;
+            return entry.size % sizeof(MeshLodData) == 0;
+        }
+        case Db::ENTRY_TEXTURE_PIXELS: {
+            const Db::TextureRecord* texture = (const Db::TextureRecord*)find_record(Db::ENTRY_TEXTURE);
+            return texture && entry.size == db_texture_get_size(*texture);
+        }
+        case Db::ENTRY_MATERIAL_VIEWS:
+        case Db::ENTRY_MATERIAL_LAYERS:
+            return find_record(Db::ENTRY_MATERIAL) != nullptr && entry.size % sizeof(uint32_t) == 0;
+
+        case Db::ENTRY_MODEL_MESHES:
+        case Db::ENTRY_MODEL_MATERIALS:
+        case Db::ENTRY_MODEL_MESH_NODES:
+        case Db::ENTRY_MODEL_NODE_PARENTS:
+        case Db::ENTRY_MODEL_NODE_TRANSFORMS: {
+            const Db::ModelRecord* model = (const Db::ModelRecord*)find_record(Db::ENTRY_MODEL);
+            if (!model)
+                return false;
+            // as allocated by `alloc_model_data`
+            uint64_t nodes_count = glm::max(model->nodes_count, 1u);
+            if (entry.type == Db::ENTRY_MODEL_NODE_PARENTS)    return entry.size == nodes_count * sizeof(uint32_t);
+            if (entry.type == Db::ENTRY_MODEL_NODE_TRANSFORMS) return entry.size == nodes_count * sizeof(glm::mat4);
+            return entry.size == (uint64_t)model->meshes_count * sizeof(uint32_t);
+        }
+
+        default:
+            // unknown types are skipped, only their bounds matter
+            return true;
+        }
+    }
+
+    // values of `entry` that index into other blobs, once decompressed: meshlet and LOD ranges inside the
+    // indices of their mesh, mesh nodes inside the hierarchy, parents before their children (see ModelData).
+    // `entry` passed `db_entry_is_valid`
+    static bool db_entry_content_is_valid(const Db::Entry& entry, const unsigned char* blob, const std::map<uint64_t, const unsigned char*>& records) {
+        switch (entry.type) {
+        case Db::ENTRY_MESH_MESHLETS: {
+            const Db::MeshRecord* mesh = (const Db::MeshRecord*)records.at(db_record_key(Db::ENTRY_MESH, entry.id));
+            const MeshletData* meshlets = (const MeshletData*)blob;
+            for (uint64_t i = 0; i < entry.size / sizeof(MeshletData); ++i)
+                if ((uint64_t)meshlets[i].first_index + meshlets[i].index_count > mesh->index_count)
+                    return false;
+            return true;
+        }
+        case Db::ENTRY_MESH_LODS: {
+            const Db::MeshRecord* mesh = (const Db::MeshRecord*)records.at(db_record_key(Db::ENTRY_MESH, entry.id));
+            const MeshLodData* lods = (const MeshLodData*)blob;
+            for (uint64_t i = 0; i < entry.size / sizeof(MeshLodData); ++i)
+                if ((uint64_t)lods[i].first_index + lods[i].index_count > mesh->index_count)
+                    return false;
+            return true;
+        }
+        case Db::ENTRY_MODEL_MESH_NODES: {
+            const Db::ModelRecord* model = (const Db::ModelRecord*)records.at(db_record_key(Db::ENTRY_MODEL, entry.id));
+            const uint32_t* nodes = (const uint32_t*)blob;
+            for (uint64_t i = 0; i < entry.size / sizeof(uint32_t); ++i)
+                if (nodes[i] >= glm::max(model->nodes_count, 1u))
+                    return false;
+            return true;
+        }
+        case Db::ENTRY_MODEL_NODE_PARENTS: {
+            const uint32_t* parents = (const uint32_t*)blob;
+            for (uint64_t i = 0; i < entry.size / sizeof(uint32_t); ++i)
+                if (i == 0 ? parents[i] != NODE_NO_PARENT : parents[i] >= i)
+                    return false;
+            return true;
+        }
+        default:
+            return true;
+        }
+    }
+
+    void asset_db_load(const char *path) {
+        FileMapping mapping;
+        if (!file_mapping_open(path, &mapping)) {
+            CC_LOG(CC_ERROR, "error opening asset db %s", path);
+            return;
+        }
+
+        const Db::Header* header = (const Db::Header*)mapping.data;
+        if (
+            mapping.size < sizeof(Db::Header) ||
+            header->magic != Db::MAGIC ||
+            header->version != Db::VERSION ||
+            header->file_size != mapping.size ||
+            header->entries_offset > mapping.size ||
+            header->chunks_offset > mapping.size ||
+            header->entries_offset + (uint64_t)header->entries_count * sizeof(Db::Entry) > mapping.size ||
+            header->chunks_offset + (uint64_t)header->chunks_count * sizeof(Db::Chunk) > mapping.size ||
+            header->chunk_size != Db::CHUNK_SIZE
+        ) {
+            CC_LOG(CC_ERROR, "%s is not a valid asset db (version %d expected, rebake it)", path, Db::VERSION);
+            file_mapping_close(&mapping);
+            return;
+        }
+
+        const Db::Entry* entries = (const Db::Entry*)(mapping.data + header->entries_offset);
+        const Db::Chunk* chunks  = (const Db::Chunk*)(mapping.data + header->chunks_offset);
+
+        // compressed blobs are decompressed straight at their final place, in one arena per db
+        // nothing is read before every entry is known to be in the file, with the size its type expects
+        std::vector<uint64_t> arena_offsets(header->entries_count);
+        std::map<uint64_t, const unsigned char*> records;
+        uint64_t arena_size = 0;
+        bool     is_valid   = true;
+        for (uint32_t i = 0; i < header->entries_count && is_valid; ++i) {
+            const Db::Entry& entry = entries[i];
+            is_valid = db_entry_is_valid(entry, records);
+            if (entry.chunks_count == 0) {
+                is_valid = is_valid && entry.offset <= mapping.size && entry.size <= mapping.size - entry.offset;
+                if (is_valid)
+                    records.emplace(db_record_key(entry.type, entry.id), mapping.data + entry.offset);
+                continue;
+            }
+
+            is_valid = is_valid && (uint64_t)entry.chunks_first + entry.chunks_count <= header->chunks_count;
+            for (uint32_t j = 0; j < entry.chunks_count && is_valid; ++j) {
+                const Db::Chunk& chunk = chunks[entry.chunks_first + j];
+                uint64_t raw_offset = (uint64_t)j * Db::CHUNK_SIZE;
+                is_valid =
+                    raw_offset < entry.size &&
+                    chunk.raw_size == glm::min<uint64_t>(Db::CHUNK_SIZE, entry.size - raw_offset) &&
+                    chunk.size <= chunk.raw_size &&
+                    chunk.offset <= mapping.size && chunk.size <= mapping.size - chunk.offset;
+            }
+            is_valid = is_valid && (uint64_t)entry.chunks_count * Db::CHUNK_SIZE >= entry.size;
+
+            arena_offsets[i] = arena_size;
+            arena_size += (entry.size + Db::ALIGNMENT - 1) / Db::ALIGNMENT * Db::ALIGNMENT;
+        }
+
+        unsigned char* arena = arena_size > 0 ? (unsigned char*)malloc(arena_size) : nullptr;
+        std::atomic<bool> is_corrupted = false;
+        Jobs::JobCounter jobs;
+        for (uint32_t i = 0; i < header->entries_count && is_valid; ++i) {
+            const Db::Entry& entry = entries[i];
+            for (uint32_t j = 0; j < entry.chunks_count; ++j) {
+                const Db::Chunk* chunk = &chunks[entry.chunks_first + j];
+                const unsigned char* src = mapping.data + chunk->offset;
+                unsigned char*       dst = arena + arena_offsets[i] + (uint64_t)j * Db::CHUNK_SIZE;
+
+                Jobs::job_pool_submit(&jobs, [chunk, src, dst, &is_corrupted]() {
+                    if (chunk->size == chunk->raw_size)
+                        memcpy(dst, src, chunk->size);
+                    else if (!Lz::lz_decompress(src, chunk->size, dst, chunk->raw_size))
+                        is_corrupted = true;
+                });
+            }
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        // then the ranges and parents, readable now
+        for (uint32_t i = 0; i < header->entries_count && is_valid && !is_corrupted; ++i) {
+            const Db::Entry& entry = entries[i];
+            const unsigned char* blob = entry.chunks_count > 0 ? arena + arena_offsets[i] : mapping.data + entry.offset;
+            is_valid = db_entry_content_is_valid(entry, blob, records);
+        }
+
+        if (!is_valid || is_corrupted) {
+            CC_LOG(CC_ERROR, "%s is corrupted (rebake it)", path);
+            free(arena);
+            file_mapping_close(&mapping);
+            return;
+        }
+
+        storage_reserve(mesh_data,     storage_size(mesh_data)     + header->num_assets[0]);
+        storage_reserve(texture_data,  storage_size(texture_data)  + header->num_assets[1]);
+        storage_reserve(material_data, storage_size(material_data) + header->num_assets[2]);
+        storage_reserve(model_data,    storage_size(model_data)    + header->num_assets[3]);
+
+        for (uint32_t i = 0; i < header->entries_count; ++i) {
+            const Db::Entry& entry = entries[i];
+            unsigned char* blob = entry.chunks_count > 0 ? arena + arena_offsets[i] : mapping.data + entry.offset;
+
+            switch (entry.type) {
+            case Db::ENTRY_MESH: {
+                const Db::MeshRecord* record = (const Db::MeshRecord*)blob;
+                MeshData data = { };
+                data.vertex_count     = record->vertex_count;
+                data.vertex_data_size = record->vertex_data_size;
+                data.index_count      = record->index_count;
+                data.flags            = (uint8_t)record->flags | MeshData::FLAG_MAPPED;
+                data.position_offset  = record->position_offset;
+                data.position_scale   = record->position_scale;
+                data.bounds_min       = record->bounds_min;
+                data.bounds_max       = record->bounds_max;
+                data.bounds_center    = record->bounds_center;
+                data.bounds_radius    = record->bounds_radius;
+                storage_insert(mesh_data, entry.id, data);
+            } break;
+            case Db::ENTRY_MESH_VERTICES:
+                storage_get(mesh_data, entry.id).vertex_data = blob;
+                break;
+            case Db::ENTRY_MESH_INDICES:
+                storage_get(mesh_data, entry.id).index_data = blob;
+                break;
+            case Db::ENTRY_MESH_MESHLETS:
+                storage_get(mesh_data, entry.id).meshlets      = (MeshletData*)blob;
+                storage_get(mesh_data, entry.id).meshlet_count = (uint32_t)(entry.size / sizeof(MeshletData));
+                break;
+            case Db::ENTRY_MESH_LODS:
+                storage_get(mesh_data, entry.id).lods      = (MeshLodData*)blob;
+                storage_get(mesh_data, entry.id).lod_count = (uint32_t)(entry.size / sizeof(MeshLodData));
+                break;
+
+            case Db::ENTRY_TEXTURE: {
+                const Db::TextureRecord* record = (const Db::TextureRecord*)blob;
+                TextureData data;
+                data.width    = record->width;
+                data.height   = record->height;
+                data.mipmaps  = record->mipmaps;
+                data.viewType = (TexViewTypes)record->view_type;
+                data.format   = (VkFormat)record->format;
+                data.flags    = TextureData::FLAG_MAPPED;
+                data.data     = { };
+                data.layers   = record->layers;
+                storage_insert(texture_data, entry.id, data);
+            } break;
+            case Db::ENTRY_TEXTURE_PIXELS:
+                storage_get(texture_data, entry.id).data = std::span<unsigned char>(blob, entry.size);
+                break;
+
+            case Db::ENTRY_MATERIAL: {
+                const Db::MaterialRecord* record = (const Db::MaterialRecord*)blob;
+                MaterialData data;
+                data.id_pipeline_config    = record->id_pipeline_config;
+                data.id_render_pass        = record->id_render_pass;
+                data.id_pipeline           = record->id_pipeline;
+                data.uniform_data_material = nullptr;
+                data.flags                 = (uint8_t)record->flags;
+                storage_insert(material_data, entry.id, data);
+            } break;
+            case Db::ENTRY_MATERIAL_VIEWS: {
+                // tiny, not worth keeping in the mapping
+                const IdAssetTexture* views = (const IdAssetTexture*)blob;
+                storage_get(material_data, entry.id).image_views.assign(views, views + entry.size / sizeof(IdAssetTexture));
+            } break;
+            case Db::ENTRY_MATERIAL_LAYERS: {
+                const uint32_t* image_layers = (const uint32_t*)blob;
+                storage_get(material_data, entry.id).image_layers.assign(image_layers, image_layers + entry.size / sizeof(uint32_t));
+            } break;
+
+            case Db::ENTRY_MODEL: {
+                const Db::ModelRecord* record = (const Db::ModelRecord*)blob;
+                ModelData data = alloc_model_data(record->meshes_count, record->nodes_count);
+                data.transform     = record->transform;
+                data.bounds_min    = record->bounds_min;
+                data.bounds_max    = record->bounds_max;
+                data.bounds_center = record->bounds_center;
+                data.bounds_radius = record->bounds_radius;
+                storage_insert(model_data, (IdAssetModel)entry.id, data);
+            } break;
+            case Db::ENTRY_MODEL_MESHES:
+                memcpy(storage_get(model_data, (IdAssetModel)entry.id).meshes, blob, entry.size);
+                break;
+            case Db::ENTRY_MODEL_MATERIALS:
+                memcpy(storage_get(model_data, (IdAssetModel)entry.id).meshes_material, blob, entry.size);
+                break;
+            case Db::ENTRY_MODEL_MESH_NODES:
+                memcpy(storage_get(model_data, (IdAssetModel)entry.id).meshes_node, blob, entry.size);
+                break;
+            case Db::ENTRY_MODEL_NODE_PARENTS:
+                memcpy(storage_get(model_data, (IdAssetModel)entry.id).nodes_parent, blob, entry.size);
+                break;
+            case Db::ENTRY_MODEL_NODE_TRANSFORMS:
+                memcpy(storage_get(model_data, (IdAssetModel)entry.id).nodes_transform, blob, entry.size);
+                break;
+
+            case Db::ENTRY_TEXTURE_SOURCE: {
+                if (entry.size < sizeof(Db::TextureSourceRecord))
+                    break;
+                const Db::TextureSourceRecord* record = (const Db::TextureSourceRecord*)blob;
+                std::string source_path((const char*)(record + 1), entry.size - sizeof(*record));
+                TextureSource source = {
+                    .id             = entry.id,
+                    .view_type      = (TexViewTypes)record->view_type,
+                    .format         = (VkFormat)record->format,
+                    .flip_vertical  = record->flip_vertical != 0,
+                    .create_mipmaps = record->create_mipmaps != 0,
+                    .compression    = (TexCompression)record->compression,
+                    .layer          = record->layer
+                };
+                texture_sources[source_path].push_back(source);
+                // loading the same file with the same options returns the texture of the db,
+                // unless it became an array (see `pack_texture_arrays`)
+                const TextureData* texture = storage_find(texture_data, source.id);
+                if (texture && texture->viewType != TEX_VIEW_TYPE_2D_ARRAY)
+                    texture_cache_add(
+                        texture_cache_make_key(source_path.c_str(), source.view_type, source.format, source.flip_vertical, source.create_mipmaps, source.compression),
+                        source.id
+                    );
+            } break;
+            case Db::ENTRY_MODEL_SOURCE: {
+                const Db::ModelSourceRecord* record = (const Db::ModelSourceRecord*)blob;
+                if (entry.size < sizeof(Db::ModelSourceRecord) || entry.size - sizeof(*record) < record->base_path_textures_length)
+                    break;
+                const char* strings = (const char*)(record + 1);
+                ModelSource source = {
+                    .id                 = (IdAssetModel)entry.id,
+                    .base_path_textures = std::string(strings, record->base_path_textures_length),
+                    .environment        = {
+                        .specular   = record->environment_specular,
+                        .irradiance = record->environment_irradiance,
+                        .brdf_lut   = record->environment_brdf_lut
+                    },
+                    .options            = {
+                        .optimize_meshes     = record->optimize_meshes != 0,
+                        .lod_count           = record->lod_count,
+                        .texture_compression = (TexCompression)record->texture_compression,
+                        .compact_vertices    = record->compact_vertices != 0,
+                        .id_pipeline_config  = record->id_pipeline_config,
+                        .texture_arrays      = record->texture_arrays != 0
+                    }
+                };
+                std::string source_path(strings + record->base_path_textures_length, entry.size - sizeof(*record) - record->base_path_textures_length);
+                model_sources[source_path].push_back(source);
+            } break;
+
+            default:
+                CC_LOG(CC_WARNING, "[asset db] %s: skipping unknown entry type %d", path, entry.type);
+                break;
+            }
+        }
+
+        db_mappings.push_back(mapping);
+        if (arena)
+            db_arenas.push_back(arena);
+    }
+
+    void asset_db_unload() {
+        // built-ins mapped from a db point into it, the static ones stay
+        for (uint32_t i = 0; i < MAX_BUILTINS; ++i) {
+            if (mesh_data.builtins_alive[i] && (mesh_data.builtins[i].flags & MeshData::FLAG_MAPPED))
+                storage_remove(mesh_data, (IdAssetMesh)~i);
+            if (texture_data.builtins_alive[i] && (texture_data.builtins[i].flags & TextureData::FLAG_MAPPED))
+                storage_remove(texture_data, (IdAssetTexture)~i);
+        }
+
+        for (MeshData& data : mesh_data.dense)
+            free_mesh_data(data);
+        storage_clear(mesh_data);
+
+        for (TextureData& data : texture_data.dense)
+            free_texture_data(data);
+        storage_clear(texture_data);
+
+        storage_clear(material_data);
+
+        for (ModelData& data : model_data.dense)
+            free_model_data(data);
+        storage_clear(model_data);
+
+        for (FileMapping& mapping : db_mappings)
+            file_mapping_close(&mapping);
+        db_mappings.clear();
+        for (void* arena : db_arenas)
+            free(arena);
+        db_arenas.clear();
+
+        texture_cache_clear();
+        texture_sources.clear();
+        model_sources.clear();
+    }
+
+    // ===================================================================================
+    // serialization - legacy
+    // ===================================================================================
+
+    // layout of the structs as they were dumped by the legacy format
+    // (raw structs, pointers included, 64 bit only)
+    struct LegacyMeshData {
+        void*     vertex_data;
+        uint32_t  vertex_count;
+        uint32_t  vertex_data_size;
+        void*     index_data;
+        uint32_t  index_count;
+        uint8_t   flags;
+    };
+
+    struct LegacyTextureData {
+        uint16_t     width;
+        uint16_t     height;
+        uint8_t      mipmaps;
+        TexViewTypes viewType;
+        VkFormat     format;
+        uint32_t     padding;
+    };
+
+    struct LegacyMaterialData {
+        uint32_t id_pipeline_config;
+        uint32_t id_render_pass;
+        uint32_t id_pipeline;
+        void*    uniform_data_material;
+    };
+
+    struct LegacyModelData {
+        glm::mat4        transform;
+        uint32_t         meshes_count;
+        IdAssetMesh*     meshes;
+        IdAssetMaterial* meshes_material;
+    };
+
+    void asset_db_dump_legacy(const char *path) {
         FILE* fp = fopen(path, "wb+");
         
         CC_ASSERT(fp, "error opening file");
 
         uint32_t sizes[] = {
-            num_mesh_assets,
-            num_texture_assets,
-            num_material_assets,
-            num_model_assets
+            storage_count_all(mesh_data),
+            storage_count_all(texture_data),
+            storage_count_all(material_data),
+            storage_count_all(model_data)
         };
 
         fwrite(sizes, sizeof(uint32_t), 4, fp);
 
-        for(auto& kp : mesh_data) {
-            IdAssetMesh id = kp.first;
-            MeshData& data = kp.second;
-            fwrite(&id,              sizeof(IdAssetMesh), 1,                 fp);
-            fwrite(&data,            sizeof(MeshData),    1,                 fp);
-            fwrite(data.vertex_data, sizeof(VertexData),  data.vertex_count, fp);
-            fwrite(data.index_data,  sizeof(uint32_t),    data.index_count,  fp);
-        }
-
-        for(auto& kp : texture_data) {
-            IdAssetTexture id = kp.first;
-            TextureData& data = kp.second;
+        storage_for_each(mesh_data, [fp](IdAssetMesh id, const MeshData& data) {
+            LegacyMeshData legacy = {
+                .vertex_data      = data.vertex_data,
+                .vertex_count     = data.vertex_count,
+                .vertex_data_size = data.vertex_data_size,
+                .index_data       = data.index_data,
+                .index_count      = data.index_count,
+                .flags            = (uint8_t)(data.flags & ~MeshData::FLAG_MAPPED)
+            };
+            fwrite(&id,              sizeof(IdAssetMesh),    1,                 fp);
+            fwrite(&legacy,          sizeof(LegacyMeshData), 1,                 fp);
+            fwrite(data.vertex_data, data.vertex_data_size,  data.vertex_count, fp);
+            fwrite(data.index_data,  mesh_get_index_size(data), data.index_count, fp);
+        });
+
+        storage_for_each(texture_data, [fp](IdAssetTexture id, const TextureData& data) {
+            LegacyTextureData legacy = {
+                .width    = data.width,
+                .height   = data.height,
+                .mipmaps  = data.mipmaps,
+                .viewType = data.viewType,
+                .format   = data.format
+            };
             fwrite(&id,              sizeof(IdAssetTexture), 1,                fp);
-            fwrite(&data,            sizeof(TextureData) - sizeof(std::vector<unsigned char>), 1, fp);
+            fwrite(&legacy,          sizeof(LegacyTextureData), 1, fp);
             // annoying, we have to manually write size if we use std
             size_t num_bytes = data.data.size();
             fwrite(&num_bytes, sizeof(size_t), 1, fp);
-            fwrite(data.data.data(), sizeof(unsigned char),  data.data.size(), fp);
-        }
-
-        for(auto& kp : material_data) {
-            IdAssetMaterial id = kp.first;
-            MaterialData& data = kp.second;
+            std::vector<unsigned char> pixels(data.data.size());
+            texture_read_pixels(data, 0, data.data.size(), pixels.data());
+            fwrite(pixels.data(), sizeof(unsigned char),  pixels.size(), fp);
+        });
+
+        storage_for_each(material_data, [fp](IdAssetMaterial id, const MaterialData& data) {
+            LegacyMaterialData legacy = {
+                .id_pipeline_config    = data.id_pipeline_config,
+                .id_render_pass        = data.id_render_pass,
+                .id_pipeline           = data.id_pipeline,
+                .uniform_data_material = data.uniform_data_material
+            };
             fwrite(&id,                     sizeof(IdAssetMaterial), 1,                       fp);
-            fwrite(&data,                   sizeof(MaterialData) - sizeof(std::vector<IdAssetTexture>), 1, fp);
+            fwrite(&legacy,                 sizeof(LegacyMaterialData), 1, fp);
             // annoying, we have to manually write size if we use std::vector
             size_t num_views = data.image_views.size();
             fwrite(&num_views, sizeof(size_t), 1, fp);
             fwrite(data.image_views.data(), sizeof(IdAssetTexture),  data.image_views.size(), fp);
-        }
-
-        for(auto& kp : model_data) {
-            IdAssetModel id = kp.first;
-            ModelData& data = kp.second;
+        });
+
+        storage_for_each(model_data, [fp](IdAssetModel id, const ModelData& data) {
+            LegacyModelData legacy = {
+                .transform       = data.transform,
+                .meshes_count    = data.meshes_count,
+                .meshes          = data.meshes,
+                .meshes_material = data.meshes_material
+            };
             fwrite(&id,                  sizeof(IdAssetModel),    1,                 fp);
-            fwrite(&data,                sizeof(ModelData),       1,                 fp);
+            fwrite(&legacy,              sizeof(LegacyModelData), 1,                 fp);
             fwrite(data.meshes,          sizeof(IdAssetMesh),     data.meshes_count, fp);
             fwrite(data.meshes_material, sizeof(IdAssetMaterial), data.meshes_count, fp);
-        }
+        });
 
         fclose(fp);
         CC_LOG_SYS_ERROR();
         //CC_ASSERT(fclose(fp) == 0, "error closing file");
     }
-    void asset_db_load(const char *path) {
+
+    void asset_db_load_legacy(const char *path) {
         FILE* fp = fopen(path, "rb+");
 
         CC_ASSERT(fp, "error opening file");
@@ -485,63 +2468,86 @@ namespace vkc::Assets {
         uint32_t sizes[4];
 
         fread(sizes, sizeof(uint32_t), 4, fp);
-        num_mesh_assets     = sizes[0];
-        num_texture_assets  = sizes[1];
-        num_material_assets = sizes[2];
-        num_model_assets    = sizes[3];
 
-        for(int i = 0; i < num_mesh_assets; ++i) {
+        for(uint32_t i = 0; i < sizes[0]; ++i) {
             IdAssetMesh id;
-            MeshData data;
-            fread(&id,              sizeof(IdAssetMesh), 1,                 fp);
-            fread(&data,            sizeof(MeshData),    1,                 fp);
-            data.vertex_data = new VertexData[data.vertex_count];
-            data.index_data  = new uint32_t[data.index_count];
-            fread(data.vertex_data, sizeof(VertexData),  data.vertex_count, fp);
-            fread(data.index_data,  sizeof(uint32_t),    data.index_count,  fp);
-
-            mesh_data[id] = data;
+            LegacyMeshData legacy;
+            fread(&id,              sizeof(IdAssetMesh),    1,                 fp);
+            fread(&legacy,          sizeof(LegacyMeshData), 1,                 fp);
+
+            MeshData data = { };
+            data.vertex_count     = legacy.vertex_count;
+            data.vertex_data_size = legacy.vertex_data_size;
+            data.index_count      = legacy.index_count;
+            data.flags            = legacy.flags;
+            data.vertex_data = malloc((size_t)data.vertex_count * data.vertex_data_size);
+            data.index_data  = malloc((size_t)mesh_get_index_size(data) * data.index_count);
+            fread(data.vertex_data, data.vertex_data_size,  data.vertex_count, fp);
+            fread(data.index_data,  mesh_get_index_size(data), data.index_count, fp);
+            // no bounds in the legacy format
+            if (data.vertex_data_size == sizeof(VertexData))
+                mesh_compute_bounds(&data);
+
+            storage_insert(mesh_data, id, data);
         }
 
-        for(int i = 0; i < num_texture_assets; ++i) {
+        for(uint32_t i = 0; i < sizes[1]; ++i) {
             IdAssetTexture id;
-            TextureData data;
+            LegacyTextureData legacy;
             fread(&id,              sizeof(IdAssetTexture), 1,                fp);
-            fread(&data,            sizeof(TextureData) - sizeof(std::vector<unsigned char>),    1,                fp);
+            fread(&legacy,          sizeof(LegacyTextureData),    1,                fp);
+
+            TextureData data = { };
+            data.width    = legacy.width;
+            data.height   = legacy.height;
+            data.mipmaps  = legacy.mipmaps;
+            data.viewType = legacy.viewType;
+            data.format   = legacy.format;
             // annoying, we have to manually read size if we use std::vector
             size_t num_bytes;
             fread(&num_bytes, sizeof(size_t), 1, fp);
-            data.data.resize(num_bytes);
+            data.data = std::span<unsigned char>((unsigned char*)malloc(num_bytes), num_bytes);
             fread(data.data.data(), sizeof(unsigned char), data.data.size(), fp);
 
-            texture_data[id] = data;
+            storage_insert(texture_data, id, data);
         }
 
-        for(int i = 0; i < num_material_assets; ++i) {
+        for(uint32_t i = 0; i < sizes[2]; ++i) {
             IdAssetMaterial id;
-            MaterialData data;
+            LegacyMaterialData legacy;
             fread(&id,                     sizeof(IdAssetMaterial), 1,                       fp);
-            fread(&data,                   sizeof(MaterialData) - sizeof(std::vector<IdAssetTexture>),    1,                       fp);
+            fread(&legacy,                 sizeof(LegacyMaterialData),    1,                       fp);
+
+            MaterialData data;
+            data.id_pipeline_config    = legacy.id_pipeline_config;
+            data.id_render_pass        = legacy.id_render_pass;
+            data.id_pipeline           = legacy.id_pipeline;
+            data.uniform_data_material = nullptr;
+            // legacy dbs predate texture arrays
+            data.flags                 = 0;
             // annoying, we have to manually read size if we use std::vector
             size_t num_views;
             fread(&num_views, sizeof(size_t), 1, fp);
             data.image_views.resize(num_views);
             fread(data.image_views.data(), sizeof(IdAssetTexture), data.image_views.size(), fp);
 
-            material_data[id] = data;
+            storage_insert(material_data, id, data);
         }
 
-        for(int i = 0; i < num_model_assets; ++i) {
+        for(uint32_t i = 0; i < sizes[3]; ++i) {
             IdAssetModel id;
-            ModelData data;
+            LegacyModelData legacy;
             fread(&id,                  sizeof(IdAssetModel),    1,                 fp);
-            fread(&data,                sizeof(ModelData),       1,                 fp);
-            data.meshes          = new IdAssetMesh[data.meshes_count];
-            data.meshes_material = new IdAssetMaterial[data.meshes_count];
+            fread(&legacy,              sizeof(LegacyModelData), 1,                 fp);
+
+            // no hierarchy in the legacy format, a single identity node
+            ModelData data = alloc_model_data(legacy.meshes_count, 1);
+            data.transform = legacy.transform;
             fread(data.meshes,          sizeof(IdAssetMesh),     data.meshes_count, fp);
             fread(data.meshes_material, sizeof(IdAssetMaterial), data.meshes_count, fp);
+            model_compute_bounds(&data);
 
-            model_data[id] = data;
+            storage_insert(model_data, id, data);
         }
 
         fclose(fp);
@@ -552,143 +2558,456 @@ namespace vkc::Assets {
     // ===================================================================================
     // private
     // ===================================================================================
-    inline void create_mesh(const IdAssetMesh id, const MeshData& data) {
-        mesh_data[id] = data;
+    void create_mesh(const IdAssetMesh id, const MeshData& data) {
+        storage_insert(mesh_data, id, data);
     }
 
-    inline void create_material(const IdAssetMaterial id, const MaterialData& data) {
-        material_data[id] = data;
+    void create_material(const IdAssetMaterial id, const MaterialData& data) {
+        storage_insert(material_data, id, data);
     }
 
     IdAssetTexture load_texture(IdAssetTexture id, const char* path, TexViewTypes viewType, VkFormat format, bool flip_vertical, bool create_mipmaps) {
-        int texWidth = 0;
-        int texHeight = 0;
-        int texChannels = 0;
-        int mips = 1;
+        TextureData data;
+        if (!decode_texture(&data, path, viewType, format, flip_vertical, create_mipmaps))
+            return IDX_MISSING_TEXTURE;
 
-        void* pixels;
-        bool use_stbi = std::filesystem::path(path).extension() != ".dds";
+        storage_insert(texture_data, id, data);
+        texture_source_add(path, {
+            .id             = id,
+            .view_type      = viewType,
+            .format         = format,
+            .flip_vertical  = flip_vertical,
+            .create_mipmaps = create_mipmaps,
+            .compression    = TEX_COMPRESSION_NONE,
+            .layer          = 0
+        });
+        return id;
+    }
 
-        uint32_t size;
-        if (use_stbi) {
-            stbi_set_flip_vertically_on_load(flip_vertical ? 1 : 0);
+    // channels of the 8 bit formats textures are stored uncompressed in, 0 for the others
+    static int texture_format_get_channels(VkFormat format) {
+        switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+            return 2;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_B8G8R8_UNORM:
+        case VK_FORMAT_B8G8R8_SRGB:
+            return 3;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+            return 4;
+        default:
+            return 0;
+        }
+    }
 
+    // `stbi_set_flip_vertically_on_load` is global state shared by all threads, flip by hand instead
+    static void flip_rows(unsigned char* pixels, int width, int height, size_t texel_size) {
+        size_t row_size = width * texel_size;
+        unsigned char* row_tmp = (unsigned char*)malloc(row_size);
+
+        for (int y = 0; y < height / 2; ++y) {
+            unsigned char* row_top    = pixels + y * row_size;
+            unsigned char* row_bottom = pixels + (height - 1 - y) * row_size;
+            memcpy(row_tmp,    row_top,    row_size);
+            memcpy(row_top,    row_bottom, row_size);
+            memcpy(row_bottom, row_tmp,    row_size);
+        }
 
-            if (stbi_is_hdr(path))
-            //if(false)
-            {
-                pixels = stbi_loadf(path, &texWidth, &texHeight, &texChannels, 0);
-                size = texWidth * texHeight * texChannels * sizeof(float);
-            }
-            else {
-                pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, 0);
-                size = texWidth * texHeight * texChannels;
-            }
+        free(row_tmp);
+    }
 
-            if (create_mipmaps) {
-                uint32_t curr_size = size;
-                int curr_width = texWidth;
-                int curr_height = texHeight;
-                int next_width = curr_width / 2;
-                int next_height = curr_height / 2;
+    // Vulkan cubemap layers (+X -X +Y -Y +Z -Z), as faces of the 4x3 cross images come in
+    static const uint32_t CUBE_CROSS_FACE_X[6] = { 2, 0, 1, 1, 1, 3 };
+    static const uint32_t CUBE_CROSS_FACE_Y[6] = { 1, 1, 0, 2, 1, 1 };
+
+    // the 6 faces of a 4x3 cross, one after the other. Returns a malloc'd buffer
+    static unsigned char* cubemap_from_cross(const unsigned char* pixels, uint32_t width, uint32_t face_size, size_t texel_size) {
+        size_t row_size  = face_size * texel_size;
+        size_t face_size_bytes = row_size * face_size;
+        unsigned char* faces = (unsigned char*)malloc(face_size_bytes * 6);
+
+        for (uint32_t face = 0; face < 6; ++face) {
+            const unsigned char* src = pixels + ((size_t)CUBE_CROSS_FACE_Y[face] * face_size * width + CUBE_CROSS_FACE_X[face] * face_size) * texel_size;
+            unsigned char*       dst = faces + face * face_size_bytes;
+            for (uint32_t y = 0; y < face_size; ++y)
+                memcpy(dst + y * row_size, src + (size_t)y * width * texel_size, row_size);
+        }
+        return faces;
+    }
 
-                size = size + size / 3;
-                pixels = realloc(pixels, size);
+    // mips of each of the `layers` images of level 0, the layers of a level stay next to each other
+    // like TextureData::data expects them. Returns a malloc'd buffer
+    static void* generate_mips_layers(
+        const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t layers, uint32_t num_channels,
+        bool is_float, bool is_srgb, uint32_t* out_mips, uint32_t* out_size
+    ) {
+        size_t texel_size = num_channels * (is_float ? sizeof(float) : sizeof(uint8_t));
+        size_t layer_size = (size_t)width * height * texel_size;
+
+        std::vector<unsigned char*> layer_mips(layers);
+        uint32_t layer_mips_size = 0;
+        for (uint32_t layer = 0; layer < layers; ++layer) {
+            layer_mips[layer] = (unsigned char*)texture_generate_mips(
+                pixels + layer * layer_size,
+                width,
+                height,
+                (TexChannelTypes)num_channels,
+                is_float,
+                is_srgb,
+                MIP_FILTER_KAISER,
+                out_mips,
+                &layer_mips_size
+            );
+        }
+        *out_size = layer_mips_size * layers;
+        if (layers == 1)
+            return layer_mips[0];
+
+        unsigned char* out = (unsigned char*)malloc(*out_size);
+        unsigned char* dst = out;
+        size_t src_offset  = 0;
+        for (uint32_t mip = 0; mip < *out_mips; ++mip) {
+            size_t level_size = (size_t)glm::max(width >> mip, 1u) * glm::max(height >> mip, 1u) * texel_size;
+            for (uint32_t layer = 0; layer < layers; ++layer, dst += level_size)
+                memcpy(dst, layer_mips[layer] + src_offset, level_size);
+            src_offset += level_size;
+        }
 
-                unsigned char* pixels_curr_mipmap_level = (unsigned char *)pixels;
-                unsigned char* pixels_next_mipmap_level = (unsigned char *)pixels + curr_size;
+        for (unsigned char* mips : layer_mips)
+            free(mips);
+        return out;
+    }
 
+    // source files of FLAG_FILE textures, indexed by `TextureData::file`. Entries are never removed, a
+    // file reloaded with another layout gets a new one. Also read by the streaming thread of the renderer
+    struct TextureFile {
+        std::string path;
+        uint64_t    size;           // of the whole file when it was parsed
+        uint64_t    data_offset;    // of the mip chain
+    };
+    std::vector<TextureFile> texture_files;
+    std::mutex texture_files_mutex;
+
+    static uint32_t texture_file_add(const char* path, uint64_t size, uint64_t data_offset) {
+        std::lock_guard<std::mutex> lock(texture_files_mutex);
+        for (uint32_t i = 0; i < texture_files.size(); ++i) {
+            const TextureFile& file = texture_files[i];
+            if (file.size == size && file.data_offset == data_offset && file.path == path)
+                return i;
+        }
+        texture_files.push_back({ .path = path, .size = size, .data_offset = data_offset });
+        return (uint32_t)texture_files.size() - 1;
+    }
 
-                /*for(int i = 0; i < size; ++i)
-                    ((unsigned char *)pixels)[i] = i % 3 == 0 ? 255 : 0;*/
+    bool texture_read_pixels(const TextureData& data, uint64_t offset, uint64_t size, void* dst) {
+        CC_ASSERT(offset + size <= data.data.size(), "reading %llu bytes at %llu of %llu bytes of pixels", (unsigned long long)size, (unsigned long long)offset, (unsigned long long)data.data.size());
+        if (!(data.flags & TextureData::FLAG_FILE)) {
+            memcpy(dst, data.data.data() + offset, size);
+            return true;
+        }
 
-                while (next_width > 0 && next_height > 0) {
-                    CC_ASSERT(((size_t)pixels_next_mipmap_level < (size_t)pixels + size), "buffer overrun");
+        TextureFile file;
+        {
+            std::lock_guard<std::mutex> lock(texture_files_mutex);
+            file = texture_files[data.file];
+        }
 
-                    ++mips;
-                    stbir_resize_float_linear(
-                    //stbir_resize_uint8_srgb(
-                    //stbir_resize_uint8_linear(
-                        (float *)pixels_curr_mipmap_level, curr_width, curr_height, 0,
-                        (float *)pixels_next_mipmap_level, next_width, next_height, 0,
-                        STBIR_RGB
-                    );
+        // the file can be edited after the load (hot reload), its layout has to be the one parsed then
+        FileMapping mapping;
+        dds_info info;
+        bool is_valid = file_mapping_open(file.path.c_str(), &mapping);
+        if (is_valid) {
+            is_valid = mapping.size == file.size
+                && dds_parse(mapping.data, mapping.size, &info)
+                && info.data_offset == file.data_offset
+                && info.data_size == data.data.size();
+            if (is_valid)
+                memcpy(dst, mapping.data + file.data_offset + offset, size);
+            file_mapping_close(&mapping);
+        }
+        if (!is_valid) {
+            CC_LOG(CC_ERROR, "%s changed since it was loaded, reading black pixels until it is reloaded", file.path.c_str());
+            memset(dst, 0, size);
+        }
+        return is_valid;
+    }
 
-                    /*int i = 0;
-                    for(unsigned char* p = pixels_curr_mipmap_level; p < pixels_next_mipmap_level; ++p)
-                        *p = i++ % 3 == mips % 3 ? 255 : 0;*/
+    // the mip chain of a DDS file is already in the layout of TextureData::data: only the header is
+    // parsed here, the levels stay in the file and `texture_read_pixels` copies them from a fresh mapping
+    // wherever they go (staging memory of the renderer, asset db). Source files are not kept mapped
+    // like the asset dbs: they can be edited or truncated while the texture is alive (hot reload).
+    // Format and mips come from the file, flipping and cubemap crosses are not supported
+    static bool decode_texture_dds(TextureData* out_data, const char* path, TexViewTypes viewType) {
+        if (viewType != TEX_VIEW_TYPE_2D) {
+            CC_LOG(CC_WARNING, "DDS textures can only be 2D, %s", path);
+            return false;
+        }
 
-                    curr_width = next_width;
-                    curr_height = next_height;
+        FileMapping mapping;
+        if (!file_mapping_open(path, &mapping))
+            return false;
 
-                    next_width = curr_width / 2;
-                    next_height = curr_height / 2;
+        dds_info info;
+        bool is_valid = dds_parse(mapping.data, mapping.size, &info);
+        uint64_t file_size = mapping.size;
+        file_mapping_close(&mapping);
+        if (!is_valid)
+            return false;
 
-                    curr_size = (curr_width) * (curr_height) * texChannels * sizeof(float);
-                    //curr_size /= 4;
+        TextureData data;
+        data.viewType = viewType;
+        data.width    = (uint16_t)info.width;
+        data.height   = (uint16_t)info.height;
+        data.mipmaps  = (uint8_t)info.mips;
+        data.format   = info.format;
+        data.flags    = TextureData::FLAG_FILE;
+        data.data     = std::span<unsigned char>((unsigned char*)nullptr, info.data_size);
+        data.layers   = 0;
+        data.file     = texture_file_add(path, file_size, info.data_offset);
+        *out_data = data;
+        return true;
+    }
 
-                    pixels_curr_mipmap_level = pixels_next_mipmap_level;
-                    pixels_next_mipmap_level += curr_size;
+    bool decode_texture(TextureData* out_data, const char* path, TexViewTypes viewType, VkFormat format, bool flip_vertical, bool create_mipmaps, TexCompression compression) {
+        // mapping the file costs as much as reading the bake cache
+        if (std::filesystem::path(path).extension() == ".dds") {
+            if (decode_texture_dds(out_data, path, viewType))
+                return true;
+            CC_LOG(CC_WARNING, "missing texture at path %s", path);
+            return false;
+        }
 
-                }
-            }
+        // decoded, mipmapped and compressed result of an earlier bake
+        uint64_t bake_key = 0;
+        if (bake_cache_is_enabled()) {
+            char key_options[64];
+            snprintf(key_options, sizeof(key_options), "texture|%d|%d|%d|%d|%d", viewType, format, flip_vertical, create_mipmaps, compression);
+            uint64_t content_hash = bake_cache_hash_file(path);
+            if (content_hash != 0)
+                bake_key = bake_cache_make_key(content_hash, key_options);
         }
-        else
+        if (bake_key != 0 && bake_cache_load_texture(bake_key, out_data))
+            return true;
+
+        int texWidth = 0;
+        int texHeight = 0;
+        int texChannels = 0;
+        int mips = 1;
+
+        void* pixels;
+        uint32_t size;
+        // 8 bit images requested in an HDR format are decoded as floats by stbi
+        bool is_hdr = stbi_is_hdr(path) || texture_is_compact_hdr_format(format);
+        if (is_hdr)
+        //if(false)
         {
-            FILE* fp = fopen(path, "rb");
-            fseek(fp, 0, SEEK_END);
-            size_t file_size = ftell(fp);
-            fseek(fp, 0, SEEK_SET);
-
-            unsigned char * file_buf = (unsigned char *)malloc(file_size);
-            fread(file_buf, 1, file_size, fp);
-            fclose(fp);
-
-            int file_format;
-
-            pixels = rl_load_dds_from_memory(
-                file_buf,
-                file_size,
-                &texWidth,
-                &texHeight,
-                &file_format,
-                &mips,
-                &size
+            pixels = stbi_loadf(path, &texWidth, &texHeight, &texChannels, 0);
+            size = texWidth * texHeight * texChannels * sizeof(float);
+            if (pixels != nullptr && flip_vertical)
+                flip_rows((unsigned char*)pixels, texWidth, texHeight, texChannels * sizeof(float));
+        }
+        else {
+            // uncompressed texels are uploaded as is, they get the channels of the format. Block
+            // compression picks its format from the channels of the file instead
+            int format_channels = compression == TEX_COMPRESSION_NONE ? texture_format_get_channels(format) : 0;
+            pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, format_channels);
+            if (format_channels != 0)
+                texChannels = format_channels;
+            size = texWidth * texHeight * texChannels;
+            if (pixels != nullptr && flip_vertical)
+                flip_rows((unsigned char*)pixels, texWidth, texHeight, texChannels);
+        }
+
+        // cubemaps are baked face by face: level 0 is cut out of the cross, each face gets its own mips
+        // and is compressed on its own, so the upload is a single copy whatever the format
+        uint32_t layers = 1;
+        if (pixels != nullptr && viewType == TEX_VIEW_TYPE_CUBE) {
+            size_t   texel_size = texChannels * (is_hdr ? sizeof(float) : sizeof(uint8_t));
+            uint32_t face_size  = texWidth / 4;
+            if (face_size == 0 || (uint32_t)texWidth != face_size * 4 || (uint32_t)texHeight != face_size * 3) {
+                CC_LOG(CC_WARNING, "cubemap %s is %dx%d, a 4x3 cross of square faces expected", path, texWidth, texHeight);
+                free(pixels);
+                return false;
+            }
+
+            unsigned char* faces = cubemap_from_cross((unsigned char*)pixels, texWidth, face_size, texel_size);
+            free(pixels);
+            pixels = faces;
+            texWidth = texHeight = face_size;
+            size = (uint32_t)(face_size * face_size * texel_size * 6);
+            layers = 6;
+        }
+
+        if (create_mipmaps && pixels != nullptr) {
+            uint32_t mips_size;
+            uint32_t mips_count;
+            void* pixels_mips = generate_mips_layers(
+                (unsigned char*)pixels,
+                texWidth,
+                texHeight,
+                layers,
+                texChannels,
+                is_hdr,
+                texture_format_is_srgb(format),
+                &mips_count,
+                &mips_size
             );
 
+            free(pixels);
+            pixels = pixels_mips;
+            size = mips_size;
+            mips = mips_count;
+        }
 
-            // overrides format since file carries it in header
-            format = static_cast<VkFormat>(file_format);
+        // HDR textures requested in a compact format instead of 12 or 16 bytes per texel
+        if (pixels != nullptr && is_hdr && texture_is_compact_hdr_format(format)) {
+            uint32_t compressed_size;
+            unsigned char* compressed = texture_compress_hdr((float*)pixels, texWidth, texHeight, mips, layers, texChannels, format, &compressed_size);
+            CC_LOG(CC_INFO, "compressed %s: %u -> %u bytes", path, size, compressed_size);
 
-            free(file_buf);
+            free(pixels);
+            pixels = compressed;
+            size = compressed_size;
+        }
+
+        // block compression of 8 bit textures, the format follows the channels actually in the file
+        if (pixels != nullptr && !is_hdr) {
+            bool has_alpha = texture_has_alpha((unsigned char*)pixels, texWidth * texHeight * layers, texChannels);
+            VkFormat compressed_format = texture_choose_compressed_format(format, texChannels, has_alpha, compression);
+
+            if (compressed_format != VK_FORMAT_UNDEFINED) {
+                uint32_t compressed_size;
+                unsigned char* compressed = texture_compress((unsigned char*)pixels, texWidth, texHeight, mips, layers, texChannels, compressed_format, &compressed_size);
+                CC_LOG(CC_INFO, "compressed %s: %u -> %u bytes", path, size, compressed_size);
+
+                free(pixels);
+                pixels = compressed;
+                size = compressed_size;
+                format = compressed_format;
+            }
         }
 
         if (pixels == nullptr) {
             CC_LOG(CC_WARNING, "missing texture at path %s", path);
-            return IDX_MISSING_TEXTURE;
+            return false;
         }
 
-
-
+        // stbi and the mip and compression passes allocate with malloc, the texture takes ownership of the pixels
         TextureData data;
         data.viewType = viewType;
         data.width = (uint16_t)texWidth;
         data.height = (uint16_t)texHeight;
         data.mipmaps = mips;
         data.format = format;
-        data.data.resize(size);
-        memcpy(data.data.data(), pixels, size);
+        data.flags = 0;
+        data.data = std::span<unsigned char>((unsigned char*)pixels, size);
 
-        if (use_stbi)
+        if (bake_key != 0)
+            bake_cache_store_texture(bake_key, data);
+        *out_data = data;
+        return true;
+    }
+
+    bool decode_environment(TextureData* out_specular, TextureData* out_irradiance, const char* path, bool flip_vertical) {
+        // the prefilter takes seconds, its results are worth caching between bakes
+        uint64_t key_specular   = 0;
+        uint64_t key_irradiance = 0;
+        if (bake_cache_is_enabled()) {
+            uint64_t content_hash = bake_cache_hash_file(path);
+            if (content_hash != 0) {
+                char key_options[96];
+                snprintf(
+                    key_options,
+                    sizeof(key_options),
+                    "environment|specular|%d|%d|%u|%u|%u",
+                    flip_vertical,
+                    VK_FORMAT_E5B9G9R9_UFLOAT_PACK32,
+                    ENVIRONMENT_SPECULAR_WIDTH,
+                    ENVIRONMENT_SPECULAR_MIPS,
+                    ENVIRONMENT_SPECULAR_SAMPLES
+                );
+                key_specular = bake_cache_make_key(content_hash, key_options);
+                snprintf(key_options, sizeof(key_options), "environment|irradiance|%d", flip_vertical);
+                key_irradiance = bake_cache_make_key(content_hash, key_options);
+            }
+        }
+        if (key_specular != 0 && bake_cache_load_texture(key_specular, out_specular)) {
+            if (bake_cache_load_texture(key_irradiance, out_irradiance))
+                return true;
+            free_texture_data(*out_specular);
+        }
+
+        auto time_start = std::chrono::high_resolution_clock::now();
+
+        int width;
+        int height;
+        int channels;
+        float* pixels = stbi_loadf(path, &width, &height, &channels, 0);
+        if (pixels == nullptr)
+            return false;
+        if (channels < 3) {
+            CC_LOG(CC_WARNING, "environment %s has %d channels, RGB expected", path, channels);
             stbi_image_free(pixels);
-        else
-            free(pixels);
+            return false;
+        }
+        if (flip_vertical)
+            flip_rows((unsigned char*)pixels, width, height, channels * sizeof(float));
 
-        if (viewType == TEX_VIEW_TYPE_CUBE) {
-            data.width /= 4;
-            data.height /= 3;
+        uint32_t size;
+        void* specular = environment_prefilter_specular(pixels, width, height, channels, &size);
+        out_specular->viewType = TEX_VIEW_TYPE_2D;
+        out_specular->width    = ENVIRONMENT_SPECULAR_WIDTH;
+        out_specular->height   = ENVIRONMENT_SPECULAR_WIDTH / 2;
+        out_specular->mipmaps  = ENVIRONMENT_SPECULAR_MIPS;
+        out_specular->format   = VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+        out_specular->flags    = 0;
+        out_specular->data     = std::span<unsigned char>((unsigned char*)specular, size);
+
+        // one texel per coefficient, full precision: the higher bands are small next to the first one
+        glm::vec3 sh[ENVIRONMENT_SH_COEFFICIENTS];
+        environment_compute_sh_irradiance(pixels, width, height, channels, sh);
+        float* coefficients = (float*)malloc(ENVIRONMENT_SH_COEFFICIENTS * 4 * sizeof(float));
+        for (uint32_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; ++i) {
+            coefficients[i * 4 + 0] = sh[i].r;
+            coefficients[i * 4 + 1] = sh[i].g;
+            coefficients[i * 4 + 2] = sh[i].b;
+            coefficients[i * 4 + 3] = 1.0f;
         }
-        texture_data[id] = data;
-        return id;
+        out_irradiance->viewType = TEX_VIEW_TYPE_2D;
+        out_irradiance->width    = ENVIRONMENT_SH_COEFFICIENTS;
+        out_irradiance->height   = 1;
+        out_irradiance->mipmaps  = 1;
+        out_irradiance->format   = VK_FORMAT_R32G32B32A32_SFLOAT;
+        out_irradiance->flags    = 0;
+        out_irradiance->data     = std::span<unsigned char>((unsigned char*)coefficients, ENVIRONMENT_SH_COEFFICIENTS * 4 * sizeof(float));
+
+        stbi_image_free(pixels);
+
+        CC_LOG(
+            CC_INFO,
+            "[environment] %s: %dx%d -> %dx%d, %d mips in %.2fms",
+            path,
+            width,
+            height,
+            out_specular->width,
+            out_specular->height,
+            out_specular->mipmaps,
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - time_start).count()
+        );
+
+        if (key_specular != 0) {
+            bake_cache_store_texture(key_specular, *out_specular);
+            bake_cache_store_texture(key_irradiance, *out_irradiance);
+        }
+        return true;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+#include <stdint.h>
+#include <vector>
+
+// dense storage of one asset type, addressed by generational handles (see the id layout in AssetManager.hpp)
+//
+// - values are packed in `dense`, `dense_ids[i]` is the id of `dense[i]`: iterating over all assets
+//   walks two contiguous arrays, no pointer chasing
+// - `slots` maps the index of an id to its position in `dense`. Removing swaps the last value
+//   into the hole and bumps the generation of the slot, ids of removed assets stop resolving
+// - built-ins live in their own small array, indexed by the bitwise not of their id
+//   (-1 -> 0, -2 -> 1, ...), they never move and are skipped by `storage_clear`
+//
+// references and spans into `dense` are invalidated by add, insert and remove
+namespace vkc::Assets {
+	const uint32_t ID_INDEX_BITS      = 24;
+	const uint32_t ID_INDEX_MASK      = (1u << ID_INDEX_BITS) - 1;
+	const uint32_t ID_GENERATION_MASK = 0x7F;
+	const uint32_t ID_BUILTIN_FLAG    = 0x80000000;
+	const uint32_t MAX_BUILTINS       = 16;
+
+	const uint32_t SLOT_FREE = 0xFFFFFFFF;
+
+	inline uint32_t id_make(uint32_t index, uint32_t generation) {
+		return ((generation & ID_GENERATION_MASK) << ID_INDEX_BITS) | index;
+	}
+
+	inline uint32_t id_get_index(uint32_t id) {
+		return id & ID_INDEX_MASK;
+	}
+
+	inline uint32_t id_get_generation(uint32_t id) {
+		return (id >> ID_INDEX_BITS) & ID_GENERATION_MASK;
+	}
+
+	inline bool id_is_builtin(uint32_t id) {
+		return id & ID_BUILTIN_FLAG;
+	}
+
+	template <typename Id, typename T>
+	struct AssetStorage {
+		struct Slot {
+			uint32_t dense;			// SLOT_FREE when unused
+			uint32_t generation;
+		};
+
+		std::vector<T>        dense;
+		std::vector<Id>       dense_ids;
+		std::vector<Slot>     slots;
+		// stack of released slots, may hold slots taken since by `storage_insert`, skipped on pop
+		std::vector<uint32_t> free_slots;
+
+		T    builtins[MAX_BUILTINS];
+		bool builtins_alive[MAX_BUILTINS] = { };
+	};
+
+	template <typename Id, typename T>
+	T* storage_find(AssetStorage<Id, T>& storage, Id id) {
+		uint32_t handle = (uint32_t)id;
+		if (id_is_builtin(handle)) {
+			uint32_t index = ~handle;
+			if (index >= MAX_BUILTINS || !storage.builtins_alive[index])
+				return nullptr;
+			return &storage.builtins[index];
+		}
+
+		uint32_t index = id_get_index(handle);
+		if (index >= storage.slots.size())
+			return nullptr;
+
+		const auto& slot = storage.slots[index];
+		if (slot.dense == SLOT_FREE || slot.generation != id_get_generation(handle))
+			return nullptr;
+		return &storage.dense[slot.dense];
+	}
+
+	template <typename Id, typename T>
+	bool storage_contains(AssetStorage<Id, T>& storage, Id id) {
+		return storage_find(storage, id) != nullptr;
+	}
+
+	template <typename Id, typename T>
+	T& storage_get(AssetStorage<Id, T>& storage, Id id) {
+		T* value = storage_find(storage, id);
+		CC_ASSERT(value, "invalid or stale asset id");
+		return *value;
+	}
+
+	// new id, released slots are reused first
+	template <typename Id, typename T>
+	Id storage_add(AssetStorage<Id, T>& storage, const T& value) {
+		uint32_t index = SLOT_FREE;
+		while (!storage.free_slots.empty()) {
+			uint32_t candidate = storage.free_slots.back();
+			storage.free_slots.pop_back();
+			if (storage.slots[candidate].dense == SLOT_FREE) {
+				index = candidate;
+				break;
+			}
+		}
+
+		if (index == SLOT_FREE) {
+			CC_ASSERT(storage.slots.size() <= ID_INDEX_MASK, "too many assets of a single type");
+			index = (uint32_t)storage.slots.size();
+			storage.slots.push_back({ .dense = SLOT_FREE, .generation = 0 });
+		}
+
+		auto& slot = storage.slots[index];
+		slot.dense = (uint32_t)storage.dense.size();
+
+		Id id = (Id)id_make(index, slot.generation);
+		storage.dense.push_back(value);
+		storage.dense_ids.push_back(id);
+		return id;
+	}
+
+	// stores `value` at a given id (built-ins, asset db), replacing whatever was there
+	template <typename Id, typename T>
+	void storage_insert(AssetStorage<Id, T>& storage, Id id, const T& value) {
+		uint32_t handle = (uint32_t)id;
+		if (id_is_builtin(handle)) {
+			uint32_t index = ~handle;
+			CC_ASSERT(index < MAX_BUILTINS, "built-in asset id out of the reserved range");
+			storage.builtins[index]       = value;
+			storage.builtins_alive[index] = true;
+			return;
+		}
+
+		uint32_t index = id_get_index(handle);
+		while (storage.slots.size() <= index) {
+			storage.free_slots.push_back((uint32_t)storage.slots.size());
+			storage.slots.push_back({ .dense = SLOT_FREE, .generation = 0 });
+		}
+
+		auto& slot = storage.slots[index];
+		slot.generation = id_get_generation(handle);
+		if (slot.dense != SLOT_FREE) {
+			storage.dense[slot.dense]     = value;
+			storage.dense_ids[slot.dense] = id;
+			return;
+		}
+
+		slot.dense = (uint32_t)storage.dense.size();
+		storage.dense.push_back(value);
+		storage.dense_ids.push_back(id);
+	}
+
+	template <typename Id, typename T>
+	void storage_remove(AssetStorage<Id, T>& storage, Id id) {
+		uint32_t handle = (uint32_t)id;
+		if (id_is_builtin(handle)) {
+			uint32_t index = ~handle;
+			if (index < MAX_BUILTINS)
+				storage.builtins_alive[index] = false;
+			return;
+		}
+
+		if (!storage_contains(storage, id))
+			return;
+
+		auto& slot = storage.slots[id_get_index(handle)];
+		uint32_t last = (uint32_t)storage.dense.size() - 1;
+		if (slot.dense != last) {
+			storage.dense[slot.dense]     = std::move(storage.dense[last]);
+			storage.dense_ids[slot.dense] = storage.dense_ids[last];
+			storage.slots[id_get_index((uint32_t)storage.dense_ids[last])].dense = slot.dense;
+		}
+		storage.dense.pop_back();
+		storage.dense_ids.pop_back();
+
+		slot.dense = SLOT_FREE;
+		slot.generation = (slot.generation + 1) & ID_GENERATION_MASK;
+		storage.free_slots.push_back(id_get_index(handle));
+	}
+
+	// removes everything but the built-ins. The next ids start again from the first slot,
+	// with a newer generation
+	template <typename Id, typename T>
+	void storage_clear(AssetStorage<Id, T>& storage) {
+		storage.dense.clear();
+		storage.dense_ids.clear();
+		storage.free_slots.clear();
+		for (uint32_t i = (uint32_t)storage.slots.size(); i-- > 0;) {
+			auto& slot = storage.slots[i];
+			if (slot.dense != SLOT_FREE) {
+				slot.dense = SLOT_FREE;
+				slot.generation = (slot.generation + 1) & ID_GENERATION_MASK;
+			}
+			storage.free_slots.push_back(i);
+		}
+	}
+
+	template <typename Id, typename T>
+	void storage_reserve(AssetStorage<Id, T>& storage, uint32_t count) {
+		storage.dense.reserve(count);
+		storage.dense_ids.reserve(count);
+		storage.slots.reserve(count);
+	}
+
+	// non built-in assets
+	template <typename Id, typename T>
+	uint32_t storage_size(const AssetStorage<Id, T>& storage) {
+		return (uint32_t)storage.dense.size();
+	}
+
+	template <typename Id, typename T>
+	AssetRange<Id, T> storage_range(AssetStorage<Id, T>& storage) {
+		return {
+			.ids  = std::span<const Id>(storage.dense_ids),
+			.data = std::span<T>(storage.dense)
+		};
+	}
+
+	// built-ins first, then the dense array: `f(Id, T&)`
+	template <typename Id, typename T, typename F>
+	void storage_for_each(AssetStorage<Id, T>& storage, F f) {
+		for (uint32_t i = 0; i < MAX_BUILTINS; ++i)
+			if (storage.builtins_alive[i])
+				f((Id)~i, storage.builtins[i]);
+		for (size_t i = 0; i < storage.dense.size(); ++i)
+			f(storage.dense_ids[i], storage.dense[i]);
+	}
+
+	// built-ins and dense array
+	template <typename Id, typename T>
+	uint32_t storage_count_all(const AssetStorage<Id, T>& storage) {
+		uint32_t count = (uint32_t)storage.dense.size();
+		for (uint32_t i = 0; i < MAX_BUILTINS; ++i)
+			count += storage.builtins_alive[i];
+		return count;
+	}
+}
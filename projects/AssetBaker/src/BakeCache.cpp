@@ -0,0 +1,392 @@
+#include "BakeCache.hpp"
+#include "AssetDatabase.hpp"
+#include "FileMapping.hpp"
+
+extern "C" {
+    #include <cc_hash.h>
+}
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <filesystem>
+
+namespace vkc::Assets {
+    const uint32_t BAKE_CACHE_MAGIC = 0x4B414256; // "VBAK"
+
+    enum BakeEntryType : uint32_t {
+        BAKE_ENTRY_TEXTURE = 0,
+        BAKE_ENTRY_MODEL   = 1,
+    };
+
+    struct BakeEntryHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t type;
+        uint32_t padding;
+    };
+
+    struct BakeModelCounts {
+        uint32_t meshes_count;
+        uint32_t materials_count;
+        uint32_t texture_paths_count;
+        uint32_t nodes_count;
+        uint32_t instances_count;
+        uint32_t padding[3];
+    };
+
+    struct BakeMeshCounts {
+        uint32_t meshlet_count;
+        uint32_t lod_count;
+    };
+
+    struct BakeCacheStats {
+        std::atomic<uint32_t> num_hits;
+        std::atomic<uint32_t> num_misses;
+        std::atomic<uint64_t> bytes_loaded;
+        std::atomic<uint64_t> bytes_stored;
+    };
+
+    static std::string    bake_cache_dir;
+    static BakeCacheStats bake_cache_stats;
+    static std::atomic<uint32_t> bake_cache_tmp_counter = 0;
+
+    void bake_cache_init(const char* dir) {
+        std::error_code error;
+        std::filesystem::create_directories(dir, error);
+        if (error) {
+            CC_LOG(CC_WARNING, "[bake cache] can't create %s, cache disabled", dir);
+            return;
+        }
+        bake_cache_dir = dir;
+    }
+
+    bool bake_cache_is_enabled() {
+        return !bake_cache_dir.empty();
+    }
+
+    void bake_cache_print_stats() {
+        if (!bake_cache_is_enabled())
+            return;
+
+        CC_LOG(
+            CC_INFO,
+            "[bake cache] %d hits, %d misses, %.2fMB loaded, %.2fMB stored",
+            bake_cache_stats.num_hits.load(),
+            bake_cache_stats.num_misses.load(),
+            bake_cache_stats.bytes_loaded.load() / (1024.0 * 1024.0),
+            bake_cache_stats.bytes_stored.load() / (1024.0 * 1024.0)
+        );
+    }
+
+    uint64_t bake_cache_hash_file(const char* path) {
+        FileMapping mapping;
+        if (!file_mapping_open(path, &mapping))
+            return 0;
+
+        uint64_t hash = Lookup3((const char*)mapping.data, mapping.size);
+        file_mapping_close(&mapping);
+        return hash;
+    }
+
+    uint64_t bake_cache_make_key(uint64_t content_hash, const char* options) {
+        std::string key = std::to_string(content_hash) + "|" + std::to_string(BAKE_CACHE_VERSION) + "|" + options;
+        return Lookup3(key.c_str(), key.size());
+    }
+
+    // ===================================================================================
+    // files
+    // ===================================================================================
+    static std::string get_entry_path(uint64_t key, BakeEntryType type) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.%s", (unsigned long long)key, type == BAKE_ENTRY_TEXTURE ? "tex" : "model");
+        return bake_cache_dir + "/" + name;
+    }
+
+    static FILE* open_entry(uint64_t key, BakeEntryType type) {
+        FILE* fp = fopen(get_entry_path(key, type).c_str(), "rb");
+        if (!fp)
+            return nullptr;
+
+        BakeEntryHeader header;
+        if (
+            fread(&header, sizeof(header), 1, fp) != 1 ||
+            header.magic != BAKE_CACHE_MAGIC ||
+            header.version != BAKE_CACHE_VERSION ||
+            header.key != key ||
+            header.type != type
+        ) {
+            fclose(fp);
+            return nullptr;
+        }
+        return fp;
+    }
+
+    // entries are written next to their final path and renamed once complete
+    static FILE* create_entry(uint64_t key, BakeEntryType type, std::string* out_tmp_path) {
+        *out_tmp_path = get_entry_path(key, type) + "." + std::to_string(bake_cache_tmp_counter++) + ".tmp";
+        FILE* fp = fopen(out_tmp_path->c_str(), "wb");
+        if (!fp)
+            return nullptr;
+
+        BakeEntryHeader header = { };
+        header.magic   = BAKE_CACHE_MAGIC;
+        header.version = BAKE_CACHE_VERSION;
+        header.key     = key;
+        header.type    = type;
+        fwrite(&header, sizeof(header), 1, fp);
+        return fp;
+    }
+
+    static void commit_entry(FILE* fp, uint64_t key, BakeEntryType type, const std::string& tmp_path) {
+        bool is_written = !ferror(fp);
+        uint64_t size = (uint64_t)ftell(fp);
+        fclose(fp);
+
+        std::error_code error;
+        if (is_written)
+            std::filesystem::rename(tmp_path, get_entry_path(key, type), error);
+        if (!is_written || error) {
+            CC_LOG(CC_WARNING, "[bake cache] error writing %s", tmp_path.c_str());
+            std::filesystem::remove(tmp_path, error);
+            return;
+        }
+        bake_cache_stats.bytes_stored += size;
+    }
+
+    // malloc'd copy of the next `size` bytes, nullptr for empty blobs
+    static bool read_blob(FILE* fp, uint64_t size, void** out_data) {
+        *out_data = nullptr;
+        if (size == 0)
+            return true;
+
+        *out_data = malloc(size);
+        if (fread(*out_data, 1, size, fp) != size) {
+            free(*out_data);
+            *out_data = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // ===================================================================================
+    // textures
+    // ===================================================================================
+    bool bake_cache_load_texture(uint64_t key, TextureData* out_data) {
+        FILE* fp = open_entry(key, BAKE_ENTRY_TEXTURE);
+        if (!fp) {
+            ++bake_cache_stats.num_misses;
+            return false;
+        }
+
+        Db::TextureRecord record;
+        uint64_t size;
+        void*    pixels = nullptr;
+        bool is_valid =
+            fread(&record, sizeof(record), 1, fp) == 1 &&
+            fread(&size, sizeof(size), 1, fp) == 1 &&
+            read_blob(fp, size, &pixels);
+        fclose(fp);
+
+        if (!is_valid) {
+            ++bake_cache_stats.num_misses;
+            return false;
+        }
+
+        TextureData data;
+        data.width    = record.width;
+        data.height   = record.height;
+        data.mipmaps  = record.mipmaps;
+        data.viewType = (TexViewTypes)record.view_type;
+        data.format   = (VkFormat)record.format;
+        data.layers   = record.layers;
+        data.flags    = 0;
+        data.data     = std::span<unsigned char>((unsigned char*)pixels, size);
+        *out_data = data;
+
+        ++bake_cache_stats.num_hits;
+        bake_cache_stats.bytes_loaded += size;
+        return true;
+    }
+
+    void bake_cache_store_texture(uint64_t key, const TextureData& data) {
+        std::string tmp_path;
+        FILE* fp = create_entry(key, BAKE_ENTRY_TEXTURE, &tmp_path);
+        if (!fp)
+            return;
+
+        Db::TextureRecord record = { };
+        record.width     = data.width;
+        record.height    = data.height;
+        record.mipmaps   = data.mipmaps;
+        record.view_type = data.viewType;
+        record.layers    = data.layers;
+        record.format    = (uint32_t)data.format;
+        uint64_t size = data.data.size();
+        fwrite(&record, sizeof(record), 1, fp);
+        fwrite(&size, sizeof(size), 1, fp);
+        fwrite(data.data.data(), 1, size, fp);
+
+        commit_entry(fp, key, BAKE_ENTRY_TEXTURE, tmp_path);
+    }
+
+    // ===================================================================================
+    // models
+    // ===================================================================================
+    static void free_meshes(std::vector<MeshData>& meshes) {
+        for (MeshData& mesh : meshes) {
+            free(mesh.vertex_data);
+            free(mesh.index_data);
+            free(mesh.meshlets);
+            free(mesh.lods);
+        }
+        meshes.clear();
+    }
+
+    static bool read_mesh(FILE* fp, MeshData* out_mesh) {
+        Db::MeshRecord record;
+        BakeMeshCounts counts;
+        if (fread(&record, sizeof(record), 1, fp) != 1 || fread(&counts, sizeof(counts), 1, fp) != 1)
+            return false;
+
+        MeshData mesh = { };
+        mesh.vertex_count     = record.vertex_count;
+        mesh.vertex_data_size = record.vertex_data_size;
+        mesh.index_count      = record.index_count;
+        mesh.flags            = (uint8_t)record.flags;
+        mesh.position_offset  = record.position_offset;
+        mesh.position_scale   = record.position_scale;
+        mesh.bounds_min       = record.bounds_min;
+        mesh.bounds_max       = record.bounds_max;
+        mesh.bounds_center    = record.bounds_center;
+        mesh.bounds_radius    = record.bounds_radius;
+        mesh.meshlet_count    = counts.meshlet_count;
+        mesh.lod_count        = counts.lod_count;
+
+        bool is_valid =
+            read_blob(fp, (uint64_t)mesh.vertex_count * mesh.vertex_data_size, &mesh.vertex_data) &&
+            read_blob(fp, (uint64_t)mesh.index_count * mesh_get_index_size(mesh), &mesh.index_data) &&
+            read_blob(fp, (uint64_t)mesh.meshlet_count * sizeof(MeshletData), (void**)&mesh.meshlets) &&
+            read_blob(fp, (uint64_t)mesh.lod_count * sizeof(MeshLodData), (void**)&mesh.lods);
+
+        // owned by the caller from here on, even when incomplete
+        *out_mesh = mesh;
+        return is_valid;
+    }
+
+    bool bake_cache_load_model(uint64_t key, BakedModel* out_model) {
+        FILE* fp = open_entry(key, BAKE_ENTRY_MODEL);
+        if (!fp) {
+            ++bake_cache_stats.num_misses;
+            return false;
+        }
+
+        BakedModel model;
+        BakeModelCounts counts;
+        bool is_valid = fread(&counts, sizeof(counts), 1, fp) == 1;
+
+        if (is_valid) {
+            model.materials_count = counts.materials_count;
+            model.meshes.resize(counts.meshes_count);
+            model.meshes_material.resize(counts.meshes_count);
+            model.imported_vertex_counts.resize(counts.meshes_count);
+            model.texture_paths.resize(counts.texture_paths_count);
+            model.nodes_parent.resize(counts.nodes_count);
+            model.nodes_transform.resize(counts.nodes_count);
+            model.instances_mesh.resize(counts.instances_count);
+            model.instances_node.resize(counts.instances_count);
+        }
+
+        for (uint32_t i = 0; i < counts.meshes_count && is_valid; ++i)
+            is_valid = read_mesh(fp, &model.meshes[i]);
+
+        is_valid = is_valid &&
+            fread(model.meshes_material.data(),        sizeof(uint32_t), counts.meshes_count, fp) == counts.meshes_count &&
+            fread(model.imported_vertex_counts.data(), sizeof(uint32_t), counts.meshes_count, fp) == counts.meshes_count &&
+            fread(model.nodes_parent.data(),           sizeof(uint32_t),  counts.nodes_count, fp) == counts.nodes_count &&
+            fread(model.nodes_transform.data(),        sizeof(glm::mat4), counts.nodes_count, fp) == counts.nodes_count &&
+            fread(model.instances_mesh.data(),         sizeof(uint32_t), counts.instances_count, fp) == counts.instances_count &&
+            fread(model.instances_node.data(),         sizeof(uint32_t), counts.instances_count, fp) == counts.instances_count;
+
+        for (uint32_t i = 0; i < counts.texture_paths_count && is_valid; ++i) {
+            uint32_t length;
+            is_valid = fread(&length, sizeof(length), 1, fp) == 1;
+            if (is_valid) {
+                model.texture_paths[i].resize(length);
+                is_valid = fread(model.texture_paths[i].data(), 1, length, fp) == length;
+            }
+        }
+
+        uint64_t size = (uint64_t)ftell(fp);
+        fclose(fp);
+
+        if (!is_valid) {
+            free_meshes(model.meshes);
+            ++bake_cache_stats.num_misses;
+            return false;
+        }
+
+        *out_model = std::move(model);
+        ++bake_cache_stats.num_hits;
+        bake_cache_stats.bytes_loaded += size;
+        return true;
+    }
+
+    void bake_cache_store_model(uint64_t key, const BakedModel& model) {
+        std::string tmp_path;
+        FILE* fp = create_entry(key, BAKE_ENTRY_MODEL, &tmp_path);
+        if (!fp)
+            return;
+
+        BakeModelCounts counts = { };
+        counts.meshes_count        = (uint32_t)model.meshes.size();
+        counts.materials_count     = model.materials_count;
+        counts.texture_paths_count = (uint32_t)model.texture_paths.size();
+        counts.nodes_count         = (uint32_t)model.nodes_parent.size();
+        counts.instances_count     = (uint32_t)model.instances_mesh.size();
+        fwrite(&counts, sizeof(counts), 1, fp);
+
+        for (const MeshData& mesh : model.meshes) {
+            Db::MeshRecord record = {
+                .vertex_count     = mesh.vertex_count,
+                .vertex_data_size = mesh.vertex_data_size,
+                .index_count      = mesh.index_count,
+                .flags            = (uint32_t)(mesh.flags & ~MeshData::FLAG_MAPPED),
+                .position_offset  = mesh.position_offset,
+                .position_scale   = mesh.position_scale,
+                .bounds_min       = mesh.bounds_min,
+                .bounds_max       = mesh.bounds_max,
+                .bounds_center    = mesh.bounds_center,
+                .bounds_radius    = mesh.bounds_radius
+            };
+            BakeMeshCounts mesh_counts = {
+                .meshlet_count = mesh.meshlet_count,
+                .lod_count     = mesh.lod_count
+            };
+            fwrite(&record,      sizeof(record),      1, fp);
+            fwrite(&mesh_counts, sizeof(mesh_counts), 1, fp);
+            fwrite(mesh.vertex_data, 1, (size_t)mesh.vertex_count * mesh.vertex_data_size, fp);
+            fwrite(mesh.index_data,  1, (size_t)mesh.index_count * mesh_get_index_size(mesh), fp);
+            fwrite(mesh.meshlets,    1, (size_t)mesh.meshlet_count * sizeof(MeshletData), fp);
+            fwrite(mesh.lods,        1, (size_t)mesh.lod_count * sizeof(MeshLodData), fp);
+        }
+
+        fwrite(model.meshes_material.data(),        sizeof(uint32_t), model.meshes_material.size(),        fp);
+        fwrite(model.imported_vertex_counts.data(), sizeof(uint32_t), model.imported_vertex_counts.size(), fp);
+        fwrite(model.nodes_parent.data(),           sizeof(uint32_t),  model.nodes_parent.size(),           fp);
+        fwrite(model.nodes_transform.data(),        sizeof(glm::mat4), model.nodes_transform.size(),        fp);
+        fwrite(model.instances_mesh.data(),         sizeof(uint32_t),  model.instances_mesh.size(),         fp);
+        fwrite(model.instances_node.data(),         sizeof(uint32_t),  model.instances_node.size(),         fp);
+
+        for (const std::string& path : model.texture_paths) {
+            uint32_t length = (uint32_t)path.size();
+            fwrite(&length, sizeof(length), 1, fp);
+            fwrite(path.data(), 1, length, fp);
+        }
+
+        commit_entry(fp, key, BAKE_ENTRY_MODEL, tmp_path);
+    }
+}
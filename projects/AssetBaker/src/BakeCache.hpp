@@ -0,0 +1,50 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+#include <string>
+#include <vector>
+
+// persistent cache of baker intermediates, one file per entry in the cache directory
+//
+// - keys hash the content of the source file (Lookup3), the import options and `BAKE_CACHE_VERSION`:
+//   editing a file, changing an option or a processing step all miss the cache, renaming or
+//   touching a file does not
+// - textures: decoded pixels, after mipmap generation and block compression
+// - models: processed meshes (optimized, meshlets, LODs, ...) and the texture paths of the materials,
+//   textures themselves are cached on their own, so editing one texture doesn't re-import its model
+// - entries are written to a temporary file and renamed, an interrupted bake never leaves a truncated entry
+// - disabled until `bake_cache_init()`, the runtime never uses it
+namespace vkc::Assets {
+	// bump when a processing step changes its output, so that stale entries are ignored
+	const uint32_t BAKE_CACHE_VERSION = 6;
+
+	struct BakedModel {
+		std::vector<MeshData>    meshes;              // owned (malloc) by the caller once loaded
+		std::vector<uint32_t>    meshes_material;     // material index of every mesh
+		std::vector<uint32_t>    imported_vertex_counts; // vertices as imported, for the memory stats
+		// flattened node hierarchy, see ModelData
+		std::vector<uint32_t>    nodes_parent;
+		std::vector<glm::mat4>   nodes_transform;
+		std::vector<uint32_t>    instances_mesh;      // mesh index of every mesh instance
+		std::vector<uint32_t>    instances_node;      // node of every mesh instance
+		uint32_t                 materials_count;
+		// materials_count * textures per material, empty path for slots without texture
+		std::vector<std::string> texture_paths;
+	};
+
+	void bake_cache_init(const char* dir);
+	bool bake_cache_is_enabled();
+	void bake_cache_print_stats();
+
+	// 0 if the file can't be read
+	uint64_t bake_cache_hash_file(const char* path);
+	// combines a content hash with a string of options
+	uint64_t bake_cache_make_key(uint64_t content_hash, const char* options);
+
+	bool bake_cache_load_texture(uint64_t key, TextureData* out_data);
+	void bake_cache_store_texture(uint64_t key, const TextureData& data);
+
+	bool bake_cache_load_model(uint64_t key, BakedModel* out_model);
+	void bake_cache_store_model(uint64_t key, const BakedModel& model);
+}
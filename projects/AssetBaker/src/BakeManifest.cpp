@@ -0,0 +1,281 @@
+#include "BakeManifest.hpp"
+
+#include <cc_logger.h>
+
+#include <vulkan/vk_enum_string_helper.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <sstream>
+
+namespace vkc::Assets {
+    static bool parse_bool(const std::string& value, bool* out) {
+        if (value != "0" && value != "1")
+            return false;
+        *out = value == "1";
+        return true;
+    }
+
+    static bool parse_uint(const std::string& value, uint32_t* out) {
+        if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        *out = (uint32_t)strtoul(value.c_str(), NULL, 10);
+        return true;
+    }
+
+    // core formats, by their name without the VK_FORMAT_ prefix
+    static bool parse_format(const std::string& value, VkFormat* out) {
+        std::string name = "VK_FORMAT_" + value;
+        for (int format = VK_FORMAT_UNDEFINED + 1; format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK; ++format) {
+            if (name == string_VkFormat((VkFormat)format)) {
+                *out = (VkFormat)format;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool parse_list(const std::string& value, std::vector<std::string>* out) {
+        std::stringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            if (!item.empty())
+                out->push_back(item);
+        return true;
+    }
+
+    static bool parse_option(ManifestEntry* entry, const std::string& key, const std::string& value) {
+        if (key == "name")
+            return entry->name = value, true;
+
+        switch (entry->type) {
+            case MANIFEST_ENTRY_TEXTURE:
+                if (key == "view") {
+                    if (value != "2d" && value != "cube")
+                        return false;
+                    entry->view_type = value == "cube" ? TEX_VIEW_TYPE_CUBE : TEX_VIEW_TYPE_2D;
+                    return true;
+                }
+                if (key == "format")  return parse_format(value, &entry->format);
+                if (key == "flip")    return parse_bool(value, &entry->flip_vertical);
+                if (key == "mipmaps") return parse_bool(value, &entry->create_mipmaps);
+                break;
+            case MANIFEST_ENTRY_ENVIRONMENT:
+                if (key == "flip") return parse_bool(value, &entry->flip_vertical);
+                break;
+            case MANIFEST_ENTRY_MATERIAL:
+                if (key == "pipeline_config") return parse_uint(value, &entry->id_pipeline_config);
+                if (key == "render_pass")     return parse_uint(value, &entry->id_render_pass);
+                if (key == "pipeline")        return parse_uint(value, &entry->id_pipeline);
+                if (key == "textures")        return parse_list(value, &entry->textures);
+                if (key == "arrays")          return parse_bool(value, &entry->texture_arrays);
+                break;
+            case MANIFEST_ENTRY_MODEL:
+                if (key == "textures")        return entry->base_path_textures = value, true;
+                if (key == "environment")     return entry->environment = value, true;
+                if (key == "optimize")        return parse_bool(value, &entry->options.optimize_meshes);
+                if (key == "lods")            return parse_uint(value, &entry->options.lod_count) && entry->options.lod_count > 0;
+                if (key == "compact")         return parse_bool(value, &entry->options.compact_vertices);
+                if (key == "pipeline_config") return parse_uint(value, &entry->options.id_pipeline_config);
+                if (key == "arrays")          return parse_bool(value, &entry->options.texture_arrays);
+                if (key == "compression") {
+                    if      (value == "none") entry->options.texture_compression = TEX_COMPRESSION_NONE;
+                    else if (value == "fast") entry->options.texture_compression = TEX_COMPRESSION_FAST;
+                    else if (value == "high") entry->options.texture_compression = TEX_COMPRESSION_HIGH;
+                    else return false;
+                    return true;
+                }
+                break;
+        }
+        return false;
+    }
+
+    bool bake_manifest_load(const char* path, BakeManifest* out_manifest) {
+        FILE* fp = fopen(path, "r");
+        if (!fp) {
+            CC_LOG(CC_ERROR, "[manifest] can't open %s", path);
+            return false;
+        }
+
+        char buffer[1024];
+        uint32_t line = 0;
+        bool is_valid = true;
+        while (is_valid && fgets(buffer, sizeof(buffer), fp)) {
+            ++line;
+            std::string text(buffer);
+            text = text.substr(0, text.find('#'));
+
+            std::vector<std::string> tokens;
+            std::stringstream stream(text);
+            for (std::string token; stream >> token;)
+                tokens.push_back(token);
+            if (tokens.empty())
+                continue;
+
+            const std::string& directive = tokens[0];
+            if (directive == "db") {
+                if (tokens.size() < 2) {
+                    CC_LOG(CC_ERROR, "[manifest] %s:%d: db without an output path", path, line);
+                    is_valid = false;
+                    break;
+                }
+                ManifestDb db = { .path = tokens[1], .compress = false };
+                for (size_t i = 2; is_valid && i < tokens.size(); ++i) {
+                    size_t separator = tokens[i].find('=');
+                    if (separator == std::string::npos || tokens[i].substr(0, separator) != "compress" || !parse_bool(tokens[i].substr(separator + 1), &db.compress)) {
+                        CC_LOG(CC_ERROR, "[manifest] %s:%d: invalid db option %s", path, line, tokens[i].c_str());
+                        is_valid = false;
+                    }
+                }
+                out_manifest->dbs.push_back(db);
+                continue;
+            }
+
+            ManifestEntry entry = { };
+            entry.line      = line;
+            entry.view_type = TEX_VIEW_TYPE_2D;
+            entry.format    = VK_FORMAT_R8G8B8A8_SRGB;
+            entry.options   = { };
+            if      (directive == "texture")     entry.type = MANIFEST_ENTRY_TEXTURE;
+            else if (directive == "material")    entry.type = MANIFEST_ENTRY_MATERIAL;
+            else if (directive == "environment") entry.type = MANIFEST_ENTRY_ENVIRONMENT;
+            else if (directive == "model")       entry.type = MANIFEST_ENTRY_MODEL;
+            else {
+                CC_LOG(CC_ERROR, "[manifest] %s:%d: unknown entry %s", path, line, directive.c_str());
+                is_valid = false;
+                break;
+            }
+
+            if (out_manifest->dbs.empty()) {
+                CC_LOG(CC_ERROR, "[manifest] %s:%d: %s before the first db", path, line, directive.c_str());
+                is_valid = false;
+                break;
+            }
+
+            for (size_t i = 1; is_valid && i < tokens.size(); ++i) {
+                size_t separator = tokens[i].find('=');
+                if (separator == std::string::npos) {
+                    if (!entry.path.empty()) {
+                        CC_LOG(CC_ERROR, "[manifest] %s:%d: more than one path", path, line);
+                        is_valid = false;
+                    }
+                    entry.path = tokens[i];
+                }
+                else if (!parse_option(&entry, tokens[i].substr(0, separator), tokens[i].substr(separator + 1))) {
+                    CC_LOG(CC_ERROR, "[manifest] %s:%d: invalid %s option %s", path, line, directive.c_str(), tokens[i].c_str());
+                    is_valid = false;
+                }
+            }
+
+            bool needs_path = entry.type != MANIFEST_ENTRY_MATERIAL;
+            if (is_valid && needs_path == entry.path.empty()) {
+                CC_LOG(CC_ERROR, "[manifest] %s:%d: %s %s", path, line, directive.c_str(), needs_path ? "without a path" : "with a path");
+                is_valid = false;
+            }
+            if (is_valid && entry.type == MANIFEST_ENTRY_ENVIRONMENT && entry.name.empty()) {
+                CC_LOG(CC_ERROR, "[manifest] %s:%d: environment without a name", path, line);
+                is_valid = false;
+            }
+
+            out_manifest->dbs.back().entries.push_back(entry);
+        }
+
+        fclose(fp);
+        return is_valid;
+    }
+
+    bool bake_manifest_db(const ManifestDb& db) {
+        CC_LOG(CC_IMPORTANT, "[manifest] baking %s, %d entries", db.path.c_str(), (int)db.entries.size());
+        auto time_start = std::chrono::high_resolution_clock::now();
+
+        std::map<std::string, IdAssetTexture>      textures;
+        std::map<std::string, EnvironmentTextures> environments;
+        std::vector<ModelLoadRequest> models;
+        auto flush_models = [&models]() {
+            if (models.empty())
+                return;
+            std::vector<IdAssetModel> ids(models.size());
+            load_models(models, ids.data());
+            models.clear();
+        };
+
+        bool is_valid = true;
+        for (const ManifestEntry& entry : db.entries) {
+            switch (entry.type) {
+                case MANIFEST_ENTRY_TEXTURE: {
+                    flush_models();
+                    IdAssetTexture id = load_texture(entry.path.c_str(), entry.view_type, entry.format, entry.flip_vertical, entry.create_mipmaps);
+                    if (!entry.name.empty())
+                        textures[entry.name] = id;
+                } break;
+
+                case MANIFEST_ENTRY_MATERIAL: {
+                    flush_models();
+                    MaterialData material = {
+                        .id_pipeline_config    = entry.id_pipeline_config,
+                        .id_render_pass        = entry.id_render_pass,
+                        .id_pipeline           = entry.id_pipeline,
+                        .uniform_data_material = nullptr,
+                        .flags                 = entry.texture_arrays ? MaterialData::FLAG_TEXTURE_ARRAYS : (uint8_t)0
+                    };
+                    for (const std::string& name : entry.textures) {
+                        auto it = textures.find(name);
+                        if (it == textures.end()) {
+                            CC_LOG(CC_ERROR, "[manifest] line %d: unknown texture %s", entry.line, name.c_str());
+                            is_valid = false;
+                            continue;
+                        }
+                        material.image_views.push_back(it->second);
+                    }
+                    create_material(material);
+                } break;
+
+                case MANIFEST_ENTRY_ENVIRONMENT: {
+                    flush_models();
+                    environments[entry.name] = load_environment(entry.path.c_str(), entry.flip_vertical);
+                } break;
+
+                case MANIFEST_ENTRY_MODEL: {
+                    EnvironmentTextures environment = ENVIRONMENT_NONE;
+                    if (!entry.environment.empty()) {
+                        auto it = environments.find(entry.environment);
+                        if (it == environments.end()) {
+                            CC_LOG(CC_ERROR, "[manifest] line %d: unknown environment %s", entry.line, entry.environment.c_str());
+                            is_valid = false;
+                        }
+                        else
+                            environment = it->second;
+                    }
+                    models.push_back({
+                        .path               = entry.path.c_str(),
+                        .base_path_textures = entry.base_path_textures.c_str(),
+                        .environment        = environment,
+                        .options            = entry.options
+                    });
+                } break;
+            }
+        }
+        flush_models();
+        pack_texture_arrays();
+
+        if (is_valid)
+            asset_db_dump(db.path.c_str(), db.compress);
+        asset_db_unload();
+
+        std::error_code error;
+        uint64_t db_size = std::filesystem::file_size(db.path, error);
+        auto time_end = std::chrono::high_resolution_clock::now();
+        CC_LOG(
+            CC_IMPORTANT,
+            "[manifest] %s: %.2fMB in %.2fms",
+            db.path.c_str(),
+            error ? 0.0 : db_size / (1024.0 * 1024.0),
+            std::chrono::duration<double, std::milli>(time_end - time_start).count()
+        );
+        return is_valid;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+#include <string>
+#include <vector>
+
+// list of asset dbs to bake and of the assets going in each of them, one line per entry:
+//
+//   # comment
+//   db       <output path> [compress=0|1]   (uncompressed by default, blobs are mapped in place)
+//   texture  <path> [name=<name>] [view=2d|cube] [format=<VkFormat without VK_FORMAT_>] [flip=0|1] [mipmaps=0|1]
+//   material name=<name> [pipeline_config=<n>] [render_pass=<n>] [pipeline=<n>] [textures=<name>,<name>,...] [arrays=0|1]
+//   environment <path> name=<name> [flip=0|1]
+//   model    <path> [textures=<base path>] [environment=<environment name>] [optimize=0|1] [lods=<n>]
+//            [compact=0|1] [compression=none|fast|high] [pipeline_config=<n>] [arrays=0|1]
+//
+// - entries belong to the last `db` line above them. Paths can't contain spaces
+// - entries are created in order, so ids are the same as loading them one by one from code.
+//   Consecutive models are imported in parallel
+// - textures and environments are referred to by name, names are local to their db
+// - texture formats BC6H_UFLOAT_BLOCK and E5B9G9R9_UFLOAT_PACK32 are encoded by the baker from float pixels
+// - `arrays` tells whether the pipeline config samples the first material textures from arrays (TEXTURE_ARRAYS
+//   pipelines), off for materials and on for models by default. Those textures are packed in texture arrays
+//   before writing the db (see `pack_texture_arrays`)
+namespace vkc::Assets {
+	enum ManifestEntryType {
+		MANIFEST_ENTRY_TEXTURE,
+		MANIFEST_ENTRY_MATERIAL,
+		MANIFEST_ENTRY_ENVIRONMENT,
+		MANIFEST_ENTRY_MODEL
+	};
+
+	struct ManifestEntry {
+		ManifestEntryType type;
+		uint32_t          line;		// in the manifest, for errors
+		std::string       path;
+		std::string       name;
+
+		// texture, environment
+		TexViewTypes view_type;
+		VkFormat     format;
+		bool         flip_vertical;
+		bool         create_mipmaps;
+
+		// material
+		uint32_t id_pipeline_config;
+		uint32_t id_render_pass;
+		uint32_t id_pipeline;
+		std::vector<std::string> textures;
+		bool     texture_arrays;
+
+		// model
+		std::string        base_path_textures;
+		std::string        environment;		// environment name, empty for none
+		ModelImportOptions options;
+	};
+
+	struct ManifestDb {
+		std::string path;
+		bool        compress;
+		std::vector<ManifestEntry> entries;
+	};
+
+	struct BakeManifest {
+		std::vector<ManifestDb> dbs;
+	};
+
+	// logs the line of the first error and returns false
+	bool bake_manifest_load(const char* path, BakeManifest* out_manifest);
+
+	// creates the entries of `db`, writes the asset db and unloads the assets. Returns false if an
+	// entry refers to a name not defined above it
+	bool bake_manifest_db(const ManifestDb& db);
+}
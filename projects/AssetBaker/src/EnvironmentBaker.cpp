@@ -0,0 +1,324 @@
+#include "EnvironmentBaker.hpp"
+#include "JobPool.hpp"
+#include "MipGenerator.hpp"
+#include "TextureCompressor.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <array>
+#include <vector>
+
+namespace vkc::Assets {
+    // texels per job, the prefilter costs ENVIRONMENT_SPECULAR_SAMPLES lookups per texel
+    const uint32_t ENVIRONMENT_TEXELS_PER_JOB = 2048;
+    // SH projection runs on the first source level at most this wide
+    const uint32_t ENVIRONMENT_SH_WIDTH = 256;
+
+    const float PI = 3.14159265358979323846f;
+
+    // ===================================================================================
+    // directions
+    // ===================================================================================
+    // inverse of `uv_spherical_mapping`
+    static glm::vec3 uv_to_direction(float u, float v) {
+        float phi   = (0.5f - u) * 2.0f * PI;
+        float theta = (v - 0.5f) * PI;
+        return glm::vec3(cosf(theta) * cosf(phi), sinf(theta), cosf(theta) * sinf(phi));
+    }
+
+    static glm::vec2 direction_to_uv(const glm::vec3& dir) {
+        return glm::vec2(
+            0.5f - atan2f(dir.z, dir.x) / (2.0f * PI),
+            0.5f + asinf(glm::clamp(dir.y, -1.0f, 1.0f)) / PI
+        );
+    }
+
+    static glm::vec2 hammersley(uint32_t i, uint32_t count) {
+        uint32_t bits = i;
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return glm::vec2((float)i / count, bits * 2.3283064365386963e-10f);
+    }
+
+    // half vector around +z, GGX distributed for `alpha`
+    static glm::vec3 importance_sample_ggx(glm::vec2 xi, float alpha) {
+        float phi       = 2.0f * PI * xi.x;
+        float cos_theta = sqrtf((1.0f - xi.y) / (1.0f + (alpha * alpha - 1.0f) * xi.y));
+        float sin_theta = sqrtf(1.0f - cos_theta * cos_theta);
+        return glm::vec3(sin_theta * cosf(phi), sin_theta * sinf(phi), cos_theta);
+    }
+
+    static float distribution_ggx(float n_dot_h, float alpha) {
+        float alpha2 = alpha * alpha;
+        float expr = n_dot_h * n_dot_h * (alpha2 - 1.0f) + 1.0f;
+        return alpha2 / (PI * expr * expr);
+    }
+
+    template<typename Fn>
+    static void for_rows(uint32_t width, uint32_t height, Fn fn) {
+        uint32_t rows_per_job = glm::max(ENVIRONMENT_TEXELS_PER_JOB / glm::max(width, 1u), 1u);
+
+        Jobs::JobCounter jobs;
+        for (uint32_t row = 0; row < height; row += rows_per_job) {
+            uint32_t count = glm::min(rows_per_job, height - row);
+            Jobs::job_pool_submit(&jobs, [=]() { fn(row, count); });
+        }
+        Jobs::job_pool_wait(&jobs);
+    }
+
+    // ===================================================================================
+    // source
+    // ===================================================================================
+    // box filtered mip chain of the environment, sampled with wrapping longitude and clamped latitude
+    struct SourceChain {
+        float*   texels;	// malloc'd by texture_generate_mips
+        uint32_t num_channels;
+        std::vector<const float*> levels;
+        std::vector<uint32_t>     widths;
+        std::vector<uint32_t>     heights;
+    };
+
+    static SourceChain source_chain_create(const float* pixels, uint32_t width, uint32_t height, uint32_t num_channels) {
+        SourceChain chain;
+        chain.num_channels = num_channels;
+
+        uint32_t mips;
+        uint32_t size;
+        chain.texels = (float*)texture_generate_mips(
+            pixels,
+            width,
+            height,
+            (TexChannelTypes)num_channels,
+            true,
+            false,
+            MIP_FILTER_BOX,
+            &mips,
+            &size
+        );
+
+        const float* level = chain.texels;
+        for (uint32_t i = 0; i < mips; ++i) {
+            uint32_t level_width  = glm::max(width  >> i, 1u);
+            uint32_t level_height = glm::max(height >> i, 1u);
+            chain.levels.push_back(level);
+            chain.widths.push_back(level_width);
+            chain.heights.push_back(level_height);
+            level += (size_t)level_width * level_height * num_channels;
+        }
+        return chain;
+    }
+
+    static glm::vec3 source_texel(const SourceChain& chain, uint32_t level, int x, int y) {
+        int width  = (int)chain.widths[level];
+        int height = (int)chain.heights[level];
+        x = ((x % width) + width) % width;
+        y = glm::clamp(y, 0, height - 1);
+        const float* texel = chain.levels[level] + ((size_t)y * width + x) * chain.num_channels;
+        return glm::vec3(texel[0], texel[1], texel[2]);
+    }
+
+    static glm::vec3 sample_bilinear(const SourceChain& chain, uint32_t level, glm::vec2 uv) {
+        float x = uv.x * chain.widths[level]  - 0.5f;
+        float y = uv.y * chain.heights[level] - 0.5f;
+        int   x0 = (int)floorf(x);
+        int   y0 = (int)floorf(y);
+        float fx = x - x0;
+        float fy = y - y0;
+
+        glm::vec3 top    = glm::mix(source_texel(chain, level, x0, y0),     source_texel(chain, level, x0 + 1, y0),     fx);
+        glm::vec3 bottom = glm::mix(source_texel(chain, level, x0, y0 + 1), source_texel(chain, level, x0 + 1, y0 + 1), fx);
+        return glm::mix(top, bottom, fy);
+    }
+
+    static glm::vec3 sample_trilinear(const SourceChain& chain, float lod, const glm::vec3& dir) {
+        glm::vec2 uv = direction_to_uv(dir);
+        lod = glm::clamp(lod, 0.0f, (float)(chain.levels.size() - 1));
+        uint32_t level = (uint32_t)lod;
+        if (level + 1 >= chain.levels.size())
+            return sample_bilinear(chain, level, uv);
+        return glm::mix(sample_bilinear(chain, level, uv), sample_bilinear(chain, level + 1, uv), lod - level);
+    }
+
+    // ===================================================================================
+    // public
+    // ===================================================================================
+    void* environment_prefilter_specular(const float* pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint32_t* out_size) {
+        SourceChain chain = source_chain_create(pixels, width, height, num_channels);
+
+        size_t size = 0;
+        for (uint32_t i = 0; i < ENVIRONMENT_SPECULAR_MIPS; ++i)
+            size += (size_t)glm::max(ENVIRONMENT_SPECULAR_WIDTH >> i, 1u) * glm::max((ENVIRONMENT_SPECULAR_WIDTH / 2) >> i, 1u) * sizeof(uint32_t);
+        uint32_t* out = (uint32_t*)malloc(size);
+
+        // solid angle of a source texel, averaged over the sphere
+        float solid_angle_texel = 4.0f * PI / ((float)width * height);
+
+        struct SpecularSample {
+            glm::vec3 direction;	// tangent space, N = +z
+            float     n_dot_l;
+            float     lod;
+        };
+        std::vector<SpecularSample> samples;
+
+        uint32_t* out_level = out;
+        for (uint32_t mip = 0; mip < ENVIRONMENT_SPECULAR_MIPS; ++mip) {
+            uint32_t level_width  = glm::max(ENVIRONMENT_SPECULAR_WIDTH >> mip, 1u);
+            uint32_t level_height = glm::max((ENVIRONMENT_SPECULAR_WIDTH / 2) >> mip, 1u);
+            float    roughness    = (float)mip / (ENVIRONMENT_SPECULAR_MIPS - 1);
+
+            // same samples for every texel, only the basis changes
+            samples.clear();
+            if (mip == 0)
+                samples.push_back({ .direction = glm::vec3(0.0f, 0.0f, 1.0f), .n_dot_l = 1.0f, .lod = log2f((float)width / level_width) });
+            else {
+                for (uint32_t i = 0; i < ENVIRONMENT_SPECULAR_SAMPLES; ++i) {
+                    glm::vec3 h = importance_sample_ggx(hammersley(i, ENVIRONMENT_SPECULAR_SAMPLES), roughness);
+                    glm::vec3 l = 2.0f * h.z * h - glm::vec3(0.0f, 0.0f, 1.0f);
+                    if (l.z <= 0.0f)
+                        continue;
+
+                    // N = V: the pdf of L is D * NdotH / (4 * VdotH) = D / 4
+                    float pdf = distribution_ggx(h.z, roughness) / 4.0f;
+                    float solid_angle_sample = 1.0f / (ENVIRONMENT_SPECULAR_SAMPLES * pdf + 0.0001f);
+                    samples.push_back({
+                        .direction = l,
+                        .n_dot_l   = l.z,
+                        .lod       = glm::max(0.5f * log2f(solid_angle_sample / solid_angle_texel) + 1.0f, 0.0f)
+                    });
+                }
+            }
+
+            for_rows(level_width, level_height, [&, out_level, level_width, level_height](uint32_t row_first, uint32_t row_count) {
+                for (uint32_t y = row_first; y < row_first + row_count; ++y) {
+                    for (uint32_t x = 0; x < level_width; ++x) {
+                        glm::vec3 n = uv_to_direction((x + 0.5f) / level_width, (y + 0.5f) / level_height);
+                        glm::vec3 up = fabsf(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                        glm::vec3 t = glm::normalize(glm::cross(up, n));
+                        glm::vec3 b = glm::cross(n, t);
+
+                        glm::vec3 color  = glm::vec3(0.0f);
+                        float     weight = 0.0f;
+                        for (const SpecularSample& sample : samples) {
+                            glm::vec3 l = t * sample.direction.x + b * sample.direction.y + n * sample.direction.z;
+                            color  += sample_trilinear(chain, sample.lod, l) * sample.n_dot_l;
+                            weight += sample.n_dot_l;
+                        }
+                        color /= glm::max(weight, 0.0001f);
+
+                        out_level[(size_t)y * level_width + x] = texture_pack_rgb9e5(color.r, color.g, color.b);
+                    }
+                }
+            });
+            out_level += (size_t)level_width * level_height;
+        }
+
+        free(chain.texels);
+        *out_size = (uint32_t)size;
+        return out;
+    }
+
+    void environment_compute_sh_irradiance(const float* pixels, uint32_t width, uint32_t height, uint32_t num_channels, glm::vec3 out_sh[ENVIRONMENT_SH_COEFFICIENTS]) {
+        SourceChain chain = source_chain_create(pixels, width, height, num_channels);
+        uint32_t level = 0;
+        while (level + 1 < chain.levels.size() && chain.widths[level] > ENVIRONMENT_SH_WIDTH)
+            ++level;
+        uint32_t level_width  = chain.widths[level];
+        uint32_t level_height = chain.heights[level];
+
+        // one partial sum per job, reduced in order so the result doesn't depend on scheduling
+        typedef std::array<glm::vec3, ENVIRONMENT_SH_COEFFICIENTS> Coefficients;
+        uint32_t rows_per_job = glm::max(ENVIRONMENT_TEXELS_PER_JOB / level_width, 1u);
+        std::vector<Coefficients> partials((level_height + rows_per_job - 1) / rows_per_job);
+
+        Jobs::JobCounter jobs;
+        for (uint32_t row = 0; row < level_height; row += rows_per_job) {
+            Jobs::job_pool_submit(&jobs, [&, row]() {
+                Coefficients& sum = partials[row / rows_per_job];
+                sum.fill(glm::vec3(0.0f));
+
+                uint32_t row_end = glm::min(row + rows_per_job, level_height);
+                for (uint32_t y = row; y < row_end; ++y) {
+                    float v = (y + 0.5f) / level_height;
+                    float solid_angle = (2.0f * PI / level_width) * (PI / level_height) * cosf((v - 0.5f) * PI);
+
+                    for (uint32_t x = 0; x < level_width; ++x) {
+                        glm::vec3 d = uv_to_direction((x + 0.5f) / level_width, v);
+                        glm::vec3 radiance = source_texel(chain, level, (int)x, (int)y) * solid_angle;
+
+                        sum[0] += radiance * 0.282095f;
+                        sum[1] += radiance * (0.488603f * d.y);
+                        sum[2] += radiance * (0.488603f * d.z);
+                        sum[3] += radiance * (0.488603f * d.x);
+                        sum[4] += radiance * (1.092548f * d.x * d.y);
+                        sum[5] += radiance * (1.092548f * d.y * d.z);
+                        sum[6] += radiance * (0.315392f * (3.0f * d.z * d.z - 1.0f));
+                        sum[7] += radiance * (1.092548f * d.x * d.z);
+                        sum[8] += radiance * (0.546274f * (d.x * d.x - d.y * d.y));
+                    }
+                }
+            });
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        // clamped cosine convolution (pi, 2pi/3, pi/4 per band), divided by pi for the lambertian BRDF
+        const float BAND_SCALE[ENVIRONMENT_SH_COEFFICIENTS] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+        for (uint32_t i = 0; i < ENVIRONMENT_SH_COEFFICIENTS; ++i) {
+            out_sh[i] = glm::vec3(0.0f);
+            for (const Coefficients& partial : partials)
+                out_sh[i] += partial[i];
+            out_sh[i] *= BAND_SCALE[i];
+        }
+
+        free(chain.texels);
+    }
+
+    void* environment_compute_brdf_lut(uint32_t* out_size) {
+        const uint32_t size = ENVIRONMENT_BRDF_LUT_SIZE;
+        uint16_t* out = (uint16_t*)malloc((size_t)size * size * 2 * sizeof(uint16_t));
+
+        for_rows(size, size, [out, size](uint32_t row_first, uint32_t row_count) {
+            for (uint32_t y = row_first; y < row_first + row_count; ++y) {
+                float roughness = (y + 0.5f) / size;
+                // Schlick-Smith visibility, k = alpha / 2 for image based lighting
+                float k = roughness / 2.0f;
+
+                for (uint32_t x = 0; x < size; ++x) {
+                    float     n_dot_v = (x + 0.5f) / size;
+                    glm::vec3 v = glm::vec3(sqrtf(1.0f - n_dot_v * n_dot_v), 0.0f, n_dot_v);
+
+                    float scale = 0.0f;
+                    float bias  = 0.0f;
+                    for (uint32_t i = 0; i < ENVIRONMENT_BRDF_LUT_SAMPLES; ++i) {
+                        glm::vec3 h = importance_sample_ggx(hammersley(i, ENVIRONMENT_BRDF_LUT_SAMPLES), roughness);
+                        glm::vec3 l = 2.0f * glm::dot(v, h) * h - v;
+
+                        float n_dot_l = l.z;
+                        float n_dot_h = h.z;
+                        float v_dot_h = glm::max(glm::dot(v, h), 0.0f);
+                        if (n_dot_l <= 0.0f)
+                            continue;
+
+                        float g = (n_dot_l / (n_dot_l * (1.0f - k) + k)) * (n_dot_v / (n_dot_v * (1.0f - k) + k));
+                        float g_vis = g * v_dot_h / (n_dot_h * n_dot_v);
+                        float fresnel = powf(1.0f - v_dot_h, 5.0f);
+                        scale += (1.0f - fresnel) * g_vis;
+                        bias  += fresnel * g_vis;
+                    }
+
+                    uint16_t* texel = out + ((size_t)y * size + x) * 2;
+                    texel[0] = glm::packHalf1x16(scale / ENVIRONMENT_BRDF_LUT_SAMPLES);
+                    texel[1] = glm::packHalf1x16(bias  / ENVIRONMENT_BRDF_LUT_SAMPLES);
+                }
+            }
+        });
+
+        *out_size = size * size * 2 * sizeof(uint16_t);
+        return out;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+#include <glm/glm.hpp>
+
+// offline image based lighting from an equirectangular HDR environment, split sum approximation
+//
+// - specular: radiance prefiltered with GGX for roughness 0 to 1 over the mips (N = V = R), importance
+//   sampled from a box filtered mip chain of the source, the level of each sample follows its pdf
+// - diffuse: irradiance projected on 2nd order spherical harmonics, 9 RGB coefficients
+// - BRDF LUT: scale and bias of f0 integrated over the hemisphere, for NdotV x roughness
+//
+// directions are the ones `uv_spherical_mapping` maps to the texture (shaders_include/utils.glsl),
+// GGX alpha is the roughness like `DistributionGGX`. Texels are split in jobs on the job pool
+namespace vkc::Assets {
+	const uint32_t ENVIRONMENT_SPECULAR_WIDTH   = 512;	// level 0, height is half of it
+	const uint32_t ENVIRONMENT_SPECULAR_MIPS    = 6;	// roughness of level i is i / (MIPS - 1)
+	const uint32_t ENVIRONMENT_SPECULAR_SAMPLES = 128;
+	const uint32_t ENVIRONMENT_SH_COEFFICIENTS  = 9;
+	const uint32_t ENVIRONMENT_BRDF_LUT_SIZE    = 128;
+	const uint32_t ENVIRONMENT_BRDF_LUT_SAMPLES = 256;
+
+	// `pixels` is `num_channels` (3 or 4, alpha ignored) floats per texel.
+	// Returns a malloc'd VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 mip chain of ENVIRONMENT_SPECULAR_MIPS levels,
+	// tightly packed, `out_size` bytes. Level 0 is ENVIRONMENT_SPECULAR_WIDTH x ENVIRONMENT_SPECULAR_WIDTH / 2
+	void* environment_prefilter_specular(
+		const float* pixels,
+		uint32_t width,
+		uint32_t height,
+		uint32_t num_channels,
+		uint32_t* out_size
+	);
+
+	// irradiance coefficients, already convolved with the clamped cosine and divided by pi:
+	// diffuse = albedo * sum(out_sh[i] * Y_i(N))
+	void environment_compute_sh_irradiance(
+		const float* pixels,
+		uint32_t width,
+		uint32_t height,
+		uint32_t num_channels,
+		glm::vec3 out_sh[ENVIRONMENT_SH_COEFFICIENTS]
+	);
+
+	// malloc'd VK_FORMAT_R16G16_SFLOAT ENVIRONMENT_BRDF_LUT_SIZE squared texels, x is NdotV and
+	// y the roughness. Doesn't depend on the environment
+	void* environment_compute_brdf_lut(uint32_t* out_size);
+}
@@ -0,0 +1,102 @@
+#include "FileMapping.hpp"
+
+#include <cc_logger.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vkc::Assets {
+#ifdef _WIN32
+	bool file_mapping_open(const char* path, FileMapping* mapping) {
+		*mapping = { };
+
+		HANDLE handle_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (handle_file == INVALID_HANDLE_VALUE) {
+			CC_LOG(CC_WARNING, "[file mapping] could not open %s", path);
+			return false;
+		}
+
+		LARGE_INTEGER file_size;
+		GetFileSizeEx(handle_file, &file_size);
+
+		HANDLE handle_mapping = CreateFileMappingA(handle_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (handle_mapping == NULL) {
+			CC_LOG(CC_WARNING, "[file mapping] could not create mapping for %s", path);
+			CloseHandle(handle_file);
+			return false;
+		}
+
+		void* data = MapViewOfFile(handle_mapping, FILE_MAP_COPY, 0, 0, 0);
+		if (data == NULL) {
+			CC_LOG(CC_WARNING, "[file mapping] could not map view of %s", path);
+			CloseHandle(handle_mapping);
+			CloseHandle(handle_file);
+			return false;
+		}
+
+		mapping->data           = (unsigned char*)data;
+		mapping->size           = (uint64_t)file_size.QuadPart;
+		mapping->handle_file    = handle_file;
+		mapping->handle_mapping = handle_mapping;
+		return true;
+	}
+
+	void file_mapping_close(FileMapping* mapping) {
+		if (mapping->data == nullptr)
+			return;
+
+		UnmapViewOfFile(mapping->data);
+		CloseHandle((HANDLE)mapping->handle_mapping);
+		CloseHandle((HANDLE)mapping->handle_file);
+		*mapping = { };
+	}
+#else
+	bool file_mapping_open(const char* path, FileMapping* mapping) {
+		*mapping = { };
+
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			CC_LOG(CC_WARNING, "[file mapping] could not open %s", path);
+			return false;
+		}
+
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+			CC_LOG(CC_WARNING, "[file mapping] could not stat %s", path);
+			close(fd);
+			return false;
+		}
+
+		void* data = mmap(NULL, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		// the mapping keeps its own reference to the file
+		close(fd);
+
+		if (data == MAP_FAILED) {
+			CC_LOG(CC_WARNING, "[file mapping] could not map %s", path);
+			return false;
+		}
+
+		// we are going to touch most of it soon (GPU upload), let the kernel read ahead
+		madvise(data, file_stat.st_size, MADV_WILLNEED);
+
+		mapping->data = (unsigned char*)data;
+		mapping->size = (uint64_t)file_stat.st_size;
+		return true;
+	}
+
+	void file_mapping_close(FileMapping* mapping) {
+		if (mapping->data == nullptr)
+			return;
+
+		munmap(mapping->data, mapping->size);
+		*mapping = { };
+	}
+#endif
+}
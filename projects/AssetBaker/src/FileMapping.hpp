@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace vkc::Assets {
+	// read-only view of a whole file, mapped copy-on-write: writing to the mapped
+	// pages is allowed, but changes are private to the process and never reach the file
+	struct FileMapping {
+		unsigned char* data;
+		uint64_t       size;
+
+		// platform handles
+		void*          handle_file;
+		void*          handle_mapping;
+	};
+
+	bool file_mapping_open(const char* path, FileMapping* mapping);
+	void file_mapping_close(FileMapping* mapping);
+}
@@ -0,0 +1,115 @@
+#include "JobPool.hpp"
+
+#include <cc_logger.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkc::Jobs {
+	struct Job {
+		JobCounter*           counter;
+		std::function<void()> fn;
+	};
+
+	std::vector<std::thread> workers;
+	std::deque<Job>          queue;
+	std::mutex               queue_mutex;
+	std::condition_variable  queue_cv;
+	bool                     is_running = false;
+
+	static void job_run(Job& job) {
+		job.fn();
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	// pops the next job, returns false if the queue is empty
+	static bool job_try_pop(Job* job) {
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		if (queue.empty())
+			return false;
+
+		*job = std::move(queue.front());
+		queue.pop_front();
+		return true;
+	}
+
+	static void worker_main() {
+		while (true) {
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex);
+				queue_cv.wait(lock, [] { return !queue.empty() || !is_running; });
+
+				if (queue.empty())
+					return;
+
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+			job_run(job);
+		}
+	}
+
+	void job_pool_init(uint32_t num_threads) {
+		CC_ASSERT(!is_running, "job pool already initialized");
+
+		if (num_threads == 0) {
+			uint32_t hw_threads = std::thread::hardware_concurrency();
+			num_threads = hw_threads > 1 ? hw_threads - 1 : 1;
+		}
+
+		is_running = true;
+		workers.reserve(num_threads);
+		for (uint32_t i = 0; i < num_threads; ++i)
+			workers.emplace_back(worker_main);
+
+		CC_LOG(CC_INFO, "[job pool] started %d workers", num_threads);
+	}
+
+	void job_pool_shutdown() {
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			is_running = false;
+		}
+		queue_cv.notify_all();
+
+		// workers drain the queue before exiting
+		for (std::thread& worker : workers)
+			worker.join();
+		workers.clear();
+	}
+
+	uint32_t job_pool_get_num_threads() {
+		return (uint32_t)workers.size();
+	}
+
+	void job_pool_submit(JobCounter* counter, std::function<void()> job) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+		if (workers.empty()) {
+			Job inline_job = { counter, std::move(job) };
+			job_run(inline_job);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			queue.push_back({ counter, std::move(job) });
+		}
+		queue_cv.notify_one();
+	}
+
+	void job_pool_wait(JobCounter* counter) {
+		while (counter->pending.load(std::memory_order_acquire) > 0) {
+			// help instead of sleeping. The job may belong to another counter, that's fine
+			Job job;
+			if (job_try_pop(&job))
+				job_run(job);
+			else
+				std::this_thread::yield();
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include "LzCodec.hpp"
+
+#include <string.h>
+
+namespace vkc::Lz {
+    const uint32_t MIN_MATCH     = 4;
+    const uint32_t MAX_OFFSET    = 65535;
+    // the tail is always emitted as literals, so that the match search never reads past the end
+    const uint32_t LAST_LITERALS = 5;
+    const uint32_t HASH_BITS     = 14;
+    // skip faster over incompressible data, one more byte of step every 2^SKIP_SHIFT misses
+    const uint32_t SKIP_SHIFT    = 6;
+
+    static inline uint32_t read_u32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static inline uint32_t hash_u32(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    static inline uint8_t* write_length(uint8_t* op, uint32_t length) {
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = (uint8_t)length;
+        return op;
+    }
+
+    static uint8_t* write_sequence(uint8_t* op, const uint8_t* literals, uint32_t literal_count, uint32_t offset, uint32_t match_length) {
+        uint8_t* token = op++;
+        uint32_t match_code = match_length - MIN_MATCH;
+
+        *token = (uint8_t)((literal_count >= 15 ? 15 : literal_count) << 4);
+        if (literal_count >= 15)
+            op = write_length(op, literal_count - 15);
+        memcpy(op, literals, literal_count);
+        op += literal_count;
+
+        *op++ = (uint8_t)(offset & 0xFF);
+        *op++ = (uint8_t)(offset >> 8);
+
+        *token |= (uint8_t)(match_code >= 15 ? 15 : match_code);
+        if (match_code >= 15)
+            op = write_length(op, match_code - 15);
+        return op;
+    }
+
+    uint32_t lz_compress_bound(uint32_t size) {
+        return size + size / 255 + 16;
+    }
+
+    uint32_t lz_compress(const void* src, uint32_t src_size, void* dst) {
+        const uint8_t* in  = (const uint8_t*)src;
+        uint8_t*       op  = (uint8_t*)dst;
+
+        // positions + 1, 0 is empty
+        uint32_t table[1 << HASH_BITS];
+        memset(table, 0, sizeof(table));
+
+        uint32_t anchor = 0;
+        if (src_size > MIN_MATCH + LAST_LITERALS) {
+            uint32_t limit = src_size - LAST_LITERALS;
+            uint32_t ip    = 0;
+
+            while (ip + MIN_MATCH <= limit) {
+                uint32_t sequence = read_u32(in + ip);
+                uint32_t h        = hash_u32(sequence);
+                uint32_t ref      = table[h];
+                table[h] = ip + 1;
+
+                if (ref == 0 || ip - (ref - 1) > MAX_OFFSET || read_u32(in + ref - 1) != sequence) {
+                    ip += 1 + ((ip - anchor) >> SKIP_SHIFT);
+                    continue;
+                }
+                ref -= 1;
+
+                uint32_t length = MIN_MATCH;
+                while (ip + length < limit && in[ref + length] == in[ip + length])
+                    ++length;
+
+                // extend backward over the pending literals
+                while (ip > anchor && ref > 0 && in[ip - 1] == in[ref - 1]) {
+                    --ip;
+                    --ref;
+                    ++length;
+                }
+
+                op = write_sequence(op, in + anchor, ip - anchor, ip - ref, length);
+                ip += length;
+                anchor = ip;
+
+                // positions inside the match are skipped, index the last one for the next search
+                if (ip + MIN_MATCH <= limit)
+                    table[hash_u32(read_u32(in + ip - 2))] = ip - 2 + 1;
+            }
+        }
+
+        // last literals
+        uint32_t literal_count = src_size - anchor;
+        *op++ = (uint8_t)((literal_count >= 15 ? 15 : literal_count) << 4);
+        if (literal_count >= 15)
+            op = write_length(op, literal_count - 15);
+        memcpy(op, in + anchor, literal_count);
+        op += literal_count;
+
+        return (uint32_t)(op - (uint8_t*)dst);
+    }
+
+    // extension bytes of a length, false if the input ends first
+    static inline bool read_length(const uint8_t** ip, const uint8_t* end, uint32_t* length) {
+        uint8_t b;
+        do {
+            if (*ip >= end)
+                return false;
+            b = *(*ip)++;
+            *length += b;
+        } while (b == 255);
+        return true;
+    }
+
+    bool lz_decompress(const void* src, uint32_t src_size, void* dst, uint32_t dst_size) {
+        const uint8_t* ip     = (const uint8_t*)src;
+        const uint8_t* in_end = ip + src_size;
+        uint8_t*       op     = (uint8_t*)dst;
+        uint8_t*       out    = op;
+        uint8_t*       out_end = op + dst_size;
+
+        while (ip < in_end) {
+            uint8_t token = *ip++;
+
+            uint32_t literal_count = token >> 4;
+            if (literal_count == 15 && !read_length(&ip, in_end, &literal_count))
+                return false;
+            if (literal_count > (uint32_t)(in_end - ip) || literal_count > (uint32_t)(out_end - op))
+                return false;
+            memcpy(op, ip, literal_count);
+            ip += literal_count;
+            op += literal_count;
+
+            // last sequence
+            if (ip == in_end)
+                break;
+
+            if (in_end - ip < 2)
+                return false;
+            uint32_t offset = ip[0] | ((uint32_t)ip[1] << 8);
+            ip += 2;
+            if (offset == 0 || offset > (uint32_t)(op - out))
+                return false;
+
+            uint32_t length = token & 15;
+            if (length == 15 && !read_length(&ip, in_end, &length))
+                return false;
+            length += MIN_MATCH;
+            if (length > (uint32_t)(out_end - op))
+                return false;
+
+            const uint8_t* match = op - offset;
+            if (offset >= length) {
+                memcpy(op, match, length);
+                op += length;
+            }
+            else if (offset >= 8) {
+                // overlapping, but every 8 byte step reads bytes already written
+                uint8_t* end = op + length;
+                while (end - op >= 8) {
+                    memcpy(op, match, 8);
+                    op    += 8;
+                    match += 8;
+                }
+                while (op < end)
+                    *op++ = *match++;
+            }
+            else {
+                for (uint32_t i = 0; i < length; ++i)
+                    *op++ = *match++;
+            }
+        }
+
+        return op == out_end;
+    }
+}
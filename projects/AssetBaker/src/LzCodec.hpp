@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// byte oriented LZ77 codec, same sequence layout as LZ4 blocks (not the frame format):
+//
+//   [token][literal length ext...][literals][offset u16][match length ext...]
+//
+// - token: literal length in the high nibble, match length - 4 in the low one, 15 means extension
+//   bytes follow (each adds up to 255, a byte below 255 ends the run)
+// - offsets are in [1, 65535], matches can overlap their output (runs)
+// - the last sequence has literals only, the input ends right after them
+//
+// greedy single probe hash table compressor, favors decompression speed over ratio
+namespace vkc::Lz {
+	// worst case compressed size (incompressible input)
+	uint32_t lz_compress_bound(uint32_t size);
+
+	// returns the compressed size, `dst` must hold `lz_compress_bound(src_size)` bytes
+	uint32_t lz_compress(const void* src, uint32_t src_size, void* dst);
+
+	// `dst_size` is the exact uncompressed size. Every read and write is bounds checked,
+	// returns false on corrupted input
+	bool lz_decompress(const void* src, uint32_t src_size, void* dst, uint32_t dst_size);
+}
@@ -0,0 +1,544 @@
+#include "MeshOptimizer.hpp"
+
+extern "C" {
+    #include <cc_hash.h>
+}
+
+#include <glm/gtc/packing.hpp>
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define VKC_MESH_SSE 1
+    #include <emmintrin.h>
+#else
+    #define VKC_MESH_SSE 0
+#endif
+
+namespace vkc::Assets {
+    const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    uint32_t mesh_weld_vertices(MeshData* mesh) {
+        uint32_t       stride   = mesh->vertex_data_size;
+        unsigned char* vertices = (unsigned char*)mesh->vertex_data;
+
+        // open addressing, at most half full
+        uint32_t table_size = 1;
+        while (table_size < mesh->vertex_count * 2)
+            table_size *= 2;
+        uint32_t table_mask = table_size - 1;
+
+        std::vector<uint32_t> table(table_size, INVALID_INDEX);
+        std::vector<uint32_t> remap(mesh->vertex_count);
+
+        // compacts in place: unique vertex `u` is always written at an index <= the one it is read from
+        uint32_t unique_count = 0;
+        for (uint32_t i = 0; i < mesh->vertex_count; ++i) {
+            const unsigned char* vertex = vertices + (size_t)i * stride;
+            uint32_t slot = (uint32_t)Lookup3((const char*)vertex, stride) & table_mask;
+
+            while (true) {
+                uint32_t u = table[slot];
+
+                if (u == INVALID_INDEX) {
+                    table[slot] = unique_count;
+                    if (unique_count != i)
+                        memcpy(vertices + (size_t)unique_count * stride, vertex, stride);
+                    remap[i] = unique_count++;
+                    break;
+                }
+
+                if (memcmp(vertices + (size_t)u * stride, vertex, stride) == 0) {
+                    remap[i] = u;
+                    break;
+                }
+
+                slot = (slot + 1) & table_mask;
+            }
+        }
+
+        uint32_t* indices = (uint32_t*)mesh->index_data;
+        for (uint32_t i = 0; i < mesh->index_count; ++i)
+            indices[i] = remap[indices[i]];
+
+        if (unique_count < mesh->vertex_count && unique_count > 0)
+            mesh->vertex_data = realloc(mesh->vertex_data, (size_t)unique_count * stride);
+        mesh->vertex_count = unique_count;
+
+        return unique_count;
+    }
+
+    // Tipsify: fan around the vertex most likely to still be in cache, jump to the
+    // most recent dead-end vertex (or the next one with live triangles) when stuck
+    void mesh_optimize_vertex_cache(uint32_t* indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size) {
+        uint32_t triangle_count = index_count / 3;
+        if (triangle_count == 0 || vertex_count == 0)
+            return;
+
+        // vertex -> triangles adjacency
+        std::vector<uint32_t> live_triangles(vertex_count, 0);
+        for (uint32_t i = 0; i < index_count; ++i)
+            ++live_triangles[indices[i]];
+
+        std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0);
+        for (uint32_t v = 0; v < vertex_count; ++v)
+            adjacency_offsets[v + 1] = adjacency_offsets[v] + live_triangles[v];
+
+        std::vector<uint32_t> adjacency(index_count);
+        std::vector<uint32_t> adjacency_fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (uint32_t t = 0; t < triangle_count; ++t)
+            for (uint32_t k = 0; k < 3; ++k)
+                adjacency[adjacency_fill[indices[t * 3 + k]]++] = t;
+
+        std::vector<uint32_t> cache_timestamps(vertex_count, 0);
+        std::vector<bool>     is_emitted(triangle_count, false);
+        std::vector<uint32_t> dead_end_stack;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(index_count);
+
+        uint32_t timestamp = cache_size + 1;
+        uint32_t cursor = 0;
+        int64_t  fanning_vertex = 0;
+
+        while (fanning_vertex >= 0) {
+            candidates.clear();
+
+            for (uint32_t a = adjacency_offsets[fanning_vertex]; a < adjacency_offsets[fanning_vertex + 1]; ++a) {
+                uint32_t t = adjacency[a];
+                if (is_emitted[t])
+                    continue;
+
+                for (uint32_t k = 0; k < 3; ++k) {
+                    uint32_t v = indices[t * 3 + k];
+                    output.push_back(v);
+                    dead_end_stack.push_back(v);
+                    candidates.push_back(v);
+                    --live_triangles[v];
+
+                    if (timestamp - cache_timestamps[v] > cache_size)
+                        cache_timestamps[v] = timestamp++;
+                }
+                is_emitted[t] = true;
+            }
+
+            // best candidate: still has live triangles and will still be in cache after emitting them
+            int64_t  next_vertex = -1;
+            int64_t  best_priority = -1;
+            for (uint32_t v : candidates) {
+                if (live_triangles[v] == 0)
+                    continue;
+
+                int64_t priority = 0;
+                if (timestamp - cache_timestamps[v] + 2 * live_triangles[v] <= cache_size)
+                    priority = timestamp - cache_timestamps[v];
+
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    next_vertex = v;
+                }
+            }
+
+            // dead end
+            if (next_vertex < 0) {
+                while (!dead_end_stack.empty()) {
+                    uint32_t v = dead_end_stack.back();
+                    dead_end_stack.pop_back();
+                    if (live_triangles[v] > 0) {
+                        next_vertex = v;
+                        break;
+                    }
+                }
+            }
+            if (next_vertex < 0) {
+                while (cursor < vertex_count && live_triangles[cursor] == 0)
+                    ++cursor;
+                if (cursor < vertex_count)
+                    next_vertex = cursor;
+            }
+
+            fanning_vertex = next_vertex;
+        }
+
+        memcpy(indices, output.data(), sizeof(uint32_t) * triangle_count * 3);
+    }
+
+    uint32_t mesh_optimize_vertex_fetch(MeshData* mesh) {
+        uint32_t stride = mesh->vertex_data_size;
+
+        std::vector<uint32_t> remap(mesh->vertex_count, INVALID_INDEX);
+        uint32_t* indices = (uint32_t*)mesh->index_data;
+        uint32_t next_vertex = 0;
+        for (uint32_t i = 0; i < mesh->index_count; ++i) {
+            uint32_t& v = indices[i];
+            if (remap[v] == INVALID_INDEX)
+                remap[v] = next_vertex++;
+            v = remap[v];
+        }
+
+        // unreferenced vertices are dropped
+        unsigned char* vertices_old = (unsigned char*)mesh->vertex_data;
+        unsigned char* vertices_new = (unsigned char*)malloc((size_t)next_vertex * stride);
+        for (uint32_t v = 0; v < mesh->vertex_count; ++v)
+            if (remap[v] != INVALID_INDEX)
+                memcpy(vertices_new + (size_t)remap[v] * stride, vertices_old + (size_t)v * stride, stride);
+
+        free(vertices_old);
+        mesh->vertex_data  = vertices_new;
+        mesh->vertex_count = next_vertex;
+
+        return next_vertex;
+    }
+
+    uint32_t mesh_count_transformed_vertices(const uint32_t* indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size) {
+        // a vertex is in cache if it entered less than `cache_size` misses ago
+        std::vector<uint32_t> cache_entry_time(vertex_count, 0);
+        uint32_t misses = 0;
+
+        for (uint32_t i = 0; i < index_count; ++i) {
+            uint32_t v = indices[i];
+            if (cache_entry_time[v] == 0 || misses - cache_entry_time[v] >= cache_size) {
+                ++misses;
+                cache_entry_time[v] = misses;
+            }
+        }
+
+        return misses;
+    }
+
+    MeshOptimizeStats mesh_optimize(MeshData* mesh) {
+        MeshOptimizeStats stats = { };
+        uint32_t triangle_count = mesh->index_count / 3;
+        if (triangle_count == 0 || mesh->vertex_count == 0)
+            return stats;
+
+        CC_ASSERT(!(mesh->flags & MeshData::FLAG_INDICES_16), "mesh optimization expects uint32_t indices");
+        uint32_t* indices = (uint32_t*)mesh->index_data;
+
+        stats.vertex_count_before = mesh->vertex_count;
+        uint32_t transformed_before = mesh_count_transformed_vertices(indices, mesh->index_count, mesh->vertex_count);
+        stats.acmr_before = (float)transformed_before / triangle_count;
+        stats.atvr_before = (float)transformed_before / mesh->vertex_count;
+
+        mesh_weld_vertices(mesh);
+        mesh_optimize_vertex_cache(indices, mesh->index_count, mesh->vertex_count);
+        mesh_optimize_vertex_fetch(mesh);
+
+        stats.vertex_count_after = mesh->vertex_count;
+        uint32_t transformed_after = mesh_count_transformed_vertices(indices, mesh->index_count, mesh->vertex_count);
+        stats.acmr_after = (float)transformed_after / triangle_count;
+        stats.atvr_after = (float)transformed_after / mesh->vertex_count;
+
+        return stats;
+    }
+
+    // Ritter's bounding sphere, within a few % of the minimal one
+    static void compute_sphere(const glm::vec3* points, uint32_t count, glm::vec3* center, float* radius) {
+        uint32_t idx_a = 0;
+        for (uint32_t i = 1; i < count; ++i)
+            if (glm::dot(points[i] - points[0], points[i] - points[0]) > glm::dot(points[idx_a] - points[0], points[idx_a] - points[0]))
+                idx_a = i;
+        uint32_t idx_b = idx_a;
+        for (uint32_t i = 0; i < count; ++i)
+            if (glm::dot(points[i] - points[idx_a], points[i] - points[idx_a]) > glm::dot(points[idx_b] - points[idx_a], points[idx_b] - points[idx_a]))
+                idx_b = i;
+
+        glm::vec3 c = (points[idx_a] + points[idx_b]) * 0.5f;
+        float     r = glm::length(points[idx_b] - points[idx_a]) * 0.5f;
+        for (uint32_t i = 0; i < count; ++i) {
+            float d = glm::length(points[i] - c);
+            if (d > r) {
+                float new_r = (r + d) * 0.5f;
+                c += (points[i] - c) * ((new_r - r) / d);
+                r = new_r;
+            }
+        }
+
+        *center = c;
+        *radius = r;
+    }
+
+    static void meshlet_compute_bounds(MeshletData* meshlet, const uint32_t* indices, const VertexData* vertices, std::vector<glm::vec3>& points) {
+        points.clear();
+        glm::vec3 normal_sum = glm::vec3(0.0f);
+        for (uint32_t i = meshlet->first_index; i < meshlet->first_index + meshlet->index_count; i += 3) {
+            glm::vec3 a = vertices[indices[i + 0]].position;
+            glm::vec3 b = vertices[indices[i + 1]].position;
+            glm::vec3 c = vertices[indices[i + 2]].position;
+            points.push_back(a);
+            points.push_back(b);
+            points.push_back(c);
+
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float     l = glm::length(n);
+            if (l > 0.0f)
+                normal_sum += n / l;
+        }
+
+        compute_sphere(points.data(), (uint32_t)points.size(), &meshlet->center, &meshlet->radius);
+
+        // normal cone: average direction, half angle from the normal furthest from it
+        meshlet->cone_axis   = glm::vec3(0.0f);
+        meshlet->cone_cutoff = 1.0f;
+        float axis_length = glm::length(normal_sum);
+        if (axis_length < 1e-6f)
+            return;
+
+        glm::vec3 axis = normal_sum / axis_length;
+        float min_dot = 1.0f;
+        for (uint32_t i = meshlet->first_index; i < meshlet->first_index + meshlet->index_count; i += 3) {
+            glm::vec3 a = vertices[indices[i + 0]].position;
+            glm::vec3 n = glm::cross(vertices[indices[i + 1]].position - a, vertices[indices[i + 2]].position - a);
+            float     l = glm::length(n);
+            if (l > 0.0f)
+                min_dot = fminf(min_dot, glm::dot(axis, n / l));
+        }
+
+        meshlet->cone_axis = axis;
+        // cone wider than a hemisphere, no view direction sees only back faces
+        if (min_dot > 0.0f)
+            meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+    }
+
+#if VKC_MESH_SSE
+    // positions are loaded 4 floats at a time, the 4th (color.x) is ignored
+    static_assert(offsetof(VertexData, position) + 4 * sizeof(float) <= sizeof(VertexData), "position loads read past the vertex");
+
+    static inline __m128 load_position(const VertexData& vertex) {
+        return _mm_loadu_ps(&vertex.position.x);
+    }
+#endif
+
+    static void compute_box(const VertexData* vertices, uint32_t count, glm::vec3* out_min, glm::vec3* out_max) {
+#if VKC_MESH_SSE
+        // 4 vertices per iteration, one accumulator each to not wait on the previous min/max
+        __m128 box_min[4];
+        __m128 box_max[4];
+        for (int k = 0; k < 4; ++k)
+            box_min[k] = box_max[k] = load_position(vertices[0]);
+
+        uint32_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            for (int k = 0; k < 4; ++k) {
+                __m128 p = load_position(vertices[i + k]);
+                box_min[k] = _mm_min_ps(box_min[k], p);
+                box_max[k] = _mm_max_ps(box_max[k], p);
+            }
+        }
+        for (; i < count; ++i) {
+            __m128 p = load_position(vertices[i]);
+            box_min[0] = _mm_min_ps(box_min[0], p);
+            box_max[0] = _mm_max_ps(box_max[0], p);
+        }
+
+        float result_min[4];
+        float result_max[4];
+        _mm_storeu_ps(result_min, _mm_min_ps(_mm_min_ps(box_min[0], box_min[1]), _mm_min_ps(box_min[2], box_min[3])));
+        _mm_storeu_ps(result_max, _mm_max_ps(_mm_max_ps(box_max[0], box_max[1]), _mm_max_ps(box_max[2], box_max[3])));
+        *out_min = glm::vec3(result_min[0], result_min[1], result_min[2]);
+        *out_max = glm::vec3(result_max[0], result_max[1], result_max[2]);
+#else
+        *out_min = vertices[0].position;
+        *out_max = vertices[0].position;
+        for (uint32_t i = 1; i < count; ++i) {
+            *out_min = glm::min(*out_min, vertices[i].position);
+            *out_max = glm::max(*out_max, vertices[i].position);
+        }
+#endif
+    }
+
+    // largest squared distance from `center`
+    static float compute_max_distance2(const VertexData* vertices, uint32_t count, glm::vec3 center) {
+        float max_d2 = 0.0f;
+        uint32_t i = 0;
+#if VKC_MESH_SSE
+        // 4 vertices transposed to x, y, z lanes per iteration
+        __m128 cx = _mm_set1_ps(center.x);
+        __m128 cy = _mm_set1_ps(center.y);
+        __m128 cz = _mm_set1_ps(center.z);
+        __m128 max_d2_4 = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = load_position(vertices[i + 0]);
+            __m128 y = load_position(vertices[i + 1]);
+            __m128 z = load_position(vertices[i + 2]);
+            __m128 w = load_position(vertices[i + 3]);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+
+            __m128 dx = _mm_sub_ps(x, cx);
+            __m128 dy = _mm_sub_ps(y, cy);
+            __m128 dz = _mm_sub_ps(z, cz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            max_d2_4 = _mm_max_ps(max_d2_4, d2);
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, max_d2_4);
+        max_d2 = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+#endif
+        for (; i < count; ++i) {
+            glm::vec3 d = vertices[i].position - center;
+            max_d2 = fmaxf(max_d2, glm::dot(d, d));
+        }
+        return max_d2;
+    }
+
+    void mesh_compute_bounds(MeshData* mesh) {
+        CC_ASSERT(mesh->vertex_data_size == sizeof(VertexData), "bounds are computed on VertexData meshes");
+        if (mesh->vertex_count == 0)
+            return;
+
+        // the sphere around the box center is a bit looser than Ritter's on some meshes, but both
+        // passes are straight SIMD over the positions and it is exact for its center
+        const VertexData* vertices = (const VertexData*)mesh->vertex_data;
+        compute_box(vertices, mesh->vertex_count, &mesh->bounds_min, &mesh->bounds_max);
+        mesh->bounds_center = (mesh->bounds_min + mesh->bounds_max) * 0.5f;
+        mesh->bounds_radius = sqrtf(compute_max_distance2(vertices, mesh->vertex_count, mesh->bounds_center));
+    }
+
+    uint32_t mesh_build_meshlets(MeshData* mesh) {
+        CC_ASSERT(mesh->vertex_data_size == sizeof(VertexData), "meshlets are built on VertexData meshes");
+        CC_ASSERT(!(mesh->flags & MeshData::FLAG_INDICES_16), "meshlets are built on uint32_t indices");
+
+        uint32_t triangle_count = mesh->index_count / 3;
+        if (triangle_count == 0)
+            return 0;
+
+        const uint32_t*   indices  = (const uint32_t*)mesh->index_data;
+        const VertexData* vertices = (const VertexData*)mesh->vertex_data;
+
+        // meshlet that last referenced each vertex, avoids clearing a set per meshlet
+        std::vector<uint32_t> vertex_tag(mesh->vertex_count, INVALID_INDEX);
+        std::vector<MeshletData> meshlets;
+        meshlets.reserve(triangle_count / MESHLET_MAX_TRIANGLES + 1);
+
+        MeshletData curr = { };
+        for (uint32_t t = 0; t < triangle_count; ++t) {
+            const uint32_t* tri = indices + t * 3;
+            uint32_t tag = (uint32_t)meshlets.size();
+
+            uint32_t new_vertices =
+                (vertex_tag[tri[0]] != tag) +
+                (vertex_tag[tri[1]] != tag && tri[1] != tri[0]) +
+                (vertex_tag[tri[2]] != tag && tri[2] != tri[0] && tri[2] != tri[1]);
+
+            if (curr.vertex_count + new_vertices > MESHLET_MAX_VERTICES || curr.index_count / 3 == MESHLET_MAX_TRIANGLES) {
+                meshlets.push_back(curr);
+                curr = { };
+                curr.first_index = t * 3;
+                tag = (uint32_t)meshlets.size();
+                new_vertices =
+                    1 +
+                    (tri[1] != tri[0]) +
+                    (tri[2] != tri[0] && tri[2] != tri[1]);
+            }
+
+            vertex_tag[tri[0]] = tag;
+            vertex_tag[tri[1]] = tag;
+            vertex_tag[tri[2]] = tag;
+            curr.vertex_count += new_vertices;
+            curr.index_count  += 3;
+        }
+        meshlets.push_back(curr);
+
+        std::vector<glm::vec3> points;
+        points.reserve(MESHLET_MAX_TRIANGLES * 3);
+        for (MeshletData& meshlet : meshlets)
+            meshlet_compute_bounds(&meshlet, indices, vertices, points);
+
+        free(mesh->meshlets);
+        mesh->meshlets = (MeshletData*)malloc(sizeof(MeshletData) * meshlets.size());
+        memcpy(mesh->meshlets, meshlets.data(), sizeof(MeshletData) * meshlets.size());
+        mesh->meshlet_count = (uint32_t)meshlets.size();
+        return mesh->meshlet_count;
+    }
+
+    // octahedral mapping of a unit vector to [-1, 1]^2 (Cigolle et al. 2014)
+    static glm::vec2 oct_encode(glm::vec3 n) {
+        float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+        if (l1 == 0.0f)
+            return glm::vec2(0.0f);
+
+        glm::vec2 e = glm::vec2(n.x, n.y) / l1;
+        if (n.z < 0.0f) {
+            e = glm::vec2(
+                (1.0f - fabsf(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - fabsf(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f)
+            );
+        }
+        return e;
+    }
+
+    static void pack_snorm16x2(glm::vec2 v, int16_t* out) {
+        out[0] = (int16_t)roundf(glm::clamp(v.x, -1.0f, 1.0f) * 32767.0f);
+        out[1] = (int16_t)roundf(glm::clamp(v.y, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    void mesh_compact_vertices(MeshData* mesh) {
+        CC_ASSERT(mesh->vertex_data_size == sizeof(VertexData), "only VertexData meshes can be compacted");
+        if (mesh->vertex_count == 0)
+            return;
+
+        const VertexData* src = (const VertexData*)mesh->vertex_data;
+
+        glm::vec3 bounds_min = src[0].position;
+        glm::vec3 bounds_max = src[0].position;
+        for (uint32_t i = 1; i < mesh->vertex_count; ++i) {
+            bounds_min = glm::min(bounds_min, src[i].position);
+            bounds_max = glm::max(bounds_max, src[i].position);
+        }
+
+        // flat meshes would divide by 0
+        glm::vec3 extent = glm::max(bounds_max - bounds_min, glm::vec3(1e-6f));
+
+        VertexDataCompact* dst = (VertexDataCompact*)malloc(sizeof(VertexDataCompact) * mesh->vertex_count);
+        for (uint32_t i = 0; i < mesh->vertex_count; ++i) {
+            const VertexData& v = src[i];
+            VertexDataCompact& c = dst[i];
+
+            glm::vec3 t = glm::clamp((v.position - bounds_min) / extent, 0.0f, 1.0f);
+            c.position[0] = (uint16_t)roundf(t.x * 65535.0f);
+            c.position[1] = (uint16_t)roundf(t.y * 65535.0f);
+            c.position[2] = (uint16_t)roundf(t.z * 65535.0f);
+            c.position[3] = 0;
+
+            pack_snorm16x2(oct_encode(v.normal),  c.normal);
+            pack_snorm16x2(oct_encode(v.tangent), c.tangent);
+
+            c.texCoords[0] = glm::packHalf1x16(v.texCoords.x);
+            c.texCoords[1] = glm::packHalf1x16(v.texCoords.y);
+
+            glm::vec3 color = glm::clamp(v.color, 0.0f, 1.0f);
+            c.color[0] = (uint8_t)roundf(color.r * 255.0f);
+            c.color[1] = (uint8_t)roundf(color.g * 255.0f);
+            c.color[2] = (uint8_t)roundf(color.b * 255.0f);
+            c.color[3] = 255;
+        }
+
+        free(mesh->vertex_data);
+        mesh->vertex_data      = dst;
+        mesh->vertex_data_size = sizeof(VertexDataCompact);
+        mesh->flags           |= MeshData::FLAG_COMPACT;
+        mesh->position_offset  = bounds_min;
+        mesh->position_scale   = extent;
+    }
+
+    bool mesh_shrink_indices(MeshData* mesh) {
+        if ((mesh->flags & MeshData::FLAG_INDICES_16) || mesh->vertex_count > 0xFFFF + 1)
+            return false;
+
+        const uint32_t* indices_32 = (const uint32_t*)mesh->index_data;
+        uint16_t* indices_16 = (uint16_t*)malloc(sizeof(uint16_t) * mesh->index_count);
+        for (uint32_t i = 0; i < mesh->index_count; ++i)
+            indices_16[i] = (uint16_t)indices_32[i];
+
+        free(mesh->index_data);
+        mesh->index_data = indices_16;
+        mesh->flags |= MeshData::FLAG_INDICES_16;
+        return true;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+// offline mesh optimization, run by the baker on imported triangle meshes
+//
+// 1. weld:         merge bit-identical vertices (importers emit one vertex per face corner)
+// 2. vertex cache: reorder triangles for the post-transform cache (Tipsify, Sander et al. 2007)
+// 3. vertex fetch: reorder vertices in first-use order, so that fetches walk memory linearly
+// 4. meshlets:     split the index buffer in clusters, with bounds for culling
+// 5. LODs:         see MeshSimplifier.hpp
+// 6. [optional] compact: quantize to VertexDataCompact
+// 7. 16 bit indices when the vertex count allows it
+//
+// ACMR (average cache miss ratio) = transformed vertices / triangles, 0.5 is the best case on closed meshes
+// ATVR (average transform to vertex ratio) = transformed vertices / vertices, 1.0 is the best case
+namespace vkc::Assets {
+	const uint32_t MESH_OPT_VERTEX_CACHE_SIZE = 16;
+	// same limits as the common mesh shader setups, so that the clusters can be reused there
+	const uint32_t MESHLET_MAX_VERTICES  = 64;
+	const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	struct MeshOptimizeStats {
+		uint32_t vertex_count_before;
+		uint32_t vertex_count_after;
+		float    acmr_before;
+		float    acmr_after;
+		float    atvr_before;
+		float    atvr_after;
+	};
+
+	// returns the new vertex count, vertex and index data are changed in place
+	uint32_t mesh_weld_vertices(MeshData* mesh);
+	void     mesh_optimize_vertex_cache(uint32_t* indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size = MESH_OPT_VERTEX_CACHE_SIZE);
+	uint32_t mesh_optimize_vertex_fetch(MeshData* mesh);
+
+	// FIFO cache simulation, returns the number of vertices transformed
+	uint32_t mesh_count_transformed_vertices(const uint32_t* indices, uint32_t index_count, uint32_t vertex_count, uint32_t cache_size = MESH_OPT_VERTEX_CACHE_SIZE);
+
+	// steps 1-3, in order. Expects a triangle list
+	MeshOptimizeStats mesh_optimize(MeshData* mesh);
+
+	// box and bounding sphere of all vertices (`MeshData::bounds_*`), SSE over the positions when
+	// available. Run before `mesh_compact_vertices`
+	void mesh_compute_bounds(MeshData* mesh);
+
+	// splits the triangles, in index buffer order, in MeshletData (the index buffer is not changed).
+	// Run after `mesh_optimize` (the vertex cache order keeps clusters local) and before
+	// `mesh_compact_vertices` (bounds read VertexData positions). Returns the meshlet count
+	uint32_t mesh_build_meshlets(MeshData* mesh);
+
+	// VertexData -> VertexDataCompact, sets FLAG_COMPACT and the position dequantization.
+	// Run after `mesh_optimize`, welding needs the full precision vertices
+	void mesh_compact_vertices(MeshData* mesh);
+
+	// switches to uint16_t indices (FLAG_INDICES_16) if all vertices can be addressed, returns true if it did.
+	// Run last, all of the above expect uint32_t indices
+	bool mesh_shrink_indices(MeshData* mesh);
+}
@@ -0,0 +1,332 @@
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tuple>
+#include <vector>
+
+namespace vkc::Assets {
+    // squared distance to a set of planes, weighted by triangle area
+    struct Quadric {
+        double a2, ab, ac, ad;
+        double b2, bc, bd;
+        double c2, cd;
+        double d2;
+        double weight;
+    };
+
+    static Quadric quadric_from_plane(glm::dvec3 n, double d, double weight) {
+        return {
+            .a2 = n.x * n.x * weight, .ab = n.x * n.y * weight, .ac = n.x * n.z * weight, .ad = n.x * d * weight,
+            .b2 = n.y * n.y * weight, .bc = n.y * n.z * weight, .bd = n.y * d * weight,
+            .c2 = n.z * n.z * weight, .cd = n.z * d * weight,
+            .d2 = d * d * weight,
+            .weight = weight
+        };
+    }
+
+    static void quadric_add(Quadric& q, const Quadric& o) {
+        q.a2 += o.a2; q.ab += o.ab; q.ac += o.ac; q.ad += o.ad;
+        q.b2 += o.b2; q.bc += o.bc; q.bd += o.bd;
+        q.c2 += o.c2; q.cd += o.cd;
+        q.d2 += o.d2;
+        q.weight += o.weight;
+    }
+
+    // mean squared distance of `p` from the planes
+    static double quadric_error(const Quadric& q, glm::dvec3 p) {
+        if (q.weight <= 0.0)
+            return 0.0;
+
+        double e =
+            q.a2 * p.x * p.x + 2.0 * q.ab * p.x * p.y + 2.0 * q.ac * p.x * p.z + 2.0 * q.ad * p.x +
+            q.b2 * p.y * p.y + 2.0 * q.bc * p.y * p.z + 2.0 * q.bd * p.y +
+            q.c2 * p.z * p.z + 2.0 * q.cd * p.z +
+            q.d2;
+        return fabs(e) / q.weight;
+    }
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double   error;
+    };
+
+    static uint64_t edge_key(uint32_t a, uint32_t b) {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // vertices sharing their position with others (attribute seams), or on an open border
+    static std::vector<bool> find_locked_vertices(const glm::vec3* positions, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count) {
+        // welded meshes only duplicate positions on seams
+        std::vector<uint32_t> position_id(vertex_count);
+        std::vector<uint32_t> position_refs;
+        std::map<std::tuple<float, float, float>, uint32_t> unique_positions;
+        for (uint32_t i = 0; i < vertex_count; ++i) {
+            auto key = std::make_tuple(positions[i].x, positions[i].y, positions[i].z);
+            auto it = unique_positions.find(key);
+            if (it == unique_positions.end()) {
+                it = unique_positions.emplace(key, (uint32_t)position_refs.size()).first;
+                position_refs.push_back(0);
+            }
+            position_id[i] = it->second;
+            ++position_refs[it->second];
+        }
+
+        std::vector<bool> is_locked(vertex_count, false);
+        for (uint32_t i = 0; i < vertex_count; ++i)
+            is_locked[i] = position_refs[position_id[i]] > 1;
+
+        // by position, so that seams don't look like borders
+        std::vector<uint64_t> edges;
+        edges.reserve(index_count);
+        for (uint32_t i = 0; i < index_count; i += 3)
+            for (uint32_t e = 0; e < 3; ++e)
+                edges.push_back(edge_key(position_id[indices[i + e]], position_id[indices[i + (e + 1) % 3]]));
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<bool> is_border_position(position_refs.size(), false);
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i + 1;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            if (j - i == 1) {
+                is_border_position[edges[i] >> 32]        = true;
+                is_border_position[edges[i] & 0xFFFFFFFF] = true;
+            }
+            i = j;
+        }
+
+        for (uint32_t i = 0; i < vertex_count; ++i)
+            if (is_border_position[position_id[i]])
+                is_locked[i] = true;
+
+        return is_locked;
+    }
+
+    // false if replacing `from` with `to` flips (or nearly flips) a triangle around `from`
+    static bool collapse_keeps_orientation(
+        const glm::vec3* positions,
+        const uint32_t* indices,
+        const std::vector<uint32_t>& remap,
+        const uint32_t* triangles, uint32_t triangle_count,
+        uint32_t from, uint32_t to
+    ) {
+        for (uint32_t t = 0; t < triangle_count; ++t) {
+            const uint32_t* tri = indices + triangles[t] * 3;
+            uint32_t v[3] = { remap[tri[0]], remap[tri[1]], remap[tri[2]] };
+
+            // removed by the collapse
+            if (v[0] == to || v[1] == to || v[2] == to)
+                continue;
+
+            glm::vec3 n_before = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+            for (uint32_t& i : v)
+                if (i == from)
+                    i = to;
+            glm::vec3 n_after  = glm::cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+
+            // within ~75 degrees
+            if (glm::dot(n_before, n_after) < 0.25f * glm::length(n_before) * glm::length(n_after))
+                return false;
+        }
+        return true;
+    }
+
+    // collapses edges, cheapest first, until `index_count` reaches `target_index_count` or nothing can collapse.
+    // Returns the new index count, `max_error` is raised to the largest collapse error
+    static uint32_t simplify(
+        uint32_t* indices, uint32_t index_count, uint32_t target_index_count,
+        const glm::vec3* positions, uint32_t vertex_count,
+        const std::vector<bool>& is_locked,
+        std::vector<Quadric>& quadrics,
+        double* max_error
+    ) {
+        std::vector<uint32_t> remap(vertex_count);
+        std::vector<bool>     is_touched(vertex_count);
+        std::vector<uint32_t> triangle_offsets(vertex_count + 1);
+        std::vector<uint32_t> vertex_triangles;
+        std::vector<uint64_t> edges;
+        std::vector<Collapse> collapses;
+
+        while (index_count > target_index_count) {
+            uint32_t triangle_count = index_count / 3;
+
+            // vertex -> triangles
+            std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+            for (uint32_t i = 0; i < index_count; ++i)
+                ++triangle_offsets[indices[i] + 1];
+            for (uint32_t i = 0; i < vertex_count; ++i)
+                triangle_offsets[i + 1] += triangle_offsets[i];
+            vertex_triangles.resize(index_count);
+            {
+                std::vector<uint32_t> fill = triangle_offsets;
+                for (uint32_t i = 0; i < index_count; ++i)
+                    vertex_triangles[fill[indices[i]]++] = i / 3;
+            }
+
+            edges.clear();
+            for (uint32_t i = 0; i < index_count; i += 3)
+                for (uint32_t e = 0; e < 3; ++e)
+                    edges.push_back(edge_key(indices[i + e], indices[i + (e + 1) % 3]));
+            std::sort(edges.begin(), edges.end());
+            edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+            // cheapest direction of each edge
+            collapses.clear();
+            for (uint64_t edge : edges) {
+                uint32_t a = (uint32_t)(edge >> 32);
+                uint32_t b = (uint32_t)(edge & 0xFFFFFFFF);
+
+                Quadric q = quadrics[a];
+                quadric_add(q, quadrics[b]);
+                double error_ab = is_locked[a] ? INFINITY : quadric_error(q, positions[b]);
+                double error_ba = is_locked[b] ? INFINITY : quadric_error(q, positions[a]);
+
+                if (error_ab == INFINITY && error_ba == INFINITY)
+                    continue;
+                if (error_ab <= error_ba)
+                    collapses.push_back({ a, b, error_ab });
+                else
+                    collapses.push_back({ b, a, error_ba });
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.error < r.error; });
+
+            for (uint32_t i = 0; i < vertex_count; ++i)
+                remap[i] = i;
+            std::fill(is_touched.begin(), is_touched.end(), false);
+
+            // an interior collapse removes 2 triangles. Vertices collapse at most once per pass,
+            // so that the flip test always sees the current triangles
+            uint32_t triangles_to_remove = (index_count - target_index_count) / 3;
+            uint32_t triangles_removed = 0;
+            uint32_t collapse_count = 0;
+            for (const Collapse& c : collapses) {
+                if (triangles_removed >= triangles_to_remove)
+                    break;
+                if (is_touched[c.from] || is_touched[c.to])
+                    continue;
+
+                const uint32_t* triangles = vertex_triangles.data() + triangle_offsets[c.from];
+                uint32_t count = triangle_offsets[c.from + 1] - triangle_offsets[c.from];
+                if (!collapse_keeps_orientation(positions, indices, remap, triangles, count, c.from, c.to))
+                    continue;
+
+                remap[c.from] = c.to;
+                is_touched[c.from] = true;
+                is_touched[c.to] = true;
+                quadric_add(quadrics[c.to], quadrics[c.from]);
+                *max_error = fmax(*max_error, c.error);
+
+                triangles_removed += 2;
+                ++collapse_count;
+            }
+
+            if (collapse_count == 0)
+                break;
+
+            // apply, drop degenerate triangles
+            uint32_t write = 0;
+            for (uint32_t t = 0; t < triangle_count; ++t) {
+                uint32_t a = remap[indices[t * 3 + 0]];
+                uint32_t b = remap[indices[t * 3 + 1]];
+                uint32_t c = remap[indices[t * 3 + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+                indices[write++] = a;
+                indices[write++] = b;
+                indices[write++] = c;
+            }
+            index_count = write;
+        }
+
+        return index_count;
+    }
+
+    uint32_t mesh_build_lods(MeshData* mesh, uint32_t max_lods) {
+        CC_ASSERT(mesh->vertex_data_size == sizeof(VertexData), "LODs are built on VertexData meshes");
+        CC_ASSERT(!(mesh->flags & MeshData::FLAG_INDICES_16), "LODs are built on uint32_t indices");
+        CC_ASSERT(mesh->lod_count == 0, "mesh already has LODs");
+
+        uint32_t base_index_count = mesh->index_count;
+        if (max_lods <= 1 || base_index_count < 3)
+            return 0;
+
+        const VertexData* vertices = (const VertexData*)mesh->vertex_data;
+        std::vector<glm::vec3> positions(mesh->vertex_count);
+        for (uint32_t i = 0; i < mesh->vertex_count; ++i)
+            positions[i] = vertices[i].position;
+
+        const uint32_t* base_indices = (const uint32_t*)mesh->index_data;
+        std::vector<bool> is_locked = find_locked_vertices(positions.data(), mesh->vertex_count, base_indices, base_index_count);
+
+        std::vector<Quadric> quadrics(mesh->vertex_count, Quadric{ });
+        for (uint32_t i = 0; i < base_index_count; i += 3) {
+            glm::dvec3 p0 = positions[base_indices[i + 0]];
+            glm::dvec3 p1 = positions[base_indices[i + 1]];
+            glm::dvec3 p2 = positions[base_indices[i + 2]];
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(n);
+            if (area <= 0.0)
+                continue;
+
+            n /= area;
+            Quadric q = quadric_from_plane(n, -glm::dot(n, p0), area * 0.5);
+            quadric_add(quadrics[base_indices[i + 0]], q);
+            quadric_add(quadrics[base_indices[i + 1]], q);
+            quadric_add(quadrics[base_indices[i + 2]], q);
+        }
+
+        // each level starts from the previous one, so quadrics and errors accumulate along the chain
+        std::vector<uint32_t> lod_indices(base_indices, base_indices + base_index_count);
+        std::vector<uint32_t> all_indices(lod_indices);
+        MeshLodData base_lod = { };
+        base_lod.index_count = base_index_count;
+        std::vector<MeshLodData> lods = { base_lod };
+        double max_error = 0.0;
+
+        while (lods.size() < max_lods) {
+            uint32_t prev_count = (uint32_t)lod_indices.size();
+            uint32_t target_count = (prev_count / 6) * 3;
+            if (target_count == 0)
+                break;
+
+            uint32_t count = simplify(
+                lod_indices.data(), prev_count, target_count,
+                positions.data(), mesh->vertex_count,
+                is_locked, quadrics, &max_error
+            );
+            // not worth the memory
+            if (count == 0 || count > prev_count - prev_count / 4)
+                break;
+
+            lod_indices.resize(count);
+            mesh_optimize_vertex_cache(lod_indices.data(), count, mesh->vertex_count);
+
+            MeshLodData lod = { };
+            lod.first_index = (uint32_t)all_indices.size();
+            lod.index_count = count;
+            lod.error       = (float)sqrt(max_error);
+            lods.push_back(lod);
+            all_indices.insert(all_indices.end(), lod_indices.begin(), lod_indices.end());
+        }
+
+        if (lods.size() == 1)
+            return 0;
+
+        free(mesh->index_data);
+        mesh->index_data = malloc(sizeof(uint32_t) * all_indices.size());
+        memcpy(mesh->index_data, all_indices.data(), sizeof(uint32_t) * all_indices.size());
+        mesh->index_count = (uint32_t)all_indices.size();
+
+        mesh->lods = (MeshLodData*)malloc(sizeof(MeshLodData) * lods.size());
+        memcpy(mesh->lods, lods.data(), sizeof(MeshLodData) * lods.size());
+        mesh->lod_count = (uint32_t)lods.size();
+        return mesh->lod_count;
+    }
+}
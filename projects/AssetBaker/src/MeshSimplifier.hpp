@@ -0,0 +1,19 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+// LOD generation by edge collapse with quadric error metrics (Garland and Heckbert 1997)
+//
+// - vertices are only removed, never moved or created: all LODs share the vertex buffer of the mesh
+// - vertices on open borders and attribute seams (same position, different attributes) are locked,
+//   so simplification never opens holes
+// - each LOD keeps about half the triangles of the previous one, the chain stops early
+//   when a step can't remove enough of them
+namespace vkc::Assets {
+	const uint32_t MESH_LOD_DEFAULT_COUNT = 4;
+
+	// appends the index lists of up to `max_lods` simplified levels to the index buffer and fills
+	// `MeshData::lods` (LOD 0 is the original range). Expects a VertexData triangle list with uint32_t
+	// indices. Returns the number of levels, LOD 0 included
+	uint32_t mesh_build_lods(MeshData* mesh, uint32_t max_lods = MESH_LOD_DEFAULT_COUNT);
+}
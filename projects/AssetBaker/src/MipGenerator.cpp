@@ -0,0 +1,416 @@
+#include "MipGenerator.hpp"
+#include "JobPool.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define VKC_MIP_SSE 1
+    #include <emmintrin.h>
+#else
+    #define VKC_MIP_SSE 0
+#endif
+
+namespace vkc::Assets {
+    // texels per job, rows are never split
+    const uint32_t MIP_TEXELS_PER_JOB = 64 * 1024;
+
+    const float KAISER_WIDTH = 3.0f;
+    const float KAISER_ALPHA = 4.0f;
+    const double PI          = 3.14159265358979323846;
+
+    // ===================================================================================
+    // one texel, linear RGBA
+    // ===================================================================================
+#if VKC_MIP_SSE
+    typedef __m128 Texel;
+
+    static inline Texel texel_zero()                                 { return _mm_setzero_ps(); }
+    static inline Texel texel_load(const float* p)                   { return _mm_load_ps(p); }
+    static inline void  texel_store(float* p, Texel t)               { _mm_store_ps(p, t); }
+    static inline Texel texel_add(Texel a, Texel b)                  { return _mm_add_ps(a, b); }
+    static inline Texel texel_mul_add(Texel acc, Texel t, float w)   { return _mm_add_ps(acc, _mm_mul_ps(t, _mm_set1_ps(w))); }
+    static inline Texel texel_scale(Texel t, float s)                { return _mm_mul_ps(t, _mm_set1_ps(s)); }
+#else
+    struct Texel {
+        float v[4];
+    };
+
+    static inline Texel texel_zero()                                 { return Texel{ }; }
+    static inline Texel texel_load(const float* p)                   { Texel t; memcpy(t.v, p, sizeof(t.v)); return t; }
+    static inline void  texel_store(float* p, Texel t)               { memcpy(p, t.v, sizeof(t.v)); }
+    static inline Texel texel_add(Texel a, Texel b)                  { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+    static inline Texel texel_mul_add(Texel acc, Texel t, float w)   { for (int i = 0; i < 4; ++i) acc.v[i] += t.v[i] * w; return acc; }
+    static inline Texel texel_scale(Texel t, float s)                { for (int i = 0; i < 4; ++i) t.v[i] *= s; return t; }
+#endif
+
+    // float RGBA image, 16 byte aligned texels
+    struct LinearImage {
+        float*   texels;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    static float* alloc_texels(size_t count) {
+        size_t size = count * 4 * sizeof(float);
+#ifdef _WIN32
+        return (float*)_aligned_malloc(size, 16);
+#else
+        return (float*)aligned_alloc(16, (size + 15) & ~(size_t)15);
+#endif
+    }
+
+    static void free_texels(float* texels) {
+#ifdef _WIN32
+        _aligned_free(texels);
+#else
+        free(texels);
+#endif
+    }
+
+    // ===================================================================================
+    // sRGB
+    // ===================================================================================
+    const uint32_t SRGB_ENCODE_BUCKETS = 4096;
+
+    struct SrgbTables {
+        float   decode[256];
+        // linear value halfway between two consecutive sRGB codes, for round to nearest on encode
+        float   thresholds[255];
+        // lowest code of each bucket of the linear range, the exact code is at most a few thresholds above
+        uint8_t encode_start[SRGB_ENCODE_BUCKETS];
+    };
+
+    static const SrgbTables& get_srgb_tables() {
+        static const SrgbTables tables = []() {
+            SrgbTables t;
+            for (uint32_t i = 0; i < 256; ++i) {
+                float c = i / 255.0f;
+                t.decode[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (uint32_t i = 0; i < 255; ++i) {
+                float c = (i + 0.5f) / 255.0f;
+                t.thresholds[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            }
+            uint32_t code = 0;
+            for (uint32_t i = 0; i < SRGB_ENCODE_BUCKETS; ++i) {
+                float v = (float)i / SRGB_ENCODE_BUCKETS;
+                while (code < 255 && v >= t.thresholds[code])
+                    ++code;
+                t.encode_start[i] = (uint8_t)code;
+            }
+            return t;
+        }();
+        return tables;
+    }
+
+    static inline uint8_t encode_srgb(const SrgbTables& tables, float v) {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        uint32_t code = tables.encode_start[glm::min((uint32_t)(v * SRGB_ENCODE_BUCKETS), SRGB_ENCODE_BUCKETS - 1)];
+        while (code < 255 && v >= tables.thresholds[code])
+            ++code;
+        return (uint8_t)code;
+    }
+
+    static inline uint8_t encode_unorm(float v) {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return (uint8_t)(v * 255.0f + 0.5f);
+    }
+
+    // grey + alpha and RGB + alpha keep alpha in the last channel
+    static inline bool channel_is_alpha(uint32_t channel, uint32_t num_channels) {
+        return (num_channels == 2 || num_channels == 4) && channel == num_channels - 1;
+    }
+
+    // ===================================================================================
+    // conversion
+    // ===================================================================================
+    struct TexelLayout {
+        uint32_t num_channels;
+        bool     is_float;
+        bool     is_srgb;
+    };
+
+    static void rows_to_linear(const void* pixels, const TexelLayout& layout, uint32_t width, uint32_t row_first, uint32_t row_count, float* out) {
+        const SrgbTables& tables = get_srgb_tables();
+        uint32_t n = layout.num_channels;
+
+        for (size_t i = (size_t)row_first * width; i < (size_t)(row_first + row_count) * width; ++i) {
+            float* texel = out + i * 4;
+            texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+
+            if (layout.is_float) {
+                memcpy(texel, (const float*)pixels + i * n, n * sizeof(float));
+                continue;
+            }
+
+            const uint8_t* src = (const uint8_t*)pixels + i * n;
+            for (uint32_t c = 0; c < n; ++c)
+                texel[c] = layout.is_srgb && !channel_is_alpha(c, n) ? tables.decode[src[c]] : src[c] / 255.0f;
+        }
+    }
+
+    static void rows_from_linear(const float* texels, const TexelLayout& layout, uint32_t width, uint32_t row_first, uint32_t row_count, void* out) {
+        const SrgbTables& tables = get_srgb_tables();
+        uint32_t n = layout.num_channels;
+
+        for (size_t i = (size_t)row_first * width; i < (size_t)(row_first + row_count) * width; ++i) {
+            const float* texel = texels + i * 4;
+
+            if (layout.is_float) {
+                float* dst = (float*)out + i * n;
+                for (uint32_t c = 0; c < n; ++c)
+                    dst[c] = texel[c] > 0.0f ? texel[c] : 0.0f;
+                continue;
+            }
+
+            uint8_t* dst = (uint8_t*)out + i * n;
+            for (uint32_t c = 0; c < n; ++c)
+                dst[c] = layout.is_srgb && !channel_is_alpha(c, n) ? encode_srgb(tables, texel[c]) : encode_unorm(texel[c]);
+        }
+    }
+
+    // ===================================================================================
+    // filters
+    // ===================================================================================
+    static void box_rows(const LinearImage& src, const LinearImage& dst, uint32_t row_first, uint32_t row_count) {
+        for (uint32_t y = row_first; y < row_first + row_count; ++y) {
+            const float* row0 = src.texels + (size_t)glm::min(y * 2,     src.height - 1) * src.width * 4;
+            const float* row1 = src.texels + (size_t)glm::min(y * 2 + 1, src.height - 1) * src.width * 4;
+            float*       out  = dst.texels + (size_t)y * dst.width * 4;
+
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                uint32_t x0 = glm::min(x * 2,     src.width - 1) * 4;
+                uint32_t x1 = glm::min(x * 2 + 1, src.width - 1) * 4;
+                Texel sum = texel_add(
+                    texel_add(texel_load(row0 + x0), texel_load(row0 + x1)),
+                    texel_add(texel_load(row1 + x0), texel_load(row1 + x1))
+                );
+                texel_store(out + x * 4, texel_scale(sum, 0.25f));
+            }
+        }
+    }
+
+    // zeroth order modified Bessel function of the first kind, series expansion
+    static double bessel_i0(double x) {
+        double sum  = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum  += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        return sum;
+    }
+
+    // `d` is in destination texels
+    static float kaiser_weight(float d) {
+        if (fabsf(d) >= KAISER_WIDTH)
+            return 0.0f;
+
+        double x    = d / KAISER_WIDTH;
+        double sinc = d == 0.0f ? 1.0 : sin(PI * d) / (PI * d);
+        return (float)(sinc * bessel_i0(KAISER_ALPHA * sqrt(1.0 - x * x)) / bessel_i0(KAISER_ALPHA));
+    }
+
+    // source taps of every destination texel along one axis, edges clamped
+    struct FilterTaps {
+        std::vector<uint32_t> first;   // per destination texel, into `index` and `weight`
+        std::vector<uint32_t> count;
+        std::vector<uint32_t> index;
+        std::vector<float>    weight;
+    };
+
+    static void build_kaiser_taps(uint32_t src_size, uint32_t dst_size, FilterTaps* taps) {
+        taps->first.resize(dst_size);
+        taps->count.resize(dst_size);
+        taps->index.clear();
+        taps->weight.clear();
+
+        // an axis already at 1 texel is not filtered
+        if (src_size == dst_size) {
+            for (uint32_t x = 0; x < dst_size; ++x) {
+                taps->first[x] = x;
+                taps->count[x] = 1;
+                taps->index.push_back(x);
+                taps->weight.push_back(1.0f);
+            }
+            return;
+        }
+
+        float scale = (float)src_size / dst_size;
+        for (uint32_t x = 0; x < dst_size; ++x) {
+            float   center = (x + 0.5f) * scale;
+            int32_t begin  = (int32_t)floorf(center - KAISER_WIDTH * scale);
+            int32_t end    = (int32_t)ceilf(center + KAISER_WIDTH * scale);
+
+            taps->first[x] = (uint32_t)taps->index.size();
+            float total = 0.0f;
+            for (int32_t i = begin; i <= end; ++i) {
+                float w = kaiser_weight((i + 0.5f - center) / scale);
+                if (w == 0.0f)
+                    continue;
+                taps->index.push_back((uint32_t)glm::clamp(i, 0, (int32_t)src_size - 1));
+                taps->weight.push_back(w);
+                total += w;
+            }
+            taps->count[x] = (uint32_t)taps->index.size() - taps->first[x];
+            for (uint32_t i = taps->first[x]; i < taps->first[x] + taps->count[x]; ++i)
+                taps->weight[i] /= total;
+        }
+    }
+
+    // src rows -> tmp (dst.width x src.height)
+    static void kaiser_rows_horizontal(const LinearImage& src, const LinearImage& tmp, const FilterTaps& taps, uint32_t row_first, uint32_t row_count) {
+        for (uint32_t y = row_first; y < row_first + row_count; ++y) {
+            const float* in  = src.texels + (size_t)y * src.width * 4;
+            float*       out = tmp.texels + (size_t)y * tmp.width * 4;
+
+            for (uint32_t x = 0; x < tmp.width; ++x) {
+                Texel acc = texel_zero();
+                for (uint32_t t = taps.first[x]; t < taps.first[x] + taps.count[x]; ++t)
+                    acc = texel_mul_add(acc, texel_load(in + taps.index[t] * 4), taps.weight[t]);
+                texel_store(out + x * 4, acc);
+            }
+        }
+    }
+
+    // tmp rows -> dst rows, whole rows at a time so that reads stay linear
+    static void kaiser_rows_vertical(const LinearImage& tmp, const LinearImage& dst, const FilterTaps& taps, uint32_t row_first, uint32_t row_count) {
+        for (uint32_t y = row_first; y < row_first + row_count; ++y) {
+            float* out = dst.texels + (size_t)y * dst.width * 4;
+            for (uint32_t x = 0; x < dst.width; ++x)
+                texel_store(out + x * 4, texel_zero());
+
+            for (uint32_t t = taps.first[y]; t < taps.first[y] + taps.count[y]; ++t) {
+                const float* in = tmp.texels + (size_t)taps.index[t] * tmp.width * 4;
+                float        w  = taps.weight[t];
+                for (uint32_t x = 0; x < dst.width; ++x)
+                    texel_store(out + x * 4, texel_mul_add(texel_load(out + x * 4), texel_load(in + x * 4), w));
+            }
+        }
+    }
+
+    // runs `fn(row_first, row_count)` on the job pool, in chunks of about MIP_TEXELS_PER_JOB texels
+    template<typename Fn>
+    static void for_rows(uint32_t width, uint32_t height, Fn fn) {
+        uint32_t rows_per_job = glm::max(MIP_TEXELS_PER_JOB / glm::max(width, 1u), 1u);
+
+        Jobs::JobCounter jobs;
+        for (uint32_t row = 0; row < height; row += rows_per_job) {
+            uint32_t count = glm::min(rows_per_job, height - row);
+            Jobs::job_pool_submit(&jobs, [=]() { fn(row, count); });
+        }
+        Jobs::job_pool_wait(&jobs);
+    }
+
+    // ===================================================================================
+    // public
+    // ===================================================================================
+    uint32_t texture_get_mip_count(uint32_t width, uint32_t height) {
+        uint32_t mips = 1;
+        for (uint32_t size = glm::max(width, height); size > 1; size /= 2)
+            ++mips;
+        return mips;
+    }
+
+    bool texture_format_is_srgb(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R8_SRGB:
+            case VK_FORMAT_R8G8_SRGB:
+            case VK_FORMAT_R8G8B8_SRGB:
+            case VK_FORMAT_B8G8R8_SRGB:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void* texture_generate_mips(
+        const void* pixels,
+        uint32_t width,
+        uint32_t height,
+        TexChannelTypes channels,
+        bool is_float,
+        bool is_srgb,
+        MipFilter filter,
+        uint32_t* out_mips,
+        uint32_t* out_size
+    ) {
+        TexelLayout layout = {
+            .num_channels = tex_get_num_channels(channels),
+            .is_float     = is_float,
+            .is_srgb      = is_srgb && !is_float
+        };
+        size_t texel_size = layout.num_channels * (is_float ? sizeof(float) : sizeof(uint8_t));
+
+        uint32_t mips = texture_get_mip_count(width, height);
+        size_t   size = 0;
+        for (uint32_t i = 0; i < mips; ++i)
+            size += (size_t)glm::max(width >> i, 1u) * glm::max(height >> i, 1u) * texel_size;
+
+        unsigned char* out = (unsigned char*)malloc(size);
+        memcpy(out, pixels, (size_t)width * height * texel_size);
+
+        // ping-pong between two buffers: even levels fit in the level 0 one, odd levels in the level 1 one
+        float* texels_even = alloc_texels((size_t)width * height);
+        float* texels_odd  = alloc_texels((size_t)glm::max(width / 2, 1u) * glm::max(height / 2, 1u));
+        // horizontal pass of the Kaiser filter, never larger than level 1 width x level 0 height
+        float* texels_tmp  = filter == MIP_FILTER_KAISER ? alloc_texels((size_t)glm::max(width / 2, 1u) * height) : nullptr;
+
+        LinearImage prev = { texels_even, width, height };
+        for_rows(width, height, [&](uint32_t row_first, uint32_t row_count) {
+            rows_to_linear(pixels, layout, width, row_first, row_count, prev.texels);
+        });
+
+        unsigned char* out_level = out + (size_t)width * height * texel_size;
+        FilterTaps taps_x;
+        FilterTaps taps_y;
+        for (uint32_t i = 1; i < mips; ++i) {
+            LinearImage curr = {
+                .texels = (i & 1) ? texels_odd : texels_even,
+                .width  = glm::max(width  >> i, 1u),
+                .height = glm::max(height >> i, 1u)
+            };
+
+            if (filter == MIP_FILTER_KAISER) {
+                LinearImage tmp = { texels_tmp, curr.width, prev.height };
+                build_kaiser_taps(prev.width,  curr.width,  &taps_x);
+                build_kaiser_taps(prev.height, curr.height, &taps_y);
+
+                for_rows(tmp.width, tmp.height, [&](uint32_t row_first, uint32_t row_count) {
+                    kaiser_rows_horizontal(prev, tmp, taps_x, row_first, row_count);
+                });
+                for_rows(curr.width, curr.height, [&](uint32_t row_first, uint32_t row_count) {
+                    kaiser_rows_vertical(tmp, curr, taps_y, row_first, row_count);
+                    rows_from_linear(curr.texels, layout, curr.width, row_first, row_count, out_level);
+                });
+            }
+            else {
+                for_rows(curr.width, curr.height, [&](uint32_t row_first, uint32_t row_count) {
+                    box_rows(prev, curr, row_first, row_count);
+                    rows_from_linear(curr.texels, layout, curr.width, row_first, row_count, out_level);
+                });
+            }
+
+            out_level += (size_t)curr.width * curr.height * texel_size;
+            prev = curr;
+        }
+
+        free_texels(texels_even);
+        free_texels(texels_odd);
+        if (texels_tmp)
+            free_texels(texels_tmp);
+
+        *out_mips = mips;
+        *out_size = (uint32_t)size;
+        return out;
+    }
+}
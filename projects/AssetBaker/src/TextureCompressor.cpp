@@ -0,0 +1,791 @@
+#include "TextureCompressor.hpp"
+#include "JobPool.hpp"
+
+#include <glm/gtc/packing.hpp>
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define VKC_BC_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define VKC_BC_SSE2 0
+#endif
+
+namespace vkc::Assets {
+    // blocks per job, small levels end up in a single job
+    const uint32_t BLOCKS_PER_JOB = 1024;
+
+    // 16 texels, one array per channel (SIMD friendly)
+    struct Block {
+        alignas(16) float c[4][16];
+    };
+
+    struct BitWriter {
+        unsigned char* out;
+        uint32_t       pos;
+
+        void write(uint32_t value, uint32_t bits) {
+            for (uint32_t i = 0; i < bits; ++i, ++pos)
+                if (value & (1u << i))
+                    out[pos >> 3] |= (unsigned char)(1u << (pos & 7));
+        }
+    };
+
+    // nearest palette entry for each texel, returns the total squared error
+    static float block_select_indices(const Block& block, const float (*palette)[4], uint32_t palette_size, uint32_t num_channels, uint8_t* indices) {
+        float total_error = 0.0f;
+#if VKC_BC_SSE2
+        for (uint32_t p = 0; p < 16; p += 4) {
+            __m128  best_error = _mm_set1_ps(FLT_MAX);
+            __m128i best_index = _mm_setzero_si128();
+
+            for (uint32_t k = 0; k < palette_size; ++k) {
+                __m128 error = _mm_setzero_ps();
+                for (uint32_t ch = 0; ch < num_channels; ++ch) {
+                    __m128 d = _mm_sub_ps(_mm_load_ps(block.c[ch] + p), _mm_set1_ps(palette[k][ch]));
+                    error = _mm_add_ps(error, _mm_mul_ps(d, d));
+                }
+
+                __m128i is_better = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+                best_error = _mm_min_ps(error, best_error);
+                best_index = _mm_or_si128(
+                    _mm_and_si128(is_better, _mm_set1_epi32((int)k)),
+                    _mm_andnot_si128(is_better, best_index)
+                );
+            }
+
+            alignas(16) int32_t  index[4];
+            alignas(16) float    error[4];
+            _mm_store_si128((__m128i*)index, best_index);
+            _mm_store_ps(error, best_error);
+            for (uint32_t i = 0; i < 4; ++i) {
+                indices[p + i] = (uint8_t)index[i];
+                total_error += error[i];
+            }
+        }
+#else
+        for (uint32_t p = 0; p < 16; ++p) {
+            float    best_error = FLT_MAX;
+            uint32_t best_index = 0;
+            for (uint32_t k = 0; k < palette_size; ++k) {
+                float error = 0.0f;
+                for (uint32_t ch = 0; ch < num_channels; ++ch) {
+                    float d = block.c[ch][p] - palette[k][ch];
+                    error += d * d;
+                }
+                if (error < best_error) {
+                    best_error = error;
+                    best_index = k;
+                }
+            }
+            indices[p] = (uint8_t)best_index;
+            total_error += best_error;
+        }
+#endif
+        return total_error;
+    }
+
+    // endpoints on the principal axis of the block, at the extremes of the texel projections
+    static void block_principal_endpoints(const Block& block, uint32_t num_channels, float* e0, float* e1) {
+        float mean[4] = { };
+        float bbox_min[4];
+        float bbox_max[4];
+        for (uint32_t ch = 0; ch < num_channels; ++ch) {
+            bbox_min[ch] = FLT_MAX;
+            bbox_max[ch] = -FLT_MAX;
+            for (uint32_t p = 0; p < 16; ++p) {
+                mean[ch] += block.c[ch][p];
+                bbox_min[ch] = fminf(bbox_min[ch], block.c[ch][p]);
+                bbox_max[ch] = fmaxf(bbox_max[ch], block.c[ch][p]);
+            }
+            mean[ch] /= 16.0f;
+        }
+
+        float cov[4][4] = { };
+        for (uint32_t p = 0; p < 16; ++p)
+            for (uint32_t i = 0; i < num_channels; ++i)
+                for (uint32_t j = 0; j < num_channels; ++j)
+                    cov[i][j] += (block.c[i][p] - mean[i]) * (block.c[j][p] - mean[j]);
+
+        // power iteration, starting from the bounding box diagonal
+        float axis[4] = { };
+        for (uint32_t ch = 0; ch < num_channels; ++ch)
+            axis[ch] = bbox_max[ch] - bbox_min[ch];
+        for (uint32_t it = 0; it < 6; ++it) {
+            float next[4] = { };
+            float length = 0.0f;
+            for (uint32_t i = 0; i < num_channels; ++i) {
+                for (uint32_t j = 0; j < num_channels; ++j)
+                    next[i] += cov[i][j] * axis[j];
+                length += next[i] * next[i];
+            }
+            if (length < 1e-12f)
+                break;
+            length = 1.0f / sqrtf(length);
+            for (uint32_t i = 0; i < num_channels; ++i)
+                axis[i] = next[i] * length;
+        }
+
+        float axis_length = 0.0f;
+        for (uint32_t ch = 0; ch < num_channels; ++ch)
+            axis_length += axis[ch] * axis[ch];
+        if (axis_length < 1e-12f) {
+            // flat block
+            for (uint32_t ch = 0; ch < num_channels; ++ch)
+                e0[ch] = e1[ch] = mean[ch];
+            return;
+        }
+        axis_length = 1.0f / sqrtf(axis_length);
+        for (uint32_t ch = 0; ch < num_channels; ++ch)
+            axis[ch] *= axis_length;
+
+        float t_min = FLT_MAX;
+        float t_max = -FLT_MAX;
+        for (uint32_t p = 0; p < 16; ++p) {
+            float t = 0.0f;
+            for (uint32_t ch = 0; ch < num_channels; ++ch)
+                t += (block.c[ch][p] - mean[ch]) * axis[ch];
+            t_min = fminf(t_min, t);
+            t_max = fmaxf(t_max, t);
+        }
+
+        for (uint32_t ch = 0; ch < num_channels; ++ch) {
+            e0[ch] = fminf(fmaxf(mean[ch] + axis[ch] * t_max, 0.0f), 255.0f);
+            e1[ch] = fminf(fmaxf(mean[ch] + axis[ch] * t_min, 0.0f), 255.0f);
+        }
+    }
+
+    // endpoints minimizing the squared error for fixed indices, `weights[i]` is the weight of e1 for index i.
+    // Returns false if the system is singular (all texels on one index)
+    static bool block_least_squares(const Block& block, uint32_t num_channels, const uint8_t* indices, const float* weights, float* e0, float* e1) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = { };
+        float bx[4] = { };
+        for (uint32_t p = 0; p < 16; ++p) {
+            float b = weights[indices[p]];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t ch = 0; ch < num_channels; ++ch) {
+                ax[ch] += a * block.c[ch][p];
+                bx[ch] += b * block.c[ch][p];
+            }
+        }
+
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            return false;
+
+        det = 1.0f / det;
+        for (uint32_t ch = 0; ch < num_channels; ++ch) {
+            e0[ch] = fminf(fmaxf((ax[ch] * bb - bx[ch] * ab) * det, 0.0f), 255.0f);
+            e1[ch] = fminf(fmaxf((bx[ch] * aa - ax[ch] * ab) * det, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    // ===================================================================================
+    // BC1
+    // ===================================================================================
+    static uint16_t pack_565(const float* c) {
+        uint32_t r = (uint32_t)(c[0] * 31.0f / 255.0f + 0.5f);
+        uint32_t g = (uint32_t)(c[1] * 63.0f / 255.0f + 0.5f);
+        uint32_t b = (uint32_t)(c[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    static void unpack_565(uint16_t v, float* c) {
+        uint32_t r = (v >> 11) & 31;
+        uint32_t g = (v >> 5)  & 63;
+        uint32_t b = v         & 31;
+        c[0] = (float)((r << 3) | (r >> 2));
+        c[1] = (float)((g << 2) | (g >> 4));
+        c[2] = (float)((b << 3) | (b >> 2));
+    }
+
+    // 4 color mode only (BC3 color blocks can't use the 3 color one)
+    static float bc1_palette_indices(const Block& block, uint16_t c0, uint16_t c1, uint8_t* indices) {
+        float palette[4][4] = { };
+        unpack_565(c0, palette[0]);
+        unpack_565(c1, palette[1]);
+        for (uint32_t ch = 0; ch < 3; ++ch) {
+            palette[2][ch] = (2.0f * palette[0][ch] + palette[1][ch]) / 3.0f;
+            palette[3][ch] = (palette[0][ch] + 2.0f * palette[1][ch]) / 3.0f;
+        }
+        return block_select_indices(block, palette, 4, 3, indices);
+    }
+
+    static void bc1_encode_block(const Block& block, unsigned char* out) {
+        // weight of c1 per index
+        static const float WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float e0[4], e1[4];
+        block_principal_endpoints(block, 3, e0, e1);
+
+        uint16_t c0 = pack_565(e0);
+        uint16_t c1 = pack_565(e1);
+        uint8_t  indices[16];
+        float    error = bc1_palette_indices(block, c0, c1, indices);
+
+        if (block_least_squares(block, 3, indices, WEIGHTS, e0, e1)) {
+            uint16_t refined_c0 = pack_565(e0);
+            uint16_t refined_c1 = pack_565(e1);
+            uint8_t  refined_indices[16];
+            float    refined_error = bc1_palette_indices(block, refined_c0, refined_c1, refined_indices);
+            if (refined_error < error) {
+                c0 = refined_c0;
+                c1 = refined_c1;
+                memcpy(indices, refined_indices, sizeof(indices));
+            }
+        }
+
+        // c0 > c1 selects the 4 color mode
+        if (c0 < c1) {
+            uint16_t tmp = c0;
+            c0 = c1;
+            c1 = tmp;
+            static const uint8_t SWAP[4] = { 1, 0, 3, 2 };
+            for (uint8_t& i : indices)
+                i = SWAP[i];
+        }
+        else if (c0 == c1) {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t bits = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+            bits |= (uint32_t)indices[p] << (p * 2);
+
+        out[0] = (unsigned char)(c0 & 0xFF);
+        out[1] = (unsigned char)(c0 >> 8);
+        out[2] = (unsigned char)(c1 & 0xFF);
+        out[3] = (unsigned char)(c1 >> 8);
+        memcpy(out + 4, &bits, 4);
+    }
+
+    // ===================================================================================
+    // BC4
+    // ===================================================================================
+    static void bc4_encode_block(const Block& block, uint32_t channel, unsigned char* out) {
+        float v_min = 255.0f;
+        float v_max = 0.0f;
+        for (uint32_t p = 0; p < 16; ++p) {
+            v_min = fminf(v_min, block.c[channel][p]);
+            v_max = fmaxf(v_max, block.c[channel][p]);
+        }
+
+        // e0 > e1 selects 6 interpolated values
+        uint8_t e0 = (uint8_t)(v_max + 0.5f);
+        uint8_t e1 = (uint8_t)(v_min + 0.5f);
+
+        uint8_t indices[16] = { };
+        if (e0 > e1) {
+            float palette[8][4] = { };
+            palette[0][0] = e0;
+            palette[1][0] = e1;
+            for (uint32_t i = 1; i < 7; ++i)
+                palette[i + 1][0] = ((7 - i) * e0 + i * e1) / 7.0f;
+
+            Block single = { };
+            memcpy(single.c[0], block.c[channel], sizeof(single.c[0]));
+            block_select_indices(single, palette, 8, 1, indices);
+        }
+
+        out[0] = e0;
+        out[1] = e1;
+        uint64_t bits = 0;
+        for (uint32_t p = 0; p < 16; ++p)
+            bits |= (uint64_t)indices[p] << (p * 3);
+        for (uint32_t i = 0; i < 6; ++i)
+            out[2 + i] = (unsigned char)(bits >> (i * 8));
+    }
+
+    // ===================================================================================
+    // BC7, mode 6
+    // ===================================================================================
+    static const float BC7_WEIGHTS_4[16] = {
+        0 / 64.0f,  4 / 64.0f,  9 / 64.0f, 13 / 64.0f, 17 / 64.0f, 21 / 64.0f, 26 / 64.0f, 30 / 64.0f,
+        34 / 64.0f, 38 / 64.0f, 43 / 64.0f, 47 / 64.0f, 51 / 64.0f, 55 / 64.0f, 60 / 64.0f, 64 / 64.0f
+    };
+
+    // 7 bits per channel plus a shared p-bit, returns the 8 bit endpoint
+    static void bc7_quantize_endpoint(const float* e, uint32_t* q, uint32_t* p_bit) {
+        float best_error = FLT_MAX;
+        for (uint32_t p = 0; p < 2; ++p) {
+            uint32_t candidate[4];
+            float    error = 0.0f;
+            for (uint32_t ch = 0; ch < 4; ++ch) {
+                int32_t v = (int32_t)((e[ch] - p) * 0.5f + 0.5f);
+                candidate[ch] = (uint32_t)(v < 0 ? 0 : (v > 127 ? 127 : v));
+                float d = (float)((candidate[ch] << 1) | p) - e[ch];
+                error += d * d;
+            }
+            if (error < best_error) {
+                best_error = error;
+                memcpy(q, candidate, sizeof(candidate));
+                *p_bit = p;
+            }
+        }
+    }
+
+    static float bc7_palette_indices(const Block& block, const uint32_t* q0, uint32_t p0, const uint32_t* q1, uint32_t p1, uint8_t* indices) {
+        static const uint32_t WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        float palette[16][4];
+        for (uint32_t ch = 0; ch < 4; ++ch) {
+            uint32_t v0 = (q0[ch] << 1) | p0;
+            uint32_t v1 = (q1[ch] << 1) | p1;
+            for (uint32_t i = 0; i < 16; ++i)
+                palette[i][ch] = (float)(((64 - WEIGHTS[i]) * v0 + WEIGHTS[i] * v1 + 32) >> 6);
+        }
+        return block_select_indices(block, palette, 16, 4, indices);
+    }
+
+    static void bc7_encode_block(const Block& block, unsigned char* out) {
+        float e0[4], e1[4];
+        block_principal_endpoints(block, 4, e0, e1);
+
+        uint32_t q0[4], q1[4], p0, p1;
+        uint8_t  indices[16];
+        bc7_quantize_endpoint(e0, q0, &p0);
+        bc7_quantize_endpoint(e1, q1, &p1);
+        float error = bc7_palette_indices(block, q0, p0, q1, p1, indices);
+
+        if (block_least_squares(block, 4, indices, BC7_WEIGHTS_4, e0, e1)) {
+            uint32_t refined_q0[4], refined_q1[4], refined_p0, refined_p1;
+            uint8_t  refined_indices[16];
+            bc7_quantize_endpoint(e0, refined_q0, &refined_p0);
+            bc7_quantize_endpoint(e1, refined_q1, &refined_p1);
+            float refined_error = bc7_palette_indices(block, refined_q0, refined_p0, refined_q1, refined_p1, refined_indices);
+            if (refined_error < error) {
+                memcpy(q0, refined_q0, sizeof(q0));
+                memcpy(q1, refined_q1, sizeof(q1));
+                p0 = refined_p0;
+                p1 = refined_p1;
+                memcpy(indices, refined_indices, sizeof(indices));
+            }
+        }
+
+        // the anchor index (texel 0) is stored without its top bit
+        if (indices[0] & 8) {
+            uint32_t tmp[4];
+            memcpy(tmp, q0, sizeof(tmp));
+            memcpy(q0, q1, sizeof(tmp));
+            memcpy(q1, tmp, sizeof(tmp));
+            uint32_t tmp_p = p0;
+            p0 = p1;
+            p1 = tmp_p;
+            for (uint8_t& i : indices)
+                i = 15 - i;
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer = { .out = out, .pos = 0 };
+        writer.write(1 << 6, 7);
+        for (uint32_t ch = 0; ch < 4; ++ch) {
+            writer.write(q0[ch], 7);
+            writer.write(q1[ch], 7);
+        }
+        writer.write(p0, 1);
+        writer.write(p1, 1);
+        writer.write(indices[0], 3);
+        for (uint32_t p = 1; p < 16; ++p)
+            writer.write(indices[p], 4);
+    }
+
+    // ===================================================================================
+    // BC6H, mode 11
+    // ===================================================================================
+    // texels are loaded as the half float bits of each channel, scaled by 64 / 31 (the last step of the
+    // decoder multiplies by 31 / 64) and by 1 / 257 so that the shared helpers see the 0-255 range
+    const float BC6H_TO_BLOCK = 64.0f / (31.0f * 257.0f);
+
+    static float bc6h_to_block(float value) {
+        uint16_t half = glm::packHalf1x16(fminf(fmaxf(value, 0.0f), 65504.0f));
+        return half * BC6H_TO_BLOCK;
+    }
+
+    // 10 bit endpoint, the inverse of the decoder unquantization ((q << 16) + 0x8000) >> 10
+    static uint32_t bc6h_quantize(float e) {
+        int32_t q = (int32_t)((e * 257.0f - 32.0f) / 64.0f + 0.5f);
+        return (uint32_t)(q < 0 ? 0 : (q > 1023 ? 1023 : q));
+    }
+
+    static uint32_t bc6h_unquantize(uint32_t q) {
+        if (q == 0)
+            return 0;
+        if (q == 1023)
+            return 0xFFFF;
+        return ((q << 16) + 0x8000) >> 10;
+    }
+
+    static float bc6h_palette_indices(const Block& block, const uint32_t* q0, const uint32_t* q1, uint8_t* indices) {
+        static const uint32_t WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        float palette[16][4];
+        for (uint32_t ch = 0; ch < 3; ++ch) {
+            uint32_t v0 = bc6h_unquantize(q0[ch]);
+            uint32_t v1 = bc6h_unquantize(q1[ch]);
+            for (uint32_t i = 0; i < 16; ++i)
+                palette[i][ch] = (float)(((64 - WEIGHTS[i]) * v0 + WEIGHTS[i] * v1 + 32) >> 6) / 257.0f;
+        }
+        return block_select_indices(block, palette, 16, 3, indices);
+    }
+
+    static void bc6h_encode_block(const Block& block, unsigned char* out) {
+        float e0[4], e1[4];
+        block_principal_endpoints(block, 3, e0, e1);
+
+        uint32_t q0[3], q1[3];
+        uint8_t  indices[16];
+        for (uint32_t ch = 0; ch < 3; ++ch) {
+            q0[ch] = bc6h_quantize(e0[ch]);
+            q1[ch] = bc6h_quantize(e1[ch]);
+        }
+        float error = bc6h_palette_indices(block, q0, q1, indices);
+
+        if (block_least_squares(block, 3, indices, BC7_WEIGHTS_4, e0, e1)) {
+            uint32_t refined_q0[3], refined_q1[3];
+            uint8_t  refined_indices[16];
+            for (uint32_t ch = 0; ch < 3; ++ch) {
+                refined_q0[ch] = bc6h_quantize(e0[ch]);
+                refined_q1[ch] = bc6h_quantize(e1[ch]);
+            }
+            float refined_error = bc6h_palette_indices(block, refined_q0, refined_q1, refined_indices);
+            if (refined_error < error) {
+                memcpy(q0, refined_q0, sizeof(q0));
+                memcpy(q1, refined_q1, sizeof(q1));
+                memcpy(indices, refined_indices, sizeof(indices));
+            }
+        }
+
+        // the anchor index (texel 0) is stored without its top bit
+        if (indices[0] & 8) {
+            uint32_t tmp[3];
+            memcpy(tmp, q0, sizeof(tmp));
+            memcpy(q0, q1, sizeof(tmp));
+            memcpy(q1, tmp, sizeof(tmp));
+            for (uint8_t& i : indices)
+                i = 15 - i;
+        }
+
+        memset(out, 0, 16);
+        BitWriter writer = { .out = out, .pos = 0 };
+        writer.write(0x03, 5);
+        for (uint32_t ch = 0; ch < 3; ++ch)
+            writer.write(q0[ch], 10);
+        for (uint32_t ch = 0; ch < 3; ++ch)
+            writer.write(q1[ch], 10);
+        writer.write(indices[0], 3);
+        for (uint32_t p = 1; p < 16; ++p)
+            writer.write(indices[p], 4);
+    }
+
+    // ===================================================================================
+    // E5B9G9R9
+    // ===================================================================================
+    uint32_t texture_pack_rgb9e5(float r, float g, float b) {
+        // from the EXT_texture_shared_exponent spec: 9 bit mantissas, exponent bias 15
+        const float SHARED_EXP_MAX = 511.0f / 512.0f * 65536.0f;
+        r = fminf(fmaxf(r, 0.0f), SHARED_EXP_MAX);
+        g = fminf(fmaxf(g, 0.0f), SHARED_EXP_MAX);
+        b = fminf(fmaxf(b, 0.0f), SHARED_EXP_MAX);
+
+        float max_c = fmaxf(r, fmaxf(g, b));
+        if (max_c == 0.0f)
+            return 0;
+
+        int32_t exp_shared = glm::max((int32_t)floorf(log2f(max_c)), -16) + 1 + 15;
+        float   scale      = ldexpf(1.0f, exp_shared - 15 - 9);
+        if ((uint32_t)floorf(max_c / scale + 0.5f) == 512) {
+            exp_shared += 1;
+            scale *= 2.0f;
+        }
+
+        uint32_t r_s = (uint32_t)floorf(r / scale + 0.5f);
+        uint32_t g_s = (uint32_t)floorf(g / scale + 0.5f);
+        uint32_t b_s = (uint32_t)floorf(b / scale + 0.5f);
+        return r_s | (g_s << 9) | (b_s << 18) | ((uint32_t)exp_shared << 27);
+    }
+
+    // ===================================================================================
+    // levels
+    // ===================================================================================
+    static uint32_t get_block_bytes(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return 8;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+            case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+                return 16;
+            default:
+                CC_ASSERT(false, "format not supported by the texture compressor");
+                return 0;
+        }
+    }
+
+    uint32_t texture_get_compressed_size(VkFormat format, uint32_t width, uint32_t height) {
+        if (format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32)
+            return width * height * sizeof(uint32_t);
+        return ((width + 3) / 4) * ((height + 3) / 4) * get_block_bytes(format);
+    }
+
+    // texels past the edge repeat the last row/column
+    static void load_block(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint32_t bx, uint32_t by, Block* block) {
+        for (uint32_t y = 0; y < 4; ++y) {
+            uint32_t py = by * 4 + y < height ? by * 4 + y : height - 1;
+            for (uint32_t x = 0; x < 4; ++x) {
+                uint32_t px = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                const unsigned char* texel = pixels + ((size_t)py * width + px) * num_channels;
+                uint32_t p = y * 4 + x;
+
+                switch (num_channels) {
+                    case 1:
+                        block->c[0][p] = block->c[1][p] = block->c[2][p] = texel[0];
+                        block->c[3][p] = 255.0f;
+                        break;
+                    case 2:
+                        block->c[0][p] = texel[0];
+                        block->c[1][p] = texel[1];
+                        block->c[2][p] = 0.0f;
+                        block->c[3][p] = 255.0f;
+                        break;
+                    case 3:
+                        block->c[0][p] = texel[0];
+                        block->c[1][p] = texel[1];
+                        block->c[2][p] = texel[2];
+                        block->c[3][p] = 255.0f;
+                        break;
+                    default:
+                        block->c[0][p] = texel[0];
+                        block->c[1][p] = texel[1];
+                        block->c[2][p] = texel[2];
+                        block->c[3][p] = texel[3];
+                        break;
+                }
+            }
+        }
+    }
+
+    static void load_block_hdr(const float* pixels, uint32_t width, uint32_t height, uint32_t num_channels, uint32_t bx, uint32_t by, Block* block) {
+        for (uint32_t y = 0; y < 4; ++y) {
+            uint32_t py = by * 4 + y < height ? by * 4 + y : height - 1;
+            for (uint32_t x = 0; x < 4; ++x) {
+                uint32_t px = bx * 4 + x < width ? bx * 4 + x : width - 1;
+                const float* texel = pixels + ((size_t)py * width + px) * num_channels;
+                uint32_t p = y * 4 + x;
+
+                block->c[0][p] = bc6h_to_block(texel[0]);
+                block->c[1][p] = bc6h_to_block(num_channels > 1 ? texel[1] : texel[0]);
+                block->c[2][p] = bc6h_to_block(num_channels > 2 ? texel[2] : (num_channels > 1 ? 0.0f : texel[0]));
+                block->c[3][p] = 0.0f;
+            }
+        }
+    }
+
+    static void compress_blocks(
+        const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t num_channels,
+        VkFormat format, uint32_t block_first, uint32_t block_count, unsigned char* out
+    ) {
+        uint32_t blocks_x    = (width + 3) / 4;
+        uint32_t block_bytes = get_block_bytes(format);
+
+        Block block;
+        for (uint32_t b = block_first; b < block_first + block_count; ++b) {
+            load_block(pixels, width, height, num_channels, b % blocks_x, b / blocks_x, &block);
+            unsigned char* dst = out + (size_t)b * block_bytes;
+
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                    bc1_encode_block(block, dst);
+                    break;
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    bc4_encode_block(block, 3, dst);
+                    bc1_encode_block(block, dst + 8);
+                    break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    bc4_encode_block(block, 0, dst);
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    bc4_encode_block(block, 0, dst);
+                    bc4_encode_block(block, 1, dst + 8);
+                    break;
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    bc7_encode_block(block, dst);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    static void compress_blocks_hdr(
+        const float* pixels, uint32_t width, uint32_t height, uint32_t num_channels,
+        VkFormat format, uint32_t block_first, uint32_t block_count, unsigned char* out
+    ) {
+        // E5B9G9R9 "blocks" are single rows
+        if (format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32) {
+            uint32_t* dst = (uint32_t*)out;
+            for (uint32_t y = block_first; y < block_first + block_count; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    const float* texel = pixels + ((size_t)y * width + x) * num_channels;
+                    float r = texel[0];
+                    float g = num_channels > 1 ? texel[1] : texel[0];
+                    float b = num_channels > 2 ? texel[2] : (num_channels > 1 ? 0.0f : texel[0]);
+                    dst[(size_t)y * width + x] = texture_pack_rgb9e5(r, g, b);
+                }
+            }
+            return;
+        }
+
+        uint32_t blocks_x = (width + 3) / 4;
+
+        Block block;
+        for (uint32_t b = block_first; b < block_first + block_count; ++b) {
+            load_block_hdr(pixels, width, height, num_channels, b % blocks_x, b / blocks_x, &block);
+            bc6h_encode_block(block, out + (size_t)b * 16);
+        }
+    }
+
+    VkFormat texture_choose_compressed_format(VkFormat format, uint32_t num_channels, bool has_alpha, TexCompression compression) {
+        if (compression == TEX_COMPRESSION_NONE)
+            return VK_FORMAT_UNDEFINED;
+
+        if (format == VK_FORMAT_R8G8B8_UNORM && num_channels >= 2)
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        if (num_channels == 1)
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        if (num_channels == 2)
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+
+        bool is_srgb = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_R8G8B8_SRGB;
+        if (compression == TEX_COMPRESSION_HIGH)
+            return is_srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        if (has_alpha)
+            return is_srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        return is_srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    }
+
+    bool texture_is_compact_hdr_format(VkFormat format) {
+        return format == VK_FORMAT_BC6H_UFLOAT_BLOCK || format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+    }
+
+    bool texture_has_alpha(const unsigned char* pixels, uint32_t texel_count, uint32_t num_channels) {
+        if (num_channels != 4)
+            return false;
+
+        for (uint32_t i = 0; i < texel_count; ++i)
+            if (pixels[i * 4 + 3] != 255)
+                return true;
+        return false;
+    }
+
+    unsigned char* texture_compress(
+        const unsigned char* pixels,
+        uint32_t width,
+        uint32_t height,
+        uint32_t mips,
+        uint32_t layers,
+        uint32_t num_channels,
+        VkFormat format,
+        uint32_t* out_size
+    ) {
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < mips; ++i)
+            size += texture_get_compressed_size(format, glm::max(width >> i, 1u), glm::max(height >> i, 1u)) * layers;
+
+        unsigned char* out = (unsigned char*)malloc(size);
+
+        Jobs::JobCounter jobs;
+        const unsigned char* src = pixels;
+        unsigned char*       dst = out;
+        for (uint32_t i = 0; i < mips; ++i) {
+            uint32_t level_width  = glm::max(width  >> i, 1u);
+            uint32_t level_height = glm::max(height >> i, 1u);
+            uint32_t block_count  = ((level_width + 3) / 4) * ((level_height + 3) / 4);
+
+            for (uint32_t layer = 0; layer < layers; ++layer) {
+                for (uint32_t first = 0; first < block_count; first += BLOCKS_PER_JOB) {
+                    uint32_t count = glm::min(BLOCKS_PER_JOB, block_count - first);
+                    Jobs::job_pool_submit(&jobs, [=]() {
+                        compress_blocks(src, level_width, level_height, num_channels, format, first, count, dst);
+                    });
+                }
+
+                src += (size_t)level_width * level_height * num_channels;
+                dst += texture_get_compressed_size(format, level_width, level_height);
+            }
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        *out_size = size;
+        return out;
+    }
+
+    unsigned char* texture_compress_hdr(
+        const float* pixels,
+        uint32_t width,
+        uint32_t height,
+        uint32_t mips,
+        uint32_t layers,
+        uint32_t num_channels,
+        VkFormat format,
+        uint32_t* out_size
+    ) {
+        CC_ASSERT(texture_is_compact_hdr_format(format), "format not supported by the HDR texture compressor");
+
+        uint32_t size = 0;
+        for (uint32_t i = 0; i < mips; ++i)
+            size += texture_get_compressed_size(format, glm::max(width >> i, 1u), glm::max(height >> i, 1u)) * layers;
+
+        unsigned char* out = (unsigned char*)malloc(size);
+
+        Jobs::JobCounter jobs;
+        const float*   src = pixels;
+        unsigned char* dst = out;
+        for (uint32_t i = 0; i < mips; ++i) {
+            uint32_t level_width  = glm::max(width  >> i, 1u);
+            uint32_t level_height = glm::max(height >> i, 1u);
+            uint32_t block_count  = format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+                ? level_height
+                : ((level_width + 3) / 4) * ((level_height + 3) / 4);
+            uint32_t per_job      = format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+                ? glm::max(BLOCKS_PER_JOB * 16 / level_width, 1u)
+                : BLOCKS_PER_JOB;
+
+            for (uint32_t layer = 0; layer < layers; ++layer) {
+                for (uint32_t first = 0; first < block_count; first += per_job) {
+                    uint32_t count = glm::min(per_job, block_count - first);
+                    Jobs::job_pool_submit(&jobs, [=]() {
+                        compress_blocks_hdr(src, level_width, level_height, num_channels, format, first, count, dst);
+                    });
+                }
+
+                src += (size_t)level_width * level_height * num_channels;
+                dst += texture_get_compressed_size(format, level_width, level_height);
+            }
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        *out_size = size;
+        return out;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "AssetManager.hpp"
+
+// offline block compression of 8 bit textures, 4x4 texel blocks
+//
+// - BC1: opaque color, 4 bpp
+// - BC3: color + alpha, 8 bpp
+// - BC4: one channel, 4 bpp
+// - BC5: two channels (normal maps, z is rebuilt in the shader), 8 bpp
+// - BC7: color + alpha, 8 bpp. Mode 6 only (one subset, 7777.1 endpoints, 4 bit indices)
+//
+// and of float (HDR) textures, negative values are clamped to 0
+//
+// - BC6H (unsigned): RGB, 8 bpp. Mode 11 only (one region, 10 bit endpoints, 4 bit indices),
+//   endpoints are fitted on the half float bit patterns the hardware interpolates
+// - E5B9G9R9: RGB with a shared exponent, 32 bpp, not a block format
+//
+// endpoints come from the principal axis of the block, refined once by least squares.
+// Index selection is vectorized with SSE2 when available, levels are split in jobs on the job pool
+namespace vkc::Assets {
+	// block compressed format for a texture decoded with `num_channels` channels and requested as `format`,
+	// VK_FORMAT_UNDEFINED if it should stay uncompressed. VK_FORMAT_R8G8B8_UNORM is the normal map format
+	VkFormat texture_choose_compressed_format(VkFormat format, uint32_t num_channels, bool has_alpha, TexCompression compression);
+
+	// true if any texel has an alpha below 255
+	bool texture_has_alpha(const unsigned char* pixels, uint32_t texel_count, uint32_t num_channels);
+
+	// true for the HDR formats `texture_compress_hdr` can produce
+	bool texture_is_compact_hdr_format(VkFormat format);
+
+	// E5B9G9R9_UFLOAT_PACK32 texel, values above the largest representable one (65408) are clamped
+	uint32_t texture_pack_rgb9e5(float r, float g, float b);
+
+	// bytes of a single level
+	uint32_t texture_get_compressed_size(VkFormat format, uint32_t width, uint32_t height);
+
+	// `pixels` holds `mips` levels, tightly packed, each half the size of the previous one. Each level is
+	// `layers` images one after the other (cubemap faces), compressed on their own.
+	// Returns a malloc'd buffer with the levels in the same order, `out_size` bytes
+	unsigned char* texture_compress(
+		const unsigned char* pixels,
+		uint32_t width,
+		uint32_t height,
+		uint32_t mips,
+		uint32_t layers,
+		uint32_t num_channels,
+		VkFormat format,
+		uint32_t* out_size
+	);
+
+	// same as `texture_compress` for float pixels, `format` is VK_FORMAT_BC6H_UFLOAT_BLOCK or
+	// VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+	unsigned char* texture_compress_hdr(
+		const float* pixels,
+		uint32_t width,
+		uint32_t height,
+		uint32_t mips,
+		uint32_t layers,
+		uint32_t num_channels,
+		VkFormat format,
+		uint32_t* out_size
+	);
+}
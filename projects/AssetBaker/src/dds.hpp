@@ -3,8 +3,8 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vk_enum_string_helper.h>
 
-// TMP headers
-#include <map>
+#include <stdint.h>
+#include <string.h>
 
 #ifndef MAKEFOURCC
 #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
@@ -46,193 +46,241 @@ typedef struct {
     uint32_t reserved2;
 } dds_header;
 
-std::map<unsigned int, unsigned int> TMP_fourcc_counts;
-std::map<unsigned int, VkFormat> TMP_fourcc_names {
-    { MAKEFOURCC('D', 'X', 'T', '1'), VK_FORMAT_BC1_RGBA_UNORM_BLOCK },
-    { MAKEFOURCC('D', 'X', 'T', '3'), VK_FORMAT_BC2_UNORM_BLOCK },
-    { MAKEFOURCC('D', 'X', 'T', '5'), VK_FORMAT_BC3_UNORM_BLOCK },
-    { MAKEFOURCC('D', 'X', 'T', '2'), VK_FORMAT_BC2_UNORM_BLOCK },
-    { MAKEFOURCC('D', 'X', 'T', '4'), VK_FORMAT_BC3_UNORM_BLOCK },
-    { MAKEFOURCC('A', 'T', 'I', '1'), VK_FORMAT_BC4_UNORM_BLOCK },
-    { MAKEFOURCC('B', 'C', '4', 'U'), VK_FORMAT_BC4_UNORM_BLOCK },
-    { MAKEFOURCC('B', 'C', '4', 'S'), VK_FORMAT_BC4_SNORM_BLOCK },
-    { MAKEFOURCC('A', 'T', 'I', '2'), VK_FORMAT_BC5_UNORM_BLOCK },
-    { MAKEFOURCC('B', 'C', '5', 'U'), VK_FORMAT_BC5_UNORM_BLOCK },
-    { MAKEFOURCC('B', 'C', '5', 'S'), VK_FORMAT_BC5_SNORM_BLOCK },
-    { MAKEFOURCC('R', 'G', 'B', 'G'), VK_FORMAT_G8B8G8R8_422_UNORM },
-    { MAKEFOURCC('G', 'R', 'G', 'B'), VK_FORMAT_B8G8R8G8_422_UNORM },
-    { MAKEFOURCC('U', 'Y', 'V', 'Y'), VK_FORMAT_G8B8G8R8_422_UNORM },
-    { MAKEFOURCC('Y', 'U', 'Y', '2'), VK_FORMAT_B8G8R8G8_422_UNORM },
-    { MAKEFOURCC('U', 'Y', 'V', 'Y'), VK_FORMAT_G8B8G8R8_422_UNORM_KHR },
-    { MAKEFOURCC('Y', 'U', 'Y', '2'), VK_FORMAT_G8B8G8R8_422_UNORM_KHR }
-};
-
-void print_fourcc_count() {
-    /*CC_LOG(CC_IMPORTANT, "FourCC counts");
-
-    for(auto& kp : TMP_fourcc_counts) {
-        unsigned int fourcc_id = kp.first;
-        unsigned int fourcc_count = kp.second;
-
-        if(TMP_fourcc_names.contains(fourcc_id))
-        {
-            VkFormat format = TMP_fourcc_names[fourcc_id];
-            CC_LOG(CC_INFO, "%-32s %3d", string_VkFormat(format), fourcc_count);
-        }
-        else
-            CC_LOG(CC_INFO, "<UNKNOWN>%d\t\t%3d", fourcc_id, fourcc_count);
-    }*/
-}
-
-// from https://github.com/Sixshaman/DDSTextureLoaderVk/blob/master/DDSTextureLoaderVk.cpp#L2196
-void fourcc_check(dds_header* header)
-{
-    if (!TMP_fourcc_counts.contains(header->ddspf.fourcc))
-        TMP_fourcc_counts[header->ddspf.fourcc] = 0;
-    TMP_fourcc_counts[header->ddspf.fourcc]++;
-
-    //if      (MAKEFOURCC('D', 'X', 'T', '1') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC1_RGBA_UNORM_BLOCK");
-    //else if (MAKEFOURCC('D', 'X', 'T', '3') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC2_UNORM_BLOCK");
-    //else if (MAKEFOURCC('D', 'X', 'T', '5') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC3_UNORM_BLOCK");
-    //else if (MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC2_UNORM_BLOCK");     // While pre-multiplied alpha isn't directly supported by the VK formats,
-    //else if (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC3_UNORM_BLOCK");     // they are basically the same as these BC formats so they can be mapped
-    //else if (MAKEFOURCC('A', 'T', 'I', '1') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC4_UNORM_BLOCK");
-    //else if (MAKEFOURCC('B', 'C', '4', 'U') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC4_UNORM_BLOCK");
-    //else if (MAKEFOURCC('B', 'C', '4', 'S') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC4_SNORM_BLOCK");
-    //else if (MAKEFOURCC('A', 'T', 'I', '2') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC5_UNORM_BLOCK");
-    //else if (MAKEFOURCC('B', 'C', '5', 'U') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC5_UNORM_BLOCK");
-    //else if (MAKEFOURCC('B', 'C', '5', 'S') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_BC5_SNORM_BLOCK");
-    //else if (MAKEFOURCC('R', 'G', 'B', 'G') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_G8B8G8R8_422_UNORM"); // BC6H and BC7 are written using the "DX10"extended header
-    //else if (MAKEFOURCC('G', 'R', 'G', 'B') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_B8G8R8G8_422_UNORM");
-    //else if (MAKEFOURCC('U', 'Y', 'V', 'Y') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_G8B8G8R8_422_UNORM"); //#if defined(VK_VERSION_1_1) && VK_VERSION_1_1
-    //else if (MAKEFOURCC('Y', 'U', 'Y', '2') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_B8G8R8G8_422_UNORM");
-    //else if (MAKEFOURCC('U', 'Y', 'V', 'Y') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_G8B8G8R8_422_UNORM_KHR"); //#elif defined(VK_KHR_sampler_ycbcr_conversion)
-    //else if (MAKEFOURCC('Y', 'U', 'Y', '2') == header->ddspf.fourcc) CC_LOG(CC_INFO, "VK_FORMAT_G8B8G8R8_422_UNORM_KHR"); //#endif // #if defined(VK_VERSION_1_1) && VK_VERSION_1_1
-    //else                                                             CC_LOG(CC_WARNING, "UNRECOGNIZED FOURCC %d", header->ddspf.fourcc);
-
-    /*CC_LOG(CC_INFO, "%s", fourcc_name);*/
-}
-
-VkFormat get_format(dds_header* header) {
-    if      (MAKEFOURCC('D', 'X', 'T', '1') == header->ddspf.fourcc) {
+// DX10 extended header, follows dds_header when the fourcc is "DX10"
+typedef struct {
+    uint32_t dxgi_format;
+    uint32_t resource_dimension;
+    uint32_t misc_flag;
+    uint32_t array_size;
+    uint32_t misc_flags2;
+} dds_header_dx10;
+
+#define DDS_PIXEL_FORMAT_FOURCC 0x04
+#define DDS_PIXEL_FORMAT_RGB    0x40
+#define DDS_CAPS2_CUBEMAP       0x200
+#define DDS_CAPS2_VOLUME        0x200000
+
+// where the pixels of a DDS file are, the file itself stays untouched
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t mips;
+    VkFormat format;
+    uint64_t data_offset;   // from the start of the file
+    uint64_t data_size;     // mip chain of the first face, tightly packed like TextureData::data
+} dds_info;
+
+inline VkFormat dds_get_format(const dds_header* header) {
+    uint32_t fourcc = header->ddspf.fourcc;
+    if      (MAKEFOURCC('D', 'X', 'T', '1') == fourcc) {
         return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('D', 'X', 'T', '3') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('D', 'X', 'T', '3') == fourcc) {
         return VK_FORMAT_BC2_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('D', 'X', 'T', '5') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('D', 'X', 'T', '5') == fourcc) {
         return VK_FORMAT_BC3_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('D', 'X', 'T', '2') == fourcc) {
         return VK_FORMAT_BC2_UNORM_BLOCK;     // While pre-multiplied alpha isn't directly supported by the VK formats,
     }
-    else if (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('D', 'X', 'T', '4') == fourcc) {
         return VK_FORMAT_BC3_UNORM_BLOCK;     // they are basically the same as these BC formats so they can be mapped
     }
-    else if (MAKEFOURCC('A', 'T', 'I', '1') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('A', 'T', 'I', '1') == fourcc) {
         return VK_FORMAT_BC4_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('B', 'C', '4', 'U') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('B', 'C', '4', 'U') == fourcc) {
         return VK_FORMAT_BC4_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('B', 'C', '4', 'S') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('B', 'C', '4', 'S') == fourcc) {
         return VK_FORMAT_BC4_SNORM_BLOCK;
     }
-    else if (MAKEFOURCC('A', 'T', 'I', '2') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('A', 'T', 'I', '2') == fourcc) {
         return VK_FORMAT_BC5_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('B', 'C', '5', 'U') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('B', 'C', '5', 'U') == fourcc) {
         return VK_FORMAT_BC5_UNORM_BLOCK;
     }
-    else if (MAKEFOURCC('B', 'C', '5', 'S') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('B', 'C', '5', 'S') == fourcc) {
         return VK_FORMAT_BC5_SNORM_BLOCK;
     }
-    else if (MAKEFOURCC('R', 'G', 'B', 'G') == header->ddspf.fourcc) {
-        return VK_FORMAT_G8B8G8R8_422_UNORM; // BC6H and BC7 are written using the "DX10"extended header
+    else if (MAKEFOURCC('R', 'G', 'B', 'G') == fourcc) {
+        return VK_FORMAT_G8B8G8R8_422_UNORM;
     }
-    else if (MAKEFOURCC('G', 'R', 'G', 'B') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('G', 'R', 'G', 'B') == fourcc) {
         return VK_FORMAT_B8G8R8G8_422_UNORM;
     }
-    else if (MAKEFOURCC('U', 'Y', 'V', 'Y') == header->ddspf.fourcc) {
-        return VK_FORMAT_G8B8G8R8_422_UNORM; //#if defined(VK_VERSION_1_1) && VK_VERSION_1_1
+    else if (MAKEFOURCC('U', 'Y', 'V', 'Y') == fourcc) {
+        return VK_FORMAT_G8B8G8R8_422_UNORM;
     }
-    else if (MAKEFOURCC('Y', 'U', 'Y', '2') == header->ddspf.fourcc) {
+    else if (MAKEFOURCC('Y', 'U', 'Y', '2') == fourcc) {
         return VK_FORMAT_B8G8R8G8_422_UNORM;
     }
-    else if (MAKEFOURCC('U', 'Y', 'V', 'Y') == header->ddspf.fourcc) {
-        return VK_FORMAT_G8B8G8R8_422_UNORM_KHR; //#elif defined(VK_KHR_sampler_ycbcr_conversion)
-    }
-    else if (MAKEFOURCC('Y', 'U', 'Y', '2') == header->ddspf.fourcc) {
-        return VK_FORMAT_G8B8G8R8_422_UNORM_KHR; //#endif // #if defined(VK_VERSION_1_1) && VK_VERSION_1_1
+    // uncompressed without fourcc, the masks give the channel order
+    else if (header->ddspf.flags & DDS_PIXEL_FORMAT_RGB && header->ddspf.rgb_bit_count == 32) {
+        return header->ddspf.r_bit_mask == 0x000000FF ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
     }
-    else CC_LOG(CC_WARNING, "UNRECOGNIZED FOURCC %d", header->ddspf.fourcc);
-}
 
-inline void *rl_load_dds_from_memory(const unsigned char *file_data, unsigned int file_size, int *width, int *height, int *format, int *mips, uint32_t *image_data_size)
-{
-    *image_data_size = 0;
-
-    void *image_data = nullptr;        // Image data pointer
-    int image_pixel_size = 0;       // Image pixel size
-
-    unsigned char *file_data_ptr = (unsigned char *)file_data;
+    CC_LOG(CC_WARNING, "UNRECOGNIZED FOURCC %d", fourcc);
+    return VK_FORMAT_UNDEFINED;
+}
 
-    int data_size = 0;
+// BC6H and BC7 are written using the "DX10" extended header
+inline VkFormat dds_get_format_dx10(const dds_header_dx10* header) {
+    switch (header->dxgi_format) {
+        case 2:  return VK_FORMAT_R32G32B32A32_SFLOAT;
+        case 10: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+        case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+        case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+        case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+        case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+        case 81: return VK_FORMAT_BC4_SNORM_BLOCK;
+        case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+        case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+        case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+        case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        case 96: return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+        case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+    }
 
-    if (file_data_ptr == nullptr)
-        return nullptr;
+    CC_LOG(CC_WARNING, "UNRECOGNIZED DXGI FORMAT %d", header->dxgi_format);
+    return VK_FORMAT_UNDEFINED;
+}
 
-    // Verify the type of file
-    unsigned char *dds_header_id = file_data_ptr;
-    file_data_ptr += 4;
+// bytes of a mip level, block formats are padded to whole 4x4 blocks. 0 for unsupported formats
+inline uint64_t dds_get_mip_size(VkFormat format, uint32_t width, uint32_t height) {
+    uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+    uint64_t pixels = (uint64_t)width * height;
+    switch (format) {
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return blocks * 8;
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return blocks * 16;
+        case VK_FORMAT_G8B8G8R8_422_UNORM:
+        case VK_FORMAT_B8G8R8G8_422_UNORM:
+            return (uint64_t)((width + 1) / 2) * height * 4;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB:
+            return pixels * 4;
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+            return pixels * 8;
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+            return pixels * 16;
+        default:
+            return 0;
+    }
+}
 
-    if ((dds_header_id[0] != 'D') || (dds_header_id[1] != 'D') || (dds_header_id[2] != 'S') || (dds_header_id[3] != ' '))
+// validates the headers and locates the mip chain of the first face, nothing is copied.
+// Cubemaps, arrays and volumes are not supported
+inline bool dds_parse(const unsigned char* file_data, uint64_t file_size, dds_info* out_info)
+{
+    uint64_t offset = 4 + sizeof(dds_header);
+    if (file_data == nullptr || file_size < offset || memcmp(file_data, "DDS ", 4) != 0)
     {
         CC_LOG(CC_WARNING, "IMAGE: DDS file data not valid");
-        return nullptr;
+        return false;
     }
 
-    dds_header *header = (dds_header *)file_data_ptr;
-
-    //fourcc_check(header);
-
-    auto header_size = sizeof(dds_header);
-    file_data_ptr += sizeof(dds_header);        // Skip header
-
-    *width = header->width;
-    *height = header->height;
-
-    image_pixel_size = header->width * header->height;
-
-    if (header->mipmap_count == 0)
-        *mips = 1;   // Parameter not used
-    else
-        *mips = header->mipmap_count;
-
-    *format = get_format(header);
-
-    //CC_LOG(CC_INFO, "%s", string_VkFormat((VkFormat)*format));
+    const dds_header* header = (const dds_header*)(file_data + 4);
+    if (header->caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME))
+    {
+        CC_LOG(CC_WARNING, "IMAGE: DDS cubemaps and volumes not supported");
+        return false;
+    }
+    // sizes are stored on 16 bits in TextureData
+    if (header->width == 0 || header->height == 0 || header->width > UINT16_MAX || header->height > UINT16_MAX)
+    {
+        CC_LOG(CC_WARNING, "IMAGE: DDS size %ux%u not supported", header->width, header->height);
+        return false;
+    }
 
-    if (header->ddspf.rgb_bit_count == 16 && header->ddspf.flags == 0x40)      // 16bit mode, no compressed
-        data_size = image_pixel_size*sizeof(unsigned short);
-    else if ((header->ddspf.flags == 0x40) && (header->ddspf.rgb_bit_count == 24))   // DDS_RGB, no compressed
-        data_size = image_pixel_size * 3 * sizeof(unsigned char);
-    else if (((header->ddspf.flags == 0x04) || (header->ddspf.flags == 0x05)) && (header->ddspf.fourcc > 0)) // Compressed
-        data_size = header->pitch_or_linear_size;
-    else if(header->ddspf.fourcc == MAKEFOURCC('A', 'T', 'I', '2')) // special case for 1x1 compressed normal maps from Bistro_5_2
-        data_size = header->pitch_or_linear_size;
+    VkFormat format;
+    if ((header->ddspf.flags & DDS_PIXEL_FORMAT_FOURCC) && header->ddspf.fourcc == MAKEFOURCC('D', 'X', '1', '0'))
+    {
+        if (file_size < offset + sizeof(dds_header_dx10))
+        {
+            CC_LOG(CC_WARNING, "IMAGE: DDS file data not valid");
+            return false;
+        }
+        const dds_header_dx10* header_dx10 = (const dds_header_dx10*)(file_data + offset);
+        if (header_dx10->array_size > 1)
+        {
+            CC_LOG(CC_WARNING, "IMAGE: DDS arrays not supported");
+            return false;
+        }
+        format = dds_get_format_dx10(header_dx10);
+        offset += sizeof(dds_header_dx10);
+    }
     else
-        CC_ASSERT(false, "DDS format not supported");
-
-    if (header->mipmap_count > 1)
-        data_size = data_size + data_size / 3;
-
-    // TMP
-    data_size = file_size - 4 - header_size;
+        format = dds_get_format(header);
+
+    if (format == VK_FORMAT_UNDEFINED)
+        return false;
+
+    // some exporters count more levels than they write, only the levels in the file are kept.
+    // Counts past the 1x1 level are clamped, so the chain has at most 16 levels (fits the 8 bit count)
+    uint32_t mips_full = 1;
+    for (uint32_t size = header->width > header->height ? header->width : header->height; size > 1; size >>= 1)
+        ++mips_full;
+    uint32_t mips_header = header->mipmap_count == 0 ? 1 : header->mipmap_count;
+    if (mips_header > mips_full)
+    {
+        CC_LOG(CC_WARNING, "IMAGE: DDS header counts %u mips, a %ux%u chain has %u", mips_header, header->width, header->height, mips_full);
+        mips_header = mips_full;
+    }
+    uint32_t mips = 0;
+    uint64_t data_size = 0;
+    for (; mips < mips_header; ++mips)
+    {
+        uint32_t mip_width  = header->width  >> mips > 0 ? header->width  >> mips : 1;
+        uint32_t mip_height = header->height >> mips > 0 ? header->height >> mips : 1;
+        uint64_t mip_size = dds_get_mip_size(format, mip_width, mip_height);
+        if (mip_size == 0)
+        {
+            CC_LOG(CC_WARNING, "IMAGE: DDS format %s not supported", string_VkFormat(format));
+            return false;
+        }
+        if (offset + data_size + mip_size > file_size)
+            break;
+        data_size += mip_size;
+    }
 
-    // TMP manually count mipmap?
-    image_data = malloc(data_size);
-    memcpy(image_data, file_data_ptr, data_size);
-    *image_data_size = data_size;
-    return image_data;
-}
\ No newline at end of file
+    if (mips == 0)
+    {
+        CC_LOG(CC_WARNING, "IMAGE: DDS file truncated");
+        return false;
+    }
+    if (mips < mips_header)
+        CC_LOG(CC_WARNING, "IMAGE: DDS file has %d of %d mips", mips, mips_header);
+
+    out_info->width       = header->width;
+    out_info->height      = header->height;
+    out_info->mips        = mips;
+    out_info->format      = format;
+    out_info->data_offset = offset;
+    out_info->data_size   = data_size;
+    return true;
+}
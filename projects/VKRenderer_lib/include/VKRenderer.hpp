@@ -17,6 +17,7 @@ extern "C" {
 }
 
 #include <utils/DearImGui.hpp>
+#include <utils/FileWatcher.hpp>
 
 #include <chrono>
 #include <memory>
@@ -38,7 +39,7 @@ class VKRenderer {
 
 public:
 	VKRenderer()
-		: m_surface{ 0 }
+		: m_surface{ 0 }, m_file_watcher{ nullptr }
 	{
 	};
 	~VKRenderer() {
@@ -51,6 +52,8 @@ public:
 
 		m_instance.reset();
 		m_window.reset();
+
+		vkc::utils::file_watcher_destroy(m_file_watcher);
 	}
 
 	void run();
@@ -69,13 +72,28 @@ protected:
 		void* uniform_data_model,
 		uint32_t uniform_data_model_size
 	);
+	// same as `drawcall_add`, with the LOD picked from the camera of the current ubo, and only the
+	// visible meshlets drawn. `transform` is the model matrix of the uniform data
+	void drawcall_add_culled(
+		vkc::Assets::IdAssetMesh id_mesh,
+		vkc::Assets::IdAssetMaterial id_material,
+		const glm::mat4& transform,
+		void* uniform_data_model,
+		uint32_t uniform_data_model_size
+	);
 	DataUniformFrame& get_ubo_reference() { return m_render_context->get_ubo_reference(); };
 
-	// upload ALL buffers to GPU, without checking if already done
+	// upload ALL buffers to GPU, without checking if already done. Textures only get their mip tail, see `stream_textures`
 	void TMP_force_gpu_upload_all();
 
 	void TMP_hot_reload();
 
+	// uploads the next texture mips within the per-frame budget, pipeline instances switch to the new views
+	void stream_textures();
+
+	// re-imports the assets whose source files changed and uploads only them, shader changes reload the pipelines
+	void hot_reload_changed_files();
+
 	// retrieve info
 	vkc::Rect2DI get_window_size() const { return m_window_size; };
 	int get_current_frame() const { return m_app_stats.curr_frame; };
@@ -100,6 +118,8 @@ private:
 
 	std::unique_ptr<vkc::utils::DearImGui> m_dear_imgui;
 
+	vkc::utils::FileWatcher* m_file_watcher;
+
 	VkSurfaceKHR m_surface;
 
 	AppConfig m_app_config;
@@ -2,10 +2,12 @@
 
 #include <cc_logger.h>
 #include <core/DrawCall.hpp>
+#include <JobPool.hpp>
 
 #include <imgui.h>
 
 #include <chrono>
+#include <map>
 
 void VKRenderer::run() {m_allocator = allocator_make_bump(KB(64));
 	m_profiler  = profiler_shared_create(m_allocator);
@@ -23,7 +25,10 @@ void VKRenderer::run() {m_allocator = allocator_make_bump(KB(64));
 			TMP_force_gpu_upload_all();
 		);
 	);
-	m_window->register_file_watcher();
+	// asset sources and shader binaries
+	m_file_watcher = vkc::utils::file_watcher_create();
+	if (m_file_watcher)
+		vkc::utils::file_watcher_add_directory(m_file_watcher, "res");
 
 	profiler_data_print(m_profiler);
 
@@ -57,13 +62,29 @@ void VKRenderer::run() {m_allocator = allocator_make_bump(KB(64));
 
 
 		m_window->collect_input();
-		
-		if(m_window->TMP_reload_shaders())
-			TMP_hot_reload();
+
+		vkc::Drawcall::destroy_retired_resources(m_render_context.get(), m_render_context->get_num_render_frames());
+		stream_textures();
+		hot_reload_changed_files();
 	}
 
 	// wait for queues to be done before cleanup
 	vkDeviceWaitIdle(m_device->get_handle());
+
+	vkc::Jobs::job_pool_shutdown();
+}
+
+// layers of the array slots, see `vkc::Assets::pack_texture_arrays`
+static DataUniformMaterialLayers get_material_layers(const vkc::Assets::MaterialData& material, const vkc::Pipeline* obj_pipeline) {
+	CC_ASSERT(
+		((obj_pipeline->get_obj_config()->flags & vkc::TEXTURE_ARRAYS) != 0) == vkc::Assets::material_uses_texture_arrays(material),
+		"material of pipeline config %u: FLAG_TEXTURE_ARRAYS doesn't match the TEXTURE_ARRAYS flag of the config",
+		material.id_pipeline_config
+	);
+	DataUniformMaterialLayers layers = { glm::uvec4(0) };
+	for (uint32_t slot = 0; slot < material.image_layers.size() && slot < vkc::Assets::MATERIAL_TEXTURE_ARRAY_SLOTS; ++slot)
+		layers.texture_layers[slot] = material.image_layers[slot];
+	return layers;
 }
 
 void VKRenderer::drawcall_add(
@@ -89,10 +110,41 @@ void VKRenderer::drawcall_add(
 		.idx_data_attributes     = id_mesh,
 		.data_uniform_model      = uniform_data_model,
 		.data_uniform_model_size = uniform_data_model_size,
-		.data_uniform_material   = (DataUniformMaterial*)material.uniform_data_material
+		.data_uniform_material   = (DataUniformMaterial*)material.uniform_data_material,
+		.data_material_layers    = get_material_layers(material, obj_pipeline)
 	});
 }
 
+void VKRenderer::drawcall_add_culled(
+	vkc::Assets::IdAssetMesh id_mesh,
+	vkc::Assets::IdAssetMaterial id_material,
+	const glm::mat4& transform,
+	void* uniform_data_model,
+	uint32_t uniform_data_model_size
+) {
+	vkc::Assets::MaterialData& material = vkc::Assets::get_material_data(id_material);
+
+	auto obj_renderpass = m_render_context->get_renderpass(material.id_render_pass);
+	auto obj_pipeline = obj_renderpass->get_pipeline_ptr(material.id_pipeline_config);
+	auto obj_pipeline_instance = obj_renderpass->get_pipeline_instance_ptr(material.id_pipeline);
+
+	vkc::Drawcall::add_drawcall_culled(
+		vkc::Drawcall::DrawcallData{
+			.obj_render_pass         = obj_renderpass,
+			.obj_pipeline            = obj_pipeline,
+			.obj_pipeline_instance   = obj_pipeline_instance,
+			.idx_data_attributes     = id_mesh,
+			.data_uniform_model      = uniform_data_model,
+			.data_uniform_model_size = uniform_data_model_size,
+			.data_uniform_material   = (DataUniformMaterial*)material.uniform_data_material,
+			.data_material_layers    = get_material_layers(material, obj_pipeline)
+		},
+		transform,
+		m_render_context->get_ubo_reference(),
+		(float)m_window_size.height
+	);
+}
+
 void VKRenderer::TMP_force_gpu_upload_all() {
 	// =========================================================
 	// Models
@@ -101,17 +153,20 @@ void VKRenderer::TMP_force_gpu_upload_all() {
 	vkc::Drawcall::createModelBuffers(vkc::Assets::BuiltinPrimitives::IDX_DEBUG_RAY,      m_device->get_handle(), m_render_context.get());
 	vkc::Drawcall::createModelBuffers(vkc::Assets::BuiltinPrimitives::IDX_FULLSCREEN_TRI, m_device->get_handle(), m_render_context.get());
 	vkc::Drawcall::createModelBuffers(vkc::Assets::BuiltinPrimitives::IDX_QUAD,           m_device->get_handle(), m_render_context.get());
-	for (int i = 0; i < vkc::Assets::get_num_mesh_assets(); ++i)
-		vkc::Drawcall::createModelBuffers(i, m_device->get_handle(), m_render_context.get());
+	for (vkc::Assets::IdAssetMesh id : vkc::Assets::get_mesh_assets().ids)
+		vkc::Drawcall::createModelBuffers(id, m_device->get_handle(), m_render_context.get());
 
 	// =========================================================
 	// Textures
 	// =========================================================
+	// small textures of the PBR materials share arrays, no-op for the ones baked in an asset db
+	vkc::Assets::pack_texture_arrays();
+
 	vkc::Drawcall::createTextureImage(vkc::Assets::BuiltinPrimitives::IDX_TEX_WHITE,     m_device->get_handle(), m_render_context.get());
 	vkc::Drawcall::createTextureImage(vkc::Assets::BuiltinPrimitives::IDX_TEX_BLACK,     m_device->get_handle(), m_render_context.get());
 	vkc::Drawcall::createTextureImage(vkc::Assets::BuiltinPrimitives::IDX_TEX_BLUE_NORM, m_device->get_handle(), m_render_context.get());
-	for (int i = 0; i < vkc::Assets::get_num_texture_assets(); ++i)
-		vkc::Drawcall::createTextureImage(i, m_device->get_handle(), m_render_context.get());
+	for (vkc::Assets::IdAssetTexture id : vkc::Assets::get_texture_assets().ids)
+		vkc::Drawcall::createTextureImage(id, m_device->get_handle(), m_render_context.get());
 
 	// =========================================================
 	// Pipelines (materials)
@@ -125,8 +180,16 @@ void VKRenderer::TMP_force_gpu_upload_all() {
 	// =========================================================
 	// Pipeline Instances (material instance)
 	// =========================================================
-	for (int i = 0; i < vkc::Assets::get_num_material_assets(); ++i) {
-		auto& material_data = vkc::Assets::get_material_data(i);
+	// materials with the same config and textures (layers excluded, they are pushed per drawcall) share
+	// an instance, unless they have their own uniform data
+	std::map<std::pair<uint32_t, std::vector<vkc::Assets::IdAssetTexture>>, uint32_t> shared_instances;
+	for (vkc::Assets::MaterialData& material_data : vkc::Assets::get_material_assets().data) {
+		auto key = std::make_pair(material_data.id_pipeline_config, material_data.image_views);
+		auto it = shared_instances.find(key);
+		if (material_data.uniform_data_material == nullptr && it != shared_instances.end()) {
+			material_data.id_pipeline = it->second;
+			continue;
+		}
 
 		std::vector<VkImageView> image_views(material_data.image_views.size());
 		for(int j = 0; j < image_views.size(); ++j)
@@ -136,6 +199,8 @@ void VKRenderer::TMP_force_gpu_upload_all() {
 			material_data.id_pipeline_config,
 			image_views
 		);
+		if (material_data.uniform_data_material == nullptr)
+			shared_instances[key] = material_data.id_pipeline;
 	}
 }
 
@@ -158,6 +223,71 @@ void VKRenderer::TMP_hot_reload() {
 	}
 }
 
+void VKRenderer::stream_textures() {
+	std::vector<vkc::Drawcall::TextureViewChange> changes;
+	vkc::Drawcall::stream_textures(
+		vkc::Drawcall::TEXTURE_STREAMING_BUDGET_BYTES,
+		m_device->get_handle(),
+		m_render_context.get(),
+		&changes
+	);
+
+	if (changes.empty())
+		return;
+
+	// only on the frames an upload completes: descriptor sets can't be updated while a frame in flight uses them
+	m_render_context->wait_all_frames_idle();
+
+	vkc::RenderPass* rp = m_render_context->get_renderpass(0);
+	for (const vkc::Drawcall::TextureViewChange& change : changes)
+		for (uint32_t i = 0; i < rp->get_pipeline_instance_count(); ++i)
+			rp->get_pipeline_instance_ptr(i)->replace_image_view(change.old_view, change.new_view);
+}
+
+void VKRenderer::hot_reload_changed_files() {
+	if (!m_file_watcher)
+		return;
+
+	std::vector<std::string> paths;
+	vkc::utils::file_watcher_poll(m_file_watcher, &paths);
+	if (paths.empty())
+		return;
+
+	// the texture loader thread reads from the asset data
+	vkc::Drawcall::wait_texture_streaming_idle();
+
+	bool is_shader_changed = false;
+	vkc::Assets::ReloadedAssets reloaded;
+	for (const std::string& path : paths) {
+		if (path.starts_with("res/shaders/"))
+			is_shader_changed = true;
+		else
+			vkc::Assets::asset_reload_file(path.c_str(), &reloaded);
+	}
+
+	// frames in flight keep drawing with the old buffers, retired until they are done
+	for (vkc::Assets::IdAssetMesh id : reloaded.meshes)
+		vkc::Drawcall::reloadModelBuffers(id, m_device->get_handle(), m_render_context.get());
+
+	// descriptor sets can't be updated while a frame in flight uses them
+	if (!reloaded.textures.empty()) {
+		m_render_context->wait_all_frames_idle();
+
+		vkc::RenderPass* rp = m_render_context->get_renderpass(0);
+		for (vkc::Assets::IdAssetTexture id : reloaded.textures) {
+			VkImageView old_view = vkc::Drawcall::get_texture_image_view(id);
+			vkc::Drawcall::reloadTextureImage(id, m_device->get_handle(), m_render_context.get());
+			VkImageView new_view = vkc::Drawcall::get_texture_image_view(id);
+
+			for (uint32_t i = 0; i < rp->get_pipeline_instance_count(); ++i)
+				rp->get_pipeline_instance_ptr(i)->replace_image_view(old_view, new_view);
+		}
+	}
+
+	if (is_shader_changed)
+		TMP_hot_reload();
+}
+
 void VKRenderer::init_base()
 {
 	const char* title = "TMP";
@@ -198,6 +328,8 @@ void VKRenderer::init_base()
 		m_render_context->get_num_render_frames()
 	);
 
+	// asset db chunks, texture/mesh imports and transform updates are split across workers
+	vkc::Jobs::job_pool_init();
 	vkc::Assets::asset_manager_init();
 
 	// init app data
@@ -227,5 +359,18 @@ void VKRenderer::gui_base() {
 	ImGui::Begin("App Info");
 	ImGui::LabelText("FPS", "%3.0f", smoothed_fps / AppStats::FPS_SMOOTH_WINDOW_SIZE);
 	ImGui::LabelText("Delta", "%3.4f", m_app_stats.delta_time);
+
+	vkc::Drawcall::CullStats cull_stats = vkc::Drawcall::get_cull_stats();
+	ImGui::LabelText("Meshes culled", "%d", cull_stats.meshes_frustum_culled);
+	ImGui::LabelText("Meshes LOD > 0", "%d", cull_stats.meshes_lod);
+	ImGui::LabelText("Meshlets", "%d", cull_stats.meshlets_total);
+	ImGui::LabelText("Culled (frustum)", "%d", cull_stats.meshlets_frustum_culled);
+	ImGui::LabelText("Culled (backface)", "%d", cull_stats.meshlets_backface_culled);
+	ImGui::LabelText("Meshlet drawcalls", "%d", cull_stats.drawcalls);
+
+	vkc::MemoryStats memory_stats = m_render_context->get_memory_stats();
+	ImGui::LabelText("GPU allocations", "%d (%d resources)", memory_stats.device_allocations, memory_stats.allocations);
+	ImGui::LabelText("GPU memory (MB)", "%.1f / %.1f", memory_stats.used / (1024.0 * 1024.0), memory_stats.reserved / (1024.0 * 1024.0));
+	ImGui::LabelText("GPU fragmentation", "%.1f%%", memory_stats.fragmentation * 100.0f);
 	ImGui::End();
 }
\ No newline at end of file
@@ -171,10 +171,8 @@ namespace vkc {
 		vkDestroyPipeline(m_handle_device, m_handle, NULL);
 		vkDestroyDescriptorSetLayout(m_handle_device, m_handle_descriptor_set_layout, NULL);
 		vkDestroyDescriptorPool(m_handle_device, m_descriptor_pool, NULL);
-		for (auto& handle : m_uniform_buffers)
-			vkDestroyBuffer(m_handle_device, handle, NULL);
-		for (auto& handle : m_uniform_buffers_memory)
-			vkFreeMemory(m_handle_device, handle, NULL);
+		for (size_t i = 0; i < m_uniform_buffers.size(); ++i)
+			m_obj_render_context->destroy_buffer(m_uniform_buffers[i], m_uniform_buffers_memory[i]);
 
 
 		// FIXME cleanup config (see below)
@@ -299,7 +297,7 @@ namespace vkc {
 					&m_uniform_buffers[i],
 					&m_uniform_buffers_memory[i]
 				);
-				vkMapMemory(m_handle_device, m_uniform_buffers_memory[i], 0, bufferSize, 0, &m_uniform_buffers_mapped[i]);
+				m_uniform_buffers_mapped[i] = m_uniform_buffers_memory[i].mapped;
 			}
 		}
 	}
@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <core/VertexData.h>
+#include <core/MemoryAllocator.hpp>
 #include <vector>
 
 
@@ -61,7 +62,7 @@ namespace vkc {
 
 		// frame data
 		std::vector<VkBuffer>			m_uniform_buffers;
-		std::vector<VkDeviceMemory>		m_uniform_buffers_memory;
+		std::vector<MemoryAllocation>	m_uniform_buffers_memory;
 		std::vector<void*>				m_uniform_buffers_mapped;
 	};
 }
\ No newline at end of file
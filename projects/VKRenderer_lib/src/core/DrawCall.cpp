@@ -6,24 +6,208 @@
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/transform.hpp>
 
-#include <vector>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace vkc::Drawcall {
     std::map<uint32_t, ModelDataGPU> model_data_gpu;
+    GeometryBuffer vertex_geometry = {
+        .usage      = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        .block_size = GEOMETRY_VERTEX_BLOCK_SIZE,
+        .debug_name = "geometry vertex block"
+    };
+    GeometryBuffer index_geometry = {
+        .usage      = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        .block_size = GEOMETRY_INDEX_BLOCK_SIZE,
+        .debug_name = "geometry index block"
+    };
     std::map<uint32_t, TextureDataGPU> texture_data_gpu;
+
+    // replaced by a hot reload, waiting for the frames in flight to be done with them
+    struct RetiredResources {
+        bool           is_texture;
+        ModelDataGPU   model;
+        TextureDataGPU texture;
+        uint32_t       frames_waited;
+    };
+    std::vector<RetiredResources> retired_resources;
+
+    // mip streaming: the loader thread copies levels from the asset data (a mapped asset db faults
+    // them in from disk, DDS files are mapped for the copy) into staging buffers, the main thread uploads them
+    struct TextureStreamState {
+        Assets::IdAssetTexture id;
+        uint32_t resident_mip;  // first level on the GPU, the view starts there
+        bool     is_loading;    // level `resident_mip - 1` is in a MipLoadRequest, until its upload is done
+    };
+
+    struct MipLoadRequest {
+        Assets::IdAssetTexture id;
+        uint32_t               mip;
+        Assets::TextureData    texture;    // read by the loader thread, the storage may move meanwhile
+        VkDeviceSize           offset;     // of the level in `texture.data`
+        VkDeviceSize           size;
+        VkBuffer               staging_buffer;
+        MemoryAllocation       staging_buffer_memory;  // host visible, written through `mapped`
+    };
+
+    // levels copied by one submission of `stream_textures`, running alongside the frames.
+    // Views move to the new levels once `fence` signals
+    struct MipUploadBatch {
+        VkCommandBuffer             command_buffer;
+        VkFence                     fence;
+        std::vector<MipLoadRequest> uploads;
+    };
+
+    std::vector<TextureStreamState> streaming_textures;
+    std::vector<MipUploadBatch>     upload_batches;
+    VkDeviceSize streaming_bytes_in_flight = 0;
+
+    std::thread                 loader_thread;
+    std::mutex                  loader_mutex;
+    std::condition_variable     loader_cv;          // requests queued, or quit
+    std::condition_variable     loader_idle_cv;     // `loader_pending` dropped to 0
+    std::deque<MipLoadRequest>  load_queue;
+    std::vector<MipLoadRequest> loaded;             // read, waiting for `stream_textures` to upload them
+    uint32_t                    loader_pending = 0; // queued or being read
+    bool                        loader_quit = false;
     std::vector<DrawcallData> drawcalls;
+    CullStats cull_stats;
 
     void add_drawcall(DrawcallData data) {
         drawcalls.push_back(data);
     }
 
+    void add_drawcall_culled(DrawcallData data, const glm::mat4& transform, const DataUniformFrame& data_frame, float viewport_height) {
+        const Assets::MeshData& mesh_data = Assets::get_mesh_data(data.idx_data_attributes);
+        if (mesh_data.meshlet_count == 0 && mesh_data.lod_count == 0) {
+            add_drawcall(data);
+            return;
+        }
+
+        // world space frustum planes (Gribb-Hartmann), xyz points inside
+        glm::mat4 view_proj = glm::transpose(data_frame.proj * data_frame.view);
+        glm::vec4 planes[6] = {
+            view_proj[3] + view_proj[0],
+            view_proj[3] - view_proj[0],
+            view_proj[3] + view_proj[1],
+            view_proj[3] - view_proj[1],
+            view_proj[3] + view_proj[2],
+            view_proj[3] - view_proj[2],
+        };
+        for (glm::vec4& plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+
+        auto is_sphere_visible = [&planes](glm::vec3 center, float radius) {
+            for (const glm::vec4& plane : planes)
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                    return false;
+            return true;
+        };
+
+        // spheres scale with the largest axis
+        glm::vec3 scale = glm::vec3(
+            glm::length(glm::vec3(transform[0])),
+            glm::length(glm::vec3(transform[1])),
+            glm::length(glm::vec3(transform[2]))
+        );
+        float scale_max = glm::max(scale.x, glm::max(scale.y, scale.z));
+        float scale_min = glm::min(scale.x, glm::min(scale.y, scale.z));
+
+        // whole mesh
+        glm::vec3 mesh_center = glm::vec3(transform * glm::vec4(mesh_data.bounds_center, 1.0f));
+        float     mesh_radius = mesh_data.bounds_radius * scale_max;
+        if (!is_sphere_visible(mesh_center, mesh_radius)) {
+            ++cull_stats.meshes_frustum_culled;
+            return;
+        }
+
+        // coarsest LOD with an error below LOD_MAX_ERROR_PIXELS on screen, from the closest point of the bounds.
+        // proj[1][1] is 1 / tan(fov_y / 2), flipped for Vulkan
+        uint32_t lod = 0;
+        float distance = glm::length(mesh_center - data_frame.cam_pos) - mesh_radius;
+        if (distance > 0.0f) {
+            float pixels_per_unit = fabsf(data_frame.proj[1][1]) * viewport_height * 0.5f / distance;
+            for (uint32_t i = mesh_data.lod_count; i-- > 1;) {
+                if (mesh_data.lods[i].error * scale_max * pixels_per_unit <= LOD_MAX_ERROR_PIXELS) {
+                    lod = i;
+                    break;
+                }
+            }
+        }
+
+        // meshlets only cover LOD 0
+        if (lod > 0 || mesh_data.meshlet_count == 0) {
+            if (lod > 0) {
+                data.first_index = mesh_data.lods[lod].first_index;
+                data.index_count = mesh_data.lods[lod].index_count;
+                ++cull_stats.meshes_lod;
+            }
+            add_drawcall(data);
+            ++cull_stats.drawcalls;
+            return;
+        }
+
+        // cones only survive rotations and uniform scales. Mirroring flips the winding
+        bool is_backface_culled =
+            (data.obj_pipeline->get_obj_config()->face_culling_mode == VK_CULL_MODE_BACK_BIT) &&
+            scale_max - scale_min <= scale_max * 0.01f &&
+            glm::determinant(glm::mat3(transform)) > 0.0f;
+        glm::mat3 rotation = glm::mat3(transform) / scale_max;
+
+        uint32_t run_first = 0;
+        uint32_t run_count = 0;
+        for (uint32_t i = 0; i < mesh_data.meshlet_count; ++i) {
+            const Assets::MeshletData& meshlet = mesh_data.meshlets[i];
+            glm::vec3 center = glm::vec3(transform * glm::vec4(meshlet.center, 1.0f));
+            float     radius = meshlet.radius * scale_max;
+
+            bool is_visible = is_sphere_visible(center, radius);
+            if (!is_visible)
+                ++cull_stats.meshlets_frustum_culled;
+
+            if (is_visible && is_backface_culled) {
+                glm::vec3 to_center = center - data_frame.cam_pos;
+                glm::vec3 cone_axis = rotation * meshlet.cone_axis;
+                if (glm::dot(to_center, cone_axis) >= meshlet.cone_cutoff * glm::length(to_center) + radius) {
+                    is_visible = false;
+                    ++cull_stats.meshlets_backface_culled;
+                }
+            }
+
+            if (is_visible) {
+                if (run_count == 0)
+                    run_first = meshlet.first_index;
+                run_count += meshlet.index_count;
+            }
+
+            // meshlets are contiguous, a run only ends on a culled meshlet or at the end
+            if ((!is_visible || i == mesh_data.meshlet_count - 1) && run_count > 0) {
+                data.first_index = run_first;
+                data.index_count = run_count;
+                add_drawcall(data);
+                ++cull_stats.drawcalls;
+                run_count = 0;
+            }
+        }
+        cull_stats.meshlets_total += mesh_data.meshlet_count;
+    }
+
+    CullStats get_cull_stats() {
+        return cull_stats;
+    }
+
     const std::vector<DrawcallData>& get_drawcalls() {
         return drawcalls;
     }
 
     void clear_drawcalls() {
         drawcalls.clear();
+        cull_stats = { };
     }
 
     VkImageView get_texture_image_view(uint32_t id) {
@@ -34,22 +218,72 @@ namespace vkc::Drawcall {
         return model_data_gpu[index];
     }
 
+    static void loader_main() {
+        std::unique_lock<std::mutex> lock(loader_mutex);
+        while (true) {
+            loader_cv.wait(lock, [] { return loader_quit || !load_queue.empty(); });
+            if (loader_quit)
+                return;
+
+            MipLoadRequest request = load_queue.front();
+            load_queue.pop_front();
+
+            lock.unlock();
+            Assets::texture_read_pixels(request.texture, request.offset, request.size, request.staging_buffer_memory.mapped);
+            lock.lock();
+
+            loaded.push_back(request);
+            if (--loader_pending == 0)
+                loader_idle_cv.notify_all();
+        }
+    }
+
+    static uint32_t get_mip_extent(uint32_t extent, uint32_t mip) {
+        return glm::max(extent >> mip, 1u);
+    }
+
+    // offset of `mip` in TextureData::data
+    static VkDeviceSize get_mip_offset(const Assets::TextureData& texture_data, uint32_t mip) {
+        VkDeviceSize offset = 0;
+        for (uint32_t i = 0; i < mip; ++i)
+            offset += get_mip_level_size(texture_data.format, get_mip_extent(texture_data.width, i), get_mip_extent(texture_data.height, i));
+        return offset * Assets::tex_get_layer_count(texture_data);
+    }
+
+    // first level fitting in TEXTURE_MIP_TAIL_SIZE, the last level for larger textures without a full chain
+    static uint32_t get_mip_tail_start(const Assets::TextureData& texture_data) {
+        uint32_t mip = 0;
+        while (mip + 1 < texture_data.mipmaps &&
+              (get_mip_extent(texture_data.width, mip) > TEXTURE_MIP_TAIL_SIZE || get_mip_extent(texture_data.height, mip) > TEXTURE_MIP_TAIL_SIZE))
+            ++mip;
+        return mip;
+    }
+
+    static void destroy_staging_buffer(vkc::RenderContext* obj_render_context, const MipLoadRequest& request) {
+        obj_render_context->destroy_buffer(request.staging_buffer, request.staging_buffer_memory);
+    }
+
     // only one texture for now
     void createTextureImage(Assets::IdAssetTexture texture_id, VkDevice device, vkc::RenderContext* obj_render_context) {
         const Assets::TextureData& texture_data = Assets::get_texture_data(texture_id);
-
-        // TODO FIXME clean up texture creation pipeline
-        if (texture_data.viewType == VK_IMAGE_VIEW_TYPE_CUBE)
-        {
-            createTextureCubemap(texture_id, device, obj_render_context);
-            return;
-        }
         TextureDataGPU new_gpu_data = { 0 };
+        // the copy regions and the streamed levels are located with the same sizes
+        CC_ASSERT(
+            get_mip_offset(texture_data, texture_data.mipmaps) == texture_data.data.size(),
+            "texture %u: %llu bytes of pixels, its mip chain is %llu",
+            texture_id, (unsigned long long)texture_data.data.size(), (unsigned long long)get_mip_offset(texture_data, texture_data.mipmaps)
+        );
 
-        VkDeviceSize imageSize = texture_data.data.size();
+        // mip tail only, the higher levels are streamed. Cubemaps and arrays of more than one layer are
+        // uploaded whole, their levels are already laid out as the copy regions expect (see AssetManager.hpp)
+        uint32_t layers = Assets::tex_get_layer_count(texture_data);
+        uint32_t first_mip = layers == 1 ? get_mip_tail_start(texture_data) : 0;
+        uint32_t mip_levels = texture_data.mipmaps - first_mip;
+        VkDeviceSize offset = get_mip_offset(texture_data, first_mip);
+        VkDeviceSize imageSize = texture_data.data.size() - offset;
 
         VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
+        MemoryAllocation stagingBufferMemory;
         obj_render_context->createBuffer(
             imageSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
@@ -58,10 +292,7 @@ namespace vkc::Drawcall {
             &stagingBufferMemory
         );
 
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-        memcpy(data, texture_data.data.data(), imageSize);
-        vkUnmapMemory(device, stagingBufferMemory);
+        Assets::texture_read_pixels(texture_data, offset, imageSize, stagingBufferMemory.mapped);
 
         // // no free, we can't fit all our scene in GPU memory at the same time
         //res_tex_free(textureId);
@@ -69,7 +300,7 @@ namespace vkc::Drawcall {
         obj_render_context->create_image(
             texture_data.width,
             texture_data.height,
-            texture_data.viewType == VK_IMAGE_VIEW_TYPE_CUBE ? 6 : 1,
+            layers,
             texture_data.mipmaps,
             static_cast<VkFormat>(texture_data.format),
             VK_IMAGE_TILING_OPTIMAL,
@@ -81,365 +312,362 @@ namespace vkc::Drawcall {
 
         obj_render_context->transition_image_layout(
             new_gpu_data.image,
-            1,
-            texture_data.mipmaps,
+            layers,
+            mip_levels,
             static_cast<VkFormat>(texture_data.format),
             VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            first_mip
         );
 
         obj_render_context->copy_buffer_to_image(
             stagingBuffer,
             new_gpu_data.image,
-            texture_data
+            texture_data,
+            first_mip
         );
 
         obj_render_context->transition_image_layout(
             new_gpu_data.image,
-            1,
-            texture_data.mipmaps,
+            layers,
+            mip_levels,
             static_cast<VkFormat>(texture_data.format),
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            first_mip
         );
 
-        vkDestroyBuffer(device, stagingBuffer, NULL);
-        vkFreeMemory(device, stagingBufferMemory, NULL);
+        obj_render_context->destroy_buffer(stagingBuffer, stagingBufferMemory);
 
-        // view
+        // view, resident levels only
         new_gpu_data.image_view = obj_render_context->create_imge_view(
             new_gpu_data.image,
             static_cast<VkFormat>(texture_data.format),
             VK_IMAGE_ASPECT_COLOR_BIT,
             static_cast<VkImageViewType>(texture_data.viewType),
-            texture_data.mipmaps
+            mip_levels,
+            first_mip
         );
 
         texture_data_gpu[texture_id] = new_gpu_data;
+
+        if (first_mip > 0) {
+            streaming_textures.push_back({ .id = texture_id, .resident_mip = first_mip, .is_loading = false });
+            if (!loader_thread.joinable())
+                loader_thread = std::thread(loader_main);
+        }
     }
 
-    void createTextureCubemap(Assets::IdAssetTexture texture_id, VkDevice device, vkc::RenderContext* obj_render_context) {
-        const uint32_t NUM_FACES_TOT = 6;
-        const uint32_t NUM_FACES_ROW = 3;
-        const uint32_t NUM_FACES_COL = 4;
-        const uint32_t SIZE_PIXEL = 4;
-        /*
-        const uint8_t  IDX_FACE_X[] = { 0, 2, 1, 1, 3, 1 };
-        const uint8_t  IDX_FACE_Y[] = { 1, 1, 2, 0, 1, 1 };*/
-        //                shoudl be   : L  R  D  U, B
-        //                cubemap side: R  L  U  D, F
-        const uint8_t  IDX_FACE_X[] = { 2, 0, 1, 1, 1, 3 };
-        const uint8_t  IDX_FACE_Y[] = { 1, 1, 0, 2, 1, 1 };
+    void updateModelVertexBuffer(
+        uint32_t model_index,
+        void* vertex_buffer_content,
+        uint32_t vertex_buffer_size,
+        VkDevice device,
+        vkc::RenderContext* obj_render_context
+    ) {
+        const ModelDataGPU& model_data_gpu_ref = model_data_gpu[model_index];
+        geometry_buffer_upload(vertex_geometry, model_data_gpu_ref.vertices, vertex_buffer_content, vertex_buffer_size, obj_render_context);
+    }
 
+    uint32_t createModelBuffers(uint32_t model_index, VkDevice device, vkc::RenderContext* obj_render_context) {
+        Assets::MeshData& mesh_data = Assets::get_mesh_data(model_index);
 
-        const Assets::TextureData& texture_data = Assets::get_texture_data(texture_id);
-        
-        TextureDataGPU new_gpu_data = { 0 };
+        assert(mesh_data.vertex_count > 0);
 
-        uint32_t pixel_count_row   = texture_data.width;
-        uint32_t pixel_count_layer = pixel_count_row * pixel_count_row;
-        uint64_t stride = pixel_count_row * NUM_FACES_COL * SIZE_PIXEL;
-        VkDeviceSize size_row   = pixel_count_row   * SIZE_PIXEL;
-        VkDeviceSize size_layer = pixel_count_layer * SIZE_PIXEL;
-        VkDeviceSize size_image = size_layer * NUM_FACES_TOT;
-        VkDeviceSize size_source_image = texture_data.width * NUM_FACES_COL * texture_data.height * NUM_FACES_ROW * SIZE_PIXEL;
+        model_data_gpu[model_index] = ModelDataGPU();
+        ModelDataGPU& model_data_gpu_ref = model_data_gpu[model_index];
 
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        obj_render_context->createBuffer(
-            size_image,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            &stagingBuffer,
-            &stagingBufferMemory
-        );
+        if (mesh_data.flags & Assets::MeshData::FLAG_COMPACT) {
+            model_data_gpu_ref.quantization = {
+                .position_offset = glm::vec4(mesh_data.position_offset, 0.0f),
+                .position_scale  = glm::vec4(mesh_data.position_scale,  0.0f)
+            };
+        }
 
-        int TMP_C = 0;
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, size_image, 0, &data);
-        unsigned char* dst = (unsigned char*)data;
-        const unsigned char* src = texture_data.data.data();
-        for(int i = 0; i < NUM_FACES_TOT; ++i)
+        // vertices ============================================================
         {
-            VkDeviceSize dst_offset = size_layer * i;
-            VkDeviceSize src_offset = IDX_FACE_Y[i] * stride * pixel_count_row + IDX_FACE_X[i] * pixel_count_row * SIZE_PIXEL;
+            // aligned to the stride, the draw addresses the first vertex with `vertexOffset`
+            VkDeviceSize bufferSize = (VkDeviceSize)mesh_data.vertex_count * mesh_data.vertex_data_size;
+            model_data_gpu_ref.vertices = geometry_buffer_alloc(&vertex_geometry, bufferSize, mesh_data.vertex_data_size, obj_render_context);
+            model_data_gpu_ref.vertex_buffer = geometry_buffer_get_handle(vertex_geometry, model_data_gpu_ref.vertices);
+            model_data_gpu_ref.vertex_offset = (int32_t)(model_data_gpu_ref.vertices.offset / mesh_data.vertex_data_size);
 
-            for(int j = 0; j < pixel_count_row; ++j)
-            {
-                assert(src_offset + size_row <= size_source_image);
-                assert(dst_offset + size_row <= size_image);
-                TMP_C++;
-                memcpy(dst + dst_offset, src + src_offset, size_row);
-                dst_offset += size_row;
-                src_offset += stride;
-            }
+            geometry_buffer_upload(vertex_geometry, model_data_gpu_ref.vertices, mesh_data.vertex_data, bufferSize, obj_render_context);
         }
-        vkUnmapMemory(device, stagingBufferMemory);
-        
 
-        // // no free, we can't fit all our scene in GPU memory at the same time
-        //res_tex_free(textureId);
+        // indices  ============================================================
+        {
+            // LODs follow LOD 0 in the same allocation
+            model_data_gpu_ref.indices_count = Assets::mesh_get_base_index_count(mesh_data);
+            model_data_gpu_ref.index_type = (mesh_data.flags & Assets::MeshData::FLAG_INDICES_16)
+                ? VK_INDEX_TYPE_UINT16
+                : VK_INDEX_TYPE_UINT32;
+            // TODO FIXME this won't work if we don't use indices.
+            uint32_t index_size = Assets::mesh_get_index_size(mesh_data);
+            VkDeviceSize bufferSize = (VkDeviceSize)mesh_data.index_count * index_size;
+            model_data_gpu_ref.indices = geometry_buffer_alloc(&index_geometry, bufferSize, GEOMETRY_INDEX_ALIGNMENT, obj_render_context);
+            model_data_gpu_ref.index_buffer = geometry_buffer_get_handle(index_geometry, model_data_gpu_ref.indices);
+            model_data_gpu_ref.first_index  = (uint32_t)(model_data_gpu_ref.indices.offset / index_size);
 
-        obj_render_context->create_image(
-            texture_data.width,
-            texture_data.height,
-            texture_data.viewType == VK_IMAGE_VIEW_TYPE_CUBE ? 6 : 1,
-            texture_data.mipmaps,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            &new_gpu_data.image,
-            &new_gpu_data.image_memory
-        );
+            geometry_buffer_upload(index_geometry, model_data_gpu_ref.indices, mesh_data.index_data, bufferSize, obj_render_context);
+        }
 
-        obj_render_context->transition_image_layout(
-            new_gpu_data.image,
-            6,
-            texture_data.mipmaps,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-        );
+        return model_index;
+    }
 
-        obj_render_context->copy_buffer_to_image(
-            stagingBuffer,
-            new_gpu_data.image,
-            texture_data
-        );
+    static void destroy_model_data_gpu(const ModelDataGPU& data) {
+        geometry_buffer_free(&vertex_geometry, data.vertices);
+        geometry_buffer_free(&index_geometry,  data.indices);
+    }
 
-        obj_render_context->transition_image_layout(
-            new_gpu_data.image,
-            6,
-            texture_data.mipmaps,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        );
+    static void destroy_texture_data_gpu(vkc::RenderContext* obj_render_context, const TextureDataGPU& data) {
+        vkDestroyImageView(obj_render_context->get_device(), data.image_view, NULL);
+        obj_render_context->destroy_image(data.image, data.image_memory);
+    }
 
-        vkDestroyBuffer(device, stagingBuffer, NULL);
-        vkFreeMemory(device, stagingBufferMemory, NULL);
+    void reloadModelBuffers(Assets::IdAssetMesh mesh_id, VkDevice device, vkc::RenderContext* obj_render_context) {
+        auto it = model_data_gpu.find(mesh_id);
+        if (it != model_data_gpu.end())
+            retired_resources.push_back({ .is_texture = false, .model = it->second });
 
-        // view
-        new_gpu_data.image_view = obj_render_context->create_imge_view(
-            new_gpu_data.image,
-            VK_FORMAT_R8G8B8A8_SRGB,
-            VK_IMAGE_ASPECT_COLOR_BIT,
-            static_cast<VkImageViewType>(texture_data.viewType),
-            texture_data.mipmaps
-        );
+        createModelBuffers(mesh_id, device, obj_render_context);
+    }
 
-        texture_data_gpu[texture_id] = new_gpu_data;
+    static void destroy_upload_batch(vkc::RenderContext* obj_render_context, const MipUploadBatch& batch) {
+        vkDestroyFence(obj_render_context->get_device(), batch.fence, NULL);
+        obj_render_context->free_single_time_commands(batch.command_buffer);
     }
 
-    void updateModelVertexBuffer(
-        uint32_t model_index,
-        void* vertex_buffer_content,
-        uint32_t vertex_buffer_size,
-        VkDevice device,
-        vkc::RenderContext* obj_render_context
-    ) {
-        ModelDataGPU& model_data_gpu_ref = model_data_gpu[model_index];
+    // drops the levels of `texture_id` read or being uploaded, the texture is not streamed anymore
+    static void cancel_texture_streaming(Assets::IdAssetTexture texture_id, vkc::RenderContext* obj_render_context) {
+        wait_texture_streaming_idle();
+
+        // the copies into the image must be done before it's retired
+        for (MipUploadBatch& batch : upload_batches) {
+            if (std::none_of(batch.uploads.begin(), batch.uploads.end(), [texture_id](const MipLoadRequest& request) { return request.id == texture_id; }))
+                continue;
+
+            CC_VK_CHECK(vkWaitForFences(obj_render_context->get_device(), 1, &batch.fence, VK_TRUE, UINT64_MAX));
+            std::erase_if(batch.uploads, [texture_id, obj_render_context](const MipLoadRequest& request) {
+                if (request.id != texture_id)
+                    return false;
+                destroy_staging_buffer(obj_render_context, request);
+                streaming_bytes_in_flight -= request.size;
+                return true;
+            });
+        }
 
-        {
-            VkDeviceSize bufferSize = vertex_buffer_size;
+        std::lock_guard<std::mutex> lock(loader_mutex);
+        for (size_t i = 0; i < loaded.size();) {
+            if (loaded[i].id != texture_id) {
+                ++i;
+                continue;
+            }
+            destroy_staging_buffer(obj_render_context, loaded[i]);
+            streaming_bytes_in_flight -= loaded[i].size;
+            loaded[i] = loaded.back();
+            loaded.pop_back();
+        }
 
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
-            obj_render_context->createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                &stagingBuffer,
-                &stagingBufferMemory
-            );
+        std::erase_if(streaming_textures, [texture_id](const TextureStreamState& state) { return state.id == texture_id; });
+    }
 
-            // map memory
-            void* data;
-            vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, vertex_buffer_content, (size_t)bufferSize);
-            vkUnmapMemory(device, stagingBufferMemory);
+    void reloadTextureImage(Assets::IdAssetTexture texture_id, VkDevice device, vkc::RenderContext* obj_render_context) {
+        cancel_texture_streaming(texture_id, obj_render_context);
 
-            obj_render_context->copyBuffer(
-                stagingBuffer,
-                model_data_gpu_ref.vertex_buffer,
-                bufferSize);
+        auto it = texture_data_gpu.find(texture_id);
+        if (it != texture_data_gpu.end())
+            retired_resources.push_back({ .is_texture = true, .texture = it->second });
 
-            vkDestroyBuffer(device, stagingBuffer, NULL);
-            vkFreeMemory(device, stagingBufferMemory, NULL);
-        }
+        createTextureImage(texture_id, device, obj_render_context);
     }
 
-    uint32_t createModelBuffers(uint32_t model_index, VkDevice device, vkc::RenderContext* obj_render_context) {
-        Assets::MeshData& mesh_data = Assets::get_mesh_data(model_index);
+    void stream_textures(VkDeviceSize budget_bytes, VkDevice device, vkc::RenderContext* obj_render_context, std::vector<TextureViewChange>* out_changes) {
+        if (streaming_textures.empty())
+            return;
 
-        assert(mesh_data.vertex_count > 0);
+        // uploads submitted by earlier calls, the views move to the new levels once they are done
+        for (size_t i = 0; i < upload_batches.size();) {
+            MipUploadBatch& batch = upload_batches[i];
+            VkResult status = vkGetFenceStatus(device, batch.fence);
+            if (status == VK_NOT_READY) {
+                ++i;
+                continue;
+            }
+            CC_VK_CHECK(status);
+
+            for (const MipLoadRequest& request : batch.uploads) {
+                destroy_staging_buffer(obj_render_context, request);
+                streaming_bytes_in_flight -= request.size;
+
+                for (TextureStreamState& state : streaming_textures) {
+                    if (state.id == request.id) {
+                        state.resident_mip = request.mip;
+                        state.is_loading = false;
+                    }
+                }
+
+                const Assets::TextureData& texture_data = Assets::get_texture_data(request.id);
+                TextureDataGPU& gpu_data = texture_data_gpu[request.id];
+                VkImageView new_view = obj_render_context->create_imge_view(
+                    gpu_data.image,
+                    static_cast<VkFormat>(texture_data.format),
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    static_cast<VkImageViewType>(texture_data.viewType),
+                    texture_data.mipmaps - request.mip,
+                    request.mip
+                );
+
+                out_changes->push_back({ .texture_id = request.id, .old_view = gpu_data.image_view, .new_view = new_view });
+                retired_resources.push_back({ .is_texture = true, .texture = { .image_view = gpu_data.image_view } });
+                gpu_data.image_view = new_view;
+            }
 
-        model_data_gpu[model_index] = ModelDataGPU();
-        ModelDataGPU& model_data_gpu_ref = model_data_gpu[model_index];
+            destroy_upload_batch(obj_render_context, batch);
+            batch = std::move(upload_batches.back());
+            upload_batches.pop_back();
+        }
+        std::erase_if(streaming_textures, [](const TextureStreamState& state) { return state.resident_mip == 0; });
 
-        // we could use a single staging buffer here, but then we would need to sync them.
-        // alternatively, create a RenderContext::copyBuffers() that handles it appropriately
-        // (avoiding to create and destroy the same staring buffer seems like a good idea in any case,
-        // just a metter of figuring out how)
-        // vertices ============================================================
+        // levels the loader thread finished reading, one submission that the frames don't wait for:
+        // the views don't include the levels yet, nothing samples them while they are written
+        std::vector<MipLoadRequest> uploads;
         {
-            // TODO FIXME this won't work if we don't use indices.
-            // but we can't just sizeof(vertices), since now vertices is now a pointer variable
-            VkDeviceSize bufferSize = mesh_data.vertex_count * mesh_data.vertex_data_size;
-
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
-            obj_render_context->createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                &stagingBuffer,
-                &stagingBufferMemory
-            );
-
-            // map memory
-            void* data;
-            vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, mesh_data.vertex_data, (size_t)bufferSize);
-            vkUnmapMemory(device, stagingBufferMemory);
-
-            obj_render_context->createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                &model_data_gpu_ref.vertex_buffer,
-                &model_data_gpu_ref.vertexbuffer_memory
-            );
+            std::lock_guard<std::mutex> lock(loader_mutex);
+            uploads.swap(loaded);
+        }
 
-            obj_render_context->copyBuffer(
-                stagingBuffer,
-                model_data_gpu_ref.vertex_buffer,
-                bufferSize
-            );
+        if (!uploads.empty()) {
+            MipUploadBatch batch = { };
+            batch.command_buffer = obj_render_context->beginSingleTimeCommands();
+            for (const MipLoadRequest& request : uploads) {
+                VkImage image = texture_data_gpu[request.id].image;
+                obj_render_context->cmd_transition_image_layout(batch.command_buffer, image, 1, request.mip, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                obj_render_context->cmd_copy_buffer_to_image(batch.command_buffer, request.staging_buffer, image, Assets::get_texture_data(request.id), request.mip, 1);
+                obj_render_context->cmd_transition_image_layout(batch.command_buffer, image, 1, request.mip, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
 
-            vkDestroyBuffer(device, stagingBuffer, NULL);
-            vkFreeMemory(device, stagingBufferMemory, NULL);
+            VkFenceCreateInfo fence_info = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+            CC_VK_CHECK(vkCreateFence(device, &fence_info, NULL, &batch.fence));
+            obj_render_context->submit_single_time_commands(batch.command_buffer, batch.fence);
 
-            // debug
-            std::string debug_name = "vertex buffer " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-                (uint64_t)model_data_gpu_ref.vertex_buffer,
-                VK_OBJECT_TYPE_BUFFER,
-                obj_render_context->get_device(),
-                debug_name.c_str()
-            );
-            /*std::string debug_name_2 = "staging vertex buffer " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-            (uint64_t)stagingBuffer,
-            VK_OBJECT_TYPE_BUFFER,
-            obj_render_context->get_device(),
-            debug_name.c_str()
-            );*/
-            std::string debug_name_3 = "vertex buffer memory " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-                (uint64_t)model_data_gpu_ref.vertexbuffer_memory,
-                VK_OBJECT_TYPE_DEVICE_MEMORY,
-                obj_render_context->get_device(),
-                debug_name_3.c_str()
-            );
+            batch.uploads = std::move(uploads);
+            upload_batches.push_back(std::move(batch));
         }
 
-
-        // indices  ============================================================
-        {
-            model_data_gpu_ref.indices_count = mesh_data.index_count;
-            // TODO FIXME this won't work if we don't use indices.
-            // but we can't just sizeof(indices), since now indices is now a pointer variable
-            VkDeviceSize bufferSize = mesh_data.index_count * sizeof(mesh_data.index_data[0]);
-
-            VkBuffer stagingBuffer;
-            VkDeviceMemory stagingBufferMemory;
+        // next levels, the coarsest missing level of all textures first
+        while (true) {
+            TextureStreamState* next = nullptr;
+            uint32_t next_extent = UINT32_MAX;
+            for (TextureStreamState& state : streaming_textures) {
+                if (state.is_loading)
+                    continue;
+                const Assets::TextureData& texture_data = Assets::get_texture_data(state.id);
+                uint32_t extent = get_mip_extent(glm::max(texture_data.width, texture_data.height), state.resident_mip - 1);
+                if (extent < next_extent) {
+                    next = &state;
+                    next_extent = extent;
+                }
+            }
+            if (!next)
+                break;
+
+            const Assets::TextureData& texture_data = Assets::get_texture_data(next->id);
+            uint32_t mip = next->resident_mip - 1;
+            VkDeviceSize size = get_mip_level_size(texture_data.format, get_mip_extent(texture_data.width, mip), get_mip_extent(texture_data.height, mip));
+            if (streaming_bytes_in_flight > 0 && streaming_bytes_in_flight + size > budget_bytes)
+                break;
+
+            MipLoadRequest request = {
+                .id      = next->id,
+                .mip     = mip,
+                .texture = texture_data,
+                .offset  = get_mip_offset(texture_data, mip),
+                .size    = size
+            };
             obj_render_context->createBuffer(
-                bufferSize,
+                size,
                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                &stagingBuffer,
-                &stagingBufferMemory
+                &request.staging_buffer,
+                &request.staging_buffer_memory
             );
 
-            // map memory
-            void* data;
-            vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, mesh_data.index_data, (size_t)bufferSize);
-            vkUnmapMemory(device, stagingBufferMemory);
-
-            obj_render_context->createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                &model_data_gpu_ref.index_buffer,
-                &model_data_gpu_ref.index_buffer_memory
-            );
+            {
+                std::lock_guard<std::mutex> lock(loader_mutex);
+                load_queue.push_back(request);
+                ++loader_pending;
+            }
+            loader_cv.notify_one();
 
-            obj_render_context->copyBuffer(
-                stagingBuffer,
-                model_data_gpu_ref.index_buffer,
-                bufferSize
-            );
+            streaming_bytes_in_flight += size;
+            next->is_loading = true;
+        }
+    }
 
-            vkDestroyBuffer(device, stagingBuffer, NULL);
-            vkFreeMemory(device, stagingBufferMemory, NULL);
+    void wait_texture_streaming_idle() {
+        std::unique_lock<std::mutex> lock(loader_mutex);
+        loader_idle_cv.wait(lock, [] { return loader_pending == 0; });
+    }
 
+    void destroy_retired_resources(vkc::RenderContext* obj_render_context, uint32_t num_frames_in_flight) {
+        for (size_t i = 0; i < retired_resources.size();) {
+            RetiredResources& retired = retired_resources[i];
+            if (retired.frames_waited++ < num_frames_in_flight) {
+                ++i;
+                continue;
+            }
 
-            // debug
-            std::string debug_name = "index buffer " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-                (uint64_t)model_data_gpu_ref.index_buffer,
-                VK_OBJECT_TYPE_BUFFER,
-                obj_render_context->get_device(),
-                debug_name.c_str()
-            );
-            /*std::string debug_name_2 = "staging index buffer " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-            (uint64_t)stagingBuffer,
-            VK_OBJECT_TYPE_BUFFER,
-            obj_render_context->get_device(),
-            debug_name.c_str()
-            );*/
-            std::string debug_name_3 = "index buffer memory " + std::to_string(model_index);
-            vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
-                (uint64_t)model_data_gpu_ref.index_buffer_memory,
-                VK_OBJECT_TYPE_DEVICE_MEMORY,
-                obj_render_context->get_device(),
-                debug_name_3.c_str()
-            );
+            if (retired.is_texture)
+                destroy_texture_data_gpu(obj_render_context, retired.texture);
+            else
+                destroy_model_data_gpu(retired.model);
+            retired = retired_resources.back();
+            retired_resources.pop_back();
         }
-
-        return model_index;
     }
 
-    void destroy_resources(VkDevice device) {
-        for (auto& data : texture_data_gpu)
-        {
-            vkDestroyImageView(device, data.second.image_view, NULL);
-            vkDestroyImage(device, data.second.image, NULL);
-            vkFreeMemory(device, data.second.image_memory, NULL);
+    void destroy_resources(vkc::RenderContext* obj_render_context) {
+        // loader first, it may still be writing to staging buffers
+        if (loader_thread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(loader_mutex);
+                loader_quit = true;
+            }
+            loader_cv.notify_all();
+            loader_thread.join();
         }
-
-        for (auto& data : model_data_gpu)
-        {
-            vkDestroyBuffer(device, data.second.vertex_buffer, NULL);
-            vkDestroyBuffer(device, data.second.index_buffer, NULL);
-            vkFreeMemory(device, data.second.index_buffer_memory, NULL);
-            vkFreeMemory(device, data.second.vertexbuffer_memory, NULL);
+        for (const MipLoadRequest& request : load_queue)
+            destroy_staging_buffer(obj_render_context, request);
+        for (const MipLoadRequest& request : loaded)
+            destroy_staging_buffer(obj_render_context, request);
+        for (const MipUploadBatch& batch : upload_batches) {
+            for (const MipLoadRequest& request : batch.uploads)
+                destroy_staging_buffer(obj_render_context, request);
+            destroy_upload_batch(obj_render_context, batch);
         }
-    }
+        load_queue.clear();
+        loaded.clear();
+        upload_batches.clear();
+        streaming_textures.clear();
+        streaming_bytes_in_flight = 0;
+
+        for (auto& data : texture_data_gpu)
+            destroy_texture_data_gpu(obj_render_context, data.second);
 
-    void add_debug_name(uint32_t gpu_data_id, VkDevice device, vkc::Instance* obj_instance, const char * debug_name) {
-        
-        auto& gpu_data = model_data_gpu[gpu_data_id];
+        // called once the device is idle
+        for (const RetiredResources& retired : retired_resources) {
+            if (retired.is_texture)
+                destroy_texture_data_gpu(obj_render_context, retired.texture);
+        }
+        retired_resources.clear();
 
-        obj_instance->add_object_debug_name((uint64_t)gpu_data.vertex_buffer, VK_OBJECT_TYPE_BUFFER, device, debug_name);
-        obj_instance->add_object_debug_name((uint64_t)gpu_data.index_buffer, VK_OBJECT_TYPE_BUFFER, device, debug_name);
+        // meshes only hold ranges of the geometry blocks
+        model_data_gpu.clear();
+        geometry_buffer_destroy(&vertex_geometry, obj_render_context);
+        geometry_buffer_destroy(&index_geometry,  obj_render_context);
     }
 
-
     // ======================================================================
     // debug drawcalls
     // ======================================================================
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 
 #include <AssetManager.hpp>
+#include <core/GeometryBuffer.hpp>
 #include <core/Instance.hpp>
 #include <core/RenderContext.hpp>
 #include <core/VertexData.h>
@@ -11,17 +12,23 @@
 
 namespace vkc {
 	namespace Drawcall {
+		// vertices and indices are suballocated from the shared geometry buffers: bind the block
+		// buffers at offset 0 and draw with `first_index` and `vertex_offset`
 		struct ModelDataGPU {
 			VkBuffer vertex_buffer;
-			VkDeviceMemory vertexbuffer_memory;
 			VkBuffer index_buffer;
-			VkDeviceMemory index_buffer_memory;
+			GeometryAllocation vertices;
+			GeometryAllocation indices;
+			int32_t  vertex_offset;		// first vertex of the mesh in `vertex_buffer`
+			uint32_t first_index;		// first index of the mesh in `index_buffer`, in `index_type` elements
 			uint32_t indices_count;
+			VkIndexType index_type;
+			DataUniformMeshQuantization quantization; // compact meshes only
 		};
 
 		struct TextureDataGPU {
 			VkImage image;
-			VkDeviceMemory image_memory;
+			MemoryAllocation image_memory;
 			VkImageView image_view;
 		};
 
@@ -33,25 +40,58 @@ namespace vkc {
 			uint32_t data_uniform_model_size;
 			uint32_t idx_data_attributes;
 			void* data_uniform_model;
+			// index range to draw, index_count 0 draws the whole mesh
+			uint32_t first_index;
+			uint32_t index_count;
+			// pipelines with TEXTURE_ARRAYS only
+			DataUniformMaterialLayers data_material_layers;
+		};
+
+		// largest LOD error allowed on screen
+		const float LOD_MAX_ERROR_PIXELS = 1.0f;
+
+		struct CullStats {
+			uint32_t meshes_frustum_culled;
+			uint32_t meshes_lod;	// drawn with a simplified LOD
+			uint32_t meshlets_total;
+			uint32_t meshlets_frustum_culled;
+			uint32_t meshlets_backface_culled;
+			uint32_t drawcalls;
 		};
 
 		void add_drawcall(DrawcallData data);
+		// frustum culls the mesh against the frame camera and picks its LOD from the projected error.
+		// At LOD 0, culls the meshlets (frustum, and normal cones when the pipeline culls back faces),
+		// then adds one drawcall per run of consecutive visible meshlets.
+		// Meshes without meshlets and LODs are added whole
+		void add_drawcall_culled(DrawcallData data, const glm::mat4& transform, const DataUniformFrame& data_frame, float viewport_height);
+		// since the last `clear_drawcalls()`
+		CullStats get_cull_stats();
 		const std::vector<DrawcallData>& get_drawcalls();
 		void clear_drawcalls();
 
 		VkImageView get_texture_image_view(uint32_t id);
 		ModelDataGPU get_model_data(uint32_t index);
 
+		// 2D textures are created with their whole mip chain, but only the levels up to
+		// TEXTURE_MIP_TAIL_SIZE texels wide and high are uploaded, the view starts at the first of them.
+		// The higher levels are streamed in later by `stream_textures`
+		const uint32_t TEXTURE_MIP_TAIL_SIZE = 128;
+		// mip levels read by the loader thread and uploaded in a single frame, at most
+		// (a single level larger than this is still streamed, alone)
+		const VkDeviceSize TEXTURE_STREAMING_BUDGET_BYTES = 8 * 1024 * 1024;
+
+		struct TextureViewChange {
+			Assets::IdAssetTexture texture_id;
+			VkImageView old_view;
+			VkImageView new_view;
+		};
+
 		void createTextureImage(
 			Assets::IdAssetTexture texture_id,
 			VkDevice device,
 			vkc::RenderContext* obj_render_context
 		);
-		void createTextureCubemap(
-			Assets::IdAssetTexture texture_id,
-			VkDevice device,
-			vkc::RenderContext* obj_render_context
-		);
 
 		void updateModelVertexBuffer(
 			uint32_t model_index,
@@ -66,9 +106,37 @@ namespace vkc {
 			vkc::RenderContext* obj_render_context
 		);
 
-		void destroy_resources(VkDevice device);
+		// hot reload: new GPU resources for assets whose data changed. The replaced resources are only
+		// retired, frames in flight can still use them: `destroy_retired_resources` destroys them later
+		void reloadModelBuffers(
+			Assets::IdAssetMesh mesh_id,
+			VkDevice device,
+			vkc::RenderContext* obj_render_context
+		);
+		// descriptor sets still point to the old image view, update them (not while their frame is in flight)
+		void reloadTextureImage(
+			Assets::IdAssetTexture texture_id,
+			VkDevice device,
+			vkc::RenderContext* obj_render_context
+		);
+		// once per frame: submits the upload of the mip levels the loader thread finished reading
+		// (one submission with a fence, nothing waits for it), then asks the loader for the next levels,
+		// coarsest first across all textures, up to `budget_bytes` in flight.
+		// Textures whose upload is done have a new view with the new level: `out_changes` lists them,
+		// update the descriptor sets once no frame in flight uses them. The old views are retired
+		void stream_textures(
+			VkDeviceSize budget_bytes,
+			VkDevice device,
+			vkc::RenderContext* obj_render_context,
+			std::vector<TextureViewChange>* out_changes
+		);
+		// blocks until the loader thread read all of the levels asked so far, texture data
+		// can't be modified or freed while it reads them
+		void wait_texture_streaming_idle();
+		// once per frame, destroys the resources retired at least `num_frames_in_flight` calls ago
+		void destroy_retired_resources(vkc::RenderContext* obj_render_context, uint32_t num_frames_in_flight);
 
-		void add_debug_name(uint32_t gpu_data_id, VkDevice device, vkc::Instance* obj_device, const char* debug_name);
+		void destroy_resources(vkc::RenderContext* obj_render_context);
 
 		// ======================================================================
 		// debug drawcalls
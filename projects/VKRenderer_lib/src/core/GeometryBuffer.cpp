@@ -0,0 +1,129 @@
+#include "GeometryBuffer.hpp"
+
+#include <VulkanUtils.h>
+#include <core/Instance.hpp>
+#include <core/RenderContext.hpp>
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+namespace vkc {
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // carves `size` bytes out of a free range of `block`, the alignment padding stays free
+    static bool block_alloc(GeometryBlock* block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* out_offset) {
+        for (size_t i = 0; i < block->free_ranges.size(); ++i) {
+            GeometryRange range = block->free_ranges[i];
+            VkDeviceSize offset = align_up(range.offset, alignment);
+            if (offset + size > range.offset + range.size)
+                continue;
+
+            GeometryRange before = { .offset = range.offset,   .size = offset - range.offset };
+            GeometryRange after  = { .offset = offset + size, .size = range.offset + range.size - (offset + size) };
+            block->free_ranges.erase(block->free_ranges.begin() + i);
+            if (after.size > 0)
+                block->free_ranges.insert(block->free_ranges.begin() + i, after);
+            if (before.size > 0)
+                block->free_ranges.insert(block->free_ranges.begin() + i, before);
+
+            *out_offset = offset;
+            return true;
+        }
+        return false;
+    }
+
+    GeometryAllocation geometry_buffer_alloc(GeometryBuffer* buffer, VkDeviceSize size, VkDeviceSize alignment, vkc::RenderContext* obj_render_context) {
+        CC_ASSERT(size > 0 && alignment > 0, "empty geometry allocation");
+
+        GeometryAllocation allocation = { .block = 0, .offset = 0, .size = size };
+        for (uint32_t i = 0; i < buffer->blocks.size(); ++i) {
+            if (block_alloc(&buffer->blocks[i], size, alignment, &allocation.offset)) {
+                allocation.block = i;
+                return allocation;
+            }
+        }
+
+        GeometryBlock block = { };
+        block.size = std::max(buffer->block_size, size);
+        block.free_ranges.push_back({ .offset = 0, .size = block.size });
+        obj_render_context->createBuffer(
+            block.size,
+            buffer->usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            &block.buffer,
+            &block.memory
+        );
+
+        std::string debug_name = std::string(buffer->debug_name) + " " + std::to_string(buffer->blocks.size());
+        vkc::Instance::TMP_get_singleton_instance()->add_object_debug_name(
+            (uint64_t)block.buffer,
+            VK_OBJECT_TYPE_BUFFER,
+            obj_render_context->get_device(),
+            debug_name.c_str()
+        );
+        CC_LOG(CC_VERBOSE, "%s: %.1fMB", debug_name.c_str(), block.size / (1024.0 * 1024.0));
+
+        block_alloc(&block, size, alignment, &allocation.offset);
+        allocation.block = (uint32_t)buffer->blocks.size();
+        buffer->blocks.push_back(block);
+        return allocation;
+    }
+
+    void geometry_buffer_free(GeometryBuffer* buffer, const GeometryAllocation& allocation) {
+        std::vector<GeometryRange>& ranges = buffer->blocks[allocation.block].free_ranges;
+
+        auto it = std::lower_bound(ranges.begin(), ranges.end(), allocation.offset, [](const GeometryRange& range, VkDeviceSize offset) {
+            return range.offset < offset;
+        });
+        it = ranges.insert(it, { .offset = allocation.offset, .size = allocation.size });
+
+        // merge with the next range, then with the previous one
+        auto next = it + 1;
+        if (next != ranges.end() && it->offset + it->size == next->offset) {
+            it->size += next->size;
+            it = ranges.erase(next) - 1;
+        }
+        if (it != ranges.begin()) {
+            auto prev = it - 1;
+            if (prev->offset + prev->size == it->offset) {
+                prev->size += it->size;
+                ranges.erase(it);
+            }
+        }
+    }
+
+    void geometry_buffer_upload(const GeometryBuffer& buffer, const GeometryAllocation& allocation, const void* data, VkDeviceSize size, vkc::RenderContext* obj_render_context) {
+        CC_ASSERT(size <= allocation.size, "upload larger than the geometry allocation");
+
+        VkBuffer stagingBuffer;
+        MemoryAllocation stagingBufferMemory;
+        obj_render_context->createBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &stagingBuffer,
+            &stagingBufferMemory
+        );
+
+        memcpy(stagingBufferMemory.mapped, data, (size_t)size);
+
+        obj_render_context->copyBuffer(
+            stagingBuffer,
+            geometry_buffer_get_handle(buffer, allocation),
+            size,
+            allocation.offset
+        );
+
+        obj_render_context->destroy_buffer(stagingBuffer, stagingBufferMemory);
+    }
+
+    void geometry_buffer_destroy(GeometryBuffer* buffer, vkc::RenderContext* obj_render_context) {
+        for (const GeometryBlock& block : buffer->blocks)
+            obj_render_context->destroy_buffer(block.buffer, block.memory);
+        buffer->blocks.clear();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <core/MemoryAllocator.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+// vertices and indices of every mesh, suballocated from a few large device local buffers
+//
+// - a buffer grows by blocks of `block_size` bytes (larger for a single larger allocation),
+//   allocations never span blocks. Free ranges of a block are kept sorted and merged on free
+// - allocations are aligned to an arbitrary `alignment`, not only powers of two: vertices are
+//   aligned to their stride so that draws address them with `vertexOffset` from offset 0
+// - draws of meshes in the same block share their vertex and index buffer binds, and can be
+//   issued as a single multi-draw indirect
+namespace vkc {
+	class RenderContext;
+
+	const VkDeviceSize GEOMETRY_VERTEX_BLOCK_SIZE = 64 * 1024 * 1024;
+	const VkDeviceSize GEOMETRY_INDEX_BLOCK_SIZE  = 32 * 1024 * 1024;
+	// uint16_t and uint32_t indices share the index blocks
+	const VkDeviceSize GEOMETRY_INDEX_ALIGNMENT   = sizeof(uint32_t);
+
+	struct GeometryRange {
+		VkDeviceSize offset;
+		VkDeviceSize size;
+	};
+
+	struct GeometryBlock {
+		VkBuffer         buffer;
+		MemoryAllocation memory;
+		VkDeviceSize     size;
+		std::vector<GeometryRange> free_ranges;	// sorted by offset, never adjacent
+	};
+
+	struct GeometryBuffer {
+		VkBufferUsageFlags usage;
+		VkDeviceSize       block_size;
+		const char*        debug_name;
+		std::vector<GeometryBlock> blocks;
+	};
+
+	struct GeometryAllocation {
+		uint32_t     block;
+		VkDeviceSize offset;	// bytes, from the start of the block buffer
+		VkDeviceSize size;
+	};
+
+	// first fit over the blocks, a new block is created when none has room
+	GeometryAllocation geometry_buffer_alloc(
+		GeometryBuffer* buffer,
+		VkDeviceSize size,
+		VkDeviceSize alignment,
+		vkc::RenderContext* obj_render_context
+	);
+	// the GPU must be done with the range, see `Drawcall::destroy_retired_resources`
+	void geometry_buffer_free(GeometryBuffer* buffer, const GeometryAllocation& allocation);
+	// `size` bytes of `data` to the start of the allocation, through a staging buffer. Waits for the copy
+	void geometry_buffer_upload(
+		const GeometryBuffer& buffer,
+		const GeometryAllocation& allocation,
+		const void* data,
+		VkDeviceSize size,
+		vkc::RenderContext* obj_render_context
+	);
+	inline VkBuffer geometry_buffer_get_handle(const GeometryBuffer& buffer, const GeometryAllocation& allocation) {
+		return buffer.blocks[allocation.block].buffer;
+	}
+	void geometry_buffer_destroy(GeometryBuffer* buffer, vkc::RenderContext* obj_render_context);
+}
@@ -0,0 +1,432 @@
+#include "MemoryAllocator.hpp"
+
+#include <cc_logger.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <bit>
+
+namespace vkc {
+    static VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // ======================================================================
+    // TLSF
+    // ======================================================================
+
+    static void tlsf_mapping(VkDeviceSize size, uint32_t* out_fl, uint32_t* out_sl) {
+        if (size < (1ull << TLSF_FL_SHIFT)) {
+            *out_fl = 0;
+            *out_sl = (uint32_t)(size / MEMORY_MIN_ALIGNMENT);
+            return;
+        }
+        uint32_t fl = 63 - std::countl_zero(size);
+        *out_fl = fl - TLSF_FL_SHIFT + 1;
+        *out_sl = (uint32_t)(size >> (fl - TLSF_SL_BITS)) ^ TLSF_SL_COUNT;
+    }
+
+    // size class whose ranges are all at least `size` bytes
+    static void tlsf_mapping_search(VkDeviceSize size, uint32_t* out_fl, uint32_t* out_sl) {
+        if (size >= (1ull << TLSF_FL_SHIFT))
+            size += (1ull << (63 - std::countl_zero(size) - TLSF_SL_BITS)) - 1;
+        tlsf_mapping(size, out_fl, out_sl);
+    }
+
+    static uint32_t tlsf_new_node(TlsfBlock* block) {
+        if (!block->unused_nodes.empty()) {
+            uint32_t index = block->unused_nodes.back();
+            block->unused_nodes.pop_back();
+            return index;
+        }
+        block->nodes.push_back({ });
+        return (uint32_t)block->nodes.size() - 1;
+    }
+
+    static void tlsf_insert_free(TlsfBlock* block, uint32_t index) {
+        TlsfNode& node = block->nodes[index];
+        uint32_t fl, sl;
+        tlsf_mapping(node.size, &fl, &sl);
+
+        node.is_free   = true;
+        node.prev_free = TLSF_NODE_NONE;
+        node.next_free = block->free_heads[fl][sl];
+        if (node.next_free != TLSF_NODE_NONE)
+            block->nodes[node.next_free].prev_free = index;
+        block->free_heads[fl][sl] = index;
+        block->fl_bitmap     |= 1ull << fl;
+        block->sl_bitmap[fl] |= 1u << sl;
+    }
+
+    static void tlsf_remove_free(TlsfBlock* block, uint32_t index) {
+        TlsfNode& node = block->nodes[index];
+        uint32_t fl, sl;
+        tlsf_mapping(node.size, &fl, &sl);
+
+        if (node.prev_free != TLSF_NODE_NONE)
+            block->nodes[node.prev_free].next_free = node.next_free;
+        else
+            block->free_heads[fl][sl] = node.next_free;
+        if (node.next_free != TLSF_NODE_NONE)
+            block->nodes[node.next_free].prev_free = node.prev_free;
+
+        if (block->free_heads[fl][sl] == TLSF_NODE_NONE) {
+            block->sl_bitmap[fl] &= ~(1u << sl);
+            if (block->sl_bitmap[fl] == 0)
+                block->fl_bitmap &= ~(1ull << fl);
+        }
+        node.is_free = false;
+    }
+
+    // first free range of the smallest size class that fits `size`, TLSF_NODE_NONE if none
+    static uint32_t tlsf_find_free(const TlsfBlock& block, VkDeviceSize size) {
+        uint32_t fl, sl;
+        tlsf_mapping_search(size, &fl, &sl);
+        if (fl >= TLSF_FL_COUNT)
+            return TLSF_NODE_NONE;
+
+        uint32_t sl_map = sl < TLSF_SL_COUNT ? block.sl_bitmap[fl] & (~0u << sl) : 0;
+        if (sl_map == 0) {
+            uint64_t fl_map = fl + 1 < 64 ? block.fl_bitmap & (~0ull << (fl + 1)) : 0;
+            if (fl_map == 0)
+                return TLSF_NODE_NONE;
+            fl = std::countr_zero(fl_map);
+            sl_map = block.sl_bitmap[fl];
+        }
+        return block.free_heads[fl][std::countr_zero(sl_map)];
+    }
+
+    // the class of `size` itself may hold a range that fits, `tlsf_find_free` rounds up to stay O(1).
+    // Walked before growing the pool, so that an exact fit doesn't cost a new block
+    static uint32_t tlsf_find_fit_in_class(const TlsfBlock& block, VkDeviceSize size, VkDeviceSize alignment) {
+        uint32_t fl, sl;
+        tlsf_mapping(size, &fl, &sl);
+        if (fl >= TLSF_FL_COUNT)
+            return TLSF_NODE_NONE;
+
+        for (uint32_t i = block.free_heads[fl][sl]; i != TLSF_NODE_NONE; i = block.nodes[i].next_free) {
+            const TlsfNode& node = block.nodes[i];
+            if (align_up(node.offset, alignment) + size <= node.offset + node.size)
+                return i;
+        }
+        return TLSF_NODE_NONE;
+    }
+
+    // keeps the first `size` bytes of range `index`, the rest becomes a free range after it
+    static uint32_t tlsf_split(TlsfBlock* block, uint32_t index, VkDeviceSize size) {
+        uint32_t rest = tlsf_new_node(block);
+        TlsfNode& node = block->nodes[index];
+        block->nodes[rest] = {
+            .offset = node.offset + size,
+            .size   = node.size - size,
+            .prev   = index,
+            .next   = node.next
+        };
+        if (node.next != TLSF_NODE_NONE)
+            block->nodes[node.next].prev = rest;
+        node.next = rest;
+        node.size = size;
+        tlsf_insert_free(block, rest);
+        return rest;
+    }
+
+    // `size` and the offset of the range are multiples of MEMORY_MIN_ALIGNMENT
+    static bool tlsf_alloc(TlsfBlock* block, VkDeviceSize size, VkDeviceSize alignment, uint32_t* out_node) {
+        // any range of the class found has room for the allocation and its worst padding
+        uint32_t index = tlsf_find_free(*block, size + alignment - MEMORY_MIN_ALIGNMENT);
+        if (index == TLSF_NODE_NONE)
+            index = tlsf_find_fit_in_class(*block, size, alignment);
+        if (index == TLSF_NODE_NONE)
+            return false;
+        tlsf_remove_free(block, index);
+
+        VkDeviceSize offset = block->nodes[index].offset;
+        VkDeviceSize padding = align_up(offset, alignment) - offset;
+        if (padding > 0) {
+            uint32_t aligned = tlsf_split(block, index, padding);
+            tlsf_remove_free(block, aligned);
+            tlsf_insert_free(block, index);
+            index = aligned;
+        }
+        if (block->nodes[index].size > size)
+            tlsf_split(block, index, size);
+
+        *out_node = index;
+        return true;
+    }
+
+    // merges `index` with its free neighbours
+    static void tlsf_free(TlsfBlock* block, uint32_t index) {
+        uint32_t next = block->nodes[index].next;
+        if (next != TLSF_NODE_NONE && block->nodes[next].is_free) {
+            tlsf_remove_free(block, next);
+            block->nodes[index].size += block->nodes[next].size;
+            block->nodes[index].next  = block->nodes[next].next;
+            if (block->nodes[index].next != TLSF_NODE_NONE)
+                block->nodes[block->nodes[index].next].prev = index;
+            block->unused_nodes.push_back(next);
+        }
+
+        uint32_t prev = block->nodes[index].prev;
+        if (prev != TLSF_NODE_NONE && block->nodes[prev].is_free) {
+            tlsf_remove_free(block, prev);
+            block->nodes[prev].size += block->nodes[index].size;
+            block->nodes[prev].next  = block->nodes[index].next;
+            if (block->nodes[prev].next != TLSF_NODE_NONE)
+                block->nodes[block->nodes[prev].next].prev = prev;
+            block->unused_nodes.push_back(index);
+            index = prev;
+        }
+
+        tlsf_insert_free(block, index);
+    }
+
+    // ======================================================================
+    // allocator
+    // ======================================================================
+
+    static VkResult vulkan_allocate(void* user_data, uint32_t memory_type, VkDeviceSize size, VkDeviceMemory* out_memory) {
+        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memory_type;
+        return vkAllocateMemory((VkDevice)user_data, &allocInfo, NULL, out_memory);
+    }
+
+    static void vulkan_free(void* user_data, VkDeviceMemory memory) {
+        vkFreeMemory((VkDevice)user_data, memory, NULL);
+    }
+
+    static VkResult vulkan_map(void* user_data, VkDeviceMemory memory, void** out_mapped) {
+        return vkMapMemory((VkDevice)user_data, memory, 0, VK_WHOLE_SIZE, 0, out_mapped);
+    }
+
+    MemoryDeviceFunctions memory_device_functions_vulkan(VkDevice device) {
+        return {
+            .user_data = (void*)device,
+            .allocate  = vulkan_allocate,
+            .free      = vulkan_free,
+            .map       = vulkan_map
+        };
+    }
+
+    // device memory of `size` bytes, mapped if host visible
+    static bool device_alloc(MemoryAllocator* allocator, uint32_t memory_type, VkDeviceSize size, VkDeviceMemory* out_memory, void** out_mapped) {
+        if (allocator->device.allocate(allocator->device.user_data, memory_type, size, out_memory) != VK_SUCCESS) {
+            CC_LOG(CC_ERROR, "[memory] failed to allocate %.2fMB of memory type %d", size / (1024.0 * 1024.0), memory_type);
+            return false;
+        }
+
+        *out_mapped = nullptr;
+        if ((allocator->memory_type_flags[memory_type] & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+            && allocator->device.map(allocator->device.user_data, *out_memory, out_mapped) != VK_SUCCESS) {
+            CC_LOG(CC_ERROR, "[memory] failed to map memory type %d", memory_type);
+            allocator->device.free(allocator->device.user_data, *out_memory);
+            return false;
+        }
+        return true;
+    }
+
+    static bool block_create(MemoryAllocator* allocator, TlsfBlock* block, uint32_t memory_type) {
+        *block = { };
+        if (!device_alloc(allocator, memory_type, allocator->block_size, &block->memory, &block->mapped)) {
+            block->memory = VK_NULL_HANDLE;
+            return false;
+        }
+
+        block->size = allocator->block_size;
+        memset(block->free_heads, 0xFF, sizeof(block->free_heads));
+        block->nodes.push_back({
+            .offset = 0,
+            .size   = block->size,
+            .prev   = TLSF_NODE_NONE,
+            .next   = TLSF_NODE_NONE
+        });
+        tlsf_insert_free(block, 0);
+        return true;
+    }
+
+    static void block_release(MemoryAllocator* allocator, TlsfBlock* block) {
+        allocator->device.free(allocator->device.user_data, block->memory);
+        *block = { };
+        block->memory = VK_NULL_HANDLE;
+    }
+
+    void memory_allocator_init(MemoryAllocator* allocator, const MemoryDeviceFunctions& device, const VkPhysicalDeviceMemoryProperties& properties, VkDeviceSize block_size) {
+        CC_ASSERT(std::has_single_bit(block_size) && block_size >= MEMORY_MIN_ALIGNMENT, "memory block size must be a power of two");
+
+        allocator->device            = device;
+        allocator->block_size        = block_size;
+        allocator->memory_type_count = properties.memoryTypeCount;
+        for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+            allocator->memory_type_flags[i] = properties.memoryTypes[i].propertyFlags;
+        allocator->pools.clear();
+        allocator->pools.resize(properties.memoryTypeCount * MEMORY_RESOURCE_KIND_COUNT);
+        allocator->dedicated_count = 0;
+        allocator->dedicated_size  = 0;
+        allocator->dedicated_used  = 0;
+    }
+
+    bool memory_alloc(MemoryAllocator* allocator, const VkMemoryRequirements& requirements, uint32_t memory_type, MemoryResourceKind kind, MemoryAllocation* out_allocation) {
+        CC_ASSERT(memory_type < allocator->memory_type_count, "invalid memory type");
+        CC_ASSERT(std::has_single_bit(std::max<VkDeviceSize>(requirements.alignment, 1)), "memory alignment must be a power of two");
+        std::lock_guard<std::mutex> lock(allocator->mutex);
+
+        *out_allocation = {
+            .memory = VK_NULL_HANDLE,
+            .offset = 0,
+            .size   = requirements.size,
+            .mapped = nullptr,
+            .pool   = memory_type * MEMORY_RESOURCE_KIND_COUNT + kind,
+            .block  = MEMORY_BLOCK_NONE,
+            .node   = TLSF_NODE_NONE
+        };
+        VkDeviceSize size      = align_up(std::max<VkDeviceSize>(requirements.size, 1), MEMORY_MIN_ALIGNMENT);
+        VkDeviceSize alignment = std::max(requirements.alignment, MEMORY_MIN_ALIGNMENT);
+
+        if (size + alignment - MEMORY_MIN_ALIGNMENT > allocator->block_size / 2) {
+            if (!device_alloc(allocator, memory_type, requirements.size, &out_allocation->memory, &out_allocation->mapped)) {
+                out_allocation->memory = VK_NULL_HANDLE;
+                return false;
+            }
+            ++allocator->dedicated_count;
+            allocator->dedicated_size += requirements.size;
+            allocator->dedicated_used += requirements.size;
+            return true;
+        }
+
+        MemoryPool& pool = allocator->pools[out_allocation->pool];
+        uint32_t block_index = MEMORY_BLOCK_NONE;
+        uint32_t node = TLSF_NODE_NONE;
+        for (uint32_t i = 0; i < pool.blocks.size() && block_index == MEMORY_BLOCK_NONE; ++i) {
+            if (pool.blocks[i].memory != VK_NULL_HANDLE && tlsf_alloc(&pool.blocks[i], size, alignment, &node))
+                block_index = i;
+        }
+
+        if (block_index == MEMORY_BLOCK_NONE) {
+            // the slot of a released block, if any
+            block_index = (uint32_t)pool.blocks.size();
+            for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+                if (pool.blocks[i].memory == VK_NULL_HANDLE) {
+                    block_index = i;
+                    break;
+                }
+            }
+            if (block_index == pool.blocks.size())
+                pool.blocks.push_back({ });
+            if (!block_create(allocator, &pool.blocks[block_index], memory_type))
+                return false;
+            bool is_allocated = tlsf_alloc(&pool.blocks[block_index], size, alignment, &node);
+            CC_ASSERT(is_allocated, "allocation doesn't fit an empty memory block");
+        }
+
+        TlsfBlock& block = pool.blocks[block_index];
+        ++block.allocation_count;
+        block.used += requirements.size;
+
+        out_allocation->memory = block.memory;
+        out_allocation->offset = block.nodes[node].offset;
+        out_allocation->mapped = block.mapped ? (unsigned char*)block.mapped + out_allocation->offset : nullptr;
+        out_allocation->block  = block_index;
+        out_allocation->node   = node;
+        return true;
+    }
+
+    void memory_free(MemoryAllocator* allocator, const MemoryAllocation& allocation) {
+        if (allocation.memory == VK_NULL_HANDLE)
+            return;
+        std::lock_guard<std::mutex> lock(allocator->mutex);
+
+        if (allocation.block == MEMORY_BLOCK_NONE) {
+            allocator->device.free(allocator->device.user_data, allocation.memory);
+            --allocator->dedicated_count;
+            allocator->dedicated_size -= allocation.size;
+            allocator->dedicated_used -= allocation.size;
+            return;
+        }
+
+        MemoryPool& pool = allocator->pools[allocation.pool];
+        TlsfBlock& block = pool.blocks[allocation.block];
+        CC_ASSERT(block.memory == allocation.memory && !block.nodes[allocation.node].is_free, "memory freed twice");
+        tlsf_free(&block, allocation.node);
+        --block.allocation_count;
+        block.used -= allocation.size;
+
+        if (block.allocation_count > 0)
+            return;
+        // keep the last block of the pool, allocations come and go (staging buffers)
+        uint32_t live_blocks = 0;
+        for (const TlsfBlock& other : pool.blocks)
+            live_blocks += other.memory != VK_NULL_HANDLE;
+        if (live_blocks > 1)
+            block_release(allocator, &block);
+    }
+
+    MemoryStats memory_allocator_get_stats(MemoryAllocator* allocator) {
+        std::lock_guard<std::mutex> lock(allocator->mutex);
+
+        MemoryStats stats = {
+            .dedicated   = allocator->dedicated_count,
+            .allocations = allocator->dedicated_count,
+            .reserved    = allocator->dedicated_size,
+            .used        = allocator->dedicated_used
+        };
+        VkDeviceSize free_bytes = 0;
+        for (const MemoryPool& pool : allocator->pools) {
+            for (const TlsfBlock& block : pool.blocks) {
+                if (block.memory == VK_NULL_HANDLE)
+                    continue;
+                ++stats.blocks;
+                stats.allocations += block.allocation_count;
+                stats.reserved    += block.size;
+                stats.used        += block.used;
+                for (uint32_t i = 0; i != TLSF_NODE_NONE; i = block.nodes[i].next) {
+                    if (!block.nodes[i].is_free)
+                        continue;
+                    ++stats.free_ranges;
+                    free_bytes += block.nodes[i].size;
+                    stats.largest_free_range = std::max(stats.largest_free_range, block.nodes[i].size);
+                }
+            }
+        }
+        stats.device_allocations = stats.blocks + stats.dedicated;
+        stats.fragmentation = free_bytes > 0 ? 1.0f - (float)((double)stats.largest_free_range / free_bytes) : 0.0f;
+        return stats;
+    }
+
+    void memory_allocator_print_stats(MemoryAllocator* allocator) {
+        MemoryStats stats = memory_allocator_get_stats(allocator);
+        CC_LOG(
+            CC_INFO,
+            "[memory] %d device allocations (%d blocks, %d dedicated), %d resources, %.2fMB used of %.2fMB, "
+            "%d free ranges, largest %.2fMB, fragmentation %.1f%%",
+            stats.device_allocations,
+            stats.blocks,
+            stats.dedicated,
+            stats.allocations,
+            stats.used / (1024.0 * 1024.0),
+            stats.reserved / (1024.0 * 1024.0),
+            stats.free_ranges,
+            stats.largest_free_range / (1024.0 * 1024.0),
+            stats.fragmentation * 100.0f
+        );
+    }
+
+    void memory_allocator_destroy(MemoryAllocator* allocator) {
+        std::lock_guard<std::mutex> lock(allocator->mutex);
+
+        uint32_t leaks = allocator->dedicated_count;
+        for (MemoryPool& pool : allocator->pools) {
+            for (TlsfBlock& block : pool.blocks) {
+                if (block.memory == VK_NULL_HANDLE)
+                    continue;
+                leaks += block.allocation_count;
+                block_release(allocator, &block);
+            }
+        }
+        allocator->pools.clear();
+        // dedicated allocations are only counted, their owners still hold them
+        if (leaks > 0)
+            CC_LOG(CC_WARNING, "[memory] %d allocations still alive at shutdown", leaks);
+    }
+}
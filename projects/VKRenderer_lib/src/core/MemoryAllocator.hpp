@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+// device memory of buffers and images, suballocated from a few large blocks instead of one
+// vkAllocateMemory per resource (drivers cap live allocations at maxMemoryAllocationCount, 4096 on most)
+//
+// - one pool of blocks per memory type and resource kind: buffers and images never share a block,
+//   so `bufferImageGranularity` never applies between neighbours
+// - ranges of a block are managed by a TLSF (two level segregated fit): free ranges are binned by
+//   power of two, then in `TLSF_SL_COUNT` linear steps, two bitmaps find a large enough one in O(1).
+//   Freed ranges are merged with their free neighbours
+// - alignments are powers of two (guaranteed by Vulkan), the padding in front of an allocation stays free
+// - resources larger than half a block get a dedicated allocation. An empty block is released,
+//   unless it's the last one of its pool
+// - host visible memory is mapped once, `MemoryAllocation::mapped` points inside the mapping
+// - device calls go through `MemoryDeviceFunctions`, tests replace them with a mock
+namespace vkc {
+	const VkDeviceSize MEMORY_BLOCK_SIZE    = 64 * 1024 * 1024;
+	// sizes and offsets in a block are multiples of it
+	const VkDeviceSize MEMORY_MIN_ALIGNMENT = 16;
+	const uint32_t     MEMORY_BLOCK_NONE    = 0xFFFFFFFF;
+
+	enum MemoryResourceKind : uint8_t {
+		MEMORY_RESOURCE_BUFFER = 0,
+		MEMORY_RESOURCE_IMAGE  = 1,	// optimal tiling
+		MEMORY_RESOURCE_KIND_COUNT
+	};
+
+	struct MemoryDeviceFunctions {
+		void* user_data;
+		VkResult (*allocate)(void* user_data, uint32_t memory_type, VkDeviceSize size, VkDeviceMemory* out_memory);
+		void     (*free)(void* user_data, VkDeviceMemory memory);
+		// the whole allocation
+		VkResult (*map)(void* user_data, VkDeviceMemory memory, void** out_mapped);
+	};
+
+	// vkAllocateMemory, vkFreeMemory and vkMapMemory on `device`
+	MemoryDeviceFunctions memory_device_functions_vulkan(VkDevice device);
+
+	struct MemoryAllocation {
+		VkDeviceMemory memory;	// shared with the other allocations of the block, bind at `offset`
+		VkDeviceSize   offset;
+		VkDeviceSize   size;
+		void*          mapped;	// at `offset`, nullptr if the memory is not host visible
+		uint32_t       pool;
+		uint32_t       block;	// MEMORY_BLOCK_NONE for dedicated allocations
+		uint32_t       node;
+	};
+
+	const uint32_t TLSF_SL_BITS   = 4;
+	const uint32_t TLSF_SL_COUNT  = 1 << TLSF_SL_BITS;
+	// sizes below 256 bytes are all in the first level, `MEMORY_MIN_ALIGNMENT` apart
+	const uint32_t TLSF_FL_SHIFT  = TLSF_SL_BITS + 4;
+	const uint32_t TLSF_FL_COUNT  = 64 - TLSF_FL_SHIFT + 1;
+	const uint32_t TLSF_NODE_NONE = 0xFFFFFFFF;
+
+	// range of a block. Neighbours in the block are linked by `prev`/`next`, free ranges of the
+	// same size class by `prev_free`/`next_free`. Two free ranges are never neighbours
+	struct TlsfNode {
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		uint32_t     prev;
+		uint32_t     next;
+		uint32_t     prev_free;
+		uint32_t     next_free;
+		bool         is_free;
+	};
+
+	// node 0 is always the range at offset 0
+	struct TlsfBlock {
+		VkDeviceMemory memory;	// VK_NULL_HANDLE once released, the slot is reused by the next block
+		VkDeviceSize   size;
+		void*          mapped;
+		uint64_t       fl_bitmap;
+		uint32_t       sl_bitmap[TLSF_FL_COUNT];
+		uint32_t       free_heads[TLSF_FL_COUNT][TLSF_SL_COUNT];
+		std::vector<TlsfNode> nodes;
+		std::vector<uint32_t> unused_nodes;
+		uint32_t       allocation_count;
+		VkDeviceSize   used;
+	};
+
+	struct MemoryPool {
+		std::vector<TlsfBlock> blocks;
+	};
+
+	struct MemoryAllocator {
+		MemoryDeviceFunctions device;
+		VkDeviceSize          block_size;
+		uint32_t              memory_type_count;
+		VkMemoryPropertyFlags memory_type_flags[VK_MAX_MEMORY_TYPES];
+		// `memory_type * MEMORY_RESOURCE_KIND_COUNT + kind`
+		std::vector<MemoryPool> pools;
+		uint32_t     dedicated_count;
+		VkDeviceSize dedicated_size;
+		VkDeviceSize dedicated_used;
+		std::mutex   mutex;
+	};
+
+	struct MemoryStats {
+		uint32_t     device_allocations;	// live vkAllocateMemory, blocks + dedicated
+		uint32_t     blocks;
+		uint32_t     dedicated;
+		uint32_t     allocations;		// live suballocations, dedicated ones included
+		VkDeviceSize reserved;			// bytes allocated from the device
+		VkDeviceSize used;				// bytes of the live allocations, without padding
+		uint32_t     free_ranges;
+		VkDeviceSize largest_free_range;
+		float        fragmentation;		// 1 - largest free range / free bytes of the blocks
+	};
+
+	void memory_allocator_init(
+		MemoryAllocator* allocator,
+		const MemoryDeviceFunctions& device,
+		const VkPhysicalDeviceMemoryProperties& properties,
+		VkDeviceSize block_size = MEMORY_BLOCK_SIZE
+	);
+	// false if the device is out of memory, `out_allocation` is left empty
+	bool memory_alloc(
+		MemoryAllocator* allocator,
+		const VkMemoryRequirements& requirements,
+		uint32_t memory_type,
+		MemoryResourceKind kind,
+		MemoryAllocation* out_allocation
+	);
+	// the GPU must be done with the range. Empty allocations are ignored
+	void memory_free(MemoryAllocator* allocator, const MemoryAllocation& allocation);
+	MemoryStats memory_allocator_get_stats(MemoryAllocator* allocator);
+	void memory_allocator_print_stats(MemoryAllocator* allocator);
+	// releases every block, allocations still alive are reported as leaks
+	void memory_allocator_destroy(MemoryAllocator* allocator);
+}
@@ -35,6 +35,7 @@ namespace vkc {
 		VkBool32 is_present_supported(VkSurfaceKHR surface, uint32_t queue_family_index) const;
 		
 		uint32_t find_memory_type(uint32_t type_filter, VkMemoryPropertyFlags properties) const;
+		const VkPhysicalDeviceMemoryProperties& get_memory_properties() const { return m_memory_properties; }
 
 		const QueueFamilyIndices find_queue_families() const;
 
@@ -134,14 +134,22 @@ namespace vkc {
 		colorBlending.blendConstants[3] = 0.0f; // Optional
 
 		// push constants
-		VkPushConstantRange push_constant_range;
+		VkPushConstantRange push_constant_ranges[2];
 		uint32_t push_constant_range_count = 0;
 		if (m_config->size_push_constant_model > 0)
 		{
-			push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-			push_constant_range.offset     = 0;
-			push_constant_range.size       = m_config->size_push_constant_model;
-			push_constant_range_count = 1;
+			push_constant_ranges[push_constant_range_count].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+			push_constant_ranges[push_constant_range_count].offset     = 0;
+			push_constant_ranges[push_constant_range_count].size       = m_config->size_push_constant_model;
+			++push_constant_range_count;
+		}
+		// texture array layers of the material
+		if (m_config->flags & TEXTURE_ARRAYS)
+		{
+			push_constant_ranges[push_constant_range_count].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			push_constant_ranges[push_constant_range_count].offset     = PUSH_CONSTANT_OFFSET_MATERIAL_LAYERS;
+			push_constant_ranges[push_constant_range_count].size       = sizeof(DataUniformMaterialLayers);
+			++push_constant_range_count;
 		}
 
 		// pipeline assembly
@@ -149,7 +157,7 @@ namespace vkc {
 		pipelineLayoutInfo.setLayoutCount = 1;
 		pipelineLayoutInfo.pSetLayouts = &m_handle_descriptor_set_layout;
 		pipelineLayoutInfo.pushConstantRangeCount = push_constant_range_count;
-		pipelineLayoutInfo.pPushConstantRanges = &push_constant_range;
+		pipelineLayoutInfo.pPushConstantRanges = push_constant_ranges;
 
 		if (vkCreatePipelineLayout(m_handle_device, &pipelineLayoutInfo, NULL, &m_handle_pipeline_layout) != VK_SUCCESS)
 			CC_LOG(CC_ERROR, "failed to create pipeline layout!");
@@ -188,10 +196,11 @@ namespace vkc {
 			return;
 		vkDestroyPipelineLayout(m_handle_device, m_handle_pipeline_layout, NULL);
 		vkDestroyPipeline(m_handle_device, m_handle, NULL);
-		for (auto& handle : m_uniform_buffers)
-			vkDestroyBuffer(m_handle_device, handle, NULL);
-		for (auto& handle : m_uniform_buffers_memory)
-			vkFreeMemory(m_handle_device, handle, NULL);
+		for (size_t i = 0; i < m_uniform_buffers.size(); ++i)
+			m_obj_render_context->destroy_buffer(m_uniform_buffers[i], m_uniform_buffers_memory[i]);
+		m_uniform_buffers.clear();
+		m_uniform_buffers_memory.clear();
+		m_uniform_buffers_mapped.clear();
 	}
 
 	void Pipeline::create_descriptor_set_layout() {
@@ -252,7 +261,7 @@ namespace vkc {
 					&m_uniform_buffers[i],
 					&m_uniform_buffers_memory[i]
 				);
-				vkMapMemory(m_handle_device, m_uniform_buffers_memory[i], 0, bufferSize, 0, &m_uniform_buffers_mapped[i]);
+				m_uniform_buffers_mapped[i] = m_uniform_buffers_memory[i].mapped;
 			}
 		}
 	}
@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <core/VertexData.h>
+#include <core/MemoryAllocator.hpp>
 #include <vector>
 
 
@@ -10,8 +11,10 @@ namespace vkc {
 	class RenderPass;
 
 	enum PipelineConfigFlags : uint8_t {
-		DYNAMIC = 0b0001,
-		MULTI   = 0b0010
+		DYNAMIC          = 0b0001,
+		MULTI            = 0b0010,
+		COMPACT_VERTICES = 0b0100,	// VertexDataCompact, the renderer pushes DataUniformMeshQuantization after the model data
+		TEXTURE_ARRAYS   = 0b1000	// the first texture slots are 2D arrays, the renderer pushes DataUniformMaterialLayers
 	};
 
 	struct PipelineConfig {
@@ -40,6 +43,7 @@ namespace vkc {
 	const uint32_t PIPELINE_CONFIG_ID_SKYBOX = 0;
 	const uint32_t PIPELINE_CONFIG_ID_PBR    = 1;
 	const uint32_t PIPELINE_CONFIG_ID_UNLIT  = 2;
+	const uint32_t PIPELINE_CONFIG_ID_PBR_COMPACT = 3;
 	const PipelineConfig PIPELINE_CONFIGS[] = {
 		{
 			.vert_path = "res/shaders/skybox.vert.spv",
@@ -61,11 +65,12 @@ namespace vkc {
 			.size_uniform_data_frame    = sizeof(DataUniformFrame),
 			.size_uniform_data_material = sizeof(DataUniformMaterial),
 			.size_push_constant_model   = sizeof(DataUniformModel),
-			.texture_slots_count        = 4,
+			.texture_slots_count        = 6,
 			.vertex_binding_descriptors         = vertexData_getBindingDescriptions(),
 			.vertex_binding_descriptors_count   = vertexData_getBindingDescriptionsCount(),
 			.vertex_attribute_descriptors       = vertexData_getAttributeDescriptions(),
 			.vertex_attribute_descriptors_count = vertexData_getAttributeDescriptionsCount(),
+			.flags = TEXTURE_ARRAYS,
 			.face_culling_mode = VK_CULL_MODE_BACK_BIT
 		},
 		{
@@ -80,6 +85,20 @@ namespace vkc {
 			.vertex_attribute_descriptors       = vertexData_getAttributeDescriptions_Unlit(),
 			.vertex_attribute_descriptors_count = vertexData_getAttributeDescriptions_UnlitCount(),
 			.face_culling_mode = VK_CULL_MODE_BACK_BIT
+		},
+		{
+			.vert_path = "res/shaders/pbr_compact.vert.spv",
+			.frag_path = "res/shaders/pbr.frag.spv",
+			.size_uniform_data_frame    = sizeof(DataUniformFrame),
+			.size_uniform_data_material = sizeof(DataUniformMaterial),
+			.size_push_constant_model   = sizeof(DataUniformModelCompact),
+			.texture_slots_count        = 6,
+			.vertex_binding_descriptors         = vertexData_getBindingDescriptions_Compact(),
+			.vertex_binding_descriptors_count   = vertexData_getBindingDescriptionsCount_Compact(),
+			.vertex_attribute_descriptors       = vertexData_getAttributeDescriptions_Compact(),
+			.vertex_attribute_descriptors_count = vertexData_getAttributeDescriptions_CompactCount(),
+			.flags = COMPACT_VERTICES | TEXTURE_ARRAYS,
+			.face_culling_mode = VK_CULL_MODE_BACK_BIT
 		}
 	};
 
@@ -134,7 +153,7 @@ namespace vkc {
 
 		// frame data
 		std::vector<VkBuffer>		m_uniform_buffers;
-		std::vector<VkDeviceMemory>	m_uniform_buffers_memory;
+		std::vector<MemoryAllocation>	m_uniform_buffers_memory;
 		std::vector<void*>			m_uniform_buffers_mapped;
 	};
 }
\ No newline at end of file
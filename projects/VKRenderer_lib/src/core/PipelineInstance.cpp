@@ -36,10 +36,8 @@ namespace vkc {
 	PipelineInstance::~PipelineInstance() {
 		destroy_descriptor_sets();
 
-		for (auto& handle : m_uniform_buffers_material)
-			vkDestroyBuffer(m_handle_device, handle, NULL);
-		for (auto& handle : m_uniform_buffers_memory_material)
-			vkFreeMemory(m_handle_device, handle, NULL);
+		for (size_t i = 0; i < m_uniform_buffers_material.size(); ++i)
+			m_obj_render_context->destroy_buffer(m_uniform_buffers_material[i], m_uniform_buffers_memory_material[i]);
 
 		for(auto &sampler : m_texture_samplers)
 			vkDestroySampler(m_handle_device, sampler, NULL);
@@ -159,6 +157,20 @@ namespace vkc {
 			vkUpdateDescriptorSets(m_handle_device, m_pool_size_count, descriptor_writes.data(), 0, NULL);
 		}
 	}
+	bool PipelineInstance::replace_image_view(VkImageView old_view, VkImageView new_view) {
+		bool is_used = false;
+		for (VkImageView& view : m_image_views) {
+			if (view == old_view) {
+				view = new_view;
+				is_used = true;
+			}
+		}
+
+		if (is_used)
+			update_descriptor_sets();
+		return is_used;
+	}
+
 	void PipelineInstance::destroy_descriptor_sets() {
 		vkDestroyDescriptorPool(m_handle_device, m_descriptor_pool, VK_NULL_HANDLE);
 	}
@@ -183,7 +195,7 @@ namespace vkc {
 					&m_uniform_buffers_material[i],
 					&m_uniform_buffers_memory_material[i]
 				);
-				vkMapMemory(m_handle_device, m_uniform_buffers_memory_material[i], 0, bufferSize, 0, &m_uniform_buffers_mapped_material[i]);
+				m_uniform_buffers_mapped_material[i] = m_uniform_buffers_memory_material[i].mapped;
 			}
 		}
 	}
@@ -2,6 +2,8 @@
 
 #include <vulkan/vulkan.h>
 
+#include <core/MemoryAllocator.hpp>
+
 #include <vector>
 
 namespace vkc {
@@ -29,6 +31,9 @@ namespace vkc {
 
 		void create_descriptor_sets();
 		void update_descriptor_sets();
+		// hot reload of a texture, updates the descriptor sets if the instance uses `old_view`.
+		// None of the frames in flight may be using them
+		bool replace_image_view(VkImageView old_view, VkImageView new_view);
 		void destroy_descriptor_sets();
 
 		void bind_descriptor_sets(VkCommandBuffer command_buffer, uint32_t image_index);
@@ -54,7 +59,7 @@ namespace vkc {
 
 		// material data
 		std::vector<VkBuffer>			m_uniform_buffers_material;
-		std::vector<VkDeviceMemory>		m_uniform_buffers_memory_material;
+		std::vector<MemoryAllocation>	m_uniform_buffers_memory_material;
 		std::vector<void*>				m_uniform_buffers_mapped_material;
 		std::vector<VkSampler>			m_texture_samplers;
 
@@ -18,6 +18,16 @@ uint32_t get_block_size(VkFormat format) {
         case VK_FORMAT_BC5_SNORM_BLOCK:
         case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
         case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
             return 16;
         default:
             return 8;
@@ -28,6 +38,10 @@ uint32_t get_texel_size(VkFormat format) {
     switch(format) {
         case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
         case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
         case VK_FORMAT_R4G4_UNORM_PACK8:
         case VK_FORMAT_R8_UNORM:
         case VK_FORMAT_R8_SNORM:
@@ -41,6 +55,13 @@ uint32_t get_texel_size(VkFormat format) {
         case VK_FORMAT_BC5_UNORM_BLOCK:
         case VK_FORMAT_BC5_SNORM_BLOCK:
         case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC2_UNORM_BLOCK:
+        case VK_FORMAT_BC2_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+        case VK_FORMAT_BC6H_SFLOAT_BLOCK:
         case VK_FORMAT_R10X6_UNORM_PACK16:
         case VK_FORMAT_R12X4_UNORM_PACK16:
         case VK_FORMAT_A4R4G4B4_UNORM_PACK16:
@@ -139,6 +160,17 @@ uint32_t get_texel_size(VkFormat format) {
         case VK_FORMAT_R16G16B16_SINT:
         case VK_FORMAT_R16G16B16_SFLOAT:
             return 48;
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_USCALED:
+        case VK_FORMAT_R16G16B16A16_SSCALED:
+        case VK_FORMAT_R16G16B16A16_UINT:
+        case VK_FORMAT_R16G16B16A16_SINT:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32G32_UINT:
+        case VK_FORMAT_R32G32_SINT:
+        case VK_FORMAT_R32G32_SFLOAT:
+            return 64;
         case VK_FORMAT_R32G32B32_UINT:
         case VK_FORMAT_R32G32B32_SINT:
         case VK_FORMAT_R32G32B32_SFLOAT:
@@ -155,6 +187,14 @@ uint32_t get_texel_size(VkFormat format) {
     }
 }
 namespace vkc {
+    VkDeviceSize get_mip_level_size(VkFormat format, uint32_t width, uint32_t height) {
+        // block formats: `get_texel_size` is the bytes of a whole 4x4 block, partial blocks are padded.
+        // Other formats: it's the bits of a texel
+        if (get_block_size(format) == 16)
+            return (VkDeviceSize)((width + 3) / 4) * ((height + 3) / 4) * get_texel_size(format);
+        return (VkDeviceSize)width * height * get_texel_size(format) / 8;
+    }
+
 
     // TODO fix these long constructor? (dependency injection good I guess, not sure about this)
     RenderContext::RenderContext(
@@ -169,6 +209,8 @@ namespace vkc {
         m_obj_physical_device = physical_device;
         m_device = device;
 
+        memory_allocator_init(&m_memory_allocator, memory_device_functions_vulkan(device), physical_device->get_memory_properties());
+
         m_swapchain = std::make_unique<Swapchain>(physical_device->get_handle(), device, surface, window->get_current_extent());
 
         const uint32_t num_frames_in_flight = 3;
@@ -217,8 +259,13 @@ namespace vkc {
     }
 
     RenderContext::~RenderContext() {
-        Drawcall::destroy_resources(m_device);
+        Drawcall::destroy_resources(this);
+        // depth images and uniform buffers go back to the allocator before it's destroyed
+        m_render_passes.clear();
         vkDestroyCommandPool(m_device, m_command_pool, NULL);
+
+        memory_allocator_print_stats(&m_memory_allocator);
+        memory_allocator_destroy(&m_memory_allocator);
     }
 
     const VkPhysicalDeviceProperties& RenderContext::get_physical_device_properties() const {
@@ -354,38 +401,53 @@ namespace vkc {
         vkFreeCommandBuffers(m_device, m_command_pool, 1, &commandBuffer);
     }
 
-    void RenderContext::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size) {
+    void RenderContext::submit_single_time_commands(VkCommandBuffer commandBuffer, VkFence fence) {
+        CC_VK_CHECK(vkEndCommandBuffer(commandBuffer));
+
+        VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        CC_VK_CHECK(vkQueueSubmit(m_queue_graphic, 1, &submitInfo, fence));
+    }
+
+    void RenderContext::free_single_time_commands(VkCommandBuffer commandBuffer) {
+        vkFreeCommandBuffers(m_device, m_command_pool, 1, &commandBuffer);
+    }
+
+    void RenderContext::copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize dst_offset) {
         VkCommandBuffer cmdbuf = beginSingleTimeCommands();
         VkBufferCopy copyRegion = { 0 };
+        copyRegion.dstOffset = dst_offset;
         copyRegion.size = size;
         vkCmdCopyBuffer(cmdbuf, src, dst, 1, &copyRegion);
         endSingleTimeCommands(cmdbuf);
     }
 
-    void RenderContext::copy_buffer_to_image(VkBuffer buffer, VkImage image, const vkc::Assets::TextureData& data) {
+    void RenderContext::copy_buffer_to_image(VkBuffer buffer, VkImage image, const vkc::Assets::TextureData& data, uint32_t base_mip) {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        cmd_copy_buffer_to_image(commandBuffer, buffer, image, data, base_mip, data.mipmaps - base_mip);
+        endSingleTimeCommands(commandBuffer);
+    }
 
-        VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(data.mipmaps, sizeof(VkBufferImageCopy));
+    void RenderContext::cmd_copy_buffer_to_image(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, const vkc::Assets::TextureData& data, uint32_t base_mip, uint32_t mip_levels) {
+        VkBufferImageCopy* regions = (VkBufferImageCopy*)calloc(mip_levels, sizeof(VkBufferImageCopy));
 
         VkFormat f = (VkFormat)data.format;
-        uint32_t mip_level_w = data.width;
-        uint32_t mip_level_h = data.height;
+        uint32_t mip_level_w = glm::max((uint32_t)data.width  >> base_mip, 1u);
+        uint32_t mip_level_h = glm::max((uint32_t)data.height >> base_mip, 1u);
         VkDeviceSize buffer_offset = 0;
 
-
-        if (data.mipmaps > 1)
-            auto a = 0;
-
-        for(int i = 0; i < data.mipmaps; ++i)
+        for(uint32_t i = 0; i < mip_levels; ++i)
         {
             //VkBufferImageCopy& region = regions[i];
             regions[i].bufferOffset = buffer_offset;
             regions[i].bufferRowLength = 0;
             regions[i].bufferImageHeight = 0;
             regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            regions[i].imageSubresource.mipLevel = i;
+            regions[i].imageSubresource.mipLevel = base_mip + i;
             regions[i].imageSubresource.baseArrayLayer = 0;
-            regions[i].imageSubresource.layerCount = data.viewType == VK_IMAGE_VIEW_TYPE_CUBE ? 6 : 1;
+            regions[i].imageSubresource.layerCount = vkc::Assets::tex_get_layer_count(data);
             regions[i].imageOffset = (VkOffset3D){
                 .x = 0,
                 .y = 0,
@@ -397,25 +459,11 @@ namespace vkc {
                 .depth = 1
             };
 
-            VkDeviceSize texels_per_block = get_block_size(f);
-            VkDeviceSize bytes_per_texel = get_texel_size(f);
-            VkDeviceSize buffer_offset_add;
-
-
-            buffer_offset_add = mip_level_w * mip_level_h * bytes_per_texel / texels_per_block;
-            /*if (bytes_per_texel >= 16)
-                buffer_offset_add = mip_level_w * mip_level_h * bytes_per_texel / 16;
-            else if (bytes_per_texel < 16)
-                buffer_offset_add = mip_level_w * mip_level_h / (16 / bytes_per_texel);*/
-
-            buffer_offset += glm::max(buffer_offset_add, bytes_per_texel);
+            // cubemap faces and array layers of a level are contiguous
+            buffer_offset += get_mip_level_size(f, mip_level_w, mip_level_h) * regions[i].imageSubresource.layerCount;
 
-            // round
-            //CC_ASSERT(buffer_offset % block_size == 0, "ivalid block alignment");
-            /*if (buffer_offset % texel_size != 0)
-                buffer_offset += texel_size - buffer_offset % texel_size;*/
-            mip_level_w /= 2;
-            mip_level_h /= 2;
+            mip_level_w = glm::max(mip_level_w / 2, 1u);
+            mip_level_h = glm::max(mip_level_h / 2, 1u);
         }
 
         vkCmdCopyBufferToImage(
@@ -423,16 +471,14 @@ namespace vkc {
             buffer,
             image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            data.mipmaps,
+            mip_levels,
             regions
         );
 
         free(regions);
-
-        endSingleTimeCommands(commandBuffer);
     }
 
-    void RenderContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* pBuffer, VkDeviceMemory* pBufferMemory) {
+    void RenderContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer* pBuffer, MemoryAllocation* pBufferMemory) {
         VkBufferCreateInfo bufferInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
@@ -446,20 +492,27 @@ namespace vkc {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(m_device, *pBuffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = m_obj_physical_device->find_memory_type(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(m_device, &allocInfo, NULL, pBufferMemory) != VK_SUCCESS) {
+        uint32_t memory_type = m_obj_physical_device->find_memory_type(memRequirements.memoryTypeBits, properties);
+        if (!memory_alloc(&m_memory_allocator, memRequirements, memory_type, MEMORY_RESOURCE_BUFFER, pBufferMemory)) {
             CC_LOG(CC_ERROR, "failed to allocate buffer memory!");
+            return;
         }
 
-        vkBindBufferMemory(m_device, *pBuffer, *pBufferMemory, 0);
+        vkBindBufferMemory(m_device, *pBuffer, pBufferMemory->memory, pBufferMemory->offset);
     }
 
-    void RenderContext::transition_image_layout(VkImage image, uint32_t layers, uint32_t mip_levels, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout) {
+    void RenderContext::destroy_buffer(VkBuffer buffer, const MemoryAllocation& memory) {
+        vkDestroyBuffer(m_device, buffer, NULL);
+        memory_free(&m_memory_allocator, memory);
+    }
+
+    void RenderContext::transition_image_layout(VkImage image, uint32_t layers, uint32_t mip_levels, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t base_mip) {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+        cmd_transition_image_layout(commandBuffer, image, layers, base_mip, mip_levels, oldLayout, newLayout);
+        endSingleTimeCommands(commandBuffer);
+    }
 
+    void RenderContext::cmd_transition_image_layout(VkCommandBuffer commandBuffer, VkImage image, uint32_t layers, uint32_t base_mip, uint32_t mip_levels, VkImageLayout oldLayout, VkImageLayout newLayout) {
         VkImageMemoryBarrier barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
         barrier.oldLayout = oldLayout;
         barrier.newLayout = newLayout;
@@ -467,7 +520,7 @@ namespace vkc {
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.image = image;
         barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.baseMipLevel = base_mip;
         barrier.subresourceRange.levelCount = mip_levels;
         barrier.subresourceRange.baseArrayLayer = 0;
         barrier.subresourceRange.layerCount = layers;
@@ -501,11 +554,9 @@ namespace vkc {
             0, NULL,
             1, &barrier
         );
-
-        endSingleTimeCommands(commandBuffer);
     }
 
-    void RenderContext::create_image(uint32_t width, uint32_t height, uint32_t layers, uint32_t mip_levels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* pImage, VkDeviceMemory* pImageMemory) {
+    void RenderContext::create_image(uint32_t width, uint32_t height, uint32_t layers, uint32_t mip_levels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage* pImage, MemoryAllocation* pImageMemory) {
         VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
         imageInfo.imageType = VK_IMAGE_TYPE_2D;
         imageInfo.extent.width = width;
@@ -520,8 +571,8 @@ namespace vkc {
         imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-        if (layers > 1) {
-            // TMP FIXME handle cubemap
+        // cubemaps, texture arrays can have any number of layers (a square array of 6 gets the flag too, harmless)
+        if (layers == 6 && width == height) {
             imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
         }
 
@@ -532,27 +583,33 @@ namespace vkc {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(m_device, *pImage, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = m_obj_physical_device->find_memory_type(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(m_device, &allocInfo, NULL, pImageMemory) != VK_SUCCESS) {
+        // linear images are placed like buffers, granularity wise
+        MemoryResourceKind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? MEMORY_RESOURCE_IMAGE : MEMORY_RESOURCE_BUFFER;
+        uint32_t memory_type = m_obj_physical_device->find_memory_type(memRequirements.memoryTypeBits, properties);
+        if (!memory_alloc(&m_memory_allocator, memRequirements, memory_type, kind, pImageMemory)) {
             CC_LOG(CC_ERROR, "failed to allocate image memory!");
+            return;
         }
 
-        vkBindImageMemory(m_device, *pImage, *pImageMemory, 0);
+        vkBindImageMemory(m_device, *pImage, pImageMemory->memory, pImageMemory->offset);
+    }
+
+    void RenderContext::destroy_image(VkImage image, const MemoryAllocation& memory) {
+        vkDestroyImage(m_device, image, NULL);
+        memory_free(&m_memory_allocator, memory);
     }
 
-    VkImageView RenderContext::create_imge_view(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageViewType viewType, uint32_t mip_levels) {
+    VkImageView RenderContext::create_imge_view(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageViewType viewType, uint32_t mip_levels, uint32_t base_mip) {
         VkImageViewCreateInfo createInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         createInfo.image = image;
         createInfo.viewType = viewType;
         createInfo.format = format;
         createInfo.subresourceRange.aspectMask = aspectFlags;
-        createInfo.subresourceRange.baseMipLevel = 0;
+        createInfo.subresourceRange.baseMipLevel = base_mip;
         createInfo.subresourceRange.levelCount = mip_levels;
         createInfo.subresourceRange.baseArrayLayer = 0;
-        createInfo.subresourceRange.layerCount = viewType == VK_IMAGE_VIEW_TYPE_CUBE ? 6 : 1;
+        // 1 for 2D views, 6 for cubemaps, all of them for arrays
+        createInfo.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
 
         VkImageView imageView;
         if (vkCreateImageView(m_device, &createInfo, NULL, &imageView) != VK_SUCCESS) {
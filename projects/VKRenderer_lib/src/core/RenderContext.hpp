@@ -5,6 +5,7 @@
 #include <core/Swapchain.hpp>
 #include <core/RenderFrame.hpp>
 #include <core/RenderPass.hpp>
+#include <core/MemoryAllocator.hpp>
 
 #include <memory>
 
@@ -12,6 +13,9 @@ namespace vkc {
 	class Window;
 	class PhysicalDevice;
 
+	// bytes of one mip level as packed in TextureData::data, mips are stored back to back from level 0
+	VkDeviceSize get_mip_level_size(VkFormat format, uint32_t width, uint32_t height);
+
 	class RenderContext {
 	public:
 		RenderContext(
@@ -50,25 +54,47 @@ namespace vkc {
 		DataUniformFrame& get_ubo_reference() { return m_ubo; };
 
 		// memory utils
-		void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size);
+		void copyBuffer(VkBuffer src, VkBuffer dst, VkDeviceSize size, VkDeviceSize dst_offset = 0);
+		// copies the mips from `base_mip` to the last one, `buffer` starts with `base_mip`
 		void copy_buffer_to_image(
 			VkBuffer buffer,
 			VkImage image,
-			const vkc::Assets::TextureData& data
+			const vkc::Assets::TextureData& data,
+			uint32_t base_mip = 0
+		);
+		void cmd_copy_buffer_to_image(
+			VkCommandBuffer command_buffer,
+			VkBuffer buffer,
+			VkImage image,
+			const vkc::Assets::TextureData& data,
+			uint32_t base_mip,
+			uint32_t mip_levels
 		);
 		void createBuffer(
 			VkDeviceSize size,
 			VkBufferUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkBuffer* pBuffer,
-			VkDeviceMemory* pBufferMemory
+			MemoryAllocation* pBufferMemory
 		);
+		// buffer and its memory, the GPU must be done with it
+		void destroy_buffer(VkBuffer buffer, const MemoryAllocation& memory);
 		void transition_image_layout(
 			VkImage image,
 			uint32_t layers,
 			uint32_t mip_levels,
 			VkFormat format,
 			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			uint32_t base_mip = 0
+		);
+		void cmd_transition_image_layout(
+			VkCommandBuffer command_buffer,
+			VkImage image,
+			uint32_t layers,
+			uint32_t base_mip,
+			uint32_t mip_levels,
+			VkImageLayout oldLayout,
 			VkImageLayout newLayout
 		);
 		void create_image(
@@ -81,18 +107,26 @@ namespace vkc {
 			VkImageUsageFlags usage,
 			VkMemoryPropertyFlags properties,
 			VkImage* pImage,
-			VkDeviceMemory* pImageMemory
+			MemoryAllocation* pImageMemory
 		);
+		// image and its memory, views must be destroyed first
+		void destroy_image(VkImage image, const MemoryAllocation& memory);
+		MemoryStats get_memory_stats() { return memory_allocator_get_stats(&m_memory_allocator); };
 		VkImageView create_imge_view(
 			VkImage image,
 			VkFormat format,
 			VkImageAspectFlags aspectFlags,
 			VkImageViewType viewType,
-			uint32_t mip_levels
+			uint32_t mip_levels,
+			uint32_t base_mip = 0
 		);
 
 		VkCommandBuffer beginSingleTimeCommands();
 		void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+		// same as `endSingleTimeCommands` without waiting: `fence` signals once the commands are done,
+		// the command buffer is freed with `free_single_time_commands` after that
+		void submit_single_time_commands(VkCommandBuffer commandBuffer, VkFence fence);
+		void free_single_time_commands(VkCommandBuffer commandBuffer);
 	private:
 
 		Window * m_window;
@@ -111,6 +145,8 @@ namespace vkc {
 
 		// pools
 		VkCommandPool m_command_pool;
+		// memory of every buffer and image, see MemoryAllocator.hpp
+		MemoryAllocator m_memory_allocator;
 
 		/// Current active frame index
 		uint32_t m_active_frame_index{ 0 };
@@ -112,8 +112,27 @@ namespace vkc {
 		// draw calls =========================================================
 		vkc::RenderPass* obj_curr_render_pass = nullptr;
 		vkc::Pipeline* obj_curr_pipeline = nullptr;
+		// materials sharing their textures share the pipeline instance, and its descriptor sets
+		vkc::PipelineInstance* obj_curr_pipeline_instance = nullptr;
 		VkRenderPassBeginInfo begin_info;
 
+		// meshes share the geometry blocks, buffers are only bound when the block changes
+		VkBuffer    curr_vertex_buffer = VK_NULL_HANDLE;
+		VkBuffer    curr_index_buffer  = VK_NULL_HANDLE;
+		VkIndexType curr_index_type    = VK_INDEX_TYPE_MAX_ENUM;
+		auto bind_geometry = [&](const Drawcall::ModelDataGPU& model_data_gpu) {
+			if (model_data_gpu.vertex_buffer != curr_vertex_buffer) {
+				VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(m_command_buffer, 0, 1, &model_data_gpu.vertex_buffer, &offset);
+				curr_vertex_buffer = model_data_gpu.vertex_buffer;
+			}
+			if (model_data_gpu.index_buffer != curr_index_buffer || model_data_gpu.index_type != curr_index_type) {
+				vkCmdBindIndexBuffer(m_command_buffer, model_data_gpu.index_buffer, 0, model_data_gpu.index_type);
+				curr_index_buffer = model_data_gpu.index_buffer;
+				curr_index_type   = model_data_gpu.index_type;
+			}
+		};
+
 		vkc::Instance::TMP_get_singleton_instance()->begin_cmd_buffer_util_label(m_command_buffer, "drawcalls", (float[4]){ 1.0f, 0.0f, 0.0f, 1.0f });
 		//for(const auto& drawcall : drawcalls)
 		for(int i =0; i < drawcalls.size(); ++i)
@@ -142,17 +161,20 @@ namespace vkc {
 					obj_curr_pipeline->get_handle()
 				);
 				obj_curr_pipeline->update_uniform_buffer(&ubo, frame_index);
+				obj_curr_pipeline_instance = nullptr;
 			}
 
 			// update pipeline instance data
-			drawcall.obj_pipeline_instance->bind_descriptor_sets(
-				m_command_buffer,
-				frame_index);
+			if (drawcall.obj_pipeline_instance != obj_curr_pipeline_instance)
+			{
+				obj_curr_pipeline_instance = drawcall.obj_pipeline_instance;
+				obj_curr_pipeline_instance->bind_descriptor_sets(
+					m_command_buffer,
+					frame_index);
+			}
 			drawcall.obj_pipeline_instance->update_uniform_buffer_material(drawcall.data_uniform_material, frame_index);
 
 			Drawcall::ModelDataGPU model_data_gpu = Drawcall::get_model_data(drawcall.idx_data_attributes);
-			VkBuffer vertexBuffers[] = { model_data_gpu.vertex_buffer };
-			VkDeviceSize offsets[] = { 0 };
 
 			if (drawcall.data_uniform_model_size > 0)
 				vkCmdPushConstants(
@@ -164,10 +186,32 @@ namespace vkc {
 					drawcall.data_uniform_model
 				);
 
-			vkCmdBindVertexBuffers(m_command_buffer, 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(m_command_buffer, model_data_gpu.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+			// compact vertices are dequantized with the bounds of the mesh
+			if (obj_curr_pipeline->get_obj_config()->flags & COMPACT_VERTICES)
+				vkCmdPushConstants(
+					m_command_buffer,
+					obj_curr_pipeline->get_handle_layout(),
+					VK_SHADER_STAGE_VERTEX_BIT,
+					offsetof(DataUniformModelCompact, quantization),
+					sizeof(DataUniformMeshQuantization),
+					&model_data_gpu.quantization
+				);
+
+			// layers of the material textures in the arrays bound with the pipeline instance
+			if (obj_curr_pipeline->get_obj_config()->flags & TEXTURE_ARRAYS)
+				vkCmdPushConstants(
+					m_command_buffer,
+					obj_curr_pipeline->get_handle_layout(),
+					VK_SHADER_STAGE_FRAGMENT_BIT,
+					PUSH_CONSTANT_OFFSET_MATERIAL_LAYERS,
+					sizeof(DataUniformMaterialLayers),
+					&drawcall.data_material_layers
+				);
+
+			bind_geometry(model_data_gpu);
 
-			vkCmdDrawIndexed(m_command_buffer, model_data_gpu.indices_count, 1, 0, 0, 0);
+			uint32_t index_count = drawcall.index_count > 0 ? drawcall.index_count : model_data_gpu.indices_count;
+			vkCmdDrawIndexed(m_command_buffer, index_count, 1, model_data_gpu.first_index + drawcall.first_index, model_data_gpu.vertex_offset, 0);
 		}
 		vkc::Instance::TMP_get_singleton_instance()->end_cmd_buffer_util_label(m_command_buffer);
 
@@ -222,12 +266,9 @@ namespace vkc {
 
 
 			Drawcall::ModelDataGPU model_data_gpu = Drawcall::get_model_data(drawcall.idx_data_attributes);
-			VkBuffer vertexBuffers[] = { model_data_gpu.vertex_buffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(m_command_buffer, 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(m_command_buffer, model_data_gpu.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+			bind_geometry(model_data_gpu);
 
-			vkCmdDrawIndexed(m_command_buffer, model_data_gpu.indices_count, 1, 0, 0, 0);
+			vkCmdDrawIndexed(m_command_buffer, model_data_gpu.indices_count, 1, model_data_gpu.first_index, model_data_gpu.vertex_offset, 0);
 		}
 		vkc::Instance::TMP_get_singleton_instance()->end_cmd_buffer_util_label(m_command_buffer);
 		// ====================================================================
@@ -73,8 +73,7 @@ namespace vkc {
 
 	RenderPass::~RenderPass() {
 		vkDestroyImageView(m_handle_device, m_depth_image_view, NULL);
-		vkDestroyImage(m_handle_device, m_depth_image, NULL);
-		vkFreeMemory(m_handle_device, m_depth_image_memory, NULL);
+		m_obj_render_context->destroy_image(m_depth_image, m_depth_image_memory);
 
 		for (auto& handle : m_handle_framebuffers)
 			vkDestroyFramebuffer(m_handle_device, handle, NULL);
@@ -232,8 +231,7 @@ namespace vkc {
 
 	void RenderPass::handle_swapchain_destruction() {
 		vkDestroyImageView(m_handle_device, m_depth_image_view, NULL);
-		vkDestroyImage(m_handle_device, m_depth_image, NULL);
-		vkFreeMemory(m_handle_device, m_depth_image_memory, NULL);
+		m_obj_render_context->destroy_image(m_depth_image, m_depth_image_memory);
 
 		for (uint32_t i = 0; i < m_handle_framebuffers.size(); ++i)
 			vkDestroyFramebuffer(m_handle_device, m_handle_framebuffers[i], NULL);
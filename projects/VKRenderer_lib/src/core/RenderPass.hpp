@@ -5,6 +5,7 @@
 #include <core/Pipeline.hpp>
 #include <core/DebugPipeline.hpp>
 #include <core/PipelineInstance.hpp>
+#include <core/MemoryAllocator.hpp>
 
 #include <vector>
 #include <memory>
@@ -61,9 +62,9 @@ namespace vkc {
 
 		std::vector<std::unique_ptr<PipelineInstance>> m_pipeline_instances;
 
-		VkImage			m_depth_image;
-		VkDeviceMemory	m_depth_image_memory;
-		VkImageView		m_depth_image_view;
+		VkImage				m_depth_image;
+		MemoryAllocation	m_depth_image_memory;
+		VkImageView			m_depth_image_view;
 
 		// one per attachment, in attachment order
 
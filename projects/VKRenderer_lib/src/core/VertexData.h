@@ -123,6 +123,89 @@ inline const uint32_t vertexData_getAttributeDescriptionsCount() {
 }
 
 
+// =================================================================
+// base forward pass - compact vertices
+// =================================================================
+
+// pushed right after DataUniformModel by the renderer, from the mesh (see `PipelineConfigFlags::COMPACT_VERTICES`)
+typedef struct {
+    glm::vec4 position_offset;
+    glm::vec4 position_scale;
+} DataUniformMeshQuantization;
+
+typedef struct {
+    DataUniformModel            model;
+    DataUniformMeshQuantization quantization;
+} DataUniformModelCompact;
+
+// pushed to the fragment stage by the renderer, from the material (see `PipelineConfigFlags::TEXTURE_ARRAYS`).
+// Right after the largest model data, so that pbr and pbr_compact share the fragment shader
+typedef struct {
+    glm::uvec4 texture_layers;  // diffuse, arm, normal, unused
+} DataUniformMaterialLayers;
+static const uint32_t PUSH_CONSTANT_OFFSET_MATERIAL_LAYERS = sizeof(DataUniformModelCompact);
+static_assert(PUSH_CONSTANT_OFFSET_MATERIAL_LAYERS == 96, "layout(offset) of the material layers in pbr.frag");
+
+static const VkVertexInputBindingDescription bindingDescriptions_compact[] = {
+    (VkVertexInputBindingDescription) {
+        .binding = 0,
+        .stride = sizeof(VertexDataCompact),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+    }
+};
+static const uint32_t bindingDescriptionsCount_compact = sizeof(bindingDescriptions_compact) / sizeof(VkVertexInputBindingDescription);
+
+// same locations as `attributeDescriptions`, the fragment shader is shared
+static const VkVertexInputAttributeDescription attributeDescriptions_compact[] = {
+    (VkVertexInputAttributeDescription) {
+        .location = 0,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16B16A16_UNORM,
+        .offset = offsetof(VertexDataCompact, position),
+    },
+    (VkVertexInputAttributeDescription) {
+        .location = 1,
+        .binding = 0,
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .offset = offsetof(VertexDataCompact, color)
+    },
+    (VkVertexInputAttributeDescription) {
+        .location = 2,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SNORM,
+        .offset = offsetof(VertexDataCompact, normal)
+    },
+    (VkVertexInputAttributeDescription) {
+        .location = 3,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SNORM,
+        .offset = offsetof(VertexDataCompact, tangent)
+    },
+    (VkVertexInputAttributeDescription) {
+        .location = 4,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SFLOAT,
+        .offset = offsetof(VertexDataCompact, texCoords)
+    }
+};
+static const uint32_t attributeDescriptionsCount_compact = sizeof(attributeDescriptions_compact) / sizeof(VkVertexInputAttributeDescription);
+
+inline const VkVertexInputBindingDescription* vertexData_getBindingDescriptions_Compact() {
+    return bindingDescriptions_compact;
+}
+
+inline const uint32_t vertexData_getBindingDescriptionsCount_Compact() {
+    return bindingDescriptionsCount_compact;
+}
+
+inline const VkVertexInputAttributeDescription* vertexData_getAttributeDescriptions_Compact() {
+    return attributeDescriptions_compact;
+}
+
+inline const uint32_t vertexData_getAttributeDescriptions_CompactCount() {
+    return attributeDescriptionsCount_compact;
+}
+
 // =================================================================
 // VFX
 // =================================================================
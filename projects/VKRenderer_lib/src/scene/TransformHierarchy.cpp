@@ -0,0 +1,148 @@
+#include "TransformHierarchy.hpp"
+
+#include <JobPool.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define VKC_TRANSFORM_SSE 1
+    #include <emmintrin.h>
+#else
+    #define VKC_TRANSFORM_SSE 0
+#endif
+
+namespace vkc::Scene {
+    // `out` = `a` * `b`, column major. `out` can't alias the operands
+    static inline void mat4_mul(const glm::mat4& a, const glm::mat4& b, glm::mat4* out) {
+#if VKC_TRANSFORM_SSE
+        __m128 a0 = _mm_loadu_ps(&a[0][0]);
+        __m128 a1 = _mm_loadu_ps(&a[1][0]);
+        __m128 a2 = _mm_loadu_ps(&a[2][0]);
+        __m128 a3 = _mm_loadu_ps(&a[3][0]);
+
+        // column i of the product: columns of `a` weighted by column i of `b`
+        for (int i = 0; i < 4; ++i) {
+            __m128 column = _mm_mul_ps(a0, _mm_set1_ps(b[i][0]));
+            column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(b[i][1])));
+            column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(b[i][2])));
+            column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(b[i][3])));
+            _mm_storeu_ps(&(*out)[i][0], column);
+        }
+#else
+        *out = a * b;
+#endif
+    }
+
+    // parents of the range are up to date, nodes of the range are in depth first order
+    static void update_range(TransformHierarchy* hierarchy, NodeRange range) {
+        glm::mat4*      local  = hierarchy->local.data();
+        glm::mat4*      world  = hierarchy->world.data();
+        const uint32_t* parent = hierarchy->parent.data();
+        uint8_t*        flags  = hierarchy->flags.data();
+
+        for (uint32_t i = range.begin; i < range.end; ++i) {
+            if (parent[i] == Assets::NODE_NO_PARENT)
+                world[i] = local[i];
+            else
+                mat4_mul(world[parent[i]], local[i], &world[i]);
+            flags[i] = 0;
+        }
+    }
+
+    // subtrees larger than a job: the root is updated right away, its children are ranges of their own
+    static void push_subtree(TransformHierarchy* hierarchy, uint32_t node) {
+        uint32_t end = node + hierarchy->subtree_size[node];
+        if (hierarchy->subtree_size[node] <= TRANSFORM_NODES_PER_JOB) {
+            hierarchy->ranges.push_back({ .begin = node, .end = end });
+            return;
+        }
+
+        update_range(hierarchy, { .begin = node, .end = node + 1 });
+        for (uint32_t child = node + 1; child < end; child += hierarchy->subtree_size[child])
+            push_subtree(hierarchy, child);
+    }
+
+    uint32_t transform_hierarchy_add_model(TransformHierarchy* hierarchy, const Assets::ModelData& model, const glm::mat4& transform) {
+        uint32_t root  = (uint32_t)hierarchy->local.size();
+        uint32_t count = model.nodes_count;
+
+        hierarchy->local.insert(hierarchy->local.end(), model.nodes_transform, model.nodes_transform + count);
+        hierarchy->world.resize(root + count);
+        hierarchy->subtree_size.resize(root + count, 1);
+        hierarchy->flags.resize(root + count, 0);
+        for (uint32_t i = 0; i < count; ++i) {
+            uint32_t parent = model.nodes_parent[i];
+            hierarchy->parent.push_back(parent == Assets::NODE_NO_PARENT ? parent : root + parent);
+        }
+
+        // children come after their parent, sizes accumulate backwards
+        for (uint32_t i = root + count; i-- > root + 1;)
+            hierarchy->subtree_size[hierarchy->parent[i]] += hierarchy->subtree_size[i];
+
+        hierarchy->local[root] = transform * hierarchy->local[root];
+        hierarchy->flags[root] = NODE_DIRTY;
+        return root;
+    }
+
+    void transform_hierarchy_set_local(TransformHierarchy* hierarchy, uint32_t node, const glm::mat4& local) {
+        hierarchy->local[node] = local;
+        hierarchy->flags[node] |= NODE_DIRTY;
+
+        // ancestors of a node flagged before are flagged already
+        for (uint32_t i = hierarchy->parent[node]; i != Assets::NODE_NO_PARENT; i = hierarchy->parent[i]) {
+            if (hierarchy->flags[i] & NODE_DIRTY_BELOW)
+                break;
+            hierarchy->flags[i] |= NODE_DIRTY_BELOW;
+        }
+    }
+
+    uint32_t transform_hierarchy_update(TransformHierarchy* hierarchy) {
+        hierarchy->ranges.clear();
+
+        uint32_t num_updated = 0;
+        uint32_t count = (uint32_t)hierarchy->local.size();
+        for (uint32_t i = 0; i < count;) {
+            uint8_t flags = hierarchy->flags[i];
+            if (flags & NODE_DIRTY) {
+                push_subtree(hierarchy, i);
+                num_updated += hierarchy->subtree_size[i];
+                i += hierarchy->subtree_size[i];
+            }
+            else if (flags & NODE_DIRTY_BELOW) {
+                hierarchy->flags[i] = 0;
+                ++i;
+            }
+            else
+                i += hierarchy->subtree_size[i];
+        }
+
+        uint32_t num_range_nodes = 0;
+        for (const NodeRange& range : hierarchy->ranges)
+            num_range_nodes += range.end - range.begin;
+
+        if (num_range_nodes <= TRANSFORM_NODES_PER_JOB) {
+            for (const NodeRange& range : hierarchy->ranges)
+                update_range(hierarchy, range);
+            return num_updated;
+        }
+
+        // consecutive ranges batched up to TRANSFORM_NODES_PER_JOB nodes per job
+        Jobs::JobCounter jobs;
+        size_t first = 0;
+        uint32_t batch_nodes = 0;
+        for (size_t i = 0; i < hierarchy->ranges.size(); ++i) {
+            batch_nodes += hierarchy->ranges[i].end - hierarchy->ranges[i].begin;
+            bool is_last = i + 1 == hierarchy->ranges.size();
+            if (batch_nodes < TRANSFORM_NODES_PER_JOB && !is_last)
+                continue;
+
+            Jobs::job_pool_submit(&jobs, [hierarchy, first, last = i + 1]() {
+                for (size_t j = first; j < last; ++j)
+                    update_range(hierarchy, hierarchy->ranges[j]);
+            });
+            first = i + 1;
+            batch_nodes = 0;
+        }
+        Jobs::job_pool_wait(&jobs);
+
+        return num_updated;
+    }
+}
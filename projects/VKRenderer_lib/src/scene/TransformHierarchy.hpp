@@ -0,0 +1,50 @@
+#pragma once
+
+#include <AssetManager.hpp>
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+
+// world transforms of node hierarchies, structure of arrays
+//
+// - nodes are stored depth first, as models are flattened on import: parents come before their
+//   children and the subtree of node i is [i, i + subtree_size[i])
+// - setting a local transform flags the node dirty and its ancestors as having a dirty node below.
+//   The update walks down to the dirty nodes only and recomputes their subtrees in a single forward
+//   pass each, clean subtrees are skipped in one jump
+// - dirty subtrees are independent: large ones are split at their children, the ranges are updated
+//   on the job pool (inline when the pool is not running). Matrix products use SSE when available
+namespace vkc::Scene {
+	const uint8_t NODE_DIRTY       = 0x01;	// local changed, the whole subtree needs a new world
+	const uint8_t NODE_DIRTY_BELOW = 0x02;	// a node of the subtree is dirty
+
+	// nodes of a single range of an update
+	const uint32_t TRANSFORM_NODES_PER_JOB = 4096;
+
+	struct NodeRange {
+		uint32_t begin;
+		uint32_t end;
+	};
+
+	struct TransformHierarchy {
+		std::vector<glm::mat4> local;
+		std::vector<glm::mat4> world;
+		std::vector<uint32_t>  parent;			// Assets::NODE_NO_PARENT for roots
+		std::vector<uint32_t>  subtree_size;	// node included
+		std::vector<uint8_t>   flags;
+
+		// dirty subtrees of the running update, kept to not allocate every frame
+		std::vector<NodeRange> ranges;
+	};
+
+	// appends the nodes of `model` as a new root, `transform` places it. Returns the index of the root:
+	// node i of the model is `root + i`, mesh i is drawn with the world transform of `root + model.meshes_node[i]`
+	uint32_t transform_hierarchy_add_model(TransformHierarchy* hierarchy, const Assets::ModelData& model, const glm::mat4& transform);
+
+	void transform_hierarchy_set_local(TransformHierarchy* hierarchy, uint32_t node, const glm::mat4& local);
+
+	// recomputes the world transforms of the dirty subtrees, returns the number of nodes updated
+	uint32_t transform_hierarchy_update(TransformHierarchy* hierarchy);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// OS level watcher of directory trees (inotify on linux, ReadDirectoryChangesW on win32),
+// reports which files changed instead of just "something changed"
+//
+// - a file is reported once its writer closed it (or once it's moved into a watched directory,
+//   editors that save through a temporary file), so the content is complete when it's reported
+// - sub directories are watched too, including the ones created later
+// - paths are the watched directory followed by the path inside it, with forward slashes
+//   ("res/textures/tex_white.png"), matching the paths assets are loaded with
+namespace vkc::utils {
+	struct FileWatcher;
+
+	FileWatcher* file_watcher_create();
+	void         file_watcher_destroy(FileWatcher* watcher);
+
+	// recursive, false if `path` is not a readable directory
+	bool file_watcher_add_directory(FileWatcher* watcher, const char* path);
+
+	// appends the files changed since the last poll, each file once. Never blocks
+	void file_watcher_poll(FileWatcher* watcher, std::vector<std::string>* out_paths);
+}
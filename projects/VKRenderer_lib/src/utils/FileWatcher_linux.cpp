@@ -0,0 +1,133 @@
+#if defined(__linux__)
+
+#include "FileWatcher.hpp"
+
+#include <cc_logger.h>
+
+#include <sys/inotify.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+
+namespace vkc::utils {
+    // IN_CREATE only matters for directories, files are reported once they are closed
+    const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+
+    struct FileWatcher {
+        int fd;
+        std::map<int, std::string> directories; // watch descriptor -> directory
+    };
+
+    static void push_unique(std::vector<std::string>* paths, std::string path) {
+        if (std::find(paths->begin(), paths->end(), path) == paths->end())
+            paths->push_back(std::move(path));
+    }
+
+    static bool add_watch(FileWatcher* watcher, const std::string& directory) {
+        int wd = inotify_add_watch(watcher->fd, directory.c_str(), WATCH_MASK);
+        if (wd < 0) {
+            CC_LOG(CC_WARNING, "[file watcher] can't watch %s: %s", directory.c_str(), strerror(errno));
+            return false;
+        }
+        watcher->directories[wd] = directory;
+        return true;
+    }
+
+    // `directory` and all of its sub directories. With `out_files`, also reports the files
+    // already inside (directories created after the watch was set, their files could be missed)
+    static bool add_tree(FileWatcher* watcher, const std::string& directory, std::vector<std::string>* out_files) {
+        if (!add_watch(watcher, directory))
+            return false;
+
+        std::error_code error;
+        auto it = std::filesystem::recursive_directory_iterator(directory, error);
+        for (; !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            std::string path = it->path().generic_string();
+            if (it->is_directory(error))
+                add_watch(watcher, path);
+            else if (out_files)
+                push_unique(out_files, path);
+        }
+        return true;
+    }
+
+    FileWatcher* file_watcher_create() {
+        int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0) {
+            CC_LOG(CC_ERROR, "[file watcher] inotify_init1 failed: %s", strerror(errno));
+            return nullptr;
+        }
+
+        FileWatcher* watcher = new FileWatcher();
+        watcher->fd = fd;
+        return watcher;
+    }
+
+    void file_watcher_destroy(FileWatcher* watcher) {
+        if (!watcher)
+            return;
+        close(watcher->fd);
+        delete watcher;
+    }
+
+    bool file_watcher_add_directory(FileWatcher* watcher, const char* path) {
+        std::string directory = std::filesystem::path(path).lexically_normal().generic_string();
+        if (!directory.empty() && directory.back() == '/')
+            directory.pop_back();
+        return add_tree(watcher, directory, nullptr);
+    }
+
+    void file_watcher_poll(FileWatcher* watcher, std::vector<std::string>* out_paths) {
+        // large enough for a few events with the longest names
+        alignas(struct inotify_event) char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+
+        while (true) {
+            ssize_t size = read(watcher->fd, buffer, sizeof(buffer));
+            if (size <= 0) {
+                if (size < 0 && errno != EAGAIN && errno != EINTR)
+                    CC_LOG(CC_WARNING, "[file watcher] read failed: %s", strerror(errno));
+                if (size < 0 && errno == EINTR)
+                    continue;
+                return;
+            }
+
+            for (ssize_t offset = 0; offset < size;) {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+                offset += sizeof(struct inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW) {
+                    CC_LOG(CC_WARNING, "[file watcher] event queue overflow, some changes were lost");
+                    continue;
+                }
+
+                auto it = watcher->directories.find(event->wd);
+                if (it == watcher->directories.end())
+                    continue;
+
+                // directory deleted or moved away, the kernel already removed the watch
+                if (event->mask & IN_IGNORED) {
+                    watcher->directories.erase(it);
+                    continue;
+                }
+
+                if (event->len == 0)
+                    continue;
+
+                std::string path = it->second + "/" + event->name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                        add_tree(watcher, path, out_paths);
+                }
+                else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                    push_unique(out_paths, path);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,140 @@
+#if defined(_WIN32)
+
+#include "FileWatcher.hpp"
+
+#include <VulkanUtils.h>
+
+#include <windows.h>
+
+#include <algorithm>
+#include <filesystem>
+
+namespace vkc::utils {
+    // win32 has no "closed after write" notification, writes are reported as they happen:
+    // a large file can be reported before its writer is done with it
+    const DWORD NOTIFY_FILTER = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+    struct WatchedDirectory {
+        std::string path;
+        HANDLE      handle;
+        OVERLAPPED  overlapped;
+        // DWORD aligned, as required by ReadDirectoryChangesW
+        DWORD       buffer[16 * 1024];
+    };
+
+    struct FileWatcher {
+        std::vector<WatchedDirectory*> directories;
+    };
+
+    static bool issue_read(WatchedDirectory* directory) {
+        return ReadDirectoryChangesW(
+            directory->handle,
+            directory->buffer,
+            sizeof(directory->buffer),
+            TRUE,
+            NOTIFY_FILTER,
+            NULL,
+            &directory->overlapped,
+            NULL
+        );
+    }
+
+    FileWatcher* file_watcher_create() {
+        return new FileWatcher();
+    }
+
+    void file_watcher_destroy(FileWatcher* watcher) {
+        if (!watcher)
+            return;
+
+        for (WatchedDirectory* directory : watcher->directories) {
+            CancelIo(directory->handle);
+            CloseHandle(directory->overlapped.hEvent);
+            CloseHandle(directory->handle);
+            delete directory;
+        }
+        delete watcher;
+    }
+
+    bool file_watcher_add_directory(FileWatcher* watcher, const char* path) {
+        WatchedDirectory* directory = new WatchedDirectory();
+        directory->path = std::filesystem::path(path).lexically_normal().generic_string();
+        if (!directory->path.empty() && directory->path.back() == '/')
+            directory->path.pop_back();
+
+        directory->handle = CreateFileA(
+            path,
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            NULL
+        );
+        if (directory->handle == INVALID_HANDLE_VALUE) {
+            CC_LOG(CC_WARNING, "[file watcher] can't watch %s (error %lu)", path, GetLastError());
+            delete directory;
+            return false;
+        }
+
+        directory->overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (!issue_read(directory)) {
+            CC_LOG(CC_WARNING, "[file watcher] can't watch %s (error %lu)", path, GetLastError());
+            CloseHandle(directory->overlapped.hEvent);
+            CloseHandle(directory->handle);
+            delete directory;
+            return false;
+        }
+
+        watcher->directories.push_back(directory);
+        return true;
+    }
+
+    void file_watcher_poll(FileWatcher* watcher, std::vector<std::string>* out_paths) {
+        for (WatchedDirectory* directory : watcher->directories) {
+            DWORD size;
+            if (!GetOverlappedResult(directory->handle, &directory->overlapped, &size, FALSE))
+                continue;   // ERROR_IO_INCOMPLETE, nothing changed yet
+
+            if (size == 0)
+                CC_LOG(CC_WARNING, "[file watcher] change buffer overflow in %s, some changes were lost", directory->path.c_str());
+
+            for (DWORD offset = 0; size > 0;) {
+                const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)((const char*)directory->buffer + offset);
+
+                bool is_written =
+                    info->Action == FILE_ACTION_MODIFIED ||
+                    info->Action == FILE_ACTION_ADDED ||
+                    info->Action == FILE_ACTION_RENAMED_NEW_NAME;
+                if (is_written) {
+                    char name[MAX_PATH * 4];
+                    int length = WideCharToMultiByte(
+                        CP_UTF8, 0,
+                        info->FileName, info->FileNameLength / sizeof(WCHAR),
+                        name, sizeof(name),
+                        NULL, NULL
+                    );
+
+                    std::string path = directory->path + "/" + std::string(name, length);
+                    std::replace(path.begin(), path.end(), '\\', '/');
+
+                    // directories get "modified" when their content changes
+                    DWORD attributes = GetFileAttributesA(path.c_str());
+                    bool is_file = attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+                    if (is_file && std::find(out_paths->begin(), out_paths->end(), path) == out_paths->end())
+                        out_paths->push_back(path);
+                }
+
+                if (info->NextEntryOffset == 0)
+                    break;
+                offset += info->NextEntryOffset;
+            }
+
+            ResetEvent(directory->overlapped.hEvent);
+            if (!issue_read(directory))
+                CC_LOG(CC_WARNING, "[file watcher] stopped watching %s (error %lu)", directory->path.c_str(), GetLastError());
+        }
+    }
+}
+
+#endif
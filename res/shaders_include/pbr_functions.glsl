@@ -1,8 +1,6 @@
 #include "shader_base.glsl"
 #include "utils.glsl"
 
-const int MAX_LOD_LEVEL = 11;
-
 struct DataMaterial {
 	vec3 albedo;
 	float opacity;
@@ -14,11 +12,12 @@ struct DataMaterial {
 };
 
 vec3 BRDFDirect(vec3 L, vec3 N, vec3 V, DataMaterial mat);
-vec3 BRDFIndirect(vec3 L, vec3 N, vec3 V, DataMaterial mat, sampler2D tex_environment);
+vec3 BRDFIndirect(vec3 N, vec3 V, DataMaterial mat, sampler2D tex_env_specular, sampler2D tex_env_irradiance, sampler2D tex_brdf_lut);
 
 vec3 GetAlbedo(DataMaterial data);										// Get the surface albedo
 vec3 GetReflectance(DataMaterial data);									// Get the surface reflectance
-vec3 SampleEnvironment(vec3 direction, float lodLevel, sampler2D tex_environment);					// Sample the EnvironmentTexture cubemap
+vec3 SampleEnvironment(vec3 direction, float roughness, sampler2D tex_env_specular);	// Sample the prefiltered environment
+vec3 SampleIrradiance(vec3 direction, sampler2D tex_env_irradiance);					// Evaluate the SH irradiance
 float DistributionGGX(vec3 N, vec3 H, float roughness);					// GGX equation for distribution function
 float GeometrySmith(vec3 N, vec3 inDir, vec3 outDir, float roughness);	// Geometry term in both directions
 vec3 FresnelSchlick(vec3 f0, vec3 V, vec3 H);							// Schlick simplification of the Fresnel term
@@ -53,31 +52,24 @@ vec3 BRDFDirect(vec3 L, vec3 N, vec3 V, DataMaterial mat) {
 	return lighting;
 }
 
-vec3 BRDFIndirect(vec3 L, vec3 N, vec3 V, DataMaterial mat, sampler2D tex_environment) {
+// split sum approximation, environment baked offline by the AssetBaker (EnvironmentBaker.hpp)
+vec3 BRDFIndirect(vec3 N, vec3 V, DataMaterial mat, sampler2D tex_env_specular, sampler2D tex_env_irradiance, sampler2D tex_brdf_lut) {
 	// compute the indirect diffuse term
-//	vec3 diffuse = SampleEnvironment(N, 1.0, tex_environment) * mat.albedo;
-	vec3 diffuse = SampleEnvironment(N, 1.0, tex_environment) * GetAlbedo(mat);
-	
+	vec3 diffuse = SampleIrradiance(N, tex_env_irradiance) * GetAlbedo(mat);
+
 	// compute the indirect specular term
-	// Compute the reflection vector with the viewDir and the normal
+	// Sample the prefiltered environment with the reflection vector, the mip follows the roughness
 	vec3 reflectionDir = reflect(-V, N);
-	
-	// Sample the environment map using the reflection vector,
-	// at a specific LOD level
-	float lodLevel = pow(mat.roughness, 0.25);
-	
-	vec3 specular = clamp01(
-		SampleEnvironment(reflectionDir, lodLevel, tex_environment)
-		* GeometrySmith(N, reflectionDir, V, mat.roughness)
-	);
-	
-	// combine diffuse and specular, mantaining energy conservation
-	// Compute the Fresnel term between the normal and the view direction
-	vec3 fresnel = FresnelSchlick(GetReflectance(mat), V, N);
+	vec3 prefiltered = SampleEnvironment(reflectionDir, mat.roughness, tex_env_specular);
+
+	// scale and bias of f0 from the BRDF LUT, texel centers only to avoid wrapping around the edges
+	vec2 lutSize = vec2(textureSize(tex_brdf_lut, 0));
+	vec2 lutUV = clamp(vec2(clamped_dot(N, V), mat.roughness), 0.5 / lutSize, 1.0 - 0.5 / lutSize);
+	vec2 brdf = texture(tex_brdf_lut, lutUV).rg;
+	vec3 reflectance = GetReflectance(mat) * brdf.x + brdf.y;
 
-	return specular;
-	// Linearly interpolate between the diffuse and specular term
-	return mix(diffuse, specular, fresnel);
+	// light reflected by the specular term doesn't reach the diffuse one
+	return diffuse * (vec3(1.0) - reflectance) + prefiltered * reflectance;
 }
 
 // Get the surface albedo
@@ -92,19 +84,41 @@ vec3 GetReflectance(DataMaterial data)
 	return mix(vec3(0.04), data.albedo, data.metalness);
 }
 
-// Sample the EnvironmentTexture cubemap
-// lodLevel: between 0 and 1 to select from the highest to the lowest mipmap
-vec3 SampleEnvironment(vec3 direction, float lodLevel, sampler2D tex_environment)
+// Sample the prefiltered environment
+// roughness: between 0 and 1 to select from the highest to the lowest mipmap
+vec3 SampleEnvironment(vec3 direction, float roughness, sampler2D tex_env_specular)
 {
 	// Flip the Z direction, because the cubemap is left-handed
 	direction.z *= -1;
 
-	// // cubemap
-	// return texture(tex_environment, direction).rgb;
 	vec2 uv = uv_spherical_mapping(direction);
+	float maxLod = float(textureQueryLevels(tex_env_specular) - 1);
+	return textureLod(tex_env_specular, uv, roughness * maxLod).rgb;
+}
 
-//	return texture(tex_environment, uv).rgb;
-	return textureLod(tex_environment, uv, lodLevel * MAX_LOD_LEVEL).rgb;
+// Evaluate the irradiance, 2nd order SH with the cosine lobe and 1/PI already folded in the 9 coefficients
+vec3 SampleIrradiance(vec3 direction, sampler2D tex_env_irradiance)
+{
+	// same space as SampleEnvironment
+	vec3 d = normalize(direction);
+	d.z *= -1;
+
+	// one texel per coefficient, sampled at the texel centers
+	vec3 c[9];
+	for (int i = 0; i < 9; ++i)
+		c[i] = texture(tex_env_irradiance, vec2((float(i) + 0.5) / 9.0, 0.5)).rgb;
+
+	vec3 irradiance =
+		c[0] * 0.282095 +
+		c[1] * 0.488603 * d.y +
+		c[2] * 0.488603 * d.z +
+		c[3] * 0.488603 * d.x +
+		c[4] * 1.092548 * d.x * d.y +
+		c[5] * 1.092548 * d.y * d.z +
+		c[6] * 0.315392 * (3.0 * d.z * d.z - 1.0) +
+		c[7] * 1.092548 * d.x * d.z +
+		c[8] * 0.546274 * (d.x * d.x - d.y * d.y);
+	return max(irradiance, vec3(0.0));
 }
 
 // Geometry term in one direction, for GGX equation
@@ -17,17 +17,14 @@ vec3 get_implicit_normal(vec2 normal)
 	return vec3(normal, z);
 }
 
-// Sample texture map in tangent space and converts to the same space of the provided normal and tangent 
-vec3 sample_normal_map(sampler2D tex_normals, vec2 uvs, vec3 normal, vec3 tangent)
+// Converts a normal map texel (rg) in tangent space to the same space of the provided normal and tangent
+vec3 normal_from_map(vec2 normal_map, vec3 normal, vec3 tangent)
 {
 	// Build the tangent space base vectors
 	normal = normalize(normal);
 	vec3 bitangent = normalize(cross(normal, tangent));
 	tangent = cross(normal, bitangent);
 
-	// Read normalTexture
-	vec2 normal_map = texture(tex_normals, uvs).rg;
-
 	// // if DirectX normals, flip green channel
 	// THIS SHOULD BE DONE IN IMPORT!
 	normal_map.g = 1.0 - normal_map.g;
@@ -45,6 +42,18 @@ vec3 sample_normal_map(sampler2D tex_normals, vec2 uvs, vec3 normal, vec3 tangen
 
 }
 
+// Sample texture map in tangent space and converts to the same space of the provided normal and tangent 
+vec3 sample_normal_map(sampler2D tex_normals, vec2 uvs, vec3 normal, vec3 tangent)
+{
+	return normal_from_map(texture(tex_normals, uvs).rg, normal, tangent);
+}
+
+// same, from layer `layer` of a texture array
+vec3 sample_normal_map(sampler2DArray tex_normals, vec2 uvs, uint layer, vec3 normal, vec3 tangent)
+{
+	return normal_from_map(texture(tex_normals, vec3(uvs, layer)).rg, normal, tangent);
+}
+
 vec2 uv_spherical_mapping(vec3 dir){
 //	vec2 uv = vec2(
 //		0.5 + atan(fragViewDir.y, fragViewDir.x) / TAU,
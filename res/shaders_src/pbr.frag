@@ -4,13 +4,16 @@
 #include "utils.glsl"
 #include "pbr_functions.glsl"
 
-layout(binding = 2) uniform sampler2D   tex_albedo;
-layout(binding = 3) uniform sampler2D   tex_specular;
-layout(binding = 4) uniform sampler2D   tex_normal;
+// texture arrays shared by materials, the layers of this one are pushed per drawcall
+layout(binding = 2) uniform sampler2DArray tex_albedo;
+layout(binding = 3) uniform sampler2DArray tex_specular;
+layout(binding = 4) uniform sampler2DArray tex_normal;
 //layout(binding = TODO) uniform sampler2D   tex_emissive;
 
-//layout(binding = 5) uniform samplerCube tex_environment;
-layout(binding = 5) uniform sampler2D tex_environment;
+// image based lighting, see BRDFIndirect
+layout(binding = 5) uniform sampler2D tex_env_specular;
+layout(binding = 6) uniform sampler2D tex_env_irradiance;
+layout(binding = 7) uniform sampler2D tex_brdf_lut;
 
 layout(location = 0) in vec3 fragPosition;
 layout(location = 1) in vec3 fragColor;
@@ -20,12 +23,17 @@ layout(location = 4) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
+// DataUniformMaterialLayers, after the model data of pbr.vert and pbr_compact.vert
+layout(push_constant) uniform MaterialLayers {
+	layout(offset = 96) uvec4 texture_layers;	// albedo, specular, normal
+} data_material;
+
 void main() {
-	vec4 albedo = texture(tex_albedo, fragTexCoord);
+	vec4 albedo = texture(tex_albedo, vec3(fragTexCoord, data_material.texture_layers.x));
 //	vec4 emissive = texture(tex_emissive, fragTexCoord);
-	vec4 params_specular = texture(tex_specular, fragTexCoord);
+	vec4 params_specular = texture(tex_specular, vec3(fragTexCoord, data_material.texture_layers.y));
 
-	vec3 N = sample_normal_map(tex_normal, fragTexCoord, normalize(fragNormal), normalize(fragTangent));
+	vec3 N = sample_normal_map(tex_normal, fragTexCoord, data_material.texture_layers.z, normalize(fragNormal), normalize(fragTangent));
 //	vec3 V = normalize(data_frame.cam_pos - fragPosition);
 	vec3 V = normalize(get_camera_position(data_frame.view) - fragPosition);
 	vec3 L = normalize(data_frame.light_dir);
@@ -45,7 +53,7 @@ void main() {
 		final_color = clamp01(final_color + BRDFDirect(L, N, V, mat));
 
 	if((data_frame.DEBUG_light_components & DEBUG_LIGHT_COMPONENT_INDIRECT) != 0)
-		final_color = clamp01(final_color + BRDFIndirect(L, N, V, mat, tex_environment));
+		final_color = clamp01(final_color + BRDFIndirect(N, V, mat, tex_env_specular, tex_env_irradiance, tex_brdf_lut));
 
 	if((data_frame.DEBUG_light_components & DEBUG_LIGHT_COMPONENT_AMBIENT) != 0)
 		final_color += data_frame.light_ambient;
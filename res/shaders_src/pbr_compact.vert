@@ -0,0 +1,47 @@
+#include "shader_base.glsl"
+#include "data_uniform.glsl"
+
+// same as pbr.vert, for VertexDataCompact
+layout(push_constant) uniform ModelData {
+    mat4 model;
+    vec4 position_offset;
+    vec4 position_scale;
+} data_model;
+
+layout(location = 0) in vec4 inPosition;   // unorm16, mesh bounds
+layout(location = 1) in vec4 inColor;      // unorm8
+layout(location = 2) in vec2 inNormal;     // octahedral, snorm16
+layout(location = 3) in vec2 inTangent;    // octahedral, snorm16
+layout(location = 4) in vec2 inTexCoord;   // half
+
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out vec3 fragColor;
+layout(location = 2) out vec3 fragNormal;
+layout(location = 3) out vec3 fragTangent;
+layout(location = 4) out vec2 fragTexCoord;
+
+vec3 oct_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    // the unorm attribute is already normalized to [0, 1] in the mesh bounds
+    vec3 position = data_model.position_offset.xyz + inPosition.xyz * data_model.position_scale.xyz;
+
+    vec4 world_pos     = data_model.model * vec4(position, 1.0);
+    vec4 world_normal  = data_model.model * vec4(oct_decode(inNormal),  0.0);
+    vec4 world_tangent = data_model.model * vec4(oct_decode(inTangent), 0.0);
+
+    gl_Position = data_frame.proj * data_frame.view * world_pos;
+
+    fragPosition = world_pos.xyz;
+    fragColor    = inColor.rgb;
+    fragNormal   = world_normal.xyz;
+    fragTangent  = world_tangent.xyz;
+    fragTexCoord = inTexCoord;
+}
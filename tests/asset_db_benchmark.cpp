@@ -0,0 +1,108 @@
+#include <AssetManager.hpp>
+#include <JobPool.hpp>
+
+#include <cc_logger.h>
+
+#include <chrono>
+#include <filesystem>
+#include <stdint.h>
+
+// compares the legacy (read + copy) asset db against the mapped one, stored raw and compressed.
+// needs a baked `res/asset_db.bin` (run AssetBaker first)
+//
+// - load:         time spent in the load call alone
+// - load + touch: load, then read every vertex, index and pixel byte once (what an upload does)
+// - MB/s are of asset bytes, "file" is the same time over the size on disk
+
+const char* PATH_DB        = "res/asset_db.bin";
+const char* PATH_DB_RAW    = "res/asset_db_raw.bin";
+const char* PATH_DB_LZ     = "res/asset_db_lz.bin";
+const char* PATH_DB_LEGACY = "res/asset_db_legacy.bin";
+const int   NUM_RUNS       = 8;
+
+using Clock = std::chrono::high_resolution_clock;
+
+uint64_t touch_all_assets(uint64_t* total_bytes) {
+    uint64_t checksum = 0;
+    uint64_t bytes = 0;
+
+    for (const vkc::Assets::MeshData& data : vkc::Assets::get_mesh_assets().data) {
+        const unsigned char* vertices = (const unsigned char*)data.vertex_data;
+        uint64_t vertex_bytes = (uint64_t)data.vertex_count * data.vertex_data_size;
+        for (uint64_t j = 0; j < vertex_bytes; ++j)
+            checksum += vertices[j];
+        const unsigned char* indices = (const unsigned char*)data.index_data;
+        uint64_t index_bytes = (uint64_t)data.index_count * vkc::Assets::mesh_get_index_size(data);
+        for (uint64_t j = 0; j < index_bytes; ++j)
+            checksum += indices[j];
+        bytes += vertex_bytes + index_bytes;
+    }
+
+    for (const vkc::Assets::TextureData& data : vkc::Assets::get_texture_assets().data) {
+        for (unsigned char c : data.data)
+            checksum += c;
+        bytes += data.data.size();
+    }
+
+    *total_bytes = bytes;
+    return checksum;
+}
+
+void run_benchmark(const char* name, const char* path, void (*fn_load)(const char*)) {
+    double   time_load  = 0;
+    double   time_touch = 0;
+    uint64_t bytes      = 0;
+    uint64_t checksum   = 0;
+
+    for (int i = 0; i < NUM_RUNS; ++i) {
+        auto t0 = Clock::now();
+        fn_load(path);
+        auto t1 = Clock::now();
+        checksum = touch_all_assets(&bytes);
+        auto t2 = Clock::now();
+        vkc::Assets::asset_db_unload();
+
+        time_load  += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        time_touch += std::chrono::duration<double, std::milli>(t2 - t0).count();
+    }
+
+    time_load  /= NUM_RUNS;
+    time_touch /= NUM_RUNS;
+    double mb      = bytes / (1024.0 * 1024.0);
+    double mb_file = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+    CC_LOG(CC_IMPORTANT, "%-8s load %8.2fms (%8.1f MB/s, file %8.1f MB/s) | load + touch %8.2fms (%8.1f MB/s) | %.1fMB, %.1fMB on disk, checksum %llu",
+        name,
+        time_load,  mb / (time_load  / 1000.0), mb_file / (time_load / 1000.0),
+        time_touch, mb / (time_touch / 1000.0),
+        mb,
+        mb_file,
+        (unsigned long long)checksum
+    );
+}
+
+int main(void) {
+    // compressed chunks are decoded on all cores
+    vkc::Jobs::job_pool_init();
+
+    // write the other copies from the same content
+    vkc::Assets::asset_db_load(PATH_DB);
+    if (vkc::Assets::get_num_mesh_assets() == 0 && vkc::Assets::get_num_texture_assets() == 0) {
+        CC_LOG(CC_ERROR, "%s missing or empty, run AssetBaker first", PATH_DB);
+        return 1;
+    }
+    vkc::Assets::asset_db_dump_legacy(PATH_DB_LEGACY);
+    vkc::Assets::asset_db_dump(PATH_DB_RAW, false);
+    vkc::Assets::asset_db_dump(PATH_DB_LZ,  true);
+    vkc::Assets::asset_db_unload();
+
+    // first runs warm up the OS file cache for all files
+    run_benchmark("legacy", PATH_DB_LEGACY, vkc::Assets::asset_db_load_legacy);
+    run_benchmark("mapped", PATH_DB_RAW,    vkc::Assets::asset_db_load);
+    run_benchmark("lz",     PATH_DB_LZ,     vkc::Assets::asset_db_load);
+    run_benchmark("legacy", PATH_DB_LEGACY, vkc::Assets::asset_db_load_legacy);
+    run_benchmark("mapped", PATH_DB_RAW,    vkc::Assets::asset_db_load);
+    run_benchmark("lz",     PATH_DB_LZ,     vkc::Assets::asset_db_load);
+
+    vkc::Jobs::job_pool_shutdown();
+    return 0;
+}
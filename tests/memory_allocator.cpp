@@ -0,0 +1,278 @@
+#include <core/MemoryAllocator.hpp>
+
+#include <cc_logger.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <map>
+#include <vector>
+
+// checks of the device memory suballocator against a mock device, no GPU needed
+//
+// - allocations are aligned, in bounds and never overlap
+// - freed ranges merge back, blocks are reused and released
+// - large resources get dedicated allocations, buffers and images never share a block
+// - a failing device is reported, then a fragmentation stress run prints the stats
+// returns the number of failed checks
+
+const VkDeviceSize BLOCK_SIZE = 1024 * 1024;
+const uint32_t     MEMORY_TYPE_DEVICE = 0;
+const uint32_t     MEMORY_TYPE_HOST   = 1;
+
+int failures = 0;
+#define CHECK(x) { if (!(x)) { CC_LOG(CC_ERROR, "%s:%d: %s", __FILE__, __LINE__, #x); ++failures; } }
+
+// hands out fake handles, host memory backs the mappings
+struct MockDevice {
+    uint64_t next_handle  = 1;
+    uint32_t live_count   = 0;
+    uint32_t total_count  = 0;
+    bool     is_exhausted = false;
+    std::map<VkDeviceMemory, std::vector<unsigned char>> memory;
+};
+
+VkResult mock_allocate(void* user_data, uint32_t memory_type, VkDeviceSize size, VkDeviceMemory* out_memory) {
+    MockDevice* device = (MockDevice*)user_data;
+    if (device->is_exhausted)
+        return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+    *out_memory = (VkDeviceMemory)(uintptr_t)device->next_handle++;
+    device->memory[*out_memory].resize(size);
+    ++device->live_count;
+    ++device->total_count;
+    return VK_SUCCESS;
+}
+
+void mock_free(void* user_data, VkDeviceMemory memory) {
+    MockDevice* device = (MockDevice*)user_data;
+    CHECK(device->memory.erase(memory) == 1);
+    --device->live_count;
+}
+
+VkResult mock_map(void* user_data, VkDeviceMemory memory, void** out_mapped) {
+    MockDevice* device = (MockDevice*)user_data;
+    *out_mapped = device->memory[memory].data();
+    return VK_SUCCESS;
+}
+
+VkPhysicalDeviceMemoryProperties mock_memory_properties() {
+    VkPhysicalDeviceMemoryProperties properties = { };
+    properties.memoryTypeCount = 2;
+    properties.memoryTypes[MEMORY_TYPE_DEVICE].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    properties.memoryTypes[MEMORY_TYPE_HOST].propertyFlags   = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    return properties;
+}
+
+void init(vkc::MemoryAllocator* allocator, MockDevice* device) {
+    vkc::MemoryDeviceFunctions functions = {
+        .user_data = device,
+        .allocate  = mock_allocate,
+        .free      = mock_free,
+        .map       = mock_map
+    };
+    vkc::memory_allocator_init(allocator, functions, mock_memory_properties(), BLOCK_SIZE);
+}
+
+vkc::MemoryAllocation alloc(vkc::MemoryAllocator* allocator, VkDeviceSize size, VkDeviceSize alignment, uint32_t memory_type, vkc::MemoryResourceKind kind = vkc::MEMORY_RESOURCE_BUFFER) {
+    VkMemoryRequirements requirements = { .size = size, .alignment = alignment, .memoryTypeBits = 1u << memory_type };
+    vkc::MemoryAllocation allocation;
+    CHECK(vkc::memory_alloc(allocator, requirements, memory_type, kind, &allocation));
+    return allocation;
+}
+
+bool overlaps(const vkc::MemoryAllocation& a, const vkc::MemoryAllocation& b) {
+    return a.memory == b.memory && a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+void test_alignment_and_overlap() {
+    MockDevice device;
+    vkc::MemoryAllocator allocator;
+    init(&allocator, &device);
+
+    std::vector<vkc::MemoryAllocation> allocations;
+    uint32_t seed = 1;
+    for (int i = 0; i < 200; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        VkDeviceSize size      = 1 + (seed >> 8) % 20000;
+        VkDeviceSize alignment = 1ull << ((seed >> 4) % 13);
+        vkc::MemoryAllocation allocation = alloc(&allocator, size, alignment, MEMORY_TYPE_HOST);
+        CHECK(allocation.offset % alignment == 0);
+        CHECK(allocation.offset + size <= BLOCK_SIZE);
+        CHECK(allocation.mapped == device.memory[allocation.memory].data() + allocation.offset);
+        for (const vkc::MemoryAllocation& other : allocations)
+            CHECK(!overlaps(allocation, other));
+        allocations.push_back(allocation);
+    }
+    CHECK(device.live_count < 10);
+
+    // every other one, then the rest: ranges merge back into a single free range per block
+    for (size_t i = 0; i < allocations.size(); i += 2)
+        vkc::memory_free(&allocator, allocations[i]);
+    for (size_t i = 1; i < allocations.size(); i += 2)
+        vkc::memory_free(&allocator, allocations[i]);
+
+    vkc::MemoryStats stats = vkc::memory_allocator_get_stats(&allocator);
+    CHECK(stats.allocations == 0);
+    CHECK(stats.used == 0);
+    CHECK(stats.blocks == 1);
+    CHECK(stats.free_ranges == 1);
+    CHECK(stats.largest_free_range == BLOCK_SIZE);
+    CHECK(stats.fragmentation == 0.0f);
+    CHECK(device.live_count == 1);
+
+    vkc::memory_allocator_destroy(&allocator);
+    CHECK(device.live_count == 0);
+}
+
+void test_block_reuse() {
+    MockDevice device;
+    vkc::MemoryAllocator allocator;
+    init(&allocator, &device);
+
+    // 4 quarters fill the first block exactly
+    std::vector<vkc::MemoryAllocation> quarters;
+    for (int i = 0; i < 4; ++i)
+        quarters.push_back(alloc(&allocator, BLOCK_SIZE / 4, 256, MEMORY_TYPE_DEVICE));
+    CHECK(device.total_count == 1);
+    for (const vkc::MemoryAllocation& allocation : quarters)
+        CHECK(allocation.mapped == nullptr);
+
+    vkc::MemoryAllocation extra = alloc(&allocator, 4096, 256, MEMORY_TYPE_DEVICE);
+    CHECK(device.total_count == 2);
+    CHECK(extra.block != quarters[0].block);
+
+    // a freed quarter is reused in place, no new block
+    vkc::memory_free(&allocator, quarters[2]);
+    quarters[2] = alloc(&allocator, BLOCK_SIZE / 4, 256, MEMORY_TYPE_DEVICE);
+    CHECK(device.total_count == 2);
+    CHECK(quarters[2].offset == 2 * BLOCK_SIZE / 4);
+
+    // the emptied second block is released, the first one is kept once empty
+    vkc::memory_free(&allocator, extra);
+    CHECK(device.live_count == 1);
+    for (const vkc::MemoryAllocation& allocation : quarters)
+        vkc::memory_free(&allocator, allocation);
+    CHECK(device.live_count == 1);
+
+    // the released slot is taken by the next block
+    for (int i = 0; i < 4; ++i)
+        quarters[i] = alloc(&allocator, BLOCK_SIZE / 4, 256, MEMORY_TYPE_DEVICE);
+    extra = alloc(&allocator, 4096, 256, MEMORY_TYPE_DEVICE);
+    CHECK(extra.block == 1);
+    CHECK(device.live_count == 2);
+
+    // still alive, reported as leaks and released anyway
+    vkc::memory_allocator_destroy(&allocator);
+    CHECK(device.live_count == 0);
+}
+
+void test_dedicated_and_pools() {
+    MockDevice device;
+    vkc::MemoryAllocator allocator;
+    init(&allocator, &device);
+
+    vkc::MemoryAllocation large = alloc(&allocator, BLOCK_SIZE / 2 + 1, 256, MEMORY_TYPE_HOST);
+    CHECK(large.block == vkc::MEMORY_BLOCK_NONE);
+    CHECK(large.offset == 0);
+    CHECK(large.mapped == device.memory[large.memory].data());
+
+    vkc::MemoryStats stats = vkc::memory_allocator_get_stats(&allocator);
+    CHECK(stats.dedicated == 1);
+    CHECK(stats.blocks == 0);
+    CHECK(stats.reserved == BLOCK_SIZE / 2 + 1);
+
+    vkc::memory_free(&allocator, large);
+    CHECK(device.live_count == 0);
+
+    // same memory type, different kinds: separate blocks
+    vkc::MemoryAllocation buffer = alloc(&allocator, 1024, 16, MEMORY_TYPE_DEVICE, vkc::MEMORY_RESOURCE_BUFFER);
+    vkc::MemoryAllocation image  = alloc(&allocator, 1024, 16, MEMORY_TYPE_DEVICE, vkc::MEMORY_RESOURCE_IMAGE);
+    CHECK(buffer.memory != image.memory);
+    CHECK(buffer.pool != image.pool);
+
+    // same kind, different memory types: separate blocks too
+    vkc::MemoryAllocation host = alloc(&allocator, 1024, 16, MEMORY_TYPE_HOST, vkc::MEMORY_RESOURCE_BUFFER);
+    CHECK(host.memory != buffer.memory);
+    CHECK(device.live_count == 3);
+
+    vkc::memory_free(&allocator, buffer);
+    vkc::memory_free(&allocator, image);
+    vkc::memory_free(&allocator, host);
+    vkc::memory_free(&allocator, { });	// empty allocations are ignored
+    vkc::memory_allocator_destroy(&allocator);
+    CHECK(device.live_count == 0);
+}
+
+void test_out_of_memory() {
+    MockDevice device;
+    vkc::MemoryAllocator allocator;
+    init(&allocator, &device);
+
+    device.is_exhausted = true;
+    VkMemoryRequirements requirements = { .size = 1024, .alignment = 16, .memoryTypeBits = 1 };
+    vkc::MemoryAllocation allocation;
+    CHECK(!vkc::memory_alloc(&allocator, requirements, MEMORY_TYPE_DEVICE, vkc::MEMORY_RESOURCE_BUFFER, &allocation));
+    CHECK(allocation.memory == VK_NULL_HANDLE);
+
+    // the failed block doesn't stay around
+    device.is_exhausted = false;
+    allocation = alloc(&allocator, 1024, 16, MEMORY_TYPE_DEVICE);
+    CHECK(allocation.block == 0);
+    CHECK(vkc::memory_allocator_get_stats(&allocator).blocks == 1);
+
+    vkc::memory_free(&allocator, allocation);
+    vkc::memory_allocator_destroy(&allocator);
+    CHECK(device.live_count == 0);
+}
+
+// many short and long lived resources of mixed sizes, what a level load followed by streaming looks like
+void test_fragmentation_stress() {
+    MockDevice device;
+    vkc::MemoryAllocator allocator;
+    init(&allocator, &device);
+
+    std::vector<vkc::MemoryAllocation> allocations;
+    uint32_t seed = 7;
+    for (int i = 0; i < 20000; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        if (!allocations.empty() && (seed >> 16) % 3 == 0) {
+            size_t index = (seed >> 4) % allocations.size();
+            vkc::memory_free(&allocator, allocations[index]);
+            allocations[index] = allocations.back();
+            allocations.pop_back();
+            continue;
+        }
+        VkDeviceSize size = (seed >> 20) % 8 == 0 ? 64 * 1024 + (seed >> 8) % (128 * 1024) : 256 + (seed >> 8) % 4096;
+        vkc::MemoryAllocation allocation = alloc(&allocator, size, 256, MEMORY_TYPE_DEVICE);
+        CHECK(allocation.offset % 256 == 0);
+        allocations.push_back(allocation);
+    }
+
+    vkc::MemoryStats stats = vkc::memory_allocator_get_stats(&allocator);
+    CHECK(stats.allocations == allocations.size());
+    CHECK(stats.device_allocations == device.live_count);
+    CHECK(stats.used <= stats.reserved);
+    CC_LOG(CC_INFO, "%d resources in %d device allocations (%d made over the run)", stats.allocations, stats.device_allocations, device.total_count);
+    vkc::memory_allocator_print_stats(&allocator);
+
+    for (const vkc::MemoryAllocation& allocation : allocations)
+        vkc::memory_free(&allocator, allocation);
+    stats = vkc::memory_allocator_get_stats(&allocator);
+    CHECK(stats.allocations == 0);
+    CHECK(stats.blocks == 1);
+    CHECK(stats.free_ranges == 1);
+
+    vkc::memory_allocator_destroy(&allocator);
+    CHECK(device.live_count == 0);
+}
+
+int main(int argc, char** argv) {
+    test_alignment_and_overlap();
+    test_block_reuse();
+    test_dedicated_and_pools();
+    test_out_of_memory();
+    test_fragmentation_stress();
+
+    if (failures == 0)
+        CC_LOG(CC_IMPORTANT, "memory allocator: all checks passed");
+    return failures;
+}
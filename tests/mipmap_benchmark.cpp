@@ -0,0 +1,108 @@
+#include <MipGenerator.hpp>
+#include <JobPool.hpp>
+
+#include <cc_logger.h>
+
+#include <chrono>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+// mip chain generation throughput, in MB of level 0 read per second.
+// Synthetic 2048x2048 textures, so that no asset is needed
+//
+// - every channel layout, 8 bit sRGB / 8 bit linear / 32 bit float
+// - box and Kaiser filters
+// - single thread (pool not started) and all cores
+
+const uint32_t SIZE     = 2048;
+const int      NUM_RUNS = 4;
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Case {
+    const char*                  name;
+    vkc::Assets::TexChannelTypes channels;
+    bool                         is_float;
+    bool                         is_srgb;
+};
+
+const Case CASES[] = {
+    { "grey     u8",     vkc::Assets::TEX_CHANNELS_GREY,   false, false },
+    { "grey_a   u8",     vkc::Assets::TEX_CHANNELS_GREY_A, false, false },
+    { "rgb      u8",     vkc::Assets::TEX_CHANNELS_RGB,    false, false },
+    { "rgb      u8 srgb", vkc::Assets::TEX_CHANNELS_RGB,   false, true  },
+    { "rgb_a    u8 srgb", vkc::Assets::TEX_CHANNELS_RGB_A, false, true  },
+    { "rgb      f32",    vkc::Assets::TEX_CHANNELS_RGB,    true,  false },
+    { "rgb_a    f32",    vkc::Assets::TEX_CHANNELS_RGB_A,  true,  false },
+};
+
+void run_benchmark(const char* threads, const Case& c, vkc::Assets::MipFilter filter) {
+    uint32_t num_channels = vkc::Assets::tex_get_num_channels(c.channels);
+    size_t   texel_size   = num_channels * (c.is_float ? sizeof(float) : sizeof(uint8_t));
+    size_t   level0_size  = (size_t)SIZE * SIZE * texel_size;
+
+    // random texels, the filters cost the same on any content
+    std::vector<unsigned char> pixels(level0_size);
+    uint32_t seed = 1;
+    if (c.is_float) {
+        float* texels = (float*)pixels.data();
+        for (size_t i = 0; i < level0_size / sizeof(float); ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            texels[i] = (seed >> 8) / (float)(1 << 24) * 16.0f;
+        }
+    }
+    else {
+        for (size_t i = 0; i < level0_size; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            pixels[i] = (unsigned char)(seed >> 24);
+        }
+    }
+
+    double   time     = 0;
+    uint64_t checksum = 0;
+    for (int i = 0; i < NUM_RUNS; ++i) {
+        uint32_t mips;
+        uint32_t size;
+        auto t0 = Clock::now();
+        unsigned char* out = (unsigned char*)vkc::Assets::texture_generate_mips(
+            pixels.data(), SIZE, SIZE, c.channels, c.is_float, c.is_srgb, filter, &mips, &size
+        );
+        auto t1 = Clock::now();
+        time += std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+        // last level depends on every texel
+        for (uint32_t j = size - (uint32_t)texel_size; j < size; ++j)
+            checksum += out[j];
+        free(out);
+    }
+
+    time /= NUM_RUNS;
+    double mb = level0_size / (1024.0 * 1024.0);
+    CC_LOG(CC_IMPORTANT, "%-8s %-6s %-16s %8.2fms (%8.1f MB/s) | checksum %llu",
+        threads,
+        filter == vkc::Assets::MIP_FILTER_BOX ? "box" : "kaiser",
+        c.name,
+        time,
+        mb / (time / 1000.0),
+        (unsigned long long)checksum
+    );
+}
+
+void run_all(const char* threads) {
+    for (const Case& c : CASES) {
+        run_benchmark(threads, c, vkc::Assets::MIP_FILTER_BOX);
+        run_benchmark(threads, c, vkc::Assets::MIP_FILTER_KAISER);
+    }
+}
+
+int main(void) {
+    // jobs run inline until the pool is started
+    run_all("1 thread");
+
+    vkc::Jobs::job_pool_init();
+    run_all("pool");
+    vkc::Jobs::job_pool_shutdown();
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <VKRenderer.hpp>
 
 #include <core/DrawCall.hpp>
+#include <scene/TransformHierarchy.hpp>
 #include <AssetManager.hpp>
 
 // TMP_Update includes
@@ -47,6 +48,14 @@ namespace TMP_Update {
     const uint32_t drawcall_cout = 3;
     std::vector<DataUniformModel> model_data;
 
+    // node hierarchy of the model, meshes are drawn with the world transform of their node
+    vkc::Scene::TransformHierarchy scene_transforms;
+    uint32_t  model_root;
+    glm::mat4 model_root_local;
+    glm::vec3 model_rot = glm::vec3(0.0f);
+    // world transforms are pushed as they are
+    static_assert(sizeof(DataUniformModel) == sizeof(glm::mat4), "DataUniformModel is not a single matrix anymore");
+
     std::vector<vkc::Assets::IdAssetMesh> TMP_mesh_idxs;
     std::vector<vkc::Assets::IdAssetMesh> TMP_mat_idxs;
 
@@ -80,6 +89,14 @@ namespace TMP_Update {
     void TMP_update_gui(vkc::Rect2DI window_size, DataUniformFrame& ubo) {
         ImGui::Begin("tmp_update_info");
         ImGui::SeparatorText("Object data");
+        if (ImGui::DragFloat3("Model Rotation", &model_rot.x)) {
+            glm::vec3 rot = glm::radians(model_rot);
+            vkc::Scene::transform_hierarchy_set_local(
+                &scene_transforms,
+                model_root,
+                glm::eulerAngleYXZ(rot.y, rot.x, rot.z) * model_root_local
+            );
+        }
 
         ImGui::SeparatorText("Frame data");
         ImGui::DragFloat3("Light Color Ambient", &ubo.light_ambient.x);
@@ -206,6 +223,13 @@ class TestRenderer : public VKRenderer {
                 .model = glm::scale(glm::vec3(0.01f))
                 //.model = glm::translate(glm::vec3(i * 2, 0.0f, 0.0f)) * glm::scale(glm::vec3(1.0f))
             };
+
+        TMP_Update::model_root = vkc::Scene::transform_hierarchy_add_model(
+            &TMP_Update::scene_transforms,
+            vkc::Assets::get_model_data(0),
+            TMP_Update::model_data[0].model
+        );
+        TMP_Update::model_root_local = TMP_Update::scene_transforms.local[TMP_Update::model_root];
     }
 
     void update() override {
@@ -221,6 +245,8 @@ class TestRenderer : public VKRenderer {
             get_window_size(),
             get_ubo_reference()
         );
+
+        vkc::Scene::transform_hierarchy_update(&TMP_Update::scene_transforms);
     }
 
     void render() override {
@@ -237,11 +263,13 @@ class TestRenderer : public VKRenderer {
         auto model_data = vkc::Assets::get_model_data(0);
         for(int i = 0; i < model_data.meshes_count; ++i)
         {
-            drawcall_add(
+            glm::mat4& world = TMP_Update::scene_transforms.world[TMP_Update::model_root + model_data.meshes_node[i]];
+            drawcall_add_culled(
                 model_data.meshes[i],
                 model_data.meshes_material[i],
-                &TMP_Update::model_data[0],
-                sizeof(TMP_Update::model_data[0])
+                world,
+                &world,
+                sizeof(DataUniformModel)
             );
         }
 